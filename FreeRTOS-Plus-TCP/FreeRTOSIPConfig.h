@@ -146,7 +146,21 @@ stack will revert to using the static IP address even when ipconfigUSE_DHCP is
 set to 1 if a valid configuration cannot be obtained from a DHCP server for any
 reason.  The static configuration used is that passed into the stack by the
 FreeRTOS_IPInit() function call. */
-#define ipconfigUSE_DHCP 0
+#define ipconfigUSE_DHCP 1
+
+/* The last lease is kept in emulated EEPROM by the application.  After a reset
+it is confirmed with an INIT-REBOOT request, retransmitted with a period that
+doubles from 50 ms.  If no server answers within about half a second the static
+address is used.  See sample_boot/boot_lease.c. */
+#define ipconfigDHCP_USE_LEASE_CACHE 1
+#define ipconfigDHCP_INIT_REBOOT_TX_PERIOD (50 / portTICK_PERIOD_MS)
+#define ipconfigDHCP_INIT_REBOOT_MAX_TX_PERIOD (200 / portTICK_PERIOD_MS)
+
+/* Without a cached lease a full discovery is done.  Retransmit the discover
+every second rather than every 5 seconds, so that a network without a DHCP
+server falls back to the static address after about 8 seconds. */
+#define dhcpINITIAL_TIMER_PERIOD (250 / portTICK_PERIOD_MS)
+#define dhcpINITIAL_DHCP_TX_PERIOD (1000 / portTICK_PERIOD_MS)
 
 /* When ipconfigUSE_DHCP is set to 1, DHCP requests will be sent out at
 increasing time intervals until either a reply is received from a DHCP server
@@ -155,7 +169,7 @@ ipconfigMAXIMUM_DISCOVER_TX_PERIOD.  The IP stack will revert to using the
 static IP address passed as a parameter to FreeRTOS_IPInit() if the
 re-transmission time interval reaches ipconfigMAXIMUM_DISCOVER_TX_PERIOD without
 a DHCP reply being received. */
-#define ipconfigMAXIMUM_DISCOVER_TX_PERIOD (120000 / portTICK_PERIOD_MS)
+#define ipconfigMAXIMUM_DISCOVER_TX_PERIOD (4000 / portTICK_PERIOD_MS)
 
 /* The ARP cache is a table that maps IP addresses to MAC addresses.  The IP
 stack can only send a UDP message to a remove IP address if it knowns the MAC
@@ -197,12 +211,32 @@ are available to the IP stack.  The total number of network buffers is limited
 to ensure the total amount of RAM that can be consumed by the IP stack is capped
 to a pre-determinable value. */
 
+/* The small and the jumbo buffers come on top of the 50 (TCP) or 100 full size
+buffers, which the receive ring and the bootloader blocks in flight need. The
+small ones cost 40 * 192 bytes, the jumbo ones 4 * 16 KB of the 768 KB SRAM. */
 #ifdef USE_TCP
-#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS (50)
+#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS (50 + 20 + 4)
+#define ipconfigNUM_SMALL_NETWORK_BUFFERS (20)
 #else
-#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS (100)
+#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS (100 + 40 + 4)
+#define ipconfigNUM_SMALL_NETWORK_BUFFERS (40)
 #endif
 
+/* BufferAllocation_3.c size classes. ARP, ICMP echo and TCP acks fit in the
+small buffers, the network interface copies such frames out of the receive ring.
+The full size buffers match the ENET receive buffers. */
+#define ipconfigSMALL_NETWORK_BUFFER_SIZE (128)
+#define ipconfigNETWORK_BUFFER_SIZE (1536)
+
+/* UDP datagrams of up to 16 KB are fragmented on send and reassembled on
+receive, for the flashing protocol. The jumbo buffers hold these datagrams and
+are counted in ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS. */
+#define ipconfigUSE_IP_FRAGMENTATION (1)
+#define ipconfigIP_MAX_DATAGRAM_SIZE (16384)
+#define ipconfigIP_REASSEMBLY_SLOTS (2)
+#define ipconfigIP_REASSEMBLY_TIMEOUT_MS (1000)
+#define ipconfigNUM_JUMBO_NETWORK_BUFFERS (4)
+
 /* A FreeRTOS queue is used to send events from application tasks to the IP
 stack.  ipconfigEVENT_QUEUE_LENGTH sets the maximum number of events that can
 be queued for processing at any one time.  The event queue must be a minimum of
@@ -236,8 +270,8 @@ aborted. */
 /* The MTU is the maximum number of bytes the payload of a network frame can
 contain.  For normal Ethernet V2 frames the maximum MTU is 1500.  Setting a
 lower value can save RAM, depending on the buffer management scheme used.  If
-ipconfigCAN_FRAGMENT_OUTGOING_PACKETS is 1 then (ipconfigNETWORK_MTU - 28) must
-be divisible by 8. */
+ipconfigUSE_IP_FRAGMENTATION is 1 then the fragments carry
+(ipconfigNETWORK_MTU - 20) bytes, rounded down to a multiple of 8. */
 #define ipconfigNETWORK_MTU 1500
 
 /* Set ipconfigUSE_DNS to 1 to include a basic DNS client/resolver.  DNS is used
@@ -271,6 +305,11 @@ Ethernet driver does all the necessary filtering in hardware then software
 filtering can be removed by using a value other than 1 or 0. */
 #define ipconfigETHERNET_DRIVER_FILTERS_FRAME_TYPES 1
 
+/* The network interface programs the ENET receive parser from the ports of the
+bound sockets, see vNetworkInterfaceBoundPortsChanged(). The stack keeps its
+own IP checks. */
+#define ipconfigETHERNET_DRIVER_FILTERS_PORTS 1
+
 /* The windows simulator cannot really simulate MAC interrupts, and needs to
 block occasionally to allow other tasks to run. */
 #define configWINDOWS_MAC_INTERRUPT_SIMULATOR_DELAY (20 / portTICK_PERIOD_MS)
@@ -315,10 +354,45 @@ disconnecting stage will timeout after a period of non-activity. */
 
 #define ipconfigTCP_IP_SANITY (1)
 
-#define ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM (0)
+/* The ENET MAC inserts the IP header and the TCP/UDP/ICMP checksums of the
+outgoing frames, and discards received frames with a wrong checksum. Set this and
+ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM to 0 to compute and verify the checksums
+in software instead. */
+#define ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM (1)
 
 #define ipconfigUSE_RMII (1)
 
+/* UDP sockets that set FREERTOS_SO_UDP_FAST_PATH get their datagrams straight
+from the ENET handler tasks, without the IP-task. */
+#define ipconfigUDP_FAST_PATH (1)
+
+/* UDP sockets reuse the headers of their last destination, for the VCI data
+path which streams to a single host. */
+#define ipconfigUDP_DESTINATION_CACHE (1)
+
+/* Set to 1 to measure the time from the ENET receive interrupt until the
+application takes a UDP datagram, per path (ENET_RxLatency* in NetworkInterface.c).
+make NET_BENCH=1 turns it on, tool/vci8_load -l reads it with the fast path off
+and on. */
+#ifndef ipconfigMEASURE_RX_LATENCY
+#define ipconfigMEASURE_RX_LATENCY (0)
+#endif
+#if (ipconfigMEASURE_RX_LATENCY != 0)
+struct xNETWORK_BUFFER;
+void vNetworkInterfaceRxLatencySample(const struct xNETWORK_BUFFER *pxNetworkBuffer);
+#define iptraceUDP_APPLICATION_RECEIVE(pxNetworkBuffer) vNetworkInterfaceRxLatencySample(pxNetworkBuffer)
+#endif
+
+/* Network buffer pool events in the kernel trace, see trace_recorder.h. The
+buffers of the stream task itself are left out, they only trace the trace. */
+#if (configUSE_TRACE_RECORDER == 1)
+#define iptraceNETWORK_BUFFER_OBTAINED(pxBufferAddress) traceRECORD_NOT_STREAM(traceREC_NET_BUFFER_GET, 0, 0, (pxBufferAddress), 0)
+#define iptraceNETWORK_BUFFER_OBTAINED_FROM_ISR(pxBufferAddress) traceRECORD(traceREC_NET_BUFFER_GET, 1, 0, (pxBufferAddress), 0)
+#define iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER() traceRECORD_NOT_STREAM(traceREC_NET_BUFFER_GET, 0, 0, 0, 0)
+#define iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER_FROM_ISR() traceRECORD(traceREC_NET_BUFFER_GET, 1, 0, 0, 0)
+#define iptraceNETWORK_BUFFER_RELEASED(pxBufferAddress) traceRECORD_NOT_STREAM(traceREC_NET_BUFFER_RELEASE, 0, 0, (pxBufferAddress), 0)
+#endif
+
 #define portINLINE __inline
 
 #endif /* FREERTOS_IP_CONFIG_H */
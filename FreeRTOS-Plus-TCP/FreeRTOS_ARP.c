@@ -52,6 +52,16 @@ to zero, so this is an old entry) an ARP request will be sent to see if the
 entry is still valid and can therefore be refreshed. */
 #define arpMAX_ARP_AGE_BEFORE_NEW_ARP_REQUEST		( 3 )
 
+/* The ARP cache is indexed by a hash of the IP address, each bucket holds a
+chain of rows linked through ucARPHashNext[]. */
+#define arpHASH_BUCKETS								( 16 )
+#define arpHASH_END									( ( uint8_t ) 0xffu )
+#define arpHASH( ulIPAddress )						( ( ( ulIPAddress ) ^ ( ( ulIPAddress ) >> 8 ) ^ ( ( ulIPAddress ) >> 16 ) ^ ( ( ulIPAddress ) >> 24 ) ) & ( arpHASH_BUCKETS - 1u ) )
+
+#if( ipconfigARP_CACHE_ENTRIES >= 255 )
+	#error ipconfigARP_CACHE_ENTRIES must be below 255
+#endif
+
 /* The time between gratuitous ARPs. */
 #ifndef arpGRATUITOUS_ARP_PERIOD
 	#define arpGRATUITOUS_ARP_PERIOD					( pdMS_TO_TICKS( 20000 ) )
@@ -64,11 +74,35 @@ entry is still valid and can therefore be refreshed. */
  */
 static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress_t * const pxMACAddress );
 
+/*
+ * Find the row holding an IP address, -1 if there is none.
+ */
+static BaseType_t prvCacheFind( uint32_t ulIPAddress );
+
+/*
+ * Change the IP address of a row and move it to the matching hash chain.  An
+ * address of zero frees the row.
+ */
+static void prvCacheSetAddress( BaseType_t xEntry, uint32_t ulIPAddress );
+
+/*
+ * Free a row.
+ */
+static void prvCacheClearEntry( BaseType_t xEntry );
+
 /*-----------------------------------------------------------*/
 
 /* The ARP cache. */
 NOINIT_DATA_SECTION static ARPCacheRow_t xARPCache[ ipconfigARP_CACHE_ENTRIES ];
 
+/* The first row of each hash chain, and the next row in the chain. */
+NOINIT_DATA_SECTION static uint8_t ucARPHashHead[ arpHASH_BUCKETS ];
+NOINIT_DATA_SECTION static uint8_t ucARPHashNext[ ipconfigARP_CACHE_ENTRIES ];
+
+/* Incremented whenever an address returned by eARPGetCacheEntry() may have
+become stale. */
+uint32_t ulARPCacheGeneration = 0UL;
+
 /* The time at which the last gratuitous ARP was sent.  Gratuitous ARPs are used
 to ensure ARP tables are up to date and to detect IP address conflicts. */
 static TickType_t xLastGratuitousARPTime = ( TickType_t ) 0;
@@ -105,6 +139,55 @@ static const uint8_t xDefaultPartARPPacketHeader[] =
 
 /*-----------------------------------------------------------*/
 
+static BaseType_t prvCacheFind( uint32_t ulIPAddress )
+{
+uint8_t ucEntry;
+
+	for( ucEntry = ucARPHashHead[ arpHASH( ulIPAddress ) ]; ucEntry != arpHASH_END; ucEntry = ucARPHashNext[ ucEntry ] )
+	{
+		if( xARPCache[ ucEntry ].ulIPAddress == ulIPAddress )
+		{
+			return ( BaseType_t ) ucEntry;
+		}
+	}
+	return -1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCacheSetAddress( BaseType_t xEntry, uint32_t ulIPAddress )
+{
+uint8_t *pucLink;
+
+	if( xARPCache[ xEntry ].ulIPAddress != 0UL )
+	{
+		for( pucLink = &( ucARPHashHead[ arpHASH( xARPCache[ xEntry ].ulIPAddress ) ] ); *pucLink != arpHASH_END; pucLink = &( ucARPHashNext[ *pucLink ] ) )
+		{
+			if( *pucLink == ( uint8_t ) xEntry )
+			{
+				*pucLink = ucARPHashNext[ xEntry ];
+				break;
+			}
+		}
+	}
+
+	xARPCache[ xEntry ].ulIPAddress = ulIPAddress;
+
+	if( ulIPAddress != 0UL )
+	{
+		ucARPHashNext[ xEntry ] = ucARPHashHead[ arpHASH( ulIPAddress ) ];
+		ucARPHashHead[ arpHASH( ulIPAddress ) ] = ( uint8_t ) xEntry;
+	}
+	ulARPCacheGeneration++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCacheClearEntry( BaseType_t xEntry )
+{
+	prvCacheSetAddress( xEntry, 0UL );
+	memset( &xARPCache[ xEntry ], '\0', sizeof( xARPCache[ xEntry ] ) );
+}
+/*-----------------------------------------------------------*/
+
 eFrameProcessingResult_t eARPProcessPacket( ARPPacket_t * const pxARPFrame )
 {
 eFrameProcessingResult_t eReturn = eReleaseBuffer;
@@ -198,7 +281,7 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 			if( ( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
 			{
 				lResult = xARPCache[ x ].ulIPAddress;
-				memset( &xARPCache[ x ], '\0', sizeof( xARPCache[ x ] ) );
+				prvCacheClearEntry( x );
 				break;
 			}
 		}
@@ -233,6 +316,20 @@ uint8_t ucMinAgeFound = 0U;
 		if( pdTRUE )
 	#endif
 	{
+		/* The common case first: a packet from a known host, found through
+		the hash.  Anything else needs the scan below. */
+		if( pxMACAddress != NULL )
+		{
+			x = prvCacheFind( ulIPAddress );
+			if( ( x >= 0 ) &&
+				( memcmp( xARPCache[ x ].xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( pxMACAddress->ucBytes ) ) == 0 ) )
+			{
+				xARPCache[ x ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
+				xARPCache[ x ].ucValid = ( uint8_t ) pdTRUE;
+				return;
+			}
+		}
+
 		/* Start with the maximum possible number. */
 		ucMinAgeFound--;
 
@@ -313,7 +410,7 @@ uint8_t ucMinAgeFound = 0U;
 				/* Both the MAC address as well as the IP address were found in
 				different locations: clear the entry which matches the
 				IP-address */
-				memset( &xARPCache[ xIpEntry ], '\0', sizeof( xARPCache[ xIpEntry ] ) );
+				prvCacheClearEntry( xIpEntry );
 			}
 		}
 		else if( xIpEntry >= 0 )
@@ -322,8 +419,10 @@ uint8_t ucMinAgeFound = 0U;
 			xUseEntry = xIpEntry;
 		}
 
-		/* If the entry was not found, we use the oldest entry and set the IPaddress */
-		xARPCache[ xUseEntry ].ulIPAddress = ulIPAddress;
+		/* If the entry was not found, we use the oldest entry and set the
+		IPaddress.  Cached destinations are invalidated, the MAC address or the
+		row may have changed. */
+		prvCacheSetAddress( xUseEntry, ulIPAddress );
 
 		if( pxMACAddress != NULL )
 		{
@@ -483,26 +582,22 @@ static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress
 BaseType_t x;
 eARPLookupResult_t eReturn = eARPCacheMiss;
 
-	/* Loop through each entry in the ARP cache. */
-	for( x = 0; x < ipconfigARP_CACHE_ENTRIES; x++ )
+	/* Does a row in the ARP cache table hold an entry for the IP address
+	being queried? */
+	x = prvCacheFind( ulAddressToLookup );
+	if( x >= 0 )
 	{
-		/* Does this row in the ARP cache table hold an entry for the IP address
-		being queried? */
-		if( xARPCache[ x ].ulIPAddress == ulAddressToLookup )
+		/* A matching valid entry was found. */
+		if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
 		{
-			/* A matching valid entry was found. */
-			if( xARPCache[ x ].ucValid == ( uint8_t ) pdFALSE )
-			{
-				/* This entry is waiting an ARP reply, so is not valid. */
-				eReturn = eCantSendPacket;
-			}
-			else
-			{
-				/* A valid entry was found. */
-				memcpy( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
-				eReturn = eARPCacheHit;
-			}
-			break;
+			/* This entry is waiting an ARP reply, so is not valid. */
+			eReturn = eCantSendPacket;
+		}
+		else
+		{
+			/* A valid entry was found. */
+			memcpy( pxMACAddress->ucBytes, xARPCache[ x ].xMACAddress.ucBytes, sizeof( MACAddress_t ) );
+			eReturn = eARPCacheHit;
 		}
 	}
 
@@ -547,7 +642,7 @@ TickType_t xTimeNow;
 			{
 				/* The entry is no longer valid.  Wipe it out. */
 				iptraceARP_TABLE_ENTRY_EXPIRED( xARPCache[ x ].ulIPAddress );
-				xARPCache[ x ].ulIPAddress = 0UL;
+				prvCacheSetAddress( x, 0UL );
 			}
 		}
 	}
@@ -638,6 +733,8 @@ ARPPacket_t *pxARPPacket;
 void FreeRTOS_ClearARP( void )
 {
 	memset( xARPCache, '\0', sizeof( xARPCache ) );
+	memset( ucARPHashHead, arpHASH_END, sizeof( ucARPHashHead ) );
+	ulARPCacheGeneration++;
 }
 /*-----------------------------------------------------------*/
 
@@ -178,6 +178,12 @@ struct xDHCP_DATA
 	eDHCPState_t eDHCPState;
 	/* The UDP socket used for all incoming and outgoing DHCP traffic. */
 	Socket_t xDHCPSocket;
+	#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+		/* pdTRUE from a reset until the cached lease has been tried. */
+		BaseType_t xInitReboot;
+		/* The lease as last loaded from or handed to the application. */
+		DHCPLease_t xCachedLease;
+	#endif
 };
 
 typedef struct xDHCP_DATA DHCPData_t;
@@ -236,6 +242,22 @@ static void prvCreateDHCPSocket( void );
 	static void prvPrepareLinkLayerIPLookUp( void );
 #endif
 
+/*
+ * Get the cached lease from the application and prepare an INIT-REBOOT
+ * request for it.  Returns pdTRUE if there is a lease to confirm.
+ */
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	static BaseType_t prvLoadCachedLease( void );
+#endif
+
+/*
+ * Hand an acknowledged lease to the application, unless it is the one that is
+ * already cached.
+ */
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	static void prvStoreLease( void );
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* The next DHCP transaction Id to be used. */
@@ -271,6 +293,13 @@ BaseType_t xGivingUp = pdFALSE;
 	if( xReset != pdFALSE )
 	{
 		xDHCPData.eDHCPState = eWaitingSendFirstDiscover;
+
+		#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+		{
+			/* Only a fresh start may skip the discovery. */
+			xDHCPData.xInitReboot = pdTRUE;
+		}
+		#endif
 	}
 
 	switch( xDHCPData.eDHCPState )
@@ -295,6 +324,22 @@ BaseType_t xGivingUp = pdFALSE;
 
 				*ipLOCAL_IP_ADDRESS_POINTER = 0UL;
 
+			#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+				if( ( xDHCPData.xInitReboot != pdFALSE ) && ( prvLoadCachedLease() != pdFALSE ) )
+				{
+					/* INIT-REBOOT: ask for the cached lease straight away.
+					Retransmissions are short, a server that knows the lease
+					answers within milliseconds. */
+					xDHCPData.xDHCPTxTime = xTaskGetTickCount();
+					xDHCPData.xDHCPTxPeriod = ipconfigDHCP_INIT_REBOOT_TX_PERIOD;
+					prvSendDHCPRequest( );
+					xDHCPData.eDHCPState = eWaitingAcknowledge;
+					vIPReloadDHCPTimer( ipconfigDHCP_INIT_REBOOT_TX_PERIOD );
+					break;
+				}
+				xDHCPData.xInitReboot = pdFALSE;
+			#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+
 				/* Send the first discover request. */
 				if( xDHCPData.xDHCPSocket != NULL )
 				{
@@ -416,6 +461,13 @@ BaseType_t xGivingUp = pdFALSE;
 
 				iptraceDHCP_SUCCEDEED( xDHCPData.ulOfferedIPAddress );
 
+				#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+				{
+					xDHCPData.xInitReboot = pdFALSE;
+					prvStoreLease();
+				}
+				#endif
+
 				/* DHCP failed, the default configured IP-address will be used
 				Now call vIPNetworkUpCalls() to send the network-up event and
 				start the ARP timer. */
@@ -451,6 +503,26 @@ BaseType_t xGivingUp = pdFALSE;
 					point of giving up - send another request. */
 					xDHCPData.xDHCPTxPeriod <<= 1;
 
+				#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+					if( xDHCPData.xInitReboot != pdFALSE )
+					{
+						/* The cached lease is only worth a short wait, after
+						that the static address is used.  The lease stays
+						cached for the next reset. */
+						if( xDHCPData.xDHCPTxPeriod <= ipconfigDHCP_INIT_REBOOT_MAX_TX_PERIOD )
+						{
+							xDHCPData.xDHCPTxTime = xTaskGetTickCount();
+							prvSendDHCPRequest( );
+						}
+						else
+						{
+							FreeRTOS_debug_printf( ( "vDHCPProcess: INIT-REBOOT not answered\n" ) );
+							xGivingUp = pdTRUE;
+						}
+						break;
+					}
+				#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+
 					if( xDHCPData.xDHCPTxPeriod <= ipconfigMAXIMUM_DISCOVER_TX_PERIOD )
 					{
 						xDHCPData.xDHCPTxTime = xTaskGetTickCount();
@@ -525,6 +597,18 @@ BaseType_t xGivingUp = pdFALSE;
 		xApplicationDHCPHook() returned another value than 'eDHCPContinue',
 		meaning that the conversion is canceled from here. */
 
+		#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+		{
+			if( ( xDHCPData.xInitReboot != pdFALSE ) && ( xDHCPData.eDHCPState == eWaitingAcknowledge ) )
+			{
+				/* The netmask, gateway and DNS server were taken from the
+				cached lease, go back to the static ones. */
+				memcpy( &xNetworkAddressing, &xDefaultAddressing, sizeof( xNetworkAddressing ) );
+			}
+			xDHCPData.xInitReboot = pdFALSE;
+		}
+		#endif
+
 		/* Revert to static IP address. */
 		taskENTER_CRITICAL();
 		{
@@ -710,6 +794,16 @@ if (lBytes > 0)
 						{
 							/* Start again. */
 							xDHCPData.eDHCPState = eWaitingSendFirstDiscover;
+
+							#if (ipconfigDHCP_USE_LEASE_CACHE != 0)
+							if (xDHCPData.xInitReboot != pdFALSE)
+							{
+								/* The cached lease is not valid on this network. */
+								xDHCPData.xInitReboot = pdFALSE;
+								memset((void *)&(xDHCPData.xCachedLease), 0x00, sizeof(xDHCPData.xCachedLease));
+								vApplicationDHCPLeaseStore(NULL);
+							}
+							#endif
 						}
 					}
 					else
@@ -756,6 +850,16 @@ if (lBytes > 0)
 						}
 						else
 						{
+							#if (ipconfigDHCP_USE_LEASE_CACHE != 0)
+							if (xDHCPData.xInitReboot != pdFALSE)
+							{
+								/* The request did not name a server, whichever
+									server acknowledges the lease is the one to
+									renew it with. */
+								xDHCPData.ulDHCPServerAddress = ulParameter;
+							}
+							#endif
+
 							/* The ack must come from the expected server. */
 							if (xDHCPData.ulDHCPServerAddress == ulParameter)
 							{
@@ -911,17 +1015,37 @@ static const uint8_t ucDHCPRequestOptions[] =
 	dhcpOPTION_END_BYTE
 };
 size_t xOptionsLength = sizeof( ucDHCPRequestOptions );
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	static const uint8_t ucDHCPInitRebootOptions[] =
+	{
+		/* An INIT-REBOOT request must not name a server (RFC 2131, 4.3.2).
+		Keep the requested IP address at dhcpREQUESTED_IP_ADDRESS_OFFSET. */
+		dhcpMESSAGE_TYPE_OPTION_CODE, 1, dhcpMESSAGE_TYPE_REQUEST,		/* Message type option. */
+		dhcpCLIENT_IDENTIFIER_OPTION_CODE, 6, 0, 0, 0, 0, 0, 0,			/* Client identifier. */
+		dhcpREQUEST_IP_ADDRESS_OPTION_CODE, 4, 0, 0, 0, 0,				/* The IP address being requested. */
+		dhcpPARAMETER_REQUEST_OPTION_CODE, 3, dhcpSUBNET_MASK_OPTION_CODE, dhcpGATEWAY_OPTION_CODE, dhcpDNS_SERVER_OPTIONS_CODE,	/* Parameter request option. */
+		dhcpOPTION_END_BYTE
+	};
+
+	if( xDHCPData.xInitReboot != pdFALSE )
+	{
+		xOptionsLength = sizeof( ucDHCPInitRebootOptions );
+		pucUDPPayloadBuffer = prvCreatePartDHCPMessage( &xAddress, dhcpREQUEST_OPCODE, ucDHCPInitRebootOptions, &xOptionsLength );
+	}
+	else
+#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+	{
+		pucUDPPayloadBuffer = prvCreatePartDHCPMessage( &xAddress, dhcpREQUEST_OPCODE, ucDHCPRequestOptions, &xOptionsLength );
 
-	pucUDPPayloadBuffer = prvCreatePartDHCPMessage( &xAddress, dhcpREQUEST_OPCODE, ucDHCPRequestOptions, &xOptionsLength );
+		/* Copy in the address of the DHCP server being used. */
+		memcpy( ( void * ) &( pucUDPPayloadBuffer[ dhcpFIRST_OPTION_BYTE_OFFSET + dhcpDHCP_SERVER_IP_ADDRESS_OFFSET ] ),
+			( void * ) &( xDHCPData.ulDHCPServerAddress ), sizeof( xDHCPData.ulDHCPServerAddress ) );
+	}
 
 	/* Copy in the IP address being requested. */
 	memcpy( ( void * ) &( pucUDPPayloadBuffer[ dhcpFIRST_OPTION_BYTE_OFFSET + dhcpREQUESTED_IP_ADDRESS_OFFSET ] ),
 		( void * ) &( xDHCPData.ulOfferedIPAddress ), sizeof( xDHCPData.ulOfferedIPAddress ) );
 
-	/* Copy in the address of the DHCP server being used. */
-	memcpy( ( void * ) &( pucUDPPayloadBuffer[ dhcpFIRST_OPTION_BYTE_OFFSET + dhcpDHCP_SERVER_IP_ADDRESS_OFFSET ] ),
-		( void * ) &( xDHCPData.ulDHCPServerAddress ), sizeof( xDHCPData.ulDHCPServerAddress ) );
-
 	FreeRTOS_debug_printf( ( "vDHCPProcess: reply %lxip\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
 	iptraceSENDING_DHCP_REQUEST();
 
@@ -1005,6 +1129,58 @@ size_t xOptionsLength = sizeof( ucDHCPDiscoverOptions );
 #endif /* ipconfigDHCP_FALL_BACK_AUTO_IP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+
+	static BaseType_t prvLoadCachedLease( void )
+	{
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( xApplicationDHCPLeaseLoad( &( xDHCPData.xCachedLease ) ) != pdFALSE ) &&
+			( xDHCPData.xCachedLease.ulIPAddress != 0UL ) )
+		{
+			xDHCPData.ulOfferedIPAddress = xDHCPData.xCachedLease.ulIPAddress;
+			xDHCPData.ulDHCPServerAddress = xDHCPData.xCachedLease.ulDHCPServerAddress;
+
+			/* Options missing from the ACK keep the cached values. */
+			xNetworkAddressing.ulNetMask = xDHCPData.xCachedLease.ulNetMask;
+			xNetworkAddressing.ulGatewayAddress = xDHCPData.xCachedLease.ulGatewayAddress;
+			xNetworkAddressing.ulDNSServerAddress = xDHCPData.xCachedLease.ulDNSServerAddress;
+
+			FreeRTOS_debug_printf( ( "vDHCPProcess: INIT-REBOOT %lxip\n", FreeRTOS_ntohl( xDHCPData.ulOfferedIPAddress ) ) );
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			memset( ( void * ) &( xDHCPData.xCachedLease ), 0x00, sizeof( xDHCPData.xCachedLease ) );
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvStoreLease( void )
+	{
+	DHCPLease_t xLease;
+
+		memset( ( void * ) &xLease, 0x00, sizeof( xLease ) );
+		xLease.ulIPAddress = xDHCPData.ulOfferedIPAddress;
+		xLease.ulNetMask = xNetworkAddressing.ulNetMask;
+		xLease.ulGatewayAddress = xNetworkAddressing.ulGatewayAddress;
+		xLease.ulDNSServerAddress = xNetworkAddressing.ulDNSServerAddress;
+		xLease.ulDHCPServerAddress = xDHCPData.ulDHCPServerAddress;
+
+		/* Renewals normally return the same lease, don't wear out the
+		application's storage for them. */
+		if( memcmp( ( void * ) &xLease, ( void * ) &( xDHCPData.xCachedLease ), sizeof( xLease ) ) != 0 )
+		{
+			memcpy( ( void * ) &( xDHCPData.xCachedLease ), ( void * ) &xLease, sizeof( xLease ) );
+			vApplicationDHCPLeaseStore( &xLease );
+		}
+	}
+
+#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+/*-----------------------------------------------------------*/
+
 #endif /* ipconfigUSE_DHCP != 0 */
 
 
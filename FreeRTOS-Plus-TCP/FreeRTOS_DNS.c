@@ -1320,6 +1320,11 @@ TickType_t xTimeoutTime = pdMS_TO_TICKS( 200 );
 			/* calculate the UDP checksum for outgoing package */
 			usGenerateProtocolChecksum( ( uint8_t* ) pxUDPPacket, lNetLength, pdTRUE );
 		}
+		#else
+		{
+			/* The MAC inserts the checksum into a zeroed field. */
+			pxUDPPacket->xUDPHeader.usChecksum = 0u;
+		}
 		#endif
 
 		/* Important: tell NIC driver how many bytes must be sent */
@@ -131,10 +131,6 @@ per ms: */
 handled.  The value is chosen simply to be easy to spot when debugging. */
 #define ipUNHANDLED_PROTOCOL		0x4321u
 
-/* Returned to indicate a valid checksum when the checksum does not need to be
-calculated. */
-#define ipCORRECT_CRC				0xffffu
-
 /* Returned as the (invalid) checksum when the length of the data being checked
 had an invalid length. */
 #define ipINVALID_LENGTH			0x1234u
@@ -247,6 +243,11 @@ static eFrameProcessingResult_t prvAllowIPPacket( const IPPacket_t * const pxIPP
 /* The queue used to pass events into the IP-task for processing. */
 QueueHandle_t xNetworkEventQueue = NULL;
 
+/* Received frames of the priority classes (PTP, control), in their order of
+arrival.  The IP-task empties this queue before it takes the next event from
+xNetworkEventQueue. */
+static QueueHandle_t xNetworkPriorityEventQueue = NULL;
+
 /*_RB_ Requires comment. */
 uint16_t usPacketIdentifier = 0U;
 
@@ -289,6 +290,7 @@ regular basis:
 	2. DPHC, to send requests and to renew a reservation
 	3. TCP, to check for timeouts, resends
 	4. DNS, to check for timeouts when looking-up a domain.
+	5. IP reassembly, to drop the datagrams that were not completed in time.
  */
 static IPTimer_t xARPTimer;
 #if( ipconfigUSE_DHCP != 0 )
@@ -300,6 +302,9 @@ static IPTimer_t xARPTimer;
 #if( ipconfigDNS_USE_CALLBACKS != 0 )
 	static IPTimer_t xDNSTimer;
 #endif
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	static IPTimer_t xReassemblyTimer;
+#endif
 
 /* Set to pdTRUE when the IP task is ready to start processing packets. */
 static BaseType_t xIPTaskInitialised = pdFALSE;
@@ -356,10 +361,14 @@ struct freertos_sockaddr xAddress;
 
 		/* Wait until there is something to do. If the following call exits
 		 * due to a time out rather than a message being received, set a
-		 * 'NoEvent' value. */
-		if ( xQueueReceive( xNetworkEventQueue, ( void * ) &xReceivedEvent, xNextIPSleep ) == pdFALSE ) 
+		 * 'NoEvent' value.  Priority frames are taken first, a sender of a
+		 * priority frame wakes this task through xNetworkEventQueue. */
+		if( xQueueReceive( xNetworkPriorityEventQueue, ( void * ) &xReceivedEvent, 0 ) == pdFALSE )
 		{
-			xReceivedEvent.eEventType = eNoEvent;
+			if ( xQueueReceive( xNetworkEventQueue, ( void * ) &xReceivedEvent, xNextIPSleep ) == pdFALSE ) 
+			{
+				xReceivedEvent.eEventType = eNoEvent;
+			}
 		}
 
 		#if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
@@ -433,6 +442,12 @@ struct freertos_sockaddr xAddress;
 				vProcessGeneratedUDPPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
 				break;
 
+			case eStackTxBatchEvent :
+				/* FreeRTOS_sendmmsg() has queued a chain of packets to the
+				same destination. */
+				vProcessGeneratedUDPBatch( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
+				break;
+
 			case eDHCPEvent:
 				/* The DHCP state machine needs processing. */
 				#if( ipconfigUSE_DHCP == 1 )
@@ -618,6 +633,18 @@ TickType_t xMaximumSleepTime;
 	}
 	#endif
 
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	{
+		if( xReassemblyTimer.bActive != pdFALSE_UNSIGNED )
+		{
+			if( xReassemblyTimer.ulRemainingTime < xMaximumSleepTime )
+			{
+				xMaximumSleepTime = xReassemblyTimer.ulRemainingTime;
+			}
+		}
+	}
+	#endif
+
 	return xMaximumSleepTime;
 }
 /*-----------------------------------------------------------*/
@@ -652,13 +679,26 @@ static void prvCheckNetworkTimers( void )
 	}
 	#endif /* ipconfigDNS_USE_CALLBACKS */
 
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	{
+		/* Drop the expired datagrams, stop when none is left. */
+		if( prvIPTimerCheck( &xReassemblyTimer ) != pdFALSE )
+		{
+			if( xIPReassemblyCheck() == pdFALSE )
+			{
+				xReassemblyTimer.bActive = pdFALSE_UNSIGNED;
+			}
+		}
+	}
+	#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 	#if( ipconfigUSE_TCP == 1 )
 	{
 	BaseType_t xWillSleep;
 	TickType_t xNextTime;
 	BaseType_t xCheckTCPSockets;
 
-		if( uxQueueMessagesWaiting( xNetworkEventQueue ) == 0u )
+		if( ( uxQueueMessagesWaiting( xNetworkEventQueue ) == 0u ) && ( uxQueueMessagesWaiting( xNetworkPriorityEventQueue ) == 0u ) )
 		{
 			xWillSleep = pdTRUE;
 		}
@@ -951,8 +991,10 @@ BaseType_t xReturn = pdFALSE;
 	/* Attempt to create the queue used to communicate with the IP task. */
 	xNetworkEventQueue = xQueueCreate( ( UBaseType_t ) ipconfigEVENT_QUEUE_LENGTH, ( UBaseType_t ) sizeof( IPStackEvent_t ) );
 	configASSERT( xNetworkEventQueue );
+	xNetworkPriorityEventQueue = xQueueCreate( ( UBaseType_t ) ipconfigPRIORITY_EVENT_QUEUE_LENGTH, ( UBaseType_t ) sizeof( IPStackEvent_t ) );
+	configASSERT( xNetworkPriorityEventQueue );
 
-	if( xNetworkEventQueue != NULL )
+	if( ( xNetworkEventQueue != NULL ) && ( xNetworkPriorityEventQueue != NULL ) )
 	{
 		#if ( configQUEUE_REGISTRY_SIZE > 0 )
 		{
@@ -1010,11 +1052,24 @@ BaseType_t xReturn = pdFALSE;
 			/* Clean up. */
 			vQueueDelete( xNetworkEventQueue );
 			xNetworkEventQueue = NULL;
+			vQueueDelete( xNetworkPriorityEventQueue );
+			xNetworkPriorityEventQueue = NULL;
 		}
 	}
 	else
 	{
 		FreeRTOS_debug_printf( ( "FreeRTOS_IPInit: Network event queue could not be created\n") );
+
+		if( xNetworkEventQueue != NULL )
+		{
+			vQueueDelete( xNetworkEventQueue );
+			xNetworkEventQueue = NULL;
+		}
+		if( xNetworkPriorityEventQueue != NULL )
+		{
+			vQueueDelete( xNetworkPriorityEventQueue );
+			xNetworkPriorityEventQueue = NULL;
+		}
 	}
 
 	return xReturn;
@@ -1214,6 +1269,50 @@ BaseType_t xReturn, xSendMessage;
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t xSendPriorityEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t xTimeout )
+{
+BaseType_t xReturn;
+IPStackEvent_t xWakeUpEvent;
+
+	if( ( xIPIsNetworkTaskReady() == pdFALSE ) || ( pxEvent->eEventType != eNetworkRxEvent ) )
+	{
+		/* Only received frames may overtake the queue, everything else keeps
+		its order. */
+		xReturn = xSendEventStructToIPTask( pxEvent, xTimeout );
+	}
+	else
+	{
+		if( ( xIsCallingFromIPTask() == pdTRUE ) && ( xTimeout > ( TickType_t ) 0 ) )
+		{
+			xTimeout = ( TickType_t ) 0;
+		}
+
+		xReturn = xQueueSendToBack( xNetworkPriorityEventQueue, pxEvent, xTimeout );
+
+		if( xReturn == pdFAIL )
+		{
+			FreeRTOS_debug_printf( ( "xSendPriorityEventStructToIPTask: CAN NOT ADD %d\n", pxEvent->eEventType ) );
+			iptraceSTACK_TX_EVENT_LOST( pxEvent->eEventType );
+		}
+		else if( uxQueueMessagesWaiting( xNetworkEventQueue ) == 0u )
+		{
+			/* The IP-task may be blocked on the other queue.  When that queue
+			is not empty the IP-task will look at the priority queue before it
+			blocks again, so no wake up is needed. */
+			xWakeUpEvent.eEventType = eNoEvent;
+			xWakeUpEvent.pvData = NULL;
+			( void ) xQueueSendToBack( xNetworkEventQueue, &xWakeUpEvent, 0 );
+		}
+		else
+		{
+			/* The IP-task will find the frame before it blocks. */
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
 eFrameProcessingResult_t eConsiderFrameForProcessing(const uint8_t *const pucEthernetBuffer)
 {
 eFrameProcessingResult_t eReturn;
@@ -1468,10 +1567,10 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 		This method may decrease the usage of sparse network buffers. */
 		uint32_t ulDestinationIPAddress = pxIPHeader->ulDestinationIPAddress;
 
-			/* Ensure that the incoming packet is not fragmented (only outgoing
-			packets can be fragmented) as these are the only handled IP frames
-			currently. */
-			if( ( pxIPHeader->usFragmentOffset & ipFRAGMENT_OFFSET_BIT_MASK ) != 0U )
+			/* Ensure that the incoming packet is not fragmented, unless the
+			fragments are reassembled by prvProcessIPPacket(). */
+			if( ( ipconfigUSE_IP_FRAGMENTATION == 0 ) &&
+				( ( pxIPHeader->usFragmentOffset & ipFRAGMENT_OFFSET_BIT_MASK ) != 0U ) )
 			{
 				/* Can not handle, fragmented packet. */
 				eReturn = eReleaseBuffer;
@@ -1519,8 +1618,11 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 				/* Check sum in IP-header not correct. */
 				eReturn = eReleaseBuffer;
 			}
-			/* Is the upper-layer checksum (TCP/UDP/ICMP) correct? */
-			else if( usGenerateProtocolChecksum( ( uint8_t * )( pxNetworkBuffer->pucEthernetBuffer ), pxNetworkBuffer->xDataLength, pdFALSE ) != ipCORRECT_CRC )
+			/* Is the upper-layer checksum (TCP/UDP/ICMP) correct?  A fragment
+			only holds a part of the packet, it is checked once the datagram has
+			been reassembled. */
+			else if( ( ( pxIPHeader->usFragmentOffset & ipFRAGMENT_FLAGS_OFFSET_MASK ) == 0U ) &&
+					 ( usGenerateProtocolChecksum( ( uint8_t * )( pxNetworkBuffer->pucEthernetBuffer ), pxNetworkBuffer->xDataLength, pdFALSE ) != ipCORRECT_CRC ) )
 			{
 				/* Protocol checksum not accepted. */
 				eReturn = eReleaseBuffer;
@@ -1559,6 +1661,32 @@ uint8_t ucProtocol;
 	/* Check if the IP headers are acceptable and if it has our destination. */
 	eReturn = prvAllowIPPacket( pxIPPacket, pxNetworkBuffer, uxHeaderLength );
 
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	{
+		if( ( eReturn == eProcessBuffer ) &&
+			( ( pxIPHeader->usFragmentOffset & ipFRAGMENT_FLAGS_OFFSET_MASK ) != 0U ) )
+		{
+		NetworkBufferDescriptor_t *pxDatagram;
+
+			/* Only UDP datagrams are reassembled, the fragment itself is always
+			released.  The complete datagram is processed as if it had been
+			received in one frame, it is not a fragment any more. */
+			if( ucProtocol == ( uint8_t ) ipPROTOCOL_UDP )
+			{
+				pxDatagram = pxIPReassemble( pxNetworkBuffer );
+				if( pxDatagram != NULL )
+				{
+					if( prvProcessIPPacket( ( IPPacket_t * ) pxDatagram->pucEthernetBuffer, pxDatagram ) != eFrameConsumed )
+					{
+						vReleaseNetworkBufferAndDescriptor( pxDatagram );
+					}
+				}
+			}
+			return eReleaseBuffer;
+		}
+	}
+	#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 	if( eReturn == eProcessBuffer )
 	{
 		if( uxHeaderLength > ipSIZE_OF_IPv4_HEADER )
@@ -1694,6 +1822,46 @@ uint8_t ucProtocol;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUDP_FAST_PATH == 1 )
+
+	BaseType_t xProcessUDPFastPath( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+	{
+	UDPPacket_t *pxUDPPacket = ( UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+	const IPHeader_t *pxIPHeader = &( pxUDPPacket->xIPHeader );
+	size_t uxPayloadLength;
+
+		/* Only plain IPv4 datagrams, everything else (IP options, fragments,
+		short frames) takes the normal path through the IP-task. */
+		if( ( pxNetworkBuffer->xDataLength < sizeof( UDPPacket_t ) ) ||
+			( pxUDPPacket->xEthernetHeader.usFrameType != ipIPv4_FRAME_TYPE ) ||
+			( pxIPHeader->ucVersionHeaderLength != 0x45u ) ||
+			( pxIPHeader->ucProtocol != ( uint8_t ) ipPROTOCOL_UDP ) ||
+			( ( FreeRTOS_ntohs( pxIPHeader->usFragmentOffset ) & 0x3FFFu ) != 0u ) )
+		{
+			return pdFAIL;
+		}
+
+		/* The same checks as the IP-task: destination and checksums.  A frame
+		that fails them is left to the IP-task, which drops it. */
+		if( prvAllowIPPacket( ( const IPPacket_t * ) pxUDPPacket, pxNetworkBuffer, ipSIZE_OF_IPv4_HEADER ) != eProcessBuffer )
+		{
+			return pdFAIL;
+		}
+
+		/* The lesser of the frame length and the length in the UDP header, see
+		prvProcessIPPacket(). */
+		uxPayloadLength = pxNetworkBuffer->xDataLength - sizeof( UDPPacket_t );
+		if( ( size_t ) ( FreeRTOS_ntohs( pxUDPPacket->xUDPHeader.usLength ) - sizeof( UDPHeader_t ) ) < uxPayloadLength )
+		{
+			uxPayloadLength = FreeRTOS_ntohs( pxUDPPacket->xUDPHeader.usLength ) - sizeof( UDPHeader_t );
+		}
+
+		return xProcessReceivedUDPPacketFast( pxNetworkBuffer, pxUDPPacket->xUDPHeader.usDestinationPort, uxPayloadLength );
+	}
+
+#endif /* ipconfigUDP_FAST_PATH */
+/*-----------------------------------------------------------*/
+
 #if ( ipconfigSUPPORT_OUTGOING_PINGS == 1 )
 
 	static void prvProcessICMPEchoReply( ICMPPacket_t * const pxICMPPacket )
@@ -1947,7 +2115,7 @@ uint8_t ucProtocol;
 		( FreeRTOS_ntohs( pxIPPacket->xIPHeader.usLength ) - ( ( uint16_t ) uxIPHeaderLength ) ); /* normally minus 20 */
 
 	if( ( ulLength < sizeof( pxProtPack->xUDPPacket.xUDPHeader ) ) ||
-		( ulLength > ( uint32_t )( ipconfigNETWORK_MTU - uxIPHeaderLength ) ) )
+		( ulLength > ( uint32_t )( ipMAX_IP_DATAGRAM_LENGTH - uxIPHeaderLength ) ) )
 	{
 		#if( ipconfigHAS_DEBUG_PRINTF != 0 )
 		{
@@ -2263,6 +2431,9 @@ void FreeRTOS_UpdateMACAddress( const uint8_t ucMACAddress[ipMAC_ADDRESS_LENGTH_
 {
 	/* Copy the MAC address at the start of the default packet header fragment. */
 	memcpy( ( void * )ipLOCAL_MAC_ADDRESS, ( void * )ucMACAddress, ( size_t )ipMAC_ADDRESS_LENGTH_BYTES );
+
+	/* The cached UDP headers hold the old source address. */
+	ulARPCacheGeneration++;
 }
 /*-----------------------------------------------------------*/
 
@@ -2330,6 +2501,19 @@ void FreeRTOS_SetGatewayAddress ( uint32_t ulGatewayAddress )
 #endif /* ipconfigDNS_USE_CALLBACKS != 0 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	void vIPReassemblyTimerStart( void )
+	{
+		/* Check a few times per timeout period, a datagram lives at most
+		1.25 times the timeout. */
+		if( xReassemblyTimer.bActive == pdFALSE_UNSIGNED )
+		{
+			prvIPTimerReload( &xReassemblyTimer, pdMS_TO_TICKS( ipconfigIP_REASSEMBLY_TIMEOUT_MS / 4u ) );
+		}
+	}
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+/*-----------------------------------------------------------*/
+
 BaseType_t xIPIsNetworkTaskReady( void )
 {
 	return xIPTaskInitialised;
@@ -0,0 +1,390 @@
+/*
+ * FreeRTOS+TCP V2.0.11
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * IPv4 fragmentation of outgoing and reassembly of incoming UDP datagrams that
+ * are bigger than the MTU, up to ipconfigIP_MAX_DATAGRAM_SIZE bytes.
+ *
+ * Reassembly: a small table holds the datagrams in progress, each one in a
+ * jumbo network buffer.  The payload of every fragment is copied to its place
+ * and recorded in a bitmap of 8 byte blocks, so that duplicated and out of
+ * order fragments are handled.  A datagram that is not complete within
+ * ipconfigIP_REASSEMBLY_TIMEOUT_MS is dropped.
+ *
+ * Fragmentation: each fragment gets its own small buffer with the Ethernet and
+ * IP headers, the payload is sent in place from the datagram buffer with
+ * xNetworkInterfaceOutputSG().  The datagram buffer is released when the last
+ * fragment has left.
+ *
+ * Everything runs in the IP-task, except the completion callback of the
+ * fragments which runs in the network interface task.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+
+/* Fields of usFragmentOffset, in host order. */
+#define ipFRAGMENT_MORE_FRAGMENTS		( ( uint16_t ) 0x2000u )
+#define ipFRAGMENT_OFFSET_MASK			( ( uint16_t ) 0x1FFFu )
+
+/* Fragment offsets count in blocks of 8 bytes. */
+#define ipFRAGMENT_BLOCK_SIZE			( 8u )
+
+/* The largest payload (behind the IP header) of a reassembled datagram. */
+#define ipMAX_REASSEMBLED_PAYLOAD		( ipconfigIP_MAX_DATAGRAM_SIZE - ipSIZE_OF_IPv4_HEADER )
+#define ipREASSEMBLY_BLOCKS				( ( ipMAX_REASSEMBLED_PAYLOAD + ipFRAGMENT_BLOCK_SIZE - 1u ) / ipFRAGMENT_BLOCK_SIZE )
+
+/* The payload of an outgoing fragment, a multiple of 8 bytes. */
+#define ipFRAGMENT_PAYLOAD_SIZE			( ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER ) & ~( ipFRAGMENT_BLOCK_SIZE - 1u ) )
+
+#define ipFRAGMENT_HEADERS_SIZE			( ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER )
+
+#if( ipconfigJUMBO_NETWORK_BUFFER_SIZE < ( ipSIZE_OF_ETH_HEADER + ipconfigIP_MAX_DATAGRAM_SIZE ) )
+	#error ipconfigJUMBO_NETWORK_BUFFER_SIZE must hold an Ethernet header and ipconfigIP_MAX_DATAGRAM_SIZE
+#endif
+
+typedef struct xIP_REASSEMBLY
+{
+	NetworkBufferDescriptor_t *pxDatagram;	/* NULL while the slot is free. */
+	uint32_t ulSourceIPAddress;				/* Network order. */
+	uint16_t usIdentification;				/* Network order. */
+	size_t uxPayloadLength;					/* Known when the last fragment has arrived, 0 before. */
+	UBaseType_t uxBlocksReceived;
+	TickType_t xStartTime;
+	uint32_t ulBlocks[ ( ipREASSEMBLY_BLOCKS + 31u ) / 32u ];
+} IPReassembly_t;
+
+static IPReassembly_t xReassembly[ ipconfigIP_REASSEMBLY_SLOTS ];
+
+/*
+ * Frees a reassembly slot, the datagram buffer is released.
+ */
+static void prvReassemblyDrop( IPReassembly_t *pxSlot );
+
+/*
+ * Finds the slot of the datagram that the fragment belongs to, or starts a new
+ * one.  NULL when all slots are busy or there is no jumbo buffer.
+ */
+static IPReassembly_t *prvReassemblySlot( const IPPacket_t *pxIPPacket );
+
+/*
+ * Called by the network interface when a fragment has been sent, and by
+ * vIPFragmentAndSend() for the fragments that could not be queued.
+ */
+static void prvFragmentSent( void *pvArg );
+static void prvDatagramRelease( NetworkBufferDescriptor_t *pxDatagram, size_t uxReferences );
+
+/*-----------------------------------------------------------*/
+
+static void prvReassemblyDrop( IPReassembly_t *pxSlot )
+{
+	vReleaseNetworkBufferAndDescriptor( pxSlot->pxDatagram );
+	pxSlot->pxDatagram = NULL;
+}
+/*-----------------------------------------------------------*/
+
+static IPReassembly_t *prvReassemblySlot( const IPPacket_t *pxIPPacket )
+{
+const IPHeader_t *pxIPHeader = &( pxIPPacket->xIPHeader );
+IPReassembly_t *pxFree = NULL;
+BaseType_t xIndex;
+
+	for( xIndex = 0; xIndex < ipconfigIP_REASSEMBLY_SLOTS; xIndex++ )
+	{
+		if( xReassembly[ xIndex ].pxDatagram == NULL )
+		{
+			if( pxFree == NULL )
+			{
+				pxFree = &( xReassembly[ xIndex ] );
+			}
+		}
+		else if( ( xReassembly[ xIndex ].ulSourceIPAddress == pxIPHeader->ulSourceIPAddress ) &&
+				 ( xReassembly[ xIndex ].usIdentification == pxIPHeader->usIdentification ) )
+		{
+			return &( xReassembly[ xIndex ] );
+		}
+	}
+
+	if( pxFree != NULL )
+	{
+		pxFree->pxDatagram = pxGetNetworkBufferWithDescriptor( ipSIZE_OF_ETH_HEADER + ipconfigIP_MAX_DATAGRAM_SIZE, 0 );
+		if( pxFree->pxDatagram == NULL )
+		{
+			pxFree = NULL;
+		}
+		else
+		{
+			/* The headers of the first fragment to arrive are kept, the
+			datagram fields are rewritten once it is complete. */
+			memcpy( pxFree->pxDatagram->pucEthernetBuffer, pxIPPacket, sizeof( IPPacket_t ) );
+			pxFree->ulSourceIPAddress = pxIPHeader->ulSourceIPAddress;
+			pxFree->usIdentification = pxIPHeader->usIdentification;
+			pxFree->uxPayloadLength = 0u;
+			pxFree->uxBlocksReceived = 0u;
+			pxFree->xStartTime = xTaskGetTickCount();
+			memset( pxFree->ulBlocks, 0, sizeof( pxFree->ulBlocks ) );
+			vIPReassemblyTimerStart();
+		}
+	}
+
+	return pxFree;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxIPReassemble( const NetworkBufferDescriptor_t * const pxFragment )
+{
+const IPPacket_t *pxIPPacket = ( const IPPacket_t * ) pxFragment->pucEthernetBuffer;
+const IPHeader_t *pxIPHeader = &( pxIPPacket->xIPHeader );
+size_t uxHeaderLength = ( size_t ) ( ( pxIPHeader->ucVersionHeaderLength & 0x0Fu ) << 2 );
+size_t uxTotalLength = ( size_t ) FreeRTOS_ntohs( pxIPHeader->usLength );
+uint16_t usFlagsOffset = FreeRTOS_ntohs( pxIPHeader->usFragmentOffset );
+size_t uxOffset, uxLength, uxBlock, uxLastBlock;
+IPReassembly_t *pxSlot;
+IPHeader_t *pxDatagramHeader;
+NetworkBufferDescriptor_t *pxReturn = NULL;
+
+	/* The frame may be longer than the IP packet because of the Ethernet
+	padding, never shorter.  All fragments but the last one carry a multiple of
+	8 bytes. */
+	if( ( uxTotalLength <= uxHeaderLength ) ||
+		( ( uxTotalLength + ipSIZE_OF_ETH_HEADER ) > pxFragment->xDataLength ) )
+	{
+		return NULL;
+	}
+	uxOffset = ( size_t ) ( usFlagsOffset & ipFRAGMENT_OFFSET_MASK ) * ipFRAGMENT_BLOCK_SIZE;
+	uxLength = uxTotalLength - uxHeaderLength;
+	if( ( ( uxOffset + uxLength ) > ipMAX_REASSEMBLED_PAYLOAD ) ||
+		( ( ( usFlagsOffset & ipFRAGMENT_MORE_FRAGMENTS ) != 0u ) && ( ( uxLength % ipFRAGMENT_BLOCK_SIZE ) != 0u ) ) )
+	{
+		iptraceIP_FRAGMENT_DROPPED( pxFragment );
+		return NULL;
+	}
+
+	pxSlot = prvReassemblySlot( pxIPPacket );
+	if( pxSlot == NULL )
+	{
+		iptraceIP_FRAGMENT_DROPPED( pxFragment );
+		return NULL;
+	}
+
+	memcpy( pxSlot->pxDatagram->pucEthernetBuffer + ipFRAGMENT_HEADERS_SIZE + uxOffset,
+		pxFragment->pucEthernetBuffer + ipSIZE_OF_ETH_HEADER + uxHeaderLength, uxLength );
+
+	/* A block that was received before is not counted twice, the data of the
+	last copy is kept. */
+	uxLastBlock = ( uxOffset + uxLength + ipFRAGMENT_BLOCK_SIZE - 1u ) / ipFRAGMENT_BLOCK_SIZE;
+	for( uxBlock = uxOffset / ipFRAGMENT_BLOCK_SIZE; uxBlock < uxLastBlock; uxBlock++ )
+	{
+		if( ( pxSlot->ulBlocks[ uxBlock / 32u ] & ( 1UL << ( uxBlock % 32u ) ) ) == 0u )
+		{
+			pxSlot->ulBlocks[ uxBlock / 32u ] |= ( 1UL << ( uxBlock % 32u ) );
+			pxSlot->uxBlocksReceived++;
+		}
+	}
+	if( ( usFlagsOffset & ipFRAGMENT_MORE_FRAGMENTS ) == 0u )
+	{
+		pxSlot->uxPayloadLength = uxOffset + uxLength;
+	}
+
+	if( ( pxSlot->uxPayloadLength != 0u ) &&
+		( pxSlot->uxBlocksReceived == ( ( pxSlot->uxPayloadLength + ipFRAGMENT_BLOCK_SIZE - 1u ) / ipFRAGMENT_BLOCK_SIZE ) ) )
+	{
+		pxReturn = pxSlot->pxDatagram;
+		pxSlot->pxDatagram = NULL;
+
+		/* The datagram has a plain 20 byte header now, IP options of the
+		fragments are not kept. */
+		pxDatagramHeader = &( ( ( IPPacket_t * ) pxReturn->pucEthernetBuffer )->xIPHeader );
+		pxDatagramHeader->ucVersionHeaderLength = ( uint8_t ) 0x45u;
+		pxDatagramHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + pxSlot->uxPayloadLength ) );
+		pxDatagramHeader->usFragmentOffset = 0u;
+		pxDatagramHeader->usHeaderChecksum = 0u;
+		pxDatagramHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxDatagramHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+		pxDatagramHeader->usHeaderChecksum = ~FreeRTOS_htons( pxDatagramHeader->usHeaderChecksum );
+		pxReturn->xDataLength = ipFRAGMENT_HEADERS_SIZE + pxSlot->uxPayloadLength;
+
+		#if( ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM != 0 )
+		{
+			/* The MAC can not check the protocol checksum of a fragment.
+			Without offloading prvAllowIPPacket() checks the datagram. */
+			if( usGenerateProtocolChecksum( pxReturn->pucEthernetBuffer, pxReturn->xDataLength, pdFALSE ) != ipCORRECT_CRC )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxReturn );
+				pxReturn = NULL;
+			}
+		}
+		#endif /* ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM */
+
+		if( pxReturn != NULL )
+		{
+			iptraceIP_DATAGRAM_REASSEMBLED( pxReturn );
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIPReassemblyCheck( void )
+{
+BaseType_t xIndex, xPending = pdFALSE;
+TickType_t xNow = xTaskGetTickCount();
+
+	for( xIndex = 0; xIndex < ipconfigIP_REASSEMBLY_SLOTS; xIndex++ )
+	{
+		if( xReassembly[ xIndex ].pxDatagram != NULL )
+		{
+			if( ( xNow - xReassembly[ xIndex ].xStartTime ) >= pdMS_TO_TICKS( ipconfigIP_REASSEMBLY_TIMEOUT_MS ) )
+			{
+				iptraceIP_REASSEMBLY_TIMEOUT( xReassembly[ xIndex ].pxDatagram );
+				prvReassemblyDrop( &( xReassembly[ xIndex ] ) );
+			}
+			else
+			{
+				xPending = pdTRUE;
+			}
+		}
+	}
+
+	return xPending;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDatagramRelease( NetworkBufferDescriptor_t *pxDatagram, size_t uxReferences )
+{
+size_t uxLeft;
+
+	/* While its fragments are queued, xDataLength of the datagram buffer
+	counts the references to it. */
+	taskENTER_CRITICAL();
+	{
+		pxDatagram->xDataLength -= uxReferences;
+		uxLeft = pxDatagram->xDataLength;
+	}
+	taskEXIT_CRITICAL();
+
+	if( uxLeft == 0u )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxDatagram );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvFragmentSent( void *pvArg )
+{
+	prvDatagramRelease( ( NetworkBufferDescriptor_t * ) pvArg, 1u );
+}
+/*-----------------------------------------------------------*/
+
+void vIPFragmentAndSend( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+IPPacket_t *pxIPPacket = ( IPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+const uint8_t *pucPayload = pxNetworkBuffer->pucEthernetBuffer + ipFRAGMENT_HEADERS_SIZE;
+size_t uxPayloadLength = pxNetworkBuffer->xDataLength - ipFRAGMENT_HEADERS_SIZE;
+size_t uxFragments = ( uxPayloadLength + ipFRAGMENT_PAYLOAD_SIZE - 1u ) / ipFRAGMENT_PAYLOAD_SIZE;
+size_t uxQueued = 0u, uxOffset, uxLength;
+uint16_t usFlagsOffset;
+NetworkBufferDescriptor_t *pxHeaderBuffer;
+IPHeader_t *pxFragmentHeader;
+
+	#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM != 0 )
+	{
+		/* The protocol checksum covers the whole datagram and is computed
+		here.  The network interface turns the protocol checksum insertion
+		of the MAC off for the fragments, it would be computed over the
+		fragment alone. */
+		( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxIPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+	}
+	#endif /* ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM */
+
+	pxIPPacket->xIPHeader.usIdentification = FreeRTOS_htons( usPacketIdentifier );
+	usPacketIdentifier++;
+
+	/* One reference per fragment, and one held until all are queued so that
+	a fragment sent early does not release the buffer. */
+	pxNetworkBuffer->xDataLength = uxFragments + 1u;
+
+	for( uxOffset = 0u; uxOffset < uxPayloadLength; uxOffset += uxLength )
+	{
+		uxLength = uxPayloadLength - uxOffset;
+		usFlagsOffset = ( uint16_t ) ( uxOffset / ipFRAGMENT_BLOCK_SIZE );
+		if( uxLength > ipFRAGMENT_PAYLOAD_SIZE )
+		{
+			uxLength = ipFRAGMENT_PAYLOAD_SIZE;
+			usFlagsOffset |= ipFRAGMENT_MORE_FRAGMENTS;
+		}
+
+		pxHeaderBuffer = pxGetNetworkBufferWithDescriptor( ipFRAGMENT_HEADERS_SIZE, 0 );
+		if( pxHeaderBuffer == NULL )
+		{
+			break;
+		}
+		memcpy( pxHeaderBuffer->pucEthernetBuffer, pxIPPacket, ipFRAGMENT_HEADERS_SIZE );
+		pxFragmentHeader = &( ( ( IPPacket_t * ) pxHeaderBuffer->pucEthernetBuffer )->xIPHeader );
+		pxFragmentHeader->usLength = FreeRTOS_htons( ( uint16_t ) ( ipSIZE_OF_IPv4_HEADER + uxLength ) );
+		pxFragmentHeader->usFragmentOffset = FreeRTOS_htons( usFlagsOffset );
+		pxFragmentHeader->usHeaderChecksum = 0u;
+		#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+		{
+			pxFragmentHeader->usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxFragmentHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+			pxFragmentHeader->usHeaderChecksum = ~FreeRTOS_htons( pxFragmentHeader->usHeaderChecksum );
+		}
+		#endif /* ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM */
+
+		if( xNetworkInterfaceOutputSG( pxHeaderBuffer, pucPayload + uxOffset, uxLength, prvFragmentSent, pxNetworkBuffer ) == pdFAIL )
+		{
+			break;
+		}
+		uxQueued++;
+	}
+
+	if( uxQueued != uxFragments )
+	{
+		/* The peer drops the incomplete datagram when its reassembly times
+		out. */
+		iptraceIP_FRAGMENTATION_FAILED( pxNetworkBuffer );
+	}
+
+	/* Drop the references of the fragments that were not queued, and the one
+	held here. */
+	prvDatagramRelease( pxNetworkBuffer, ( uxFragments - uxQueued ) + 1u );
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
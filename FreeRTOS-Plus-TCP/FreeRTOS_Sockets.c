@@ -132,6 +132,30 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static int32_t prvTCPSendCheck( FreeRTOS_Socket_t *pxSocket, size_t xDataLength );
 #endif /* ipconfigUSE_TCP */
 
+#if( ipconfigUSE_TCP == 1 )
+	/*
+	 * Return the number of bytes that may be added to the txStream.  'pucFile'
+	 * is the address of the next byte for FreeRTOS_sendfile(), or NULL for
+	 * ordinary data.  Both kinds can not be mixed in the txStream.
+	 */
+	static size_t prvTCPSendSpace( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucFile );
+#endif /* ipconfigUSE_TCP */
+
+#if( ipconfigUSE_TCP == 1 )
+	/*
+	 * The common part of FreeRTOS_send() and FreeRTOS_sendfile().
+	 */
+	static BaseType_t prvTCPSend( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucData, size_t uxDataLength, BaseType_t xFlags, BaseType_t xFromFile );
+#endif /* ipconfigUSE_TCP */
+
+#if( ipconfigUSE_TCP == 1 )
+	/*
+	 * Called after data has been taken from the rxStream: if the low-water mark
+	 * had been reached, see if the peer can be told about the new space.
+	 */
+	static void prvTCPCheckLowWater( FreeRTOS_Socket_t *pxSocket );
+#endif /* ipconfigUSE_TCP */
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * When a child socket gets closed, make sure to update the child-count of the parent
@@ -585,33 +609,19 @@ Socket_t xReturn;
 /*-----------------------------------------------------------*/
 
 	/*
- * FreeRTOS_recvfrom: receive data from a bound socket
- * In this library, the function can only be used with connectionsless sockets
- * (UDP)
+ * Wait until datagrams are queued on a UDP socket, for the receive block time
+ * unless FREERTOS_MSG_DONTWAIT is set. Returns the number of queued datagrams.
  */
-	extern void getPTPUsrTime(int32_t *const second, int32_t *const nanoSecond);
-	int32_t FreeRTOS_recvfrom(Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, int32_t *const time_s, int32_t *const time_ns)
+	static BaseType_t prvWaitForUDPPackets(FreeRTOS_Socket_t *pxSocket, BaseType_t xFlags, EventBits_t *pxEventBits)
 	{
-		BaseType_t lPacketCount = 0;
-		NetworkBufferDescriptor_t *pxNetworkBuffer;
-		FreeRTOS_Socket_t *pxSocket = (FreeRTOS_Socket_t *)xSocket;
+		BaseType_t lPacketCount;
 		TickType_t xRemainingTime = (TickType_t)0; /* Obsolete assignment, but some compilers output a warning if its not done. */
 		BaseType_t xTimed = pdFALSE;
 		TimeOut_t xTimeOut;
-		int32_t lReturn;
 		EventBits_t xEventBits = (EventBits_t)0;
 
-		if (prvValidSocket(pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE) == pdFALSE)
-		{
-			return -pdFREERTOS_ERRNO_EINVAL;
-		}
-
 		lPacketCount = (BaseType_t)listCURRENT_LIST_LENGTH(&(pxSocket->u.xUDP.xWaitingPacketsList));
 
-		/* The function prototype is designed to maintain the expected Berkeley
-	sockets standard, but this implementation does not use all the parameters. */
-		//(void)pxSourceAddressLength;
-
 		while (lPacketCount == 0)
 		{
 			if (xTimed == pdFALSE)
@@ -682,6 +692,32 @@ Socket_t xReturn;
 			}
 		} /* while( lPacketCount == 0 ) */
 
+		*pxEventBits = xEventBits;
+		return lPacketCount;
+	}
+	/*-----------------------------------------------------------*/
+
+	/*
+ * FreeRTOS_recvfrom: receive data from a bound socket
+ * In this library, the function can only be used with connectionsless sockets
+ * (UDP)
+ */
+	extern void getPTPUsrTime(int32_t *const second, int32_t *const nanoSecond);
+	int32_t FreeRTOS_recvfrom(Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, int32_t *const time_s, int32_t *const time_ns)
+	{
+		BaseType_t lPacketCount = 0;
+		NetworkBufferDescriptor_t *pxNetworkBuffer;
+		FreeRTOS_Socket_t *pxSocket = (FreeRTOS_Socket_t *)xSocket;
+		int32_t lReturn;
+		EventBits_t xEventBits;
+
+		if (prvValidSocket(pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE) == pdFALSE)
+		{
+			return -pdFREERTOS_ERRNO_EINVAL;
+		}
+
+		lPacketCount = prvWaitForUDPPackets(pxSocket, xFlags, &xEventBits);
+
 		if (lPacketCount != 0)
 		{
 			taskENTER_CRITICAL();
@@ -698,6 +734,8 @@ Socket_t xReturn;
 			}
 			taskEXIT_CRITICAL();
 
+			iptraceUDP_APPLICATION_RECEIVE( pxNetworkBuffer );
+
 			/* The returned value is the data length, which may have been capped to
 		the receive buffer size. */
 			lReturn = (int32_t)pxNetworkBuffer->xDataLength;
@@ -755,6 +793,76 @@ Socket_t xReturn;
 		return lReturn;
 	}
 	/*-----------------------------------------------------------*/
+
+	int32_t FreeRTOS_recvmmsg(Socket_t xSocket, struct freertos_mmsghdr *pxMessages, size_t uxCount, BaseType_t xFlags, int32_t *const time_s, int32_t *const time_ns)
+	{
+		BaseType_t lPacketCount;
+		BaseType_t lIndex;
+		NetworkBufferDescriptor_t *pxNetworkBuffer;
+		FreeRTOS_Socket_t *pxSocket = (FreeRTOS_Socket_t *)xSocket;
+		int32_t lReturn;
+		EventBits_t xEventBits;
+
+		if ((prvValidSocket(pxSocket, FREERTOS_IPPROTO_UDP, pdTRUE) == pdFALSE) || (pxMessages == NULL) || (uxCount == 0u))
+		{
+			return -pdFREERTOS_ERRNO_EINVAL;
+		}
+
+		lPacketCount = prvWaitForUDPPackets(pxSocket, xFlags, &xEventBits);
+
+		if (lPacketCount != 0)
+		{
+			if (lPacketCount > (BaseType_t)uxCount)
+			{
+				lPacketCount = (BaseType_t)uxCount;
+			}
+
+			/* One critical section for the whole batch, the descriptors are
+		parked in pvData until the payload pointers are filled in. */
+			taskENTER_CRITICAL();
+			{
+				for (lIndex = 0; lIndex < lPacketCount; lIndex++)
+				{
+					pxNetworkBuffer = (NetworkBufferDescriptor_t *)listGET_OWNER_OF_HEAD_ENTRY(&(pxSocket->u.xUDP.xWaitingPacketsList));
+					uxListRemove(&(pxNetworkBuffer->xBufferListItem));
+					pxMessages[lIndex].pvData = pxNetworkBuffer;
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			for (lIndex = 0; lIndex < lPacketCount; lIndex++)
+			{
+				pxNetworkBuffer = (NetworkBufferDescriptor_t *)pxMessages[lIndex].pvData;
+				iptraceUDP_APPLICATION_RECEIVE( pxNetworkBuffer );
+				pxMessages[lIndex].pvData = (void *)(&(pxNetworkBuffer->pucEthernetBuffer[ipUDP_PAYLOAD_OFFSET_IPv4]));
+				pxMessages[lIndex].xLength = pxNetworkBuffer->xDataLength;
+				pxMessages[lIndex].xAddress.sin_port = pxNetworkBuffer->usPort;
+				pxMessages[lIndex].xAddress.sin_addr = pxNetworkBuffer->ulIPAddress;
+			}
+			if ((NULL != time_s) && (NULL != time_ns))
+			{
+				getPTPUsrTime(time_s, time_ns);
+			}
+			lReturn = (int32_t)lPacketCount;
+		}
+#if (ipconfigSUPPORT_SIGNALS != 0)
+		else if ((xEventBits & eSOCKET_INTR) != 0)
+		{
+			lReturn = -pdFREERTOS_ERRNO_EINTR;
+			iptraceRECVFROM_INTERRUPTED();
+		}
+#endif /* ipconfigSUPPORT_SIGNALS */
+		else
+		{
+			(void)xEventBits;
+			lReturn = -pdFREERTOS_ERRNO_EWOULDBLOCK;
+			iptraceRECVFROM_TIMEOUT();
+		}
+
+		return lReturn;
+	}
+	/*-----------------------------------------------------------*/
+
 	int32_t FreeRTOS_sendto(Socket_t xSocket, const void *pvBuffer, size_t xTotalDataLength, BaseType_t xFlags, const struct freertos_sockaddr *pxDestinationAddress, int32_t *const time_s, int32_t *const time_ns)
 	{
 		NetworkBufferDescriptor_t *pxNetworkBuffer;
@@ -895,6 +1003,104 @@ Socket_t xReturn;
 	} /* Tested */
 	/*-----------------------------------------------------------*/
 
+	int32_t FreeRTOS_sendmmsg(Socket_t xSocket, const struct freertos_mmsghdr *pxMessages, size_t uxCount, BaseType_t xFlags, const struct freertos_sockaddr *pxDestinationAddress)
+	{
+		NetworkBufferDescriptor_t *pxNetworkBuffer;
+		NetworkBufferDescriptor_t *pxPreviousBuffer = NULL;
+		IPStackEvent_t xStackTxEvent = {eStackTxBatchEvent, NULL};
+		TickType_t xTicksToWait;
+		FreeRTOS_Socket_t *pxSocket = (FreeRTOS_Socket_t *)xSocket;
+		size_t uxIndex;
+		int32_t lReturn = 0;
+
+		if ((prvValidSocket(pxSocket, FREERTOS_IPPROTO_UDP, pdFALSE) == pdFALSE) || (pxMessages == NULL) || (uxCount == 0u))
+		{
+			return -pdFREERTOS_ERRNO_EINVAL;
+		}
+
+		for (uxIndex = 0; uxIndex < uxCount; uxIndex++)
+		{
+			if (pxMessages[uxIndex].xLength > (size_t)ipMAX_UDP_PAYLOAD_LENGTH)
+			{
+				iptraceSENDTO_DATA_TOO_LONG();
+				return -pdFREERTOS_ERRNO_EINVAL;
+			}
+		}
+
+		if ((socketSOCKET_IS_BOUND(pxSocket) != pdFALSE) ||
+			(FreeRTOS_bind(xSocket, NULL, 0u) == 0))
+		{
+			xTicksToWait = pxSocket->xSendBlockTime;
+
+#if (ipconfigUSE_CALLBACKS != 0)
+			{
+				if (xIsCallingFromIPTask() != pdFALSE)
+				{
+					/* May not block in a call-back handler, see FreeRTOS_sendto(). */
+					xTicksToWait = (TickType_t)0;
+				}
+			}
+#endif /* ipconfigUSE_CALLBACKS */
+
+			if ((xFlags & FREERTOS_MSG_DONTWAIT) != 0)
+			{
+				xTicksToWait = (TickType_t)0;
+			}
+
+			/* Chain the buffers in order, the IP-task sends them as they are
+		linked. */
+			for (uxIndex = 0; uxIndex < uxCount; uxIndex++)
+			{
+				pxNetworkBuffer = pxUDPPayloadBuffer_to_NetworkBuffer(pxMessages[uxIndex].pvData);
+				configASSERT(pxNetworkBuffer != NULL);
+				pxNetworkBuffer->xDataLength = pxMessages[uxIndex].xLength;
+				pxNetworkBuffer->usPort = pxDestinationAddress->sin_port;
+				pxNetworkBuffer->usBoundPort = (uint16_t)socketGET_SOCKET_PORT(pxSocket);
+				pxNetworkBuffer->ulIPAddress = pxDestinationAddress->sin_addr;
+				pxNetworkBuffer->pucEthernetBuffer[ipSOCKET_OPTIONS_OFFSET] = pxSocket->ucSocketOptions;
+				ipSET_NEXT_BATCH_BUFFER(pxNetworkBuffer, NULL);
+
+				if (pxPreviousBuffer == NULL)
+				{
+					xStackTxEvent.pvData = pxNetworkBuffer;
+				}
+				else
+				{
+					ipSET_NEXT_BATCH_BUFFER(pxPreviousBuffer, pxNetworkBuffer);
+				}
+				pxPreviousBuffer = pxNetworkBuffer;
+			}
+
+			if (xSendEventStructToIPTask(&xStackTxEvent, xTicksToWait) == pdPASS)
+			{
+				lReturn = (int32_t)uxCount;
+#if (ipconfigUSE_CALLBACKS == 1)
+				{
+					if (ipconfigIS_VALID_PROG_ADDRESS(pxSocket->u.xUDP.pxHandleSent))
+					{
+						for (uxIndex = 0; uxIndex < uxCount; uxIndex++)
+						{
+							pxSocket->u.xUDP.pxHandleSent((Socket_t *)pxSocket, pxMessages[uxIndex].xLength);
+						}
+					}
+				}
+#endif /* ipconfigUSE_CALLBACKS */
+			}
+			else
+			{
+				/* The buffers are still owned by the caller. */
+				iptraceSTACK_TX_EVENT_LOST(ipSTACK_TX_EVENT);
+			}
+		}
+		else
+		{
+			iptraceSENDTO_SOCKET_NOT_BOUND();
+		}
+
+		return lReturn;
+	}
+	/*-----------------------------------------------------------*/
+
 	/*
  * FreeRTOS_bind() : binds a sockt to a local port number.  If port 0 is
  * provided, a system provided port number will be assigned.  This function can
@@ -1051,7 +1257,7 @@ List_t *pxSocketList;
 				/* If the network driver can iterate through 'xBoundUDPSocketsList',
 				by calling xPortHasUDPSocket() then the IP-task must temporarily
 				suspend the scheduler to keep the list in a consistent state. */
-				#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+				#if( ( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 ) || ( ipconfigETHERNET_DRIVER_FILTERS_PORTS == 1 ) || ( ipconfigUDP_FAST_PATH == 1 ) )
 				{
 					vTaskSuspendAll();
 				}
@@ -1060,11 +1266,17 @@ List_t *pxSocketList;
 				/* Add the socket to 'xBoundUDPSocketsList' or 'xBoundTCPSocketsList' */
 				vListInsertEnd( pxSocketList, &( pxSocket->xBoundSocketListItem ) );
 
-				#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+				#if( ( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 ) || ( ipconfigETHERNET_DRIVER_FILTERS_PORTS == 1 ) || ( ipconfigUDP_FAST_PATH == 1 ) )
 				{
 					xTaskResumeAll();
 				}
 				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
+
+				#if( ipconfigETHERNET_DRIVER_FILTERS_PORTS == 1 )
+				{
+					vNetworkInterfaceBoundPortsChanged();
+				}
+				#endif /* ipconfigETHERNET_DRIVER_FILTERS_PORTS */
 			}
 		}
 	}
@@ -1185,7 +1397,7 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 		/* If the network driver can iterate through 'xBoundUDPSocketsList',
 		by calling xPortHasUDPSocket(), then the IP-task must temporarily
 		suspend the scheduler to keep the list in a consistent state. */
-		#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+		#if( ( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 ) || ( ipconfigETHERNET_DRIVER_FILTERS_PORTS == 1 ) || ( ipconfigUDP_FAST_PATH == 1 ) )
 		{
 			vTaskSuspendAll();
 		}
@@ -1193,11 +1405,17 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 
 		uxListRemove( &( pxSocket->xBoundSocketListItem ) );
 
-		#if( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 )
+		#if( ( ipconfigETHERNET_DRIVER_FILTERS_PACKETS == 1 ) || ( ipconfigETHERNET_DRIVER_FILTERS_PORTS == 1 ) || ( ipconfigUDP_FAST_PATH == 1 ) )
 		{
 			xTaskResumeAll();
 		}
 		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PACKETS */
+
+		#if( ipconfigETHERNET_DRIVER_FILTERS_PORTS == 1 )
+		{
+			vNetworkInterfaceBoundPortsChanged();
+		}
+		#endif /* ipconfigETHERNET_DRIVER_FILTERS_PORTS */
 	}
 
 	/* Now the socket is not bound the list of waiting packets can be
@@ -1333,6 +1551,17 @@ FreeRTOS_Socket_t *pxSocket;
 				break;
 		#endif /* ipconfigUDP_MAX_RX_PACKETS */
 
+		#if( ipconfigUDP_FAST_PATH == 1 )
+			case FREERTOS_SO_UDP_FAST_PATH:
+				if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_UDP )
+				{
+					break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+				}
+				pxSocket->u.xUDP.xFastPath = ( *( ( BaseType_t * ) pvOptionValue ) != pdFALSE ) ? pdTRUE : pdFALSE;
+				xReturn = 0;
+				break;
+		#endif /* ipconfigUDP_FAST_PATH */
+
 		case FREERTOS_SO_UDPCKSUM_OUT :
 			/* Turn calculating of the UDP checksum on/off for this socket. */
 			lOptionValue = ( BaseType_t ) pvOptionValue;
@@ -1735,6 +1964,70 @@ FreeRTOS_Socket_t *pxSocket = NULL;
 
 /*-----------------------------------------------------------*/
 
+#if( ipconfigETHERNET_DRIVER_FILTERS_PORTS == 1 )
+
+	UBaseType_t uxSocketGetBoundPorts( BaseType_t xProtocol, uint16_t *pusPorts, UBaseType_t uxMaxPorts )
+	{
+	const List_t *pxList;
+	const ListItem_t *pxIterator;
+	const MiniListItem_t *pxEnd;
+	uint16_t usPort;
+	UBaseType_t uxCount = 0u, uxIndex;
+
+		#if( ipconfigUSE_TCP == 1 )
+		if( xProtocol == ( BaseType_t ) FREERTOS_IPPROTO_TCP )
+		{
+			pxList = &xBoundTCPSocketsList;
+		}
+		else
+		#endif /* ipconfigUSE_TCP */
+		{
+			pxList = &xBoundUDPSocketsList;
+		}
+
+		if( listLIST_IS_INITIALISED( pxList ) != pdFALSE )
+		{
+			/* The lists are changed by the IP-task with the scheduler
+			suspended, see vSocketBind(). */
+			vTaskSuspendAll();
+			{
+				pxEnd = ( const MiniListItem_t * ) listGET_END_MARKER( pxList );
+				for( pxIterator = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+					 pxIterator != ( const ListItem_t * ) pxEnd;
+					 pxIterator = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+				{
+					usPort = FreeRTOS_ntohs( ( uint16_t ) listGET_LIST_ITEM_VALUE( pxIterator ) );
+
+					/* TCP child sockets share the port of their listening socket. */
+					for( uxIndex = 0u; uxIndex < uxCount; uxIndex++ )
+					{
+						if( pusPorts[ uxIndex ] == usPort )
+						{
+							break;
+						}
+					}
+
+					if( uxIndex == uxCount )
+					{
+						if( uxCount >= uxMaxPorts )
+						{
+							/* Too many ports, the caller can not filter. */
+							uxCount = uxMaxPorts + 1u;
+							break;
+						}
+						pusPorts[ uxCount++ ] = usPort;
+					}
+				}
+			}
+			( void ) xTaskResumeAll();
+		}
+
+		return uxCount;
+	}
+
+#endif /* ipconfigETHERNET_DRIVER_FILTERS_PORTS */
+/*-----------------------------------------------------------*/
+
 #if ipconfigINCLUDE_FULL_INET_ADDR == 1
 
 	uint32_t FreeRTOS_inet_addr( const char * pcIPAddress )
@@ -2337,24 +2630,13 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				if( ( xFlags & FREERTOS_ZERO_COPY ) == 0 )
 				{
 					xByteCount = ( BaseType_t ) uxStreamBufferGet( pxSocket->u.xTCP.rxStream, 0ul, ( uint8_t * ) pvBuffer, ( size_t ) xBufferLength, ( xFlags & FREERTOS_MSG_PEEK ) != 0 );
-					if( pxSocket->u.xTCP.bits.bLowWater != pdFALSE_UNSIGNED )
-					{
-						/* We had reached the low-water mark, now see if the flag
-						can be cleared */
-						size_t uxFrontSpace = uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
-
-						if( uxFrontSpace >= pxSocket->u.xTCP.uxEnoughSpace )
-						{
-							pxSocket->u.xTCP.bits.bLowWater = pdFALSE_UNSIGNED;
-							pxSocket->u.xTCP.bits.bWinChange = pdTRUE_UNSIGNED;
-							pxSocket->u.xTCP.usTimeout = 1u; /* because bLowWater is cleared. */
-							xSendEventToIPTask( eTCPTimerEvent );
-						}
-					}
+					prvTCPCheckLowWater( pxSocket );
 				}
 				else
 				{
-					/* Zero-copy reception of data: pvBuffer is a pointer to a pointer. */
+					/* Zero-copy reception of data: pvBuffer is a pointer to a
+					pointer.  The data must be released by calling
+					FreeRTOS_rx_release(). */
 					xByteCount = ( BaseType_t ) uxStreamBufferGetPtr( pxSocket->u.xTCP.rxStream, (uint8_t **)pvBuffer );
 				}
 			}
@@ -2366,6 +2648,58 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 )
+
+	static void prvTCPCheckLowWater( FreeRTOS_Socket_t *pxSocket )
+	{
+		if( pxSocket->u.xTCP.bits.bLowWater != pdFALSE_UNSIGNED )
+		{
+			/* We had reached the low-water mark, now see if the flag
+			can be cleared */
+			size_t uxFrontSpace = uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
+
+			if( uxFrontSpace >= pxSocket->u.xTCP.uxEnoughSpace )
+			{
+				pxSocket->u.xTCP.bits.bLowWater = pdFALSE_UNSIGNED;
+				pxSocket->u.xTCP.bits.bWinChange = pdTRUE_UNSIGNED;
+				pxSocket->u.xTCP.usTimeout = 1u; /* because bLowWater is cleared. */
+				xSendEventToIPTask( eTCPTimerEvent );
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	/* Release data that was obtained with FreeRTOS_recv( FREERTOS_ZERO_COPY ). */
+	BaseType_t FreeRTOS_rx_release( Socket_t xSocket, size_t uxCount )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	BaseType_t xByteCount;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
+		{
+			xByteCount = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else if( pxSocket->u.xTCP.rxStream == NULL )
+		{
+			xByteCount = 0;
+		}
+		else
+		{
+			/* Only advance the tail marker. */
+			xByteCount = ( BaseType_t ) uxStreamBufferGet( pxSocket->u.xTCP.rxStream, 0ul, NULL, uxCount, pdFALSE );
+			prvTCPCheckLowWater( pxSocket );
+		}
+
+		return xByteCount;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	static int32_t prvTCPSendCheck( FreeRTOS_Socket_t *pxSocket, size_t xDataLength )
@@ -2422,11 +2756,21 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	{
 	uint8_t *pucReturn;
 	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
-	StreamBuffer_t *pxBuffer = pxSocket->u.xTCP.txStream;
+	StreamBuffer_t *pxBuffer;
+
+		/* Create the txStream in case nothing has been sent yet. */
+		if( prvTCPSendCheck( pxSocket, 1ul ) > 0 )
+		{
+			pxBuffer = pxSocket->u.xTCP.txStream;
+		}
+		else
+		{
+			pxBuffer = NULL;
+		}
 
 		if( pxBuffer != NULL )
 		{
-		BaseType_t xSpace = ( BaseType_t ) uxStreamBufferGetSpace( pxBuffer );
+		BaseType_t xSpace = ( BaseType_t ) prvTCPSendSpace( pxSocket, NULL );
 		BaseType_t xRemain = ( BaseType_t ) ( pxBuffer->LENGTH - pxBuffer->uxHead );
 
 			*pxLength = FreeRTOS_min_BaseType( xSpace, xRemain );
@@ -2443,6 +2787,85 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 )
+
+	/* Pass on data that was written to the pointer returned by
+	FreeRTOS_get_tx_head(). */
+	BaseType_t FreeRTOS_tx_commit( Socket_t xSocket, size_t uxCount )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+	BaseType_t xByteCount;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) == pdFALSE )
+		{
+			xByteCount = -pdFREERTOS_ERRNO_EINVAL;
+		}
+		else if( pxSocket->u.xTCP.txStream == NULL )
+		{
+			xByteCount = 0;
+		}
+		else
+		{
+			/* The data is already in place, only advance the head marker.  Never
+			commit more than FreeRTOS_get_tx_head() could have offered: the free
+			space up to the end of the buffer, as it does not wrap. */
+			uxCount = FreeRTOS_min_uint32( uxCount, prvTCPSendSpace( pxSocket, NULL ) );
+			uxCount = FreeRTOS_min_uint32( uxCount, pxSocket->u.xTCP.txStream->LENGTH - pxSocket->u.xTCP.txStream->uxHead );
+			xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, NULL, uxCount );
+
+			if( xByteCount > 0 )
+			{
+				pxSocket->u.xTCP.usTimeout = 1u;
+
+				if( xIsCallingFromIPTask() == pdFALSE )
+				{
+					xSendEventToIPTask( eTCPTimerEvent );
+				}
+			}
+		}
+
+		return xByteCount;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	static size_t prvTCPSendSpace( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucFile )
+	{
+	StreamBuffer_t *pxStream = pxSocket->u.xTCP.txStream;
+	size_t uxSpace;
+
+		/* The IP-task reads pucTxFileHead together with the head marker. */
+		taskENTER_CRITICAL();
+		{
+			if( uxStreamBufferGetSize( pxStream ) == 0u )
+			{
+				/* All data has been delivered, the txStream may switch between
+				ordinary data and file data. */
+				pxSocket->u.xTCP.pucTxFileHead = pucFile;
+			}
+
+			/* File data can only be appended if it continues the file data
+			that is already queued. */
+			if( pxSocket->u.xTCP.pucTxFileHead == pucFile )
+			{
+				uxSpace = uxStreamBufferGetSpace( pxStream );
+			}
+			else
+			{
+				uxSpace = 0u;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		return uxSpace;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Send data using a TCP socket.  It is not necessary to have the socket
@@ -2450,19 +2873,38 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	 * the socket gets connected.
 	 */
 	BaseType_t FreeRTOS_send( Socket_t xSocket, const void *pvBuffer, size_t uxDataLength, BaseType_t xFlags )
+	{
+		return prvTCPSend( ( FreeRTOS_Socket_t * ) xSocket, ( const uint8_t * ) pvBuffer, uxDataLength, xFlags, pdFALSE );
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+	/*
+	 * Send data from flash.  Only place holders are stored in the txStream,
+	 * the data itself will be copied from 'pvFile' when a packet is sent, so
+	 * it must stay unchanged until it has been acknowledged.
+	 */
+	BaseType_t FreeRTOS_sendfile( Socket_t xSocket, const void *pvFile, size_t uxDataLength, BaseType_t xFlags )
+	{
+		return prvTCPSend( ( FreeRTOS_Socket_t * ) xSocket, ( const uint8_t * ) pvFile, uxDataLength, xFlags, pdTRUE );
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 )
+
+	static BaseType_t prvTCPSend( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucData, size_t uxDataLength, BaseType_t xFlags, BaseType_t xFromFile )
 	{
 	BaseType_t xByteCount;
 	BaseType_t xBytesLeft;
-	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
 	TickType_t xRemainingTime;
 	BaseType_t xTimed = pdFALSE;
 	TimeOut_t xTimeOut;
 	BaseType_t xCloseAfterSend;
 
-		/* Prevent compiler warnings about unused parameters.  The parameter
-		may be used in future versions. */
-		( void ) xFlags;
-
 		xByteCount = ( BaseType_t ) prvTCPSendCheck( pxSocket, uxDataLength );
 
 		if( xByteCount > 0 )
@@ -2471,7 +2913,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			xBytesLeft = ( BaseType_t ) uxDataLength;
 
 			/* xByteCount is number of bytes that can be sent now. */
-			xByteCount = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+			xByteCount = ( BaseType_t ) prvTCPSendSpace( pxSocket, ( xFromFile != pdFALSE ) ? pucData : NULL );
 
 			/* While there are still bytes to be sent. */
 			while( xBytesLeft > 0 )
@@ -2512,7 +2954,21 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 						pxSocket->u.xTCP.bits.bCloseRequested = pdTRUE_UNSIGNED;
 					}
 
-					xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, ( const uint8_t * ) pvBuffer, ( size_t ) xByteCount );
+					if( xFromFile != pdFALSE )
+					{
+						/* Only add place holders, prvTCPPrepareSend() will read
+						the data from the file. */
+						taskENTER_CRITICAL();
+						{
+							xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, NULL, ( size_t ) xByteCount );
+							pxSocket->u.xTCP.pucTxFileHead += xByteCount;
+						}
+						taskEXIT_CRITICAL();
+					}
+					else
+					{
+						xByteCount = ( BaseType_t ) uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0ul, pucData, ( size_t ) xByteCount );
+					}
 
 					if( xCloseAfterSend != pdFALSE )
 					{
@@ -2542,7 +2998,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 					/* As there are still bytes left to be sent, increase the
 					data pointer. */
-					pvBuffer = ( void * ) ( ( ( const uint8_t * ) pvBuffer) + xByteCount );
+					pucData += xByteCount;
 				}
 
 				/* Not all bytes have been sent. In case the socket is marked as
@@ -2594,7 +3050,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				xEventGroupWaitBits( pxSocket->xEventGroup, eSOCKET_SEND | eSOCKET_CLOSED,
 					pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
 
-				xByteCount = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+				xByteCount = ( BaseType_t ) prvTCPSendSpace( pxSocket, ( xFromFile != pdFALSE ) ? pucData : NULL );
 			}
 
 			/* How much was actually sent? */
@@ -2610,7 +3066,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				{
 					if( ipconfigTCP_MAY_LOG_PORT( pxSocket->usLocalPort ) != pdFALSE )
 					{
-						FreeRTOS_debug_printf( ( "FreeRTOS_send: %u -> %lxip:%d: no space\n",
+						FreeRTOS_debug_printf( ( "prvTCPSend: %u -> %lxip:%d: no space\n",
 							pxSocket->usLocalPort,
 							pxSocket->u.xTCP.ulRemoteIP,
 							pxSocket->u.xTCP.usRemotePort ) );
@@ -2670,6 +3126,8 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 					vStreamBufferClear( pxSocket->u.xTCP.txStream );
 				}
 
+				pxSocket->u.xTCP.pucTxFileHead = NULL;
+
 				memset( pxSocket->u.xTCP.xPacket.u.ucLastPacket, '\0', sizeof( pxSocket->u.xTCP.xPacket.u.ucLastPacket ) );
 				memset( &pxSocket->u.xTCP.xTCPWindow, '\0', sizeof( pxSocket->u.xTCP.xTCPWindow ) );
 				memset( &pxSocket->u.xTCP.bits, '\0', sizeof( pxSocket->u.xTCP.bits ) );
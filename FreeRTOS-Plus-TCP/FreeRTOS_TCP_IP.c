@@ -246,6 +246,12 @@ static void prvTCPTouchSocket( FreeRTOS_Socket_t *pxSocket );
  */
 static int32_t prvTCPPrepareSend( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t **ppxNetworkBuffer, UBaseType_t uxOptionsLength );
 
+/*
+ * Data added with FreeRTOS_sendfile() is not stored in the txStream, only
+ * place holders are.  Copy the data for a transmission directly from flash.
+ */
+static uint32_t prvTCPTxFileGet( FreeRTOS_Socket_t *pxSocket, size_t uxOffset, uint8_t *pucData, size_t uxCount );
+
 /*
  * Calculate when this socket needs to be checked to do (re-)transmissions.
  */
@@ -892,6 +898,11 @@ NetworkBufferDescriptor_t xTempBuffer;
 				pxTCPPacket->xTCPHeader.usChecksum = 0xffffU;
 			}
 		}
+		#else
+		{
+			/* The MAC inserts the checksum into a zeroed field. */
+			pxTCPPacket->xTCPHeader.usChecksum = 0u;
+		}
 		#endif
 
 	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
@@ -1598,6 +1609,34 @@ BaseType_t bAfter  = ( BaseType_t ) NOW_CONNECTED( eTCPState );						/* Is it co
 }
 /*-----------------------------------------------------------*/
 
+static uint32_t prvTCPTxFileGet( FreeRTOS_Socket_t *pxSocket, size_t uxOffset, uint8_t *pucData, size_t uxCount )
+{
+const uint8_t *pucTail;
+size_t uxSize;
+
+	/* FreeRTOS_sendfile() advances uxHead and pucTxFileHead together, take a
+	consistent copy of both. */
+	taskENTER_CRITICAL();
+	{
+		uxSize = uxStreamBufferGetSize( pxSocket->u.xTCP.txStream );
+		pucTail = pxSocket->u.xTCP.pucTxFileHead - uxSize;
+	}
+	taskEXIT_CRITICAL();
+
+	if( uxSize > uxOffset )
+	{
+		uxCount = FreeRTOS_min_uint32( uxSize - uxOffset, uxCount );
+		memcpy( pucData, pucTail + uxOffset, uxCount );
+	}
+	else
+	{
+		uxCount = 0u;
+	}
+
+	return ( uint32_t ) uxCount;
+}
+/*-----------------------------------------------------------*/
+
 static NetworkBufferDescriptor_t *prvTCPBufferResize( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer,
 	int32_t lDataLen, UBaseType_t uxOptionsLength )
 {
@@ -1728,8 +1767,16 @@ int32_t lStreamPos;
 				uxOffset = uxStreamBufferDistance( pxSocket->u.xTCP.txStream, pxSocket->u.xTCP.txStream->uxTail, ( size_t ) lStreamPos );
 
 				/* Here data is copied from the txStream in 'peek' mode.  Only
-				when the packets are acked, the tail marker will be updated. */
-				ulDataGot = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pucSendData, ( size_t ) lDataLen, pdTRUE );
+				when the packets are acked, the tail marker will be updated.
+				Data queued by FreeRTOS_sendfile() is read from flash. */
+				if( pxSocket->u.xTCP.pucTxFileHead != NULL )
+				{
+					ulDataGot = prvTCPTxFileGet( pxSocket, uxOffset, pucSendData, ( size_t ) lDataLen );
+				}
+				else
+				{
+					ulDataGot = ( uint32_t ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, uxOffset, pucSendData, ( size_t ) lDataLen, pdTRUE );
+				}
 
 				#if( ipconfigHAS_DEBUG_PRINTF != 0 )
 				{
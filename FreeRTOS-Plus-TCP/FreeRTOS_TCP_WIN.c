@@ -87,6 +87,21 @@
 	 */
 	#define MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW		( 4u )
 
+	/* The segments of a window are kept in the rings xRxRing and xTxRing, sorted
+	 * on sequence number.  Position 0 is the segment with the lowest sequence
+	 * number, winRING_SLOT() gives the entry of a position.
+	 */
+	#define winRING_SLOT( pxRing, xPosition )			( ( pxRing )->usSegments[ ( ( pxRing )->usHead + ( xPosition ) ) & ( ipconfigTCP_WIN_RING_LENGTH - 1u ) ] )
+	#define winRING_SEGMENT( pxRing, xPosition )		( &( xTCPSegments[ winRING_SLOT( pxRing, xPosition ) ] ) )
+
+	#if( ( ipconfigTCP_WIN_RING_LENGTH & ( ipconfigTCP_WIN_RING_LENGTH - 1 ) ) != 0 )
+		#error ipconfigTCP_WIN_RING_LENGTH must be a power of 2
+	#endif
+
+	#if( ( ipconfigTCP_WIN_RING_LENGTH > 0x8000 ) || ( ipconfigTCP_WIN_SEG_COUNT > 0xffff ) )
+		#error ipconfigTCP_WIN_RING_LENGTH or ipconfigTCP_WIN_SEG_COUNT is too large for the segment rings
+	#endif
+
 #endif /* configUSE_TCP_WIN */
 /*-----------------------------------------------------------*/
 
@@ -112,6 +127,31 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 	static TCPSegment_t *xTCPWindowRxFind( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Binary search in a segment ring: returns the position of the first segment
+ * of which the sequence number is at or above 'ulSequenceNumber', or the
+ * number of segments in the ring if there is none.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static BaseType_t prvTCPWindowRingSearch( const TCPSegmentRing_t *pxRing, uint32_t ulSequenceNumber );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
+/*
+ * Find a segment with a given sequence number in a segment ring.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static TCPSegment_t *prvTCPWindowRingFind( const TCPSegmentRing_t *pxRing, uint32_t ulSequenceNumber );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
+/*
+ * Add a segment to a ring at a position found with prvTCPWindowRingSearch(),
+ * or remove it from its ring.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static void prvTCPWindowRingInsert( TCPSegmentRing_t *pxRing, BaseType_t xPosition, TCPSegment_t *pxSegment );
+	static void prvTCPWindowRingRemove( TCPSegmentRing_t *pxRing, TCPSegment_t *pxSegment );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
 /*
  * Allocate a new segment
  * The socket will borrow all segments from a common pool: 'xSegmentList',
@@ -150,7 +190,7 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
  *	The ownership will be passed back to the segment pool
  */
 #if( ipconfigUSE_TCP_WIN == 1 )
-	static void vTCPWindowFree( TCPSegment_t *pxSegment );
+	static void vTCPWindowFree( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
 /*
@@ -345,40 +385,137 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 
 	static TCPSegment_t *xTCPWindowRxFind( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber )
 	{
-	const ListItem_t *pxIterator;
-	const MiniListItem_t* pxEnd;
-	TCPSegment_t *pxSegment, *pxReturn = NULL;
-
 		/* Find a segment with a given sequence number in the list of received
 		segments. */
+		return prvTCPWindowRingFind( &( pxWindow->xRxRing ), ulSequenceNumber );
+	}
 
-		pxEnd = ( const MiniListItem_t* )listGET_END_MARKER( &pxWindow->xRxSegments );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
 
-		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( const ListItem_t * ) pxEnd;
-			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static BaseType_t prvTCPWindowRingSearch( const TCPSegmentRing_t *pxRing, uint32_t ulSequenceNumber )
+	{
+	BaseType_t xLow = 0, xHigh = ( BaseType_t ) pxRing->usCount, xMiddle;
+
+		/* The segments of a window lie within half the sequence space, so the
+		wrapping comparison gives a total order. */
+		while( xLow < xHigh )
 		{
-			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
+			xMiddle = ( xLow + xHigh ) / 2;
 
-			if( pxSegment->ulSequenceNumber == ulSequenceNumber )
+			if( xSequenceLessThan( winRING_SEGMENT( pxRing, xMiddle )->ulSequenceNumber, ulSequenceNumber ) != pdFALSE )
 			{
-				pxReturn = pxSegment;
-				break;
+				xLow = xMiddle + 1;
+			}
+			else
+			{
+				xHigh = xMiddle;
 			}
 		}
 
+		return xLow;
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static TCPSegment_t *prvTCPWindowRingFind( const TCPSegmentRing_t *pxRing, uint32_t ulSequenceNumber )
+	{
+	BaseType_t xPosition = prvTCPWindowRingSearch( pxRing, ulSequenceNumber );
+	TCPSegment_t *pxReturn = NULL;
+
+		if( ( xPosition < ( BaseType_t ) pxRing->usCount ) &&
+			( winRING_SEGMENT( pxRing, xPosition )->ulSequenceNumber == ulSequenceNumber ) )
+		{
+			pxReturn = winRING_SEGMENT( pxRing, xPosition );
+		}
+
 		return pxReturn;
 	}
 
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static void prvTCPWindowRingInsert( TCPSegmentRing_t *pxRing, BaseType_t xPosition, TCPSegment_t *pxSegment )
+	{
+	BaseType_t xIndex;
+
+		/* Make room by moving the shorter side of the ring.  Tx segments are
+		always added at the end, out-of-order Rx data normally too. */
+		if( xPosition < ( ( BaseType_t ) pxRing->usCount - xPosition ) )
+		{
+			pxRing->usHead = ( uint16_t ) ( ( pxRing->usHead - 1u ) & ( ipconfigTCP_WIN_RING_LENGTH - 1u ) );
+
+			for( xIndex = 0; xIndex < xPosition; xIndex++ )
+			{
+				winRING_SLOT( pxRing, xIndex ) = winRING_SLOT( pxRing, xIndex + 1 );
+			}
+		}
+		else
+		{
+			for( xIndex = ( BaseType_t ) pxRing->usCount; xIndex > xPosition; xIndex-- )
+			{
+				winRING_SLOT( pxRing, xIndex ) = winRING_SLOT( pxRing, xIndex - 1 );
+			}
+		}
+
+		winRING_SLOT( pxRing, xPosition ) = ( uint16_t ) ( pxSegment - xTCPSegments );
+		pxRing->usCount++;
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static void prvTCPWindowRingRemove( TCPSegmentRing_t *pxRing, TCPSegment_t *pxSegment )
+	{
+	BaseType_t xPosition = prvTCPWindowRingSearch( pxRing, pxSegment->ulSequenceNumber );
+	BaseType_t xIndex;
+
+		configASSERT( ( xPosition < ( BaseType_t ) pxRing->usCount ) && ( winRING_SEGMENT( pxRing, xPosition ) == pxSegment ) );
+
+		/* Close the gap from the shorter side.  ACK's free the Tx segments
+		from the head, and Rx segments are passed to the user from the head. */
+		if( xPosition < ( ( BaseType_t ) pxRing->usCount - 1 - xPosition ) )
+		{
+			for( xIndex = xPosition; xIndex > 0; xIndex-- )
+			{
+				winRING_SLOT( pxRing, xIndex ) = winRING_SLOT( pxRing, xIndex - 1 );
+			}
+
+			pxRing->usHead = ( uint16_t ) ( ( pxRing->usHead + 1u ) & ( ipconfigTCP_WIN_RING_LENGTH - 1u ) );
+		}
+		else
+		{
+			for( xIndex = xPosition; xIndex < ( ( BaseType_t ) pxRing->usCount - 1 ); xIndex++ )
+			{
+				winRING_SLOT( pxRing, xIndex ) = winRING_SLOT( pxRing, xIndex + 1 );
+			}
+		}
+
+		pxRing->usCount--;
+	}
+
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP_WIN == 1 )
 
 	static TCPSegment_t *xTCPWindowNew( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber, int32_t lCount, BaseType_t xIsForRx )
 	{
 	TCPSegment_t *pxSegment;
 	ListItem_t * pxItem;
+	MiniListItem_t *pxWhere;
+	TCPSegmentRing_t *pxRing = ( xIsForRx != pdFALSE ) ? &( pxWindow->xRxRing ) : &( pxWindow->xTxRing );
+	List_t *pxSegments = ( xIsForRx != pdFALSE ) ? &( pxWindow->xRxSegments ) : &( pxWindow->xTxSegments );
+	BaseType_t xPosition;
 
 		/* Allocate a new segment.  The socket will borrow all segments from a
 		common pool: 'xSegmentList', which is a list of 'TCPSegment_t' */
@@ -389,6 +526,12 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 			FreeRTOS_debug_printf( ( "xTCPWindow%cxNew: Error: all segments occupied\n", xIsForRx ? 'R' : 'T' ) );
 			pxSegment = NULL;
 		}
+		else if( pxRing->usCount >= ipconfigTCP_WIN_RING_LENGTH )
+		{
+			/* This window holds as many segments as 'ipconfigTCP_WIN_RING_LENGTH'. */
+			FreeRTOS_debug_printf( ( "xTCPWindow%cxNew: Error: segment ring full\n", xIsForRx ? 'R' : 'T' ) );
+			pxSegment = NULL;
+		}
 		else
 		{
 			/* Pop the item at the head of the list.  Semaphore protection is
@@ -402,8 +545,21 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 			/* Remove the item from xSegmentList. */
 			uxListRemove( pxItem );
 
-			/* Add it to either the connections' Rx or Tx queue. */
-			vListInsertFifo( xIsForRx ? &pxWindow->xRxSegments : &pxWindow->xTxSegments, pxItem );
+			/* Add it to either the connections' Rx or Tx queue.  Both are kept
+			sorted on sequence number, the ring gives the insertion point: just
+			before the first segment with a higher sequence number. */
+			xPosition = prvTCPWindowRingSearch( pxRing, ulSequenceNumber );
+
+			if( xPosition < ( BaseType_t ) pxRing->usCount )
+			{
+				pxWhere = ( MiniListItem_t * ) &( winRING_SEGMENT( pxRing, xPosition )->xListItem );
+			}
+			else
+			{
+				pxWhere = ( MiniListItem_t * ) listGET_END_MARKER( pxSegments );
+			}
+
+			vListInsertGeneric( pxSegments, pxItem, pxWhere );
 
 			/* And set the segment's timer to zero */
 			vTCPTimerSet( &pxSegment->xTransmitTimer );
@@ -413,6 +569,8 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 			pxSegment->lMaxLength = lCount;
 			pxSegment->lDataLength = lCount;
 			pxSegment->ulSequenceNumber = ulSequenceNumber;
+			prvTCPWindowRingInsert( pxRing, xPosition, pxSegment );
+
 			#if( ipconfigHAS_DEBUG_PRINTF != 0 )
 			{
 			static UBaseType_t xLowestLength = ipconfigTCP_WIN_SEG_COUNT;
@@ -520,7 +678,7 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 
 #if( ipconfigUSE_TCP_WIN == 1 )
 
-	static void vTCPWindowFree( TCPSegment_t *pxSegment )
+	static void vTCPWindowFree( TCPWindow_t *pxWindow, TCPSegment_t *pxSegment )
 	{
 		/*  Free entry pxSegment because it's not used any more.  The ownership
 		will be passed back to the segment pool.
@@ -531,6 +689,12 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 			uxListRemove( &( pxSegment->xQueueItem ) );
 		}
 
+		/* Take it out of its ring while the sequence number is known. */
+		if( listLIST_ITEM_CONTAINER( &( pxSegment->xListItem ) ) != NULL )
+		{
+			prvTCPWindowRingRemove( ( pxSegment->u.bits.bIsForRx != pdFALSE_UNSIGNED ) ? &( pxWindow->xRxRing ) : &( pxWindow->xTxRing ), pxSegment );
+		}
+
 		pxSegment->ulSequenceNumber = 0u;
 		pxSegment->lDataLength = 0l;
 		pxSegment->u.ulFlags = 0u;
@@ -576,7 +740,7 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 				while( listCURRENT_LIST_LENGTH( pxSegments ) > 0U )
 				{
 					pxSegment = ( TCPSegment_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxSegments );
-					vTCPWindowFree( pxSegment );
+					vTCPWindowFree( pxWindow, pxSegment );
 				}
 			}
 		}
@@ -600,6 +764,11 @@ void vTCPWindowCreate( TCPWindow_t *pxWindow, uint32_t ulRxWindowLength,
 		vListInitialise( &pxWindow->xTxSegments );
 		vListInitialise( &pxWindow->xRxSegments );
 
+		pxWindow->xTxRing.usHead = 0u;
+		pxWindow->xTxRing.usCount = 0u;
+		pxWindow->xRxRing.usHead = 0u;
+		pxWindow->xRxRing.usCount = 0u;
+
 		vListInitialise( &pxWindow->xPriorityQueue );			/* Priority queue: segments which must be sent immediately */
 		vListInitialise( &pxWindow->xTxQueue   );			/* Transmit queue: segments queued for transmission */
 		vListInitialise( &pxWindow->xWaitQueue );			/* Waiting queue:  outstanding segments */
@@ -710,9 +879,8 @@ const int32_t l500ms = 500;
 	static TCPSegment_t *xTCPWindowRxConfirm( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber, uint32_t ulLength )
 	{
 	TCPSegment_t *pxBest = NULL;
-	const ListItem_t *pxIterator;
 	uint32_t ulNextSequenceNumber = ulSequenceNumber + ulLength;
-	const MiniListItem_t* pxEnd = ( const MiniListItem_t* ) listGET_END_MARKER( &pxWindow->xRxSegments );
+	BaseType_t xPosition;
 	TCPSegment_t *pxSegment;
 
 		/* A segment has been received with sequence number 'ulSequenceNumber',
@@ -723,23 +891,20 @@ const int32_t l500ms = 500;
 		the next RX segment should have a sequence number equal to
 		'(ulSequenceNumber+ulLength)'. */
 
-		/* Iterate through all RX segments that are stored: */
-		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( const ListItem_t * ) pxEnd;
-			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
+		/* See if there is a segment for which:
+		'ulSequenceNumber' <= 'pxSegment->ulSequenceNumber' < 'ulNextSequenceNumber'
+		If there are more matching segments, the one with the lowest sequence number
+		shall be taken.  As xRxRing is sorted on sequence number, that is the
+		first one at or above 'ulSequenceNumber'. */
+		xPosition = prvTCPWindowRingSearch( &( pxWindow->xRxRing ), ulSequenceNumber );
+
+		if( xPosition < ( BaseType_t ) pxWindow->xRxRing.usCount )
 		{
-			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
-			/* And see if there is a segment for which:
-			'ulSequenceNumber' <= 'pxSegment->ulSequenceNumber' < 'ulNextSequenceNumber'
-			If there are more matching segments, the one with the lowest sequence number
-			shall be taken */
-			if( ( xSequenceGreaterThanOrEqual( pxSegment->ulSequenceNumber, ulSequenceNumber ) != 0 ) &&
-				( xSequenceLessThan( pxSegment->ulSequenceNumber, ulNextSequenceNumber ) != 0 ) )
+			pxSegment = winRING_SEGMENT( &( pxWindow->xRxRing ), xPosition );
+
+			if( xSequenceLessThan( pxSegment->ulSequenceNumber, ulNextSequenceNumber ) != 0 )
 			{
-				if( ( pxBest == NULL ) || ( xSequenceLessThan( pxSegment->ulSequenceNumber, pxBest->ulSequenceNumber ) != 0 ) )
-				{
-					pxBest = pxSegment;
-				}
+				pxBest = pxSegment;
 			}
 		}
 
@@ -816,7 +981,7 @@ const int32_t l500ms = 500;
                         if ( pxFound != NULL )
                         {
                             /* Remove it because it will be passed to user directly. */
-                            vTCPWindowFree( pxFound );
+                            vTCPWindowFree( pxWindow, pxFound );
                         }
                     } while ( pxFound );
 
@@ -828,7 +993,7 @@ const int32_t l500ms = 500;
 
 						/* As all packet below this one have been passed to the
 						user it can be discarded. */
-						vTCPWindowFree( pxFound );
+						vTCPWindowFree( pxWindow, pxFound );
 					}
 
 					if( ulSavedSequenceNumber != ulCurrentSequenceNumber )
@@ -1470,8 +1635,22 @@ const int32_t l500ms = 500;
 		 A Smoothed RTT will increase quickly, but it is conservative when
 		 becoming smaller. */
 
-		for(
-				pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
+		/* As xTxSegments is sorted, a contiguous ACK'd block can only start at
+		the segment of which the sequence number equals 'ulFirst'.  Look it up
+		in xTxRing rather than walking all outstanding segments, which would
+		make a SACK cost O(n) for large windows. */
+		pxSegment = prvTCPWindowRingFind( &( pxWindow->xTxRing ), ulFirst );
+
+		if( pxSegment != NULL )
+		{
+			pxIterator = ( const ListItem_t * ) &( pxSegment->xListItem );
+		}
+		else
+		{
+			pxIterator = ( const ListItem_t * ) pxEnd;
+		}
+
+		for( ;
 				( pxIterator != ( const ListItem_t * ) pxEnd ) && ( xSequenceLessThan( ulSequenceNumber, ulLast ) != 0 );
 			)
 		{
@@ -1570,7 +1749,7 @@ const int32_t l500ms = 500;
 				ulBytesConfirmed += ulDataLength;
 
 				/* All segments below tx.ulCurrentSequenceNumber may be freed. */
-				vTCPWindowFree( pxSegment );
+				vTCPWindowFree( pxWindow, pxSegment );
 
 				/* No need to unlink it any more. */
 				xDoUnlink = pdFALSE;
@@ -1600,25 +1779,30 @@ const int32_t l500ms = 500;
 	uint32_t ulCount = 0UL;
 
 		/* A higher Tx block has been acknowledged.  Now iterate through the
-		 xWaitQueue to find a possible condition for a FAST retransmission. */
+		segments of xWaitQueue below 'ulFirst' to find a possible condition for
+		a FAST retransmission.  xTxSegments is sorted on sequence number, so
+		the walk stops at 'ulFirst' and does not visit the rest of the window. */
 
-		pxEnd = ( const MiniListItem_t* ) listGET_END_MARKER( &( pxWindow->xWaitQueue ) );
+		pxEnd = ( const MiniListItem_t* ) listGET_END_MARKER( &( pxWindow->xTxSegments ) );
 
 		for( pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxEnd );
-			 pxIterator != ( const ListItem_t * ) pxEnd; )
+			 pxIterator != ( const ListItem_t * ) pxEnd;
+			 pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator ) )
 		{
 			/* Get the owner, which is a TCP segment. */
 			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxIterator );
 
-			/* Hop to the next item before the current gets unlinked. */
-			pxIterator  = ( const ListItem_t * ) listGET_NEXT( pxIterator );
+			if( xSequenceLessThan( pxSegment->ulSequenceNumber, ulFirst ) == pdFALSE )
+			{
+				break;
+			}
 
 			/* Fast retransmission:
 			When 3 packets with a higher sequence number have been acknowledged
 			by the peer, it is very unlikely a current packet will ever arrive.
 			It will be retransmitted far before the RTO. */
 			if( ( pxSegment->u.bits.bAcked == pdFALSE_UNSIGNED ) &&
-				( xSequenceLessThan( pxSegment->ulSequenceNumber, ulFirst ) != pdFALSE ) &&
+				( listLIST_ITEM_CONTAINER( &( pxSegment->xQueueItem ) ) == &( pxWindow->xWaitQueue ) ) &&
 				( ++( pxSegment->u.bits.ucDupAckCount ) == DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) )
 			{
 				pxSegment->u.bits.ucTransmitCount = pdFALSE_UNSIGNED;
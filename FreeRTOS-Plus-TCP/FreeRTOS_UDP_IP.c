@@ -50,6 +50,23 @@
 /* The expected IP version and header length coded into the IP header itself. */
 #define ipIP_VERSION_AND_HEADER_LENGTH_BYTE ( ( uint8_t ) 0x45 )
 
+/* Pads pxNetworkBuffer to the minimum frame size and hands it to the driver,
+or fragments it when it is bigger than the MTU. */
+static void prvSendGeneratedPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+
+/* Copies the headers of pxTemplate in front of the payload of pxNetworkBuffer
+and fills in the lengths and the checksums. */
+static void prvApplyUDPTemplate( NetworkBufferDescriptor_t * const pxNetworkBuffer, const UDPPacket_t *pxTemplate, uint8_t ucSocketOptions );
+
+#if( ipconfigUDP_DESTINATION_CACHE != 0 )
+	/* Returns the cached headers of pxSocket when they are still valid for
+	the destination of pxNetworkBuffer, otherwise NULL. */
+	static const UDPPacket_t *prvDestinationCacheGet( const FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/* Stores the headers that were built for pxSocket. */
+	static void prvDestinationCacheSet( FreeRTOS_Socket_t *pxSocket, const UDPPacket_t *pxHeaders );
+#endif /* ipconfigUDP_DESTINATION_CACHE */
+
 /* Part of the Ethernet and IP headers are always constant when sending an IPv4
 UDP packet.  This array defines the constant parts, allowing this part of the
 packet to be filled in using a simple memcpy() instead of individual writes. */
@@ -78,10 +95,36 @@ UDPPacket_t *pxUDPPacket;
 IPHeader_t *pxIPHeader;
 eARPLookupResult_t eReturned;
 uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
+#if( ipconfigUDP_DESTINATION_CACHE != 0 )
+	FreeRTOS_Socket_t *pxSocket = NULL;
+	const UDPPacket_t *pxCachedHeaders;
+#endif
 
 	/* Map the UDP packet onto the start of the frame. */
 	pxUDPPacket = ( UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
 
+	#if( ipconfigUDP_DESTINATION_CACHE != 0 )
+	{
+		#if ( ipconfigSUPPORT_OUTGOING_PINGS == 1 )
+			if( pxNetworkBuffer->usPort != ipPACKET_CONTAINS_ICMP_DATA )
+		#endif /* ipconfigSUPPORT_OUTGOING_PINGS */
+		{
+			pxSocket = pxUDPSocketLookup( pxNetworkBuffer->usBoundPort );
+		}
+
+		/* Sending to the same destination as last time only needs a copy of
+		the headers, without an ARP lookup or a routing decision. */
+		pxCachedHeaders = prvDestinationCacheGet( pxSocket, pxNetworkBuffer );
+		if( pxCachedHeaders != NULL )
+		{
+			iptraceSENDING_UDP_PACKET( pxNetworkBuffer->ulIPAddress );
+			prvApplyUDPTemplate( pxNetworkBuffer, pxCachedHeaders, pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] );
+			prvSendGeneratedPacket( pxNetworkBuffer );
+			return;
+		}
+	}
+	#endif /* ipconfigUDP_DESTINATION_CACHE */
+
 	/* Determine the ARP cache status for the requested IP address. */
 	eReturned = eARPGetCacheEntry( &( ulIPAddress ), &( pxUDPPacket->xEthernetHeader.xDestinationAddress ) );
 
@@ -187,6 +230,15 @@ uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
 			pxIPHeader->usHeaderChecksum = 0u;
 			pxUDPPacket->xUDPHeader.usChecksum = 0u;
 			#endif
+
+			#if( ipconfigUDP_DESTINATION_CACHE != 0 )
+			{
+				if( pxSocket != NULL )
+				{
+					prvDestinationCacheSet( pxSocket, pxUDPPacket );
+				}
+			}
+			#endif /* ipconfigUDP_DESTINATION_CACHE */
 		}
 		else if( eReturned == eARPCacheMiss )
 		{
@@ -210,140 +262,328 @@ uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
 
 	if( eReturned != eCantSendPacket )
 	{
-		/* The network driver is responsible for freeing the network buffer
-		after the packet has been sent. */
+		prvSendGeneratedPacket( pxNetworkBuffer );
+	}
+	else
+	{
+		/* The packet can't be sent (DHCP not completed?).  Just drop the
+		packet. */
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendGeneratedPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	/* The network driver is responsible for freeing the network buffer
+	after the packet has been sent. */
 
-		#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+	#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	{
+		if( pxNetworkBuffer->xDataLength > ( size_t ) ( ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER ) )
 		{
-			if( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
-			{
-			BaseType_t xIndex;
+			vIPFragmentAndSend( pxNetworkBuffer );
+			return;
+		}
+	}
+	#endif
 
-				for( xIndex = ( BaseType_t ) pxNetworkBuffer->xDataLength; xIndex < ( BaseType_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES; xIndex++ )
-				{
-					pxNetworkBuffer->pucEthernetBuffer[ xIndex ] = 0u;
-				}
-				pxNetworkBuffer->xDataLength = ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES;
+	#if defined( ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+	{
+		if( pxNetworkBuffer->xDataLength < ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES )
+		{
+		BaseType_t xIndex;
+
+			for( xIndex = ( BaseType_t ) pxNetworkBuffer->xDataLength; xIndex < ( BaseType_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES; xIndex++ )
+			{
+				pxNetworkBuffer->pucEthernetBuffer[ xIndex ] = 0u;
 			}
+			pxNetworkBuffer->xDataLength = ( size_t ) ipconfigETHERNET_MINIMUM_PACKET_BYTES;
 		}
-		#endif
+	}
+	#endif
+
+	xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+}
+/*-----------------------------------------------------------*/
 
-		xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+static void prvApplyUDPTemplate( NetworkBufferDescriptor_t * const pxNetworkBuffer, const UDPPacket_t *pxTemplate, uint8_t ucSocketOptions )
+{
+UDPPacket_t *pxUDPPacket = ( UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+uint16_t usLength;
+
+	memcpy( pxUDPPacket, pxTemplate, sizeof( UDPPacket_t ) );
+
+	usLength = ( uint16_t ) ( pxNetworkBuffer->xDataLength + sizeof( UDPHeader_t ) );
+	pxUDPPacket->xUDPHeader.usLength = FreeRTOS_htons( usLength );
+	usLength += ( uint16_t ) sizeof( IPHeader_t );
+	pxUDPPacket->xIPHeader.usLength = FreeRTOS_htons( usLength );
+
+	/* The total transmit size adds on the Ethernet header. */
+	pxNetworkBuffer->xDataLength = ( size_t ) usLength + sizeof( EthernetHeader_t );
+
+	#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+	{
+		pxUDPPacket->xIPHeader.usHeaderChecksum = usGenerateChecksum( 0UL, ( uint8_t * ) &( pxUDPPacket->xIPHeader.ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+		pxUDPPacket->xIPHeader.usHeaderChecksum = ~FreeRTOS_htons( pxUDPPacket->xIPHeader.usHeaderChecksum );
+
+		if( ( ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0u )
+		{
+			usGenerateProtocolChecksum( ( uint8_t * ) pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+		}
 	}
-	else
+	#else
 	{
-		/* The packet can't be sent (DHCP not completed?).  Just drop the
-		packet. */
-		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		( void ) ucSocketOptions;
 	}
+	#endif
 }
 /*-----------------------------------------------------------*/
 
-BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer, uint16_t usPort )
-{
-BaseType_t xReturn = pdPASS;
-FreeRTOS_Socket_t *pxSocket;
+#if( ipconfigUDP_DESTINATION_CACHE != 0 )
 
-UDPPacket_t *pxUDPPacket = (UDPPacket_t *) pxNetworkBuffer->pucEthernetBuffer;
+	static const UDPPacket_t *prvDestinationCacheGet( const FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	const UDPDestinationCache_t *pxCache;
 
-	/* Caller must check for minimum packet size. */
-	pxSocket = pxUDPSocketLookup( usPort );
+		if( pxSocket == NULL )
+		{
+			return NULL;
+		}
+		pxCache = &( pxSocket->u.xUDP.xDestination );
+
+		/* The local addresses are checked here, so that the places changing
+		them need not know about the caches. */
+		if( ( pxCache->xValid == pdFALSE ) ||
+			( pxCache->ulARPCacheGeneration != ulARPCacheGeneration ) ||
+			( pxCache->xHeaders.xIPHeader.ulDestinationIPAddress != pxNetworkBuffer->ulIPAddress ) ||
+			( pxCache->xHeaders.xUDPHeader.usDestinationPort != pxNetworkBuffer->usPort ) ||
+			( pxCache->xHeaders.xIPHeader.ulSourceIPAddress != *ipLOCAL_IP_ADDRESS_POINTER ) ||
+			( pxCache->ulNetMask != xNetworkAddressing.ulNetMask ) ||
+			( pxCache->ulGatewayAddress != xNetworkAddressing.ulGatewayAddress ) )
+		{
+			return NULL;
+		}
+		return &( pxCache->xHeaders );
+	}
+	/*-----------------------------------------------------------*/
 
-	if( pxSocket )
+	static void prvDestinationCacheSet( FreeRTOS_Socket_t *pxSocket, const UDPPacket_t *pxHeaders )
 	{
+	UDPDestinationCache_t *pxCache = &( pxSocket->u.xUDP.xDestination );
+
+		memcpy( &( pxCache->xHeaders ), pxHeaders, sizeof( pxCache->xHeaders ) );
+		pxCache->xHeaders.xIPHeader.usLength = 0u;
+		pxCache->xHeaders.xIPHeader.usHeaderChecksum = 0u;
+		pxCache->xHeaders.xUDPHeader.usLength = 0u;
+		pxCache->xHeaders.xUDPHeader.usChecksum = 0u;
+		pxCache->ulARPCacheGeneration = ulARPCacheGeneration;
+		pxCache->ulNetMask = xNetworkAddressing.ulNetMask;
+		pxCache->ulGatewayAddress = xNetworkAddressing.ulGatewayAddress;
+		pxCache->xValid = pdTRUE;
+	}
+	/*-----------------------------------------------------------*/
 
-		/* When refreshing the ARP cache with received UDP packets we must be
-		careful;  hundreds of broadcast messages may pass and if we're not
-		handling them, no use to fill the ARP cache with those IP addresses. */
-		vARPRefreshCacheEntry( &( pxUDPPacket->xEthernetHeader.xSourceAddress ), pxUDPPacket->xIPHeader.ulSourceIPAddress );
+#endif /* ipconfigUDP_DESTINATION_CACHE */
+
+void vProcessGeneratedUDPBatch( NetworkBufferDescriptor_t * const pxFirstBuffer )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+NetworkBufferDescriptor_t *pxNextBuffer;
+UDPPacket_t xTemplate;
+const UDPPacket_t *pxTemplate = NULL;
+uint32_t ulIPAddress = pxFirstBuffer->ulIPAddress;
+uint8_t ucSocketOptions = pxFirstBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ];
+#if( ipconfigUDP_DESTINATION_CACHE != 0 )
+	FreeRTOS_Socket_t *pxSocket = pxUDPSocketLookup( pxFirstBuffer->usBoundPort );
+
+	pxTemplate = prvDestinationCacheGet( pxSocket, pxFirstBuffer );
+#endif
+
+	if( pxTemplate != NULL )
+	{
+		/* The headers come from the destination cache of the socket. */
+	}
+	else if( eARPGetCacheEntry( &( ulIPAddress ), &( xTemplate.xEthernetHeader.xDestinationAddress ) ) != eARPCacheHit )
+	{
+		/* The first packet takes the normal path, which sends an ARP request
+		if needed.  The others are dropped, as they would have been when sent
+		one by one. */
+		pxNetworkBuffer = ipGET_NEXT_BATCH_BUFFER( pxFirstBuffer );
+		vProcessGeneratedUDPPacket( pxFirstBuffer );
+
+		while( pxNetworkBuffer != NULL )
+		{
+			pxNextBuffer = ipGET_NEXT_BATCH_BUFFER( pxNetworkBuffer );
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			pxNetworkBuffer = pxNextBuffer;
+		}
+	}
+	else
+	{
+		/* The headers are built once in xTemplate, only the lengths and the
+		checksums differ per packet.  It can not be kept in the first buffer,
+		which the driver may release before the last one is sent. */
+		memcpy( ( ( uint8_t * ) &xTemplate ) + sizeof( MACAddress_t ), xDefaultPartUDPPacketHeader.ucBytes, sizeof( xDefaultPartUDPPacketHeader ) );
+		xTemplate.xIPHeader.ulDestinationIPAddress = pxFirstBuffer->ulIPAddress;
+		xTemplate.xUDPHeader.usDestinationPort = pxFirstBuffer->usPort;
+		xTemplate.xUDPHeader.usSourcePort = pxFirstBuffer->usBoundPort;
+		xTemplate.xUDPHeader.usChecksum = 0u;
+		xTemplate.xIPHeader.usHeaderChecksum = 0u;
 
-		#if( ipconfigUSE_CALLBACKS == 1 )
+		#if( ipconfigUSE_LLMNR == 1 )
 		{
-			/* Did the owner of this socket register a reception handler ? */
-			if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xUDP.pxHandleReceive ) )
+			if( pxFirstBuffer->ulIPAddress == ipLLMNR_IP_ADDR )
 			{
-				struct freertos_sockaddr xSourceAddress, destinationAddress;
-				void *pcData = ( void * ) &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] );
-				FOnUDPReceive_t xHandler = ( FOnUDPReceive_t ) pxSocket->u.xUDP.pxHandleReceive;
-				xSourceAddress.sin_port = pxNetworkBuffer->usPort;
-				xSourceAddress.sin_addr = pxNetworkBuffer->ulIPAddress;
-				destinationAddress.sin_port = usPort;
-				destinationAddress.sin_addr = pxUDPPacket->xIPHeader.ulDestinationIPAddress;
-
-				if( xHandler( ( Socket_t * ) pxSocket, ( void* ) pcData, ( size_t ) pxNetworkBuffer->xDataLength,
-					&xSourceAddress, &destinationAddress ) )
-				{
-					xReturn = pdFAIL; /* FAIL means that we did not consume or release the buffer */
-				}
+				xTemplate.xIPHeader.ucTimeToLive = 0x01;
 			}
 		}
-		#endif /* ipconfigUSE_CALLBACKS */
+		#endif
 
-		#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
+		#if( ipconfigUDP_DESTINATION_CACHE != 0 )
 		{
-			if( xReturn == pdPASS )
+			if( pxSocket != NULL )
 			{
-				if ( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) >= pxSocket->u.xUDP.uxMaxPackets )
-				{
-					FreeRTOS_debug_printf( ( "xProcessReceivedUDPPacket: buffer full %ld >= %ld port %u\n",
-						listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ),
-						pxSocket->u.xUDP.uxMaxPackets, pxSocket->usLocalPort ) );
-					xReturn = pdFAIL; /* we did not consume or release the buffer */
-				}
+				prvDestinationCacheSet( pxSocket, &xTemplate );
 			}
 		}
-		#endif
+		#endif /* ipconfigUDP_DESTINATION_CACHE */
 
-		if( xReturn == pdPASS )
+		pxTemplate = &xTemplate;
+	}
+
+	if( pxTemplate != NULL )
+	{
+		for( pxNetworkBuffer = pxFirstBuffer; pxNetworkBuffer != NULL; pxNetworkBuffer = pxNextBuffer )
+		{
+			pxNextBuffer = ipGET_NEXT_BATCH_BUFFER( pxNetworkBuffer );
+			iptraceSENDING_UDP_PACKET( pxNetworkBuffer->ulIPAddress );
+			prvApplyUDPTemplate( pxNetworkBuffer, pxTemplate, ucSocketOptions );
+			prvSendGeneratedPacket( pxNetworkBuffer );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Hands a datagram to the receive handler or to the waiting list of pxSocket.
+Returns pdFAIL when the buffer was not consumed. */
+static BaseType_t prvDeliverUDPPacket( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer, uint16_t usPort )
+{
+BaseType_t xReturn = pdPASS;
+
+	#if( ipconfigUSE_CALLBACKS == 1 )
+	{
+		/* Did the owner of this socket register a reception handler ? */
+		if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xUDP.pxHandleReceive ) )
 		{
-			vTaskSuspendAll();
+			UDPPacket_t *pxUDPPacket = (UDPPacket_t *) pxNetworkBuffer->pucEthernetBuffer;
+			struct freertos_sockaddr xSourceAddress, destinationAddress;
+			void *pcData = ( void * ) &( pxNetworkBuffer->pucEthernetBuffer[ ipUDP_PAYLOAD_OFFSET_IPv4 ] );
+			FOnUDPReceive_t xHandler = ( FOnUDPReceive_t ) pxSocket->u.xUDP.pxHandleReceive;
+			xSourceAddress.sin_port = pxNetworkBuffer->usPort;
+			xSourceAddress.sin_addr = pxNetworkBuffer->ulIPAddress;
+			destinationAddress.sin_port = usPort;
+			destinationAddress.sin_addr = pxUDPPacket->xIPHeader.ulDestinationIPAddress;
+
+			iptraceUDP_APPLICATION_RECEIVE( pxNetworkBuffer );
+			if( xHandler( ( Socket_t * ) pxSocket, ( void* ) pcData, ( size_t ) pxNetworkBuffer->xDataLength,
+				&xSourceAddress, &destinationAddress ) )
 			{
-				if( xReturn == pdPASS )
-				{
-					taskENTER_CRITICAL();
-					{
-						/* Add the network packet to the list of packets to be
-						processed by the socket. */
-						vListInsertEnd( &( pxSocket->u.xUDP.xWaitingPacketsList ), &( pxNetworkBuffer->xBufferListItem ) );
-					}
-					taskEXIT_CRITICAL();
-				}
+				xReturn = pdFAIL; /* FAIL means that we did not consume or release the buffer */
 			}
-			xTaskResumeAll();
+		}
+	}
+	#endif /* ipconfigUSE_CALLBACKS */
 
-			/* Set the socket's receive event */
-			if( pxSocket->xEventGroup != NULL )
+	#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
+	{
+		if( xReturn == pdPASS )
+		{
+			if ( listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) >= pxSocket->u.xUDP.uxMaxPackets )
 			{
-				xEventGroupSetBits( pxSocket->xEventGroup, eSOCKET_RECEIVE );
+				FreeRTOS_debug_printf( ( "xProcessReceivedUDPPacket: buffer full %ld >= %ld port %u\n",
+					listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ),
+					pxSocket->u.xUDP.uxMaxPackets, pxSocket->usLocalPort ) );
+				xReturn = pdFAIL; /* we did not consume or release the buffer */
 			}
+		}
+	}
+	#endif
 
-			#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+	if( xReturn == pdPASS )
+	{
+		vTaskSuspendAll();
+		{
+			if( xReturn == pdPASS )
 			{
-				if( ( pxSocket->pxSocketSet != NULL ) && ( ( pxSocket->xSelectBits & eSELECT_READ ) != 0 ) )
+				taskENTER_CRITICAL();
 				{
-					xEventGroupSetBits( pxSocket->pxSocketSet->xSelectGroup, eSELECT_READ );
+					/* Add the network packet to the list of packets to be
+					processed by the socket. */
+					vListInsertEnd( &( pxSocket->u.xUDP.xWaitingPacketsList ), &( pxNetworkBuffer->xBufferListItem ) );
 				}
+				taskEXIT_CRITICAL();
 			}
-			#endif
+		}
+		xTaskResumeAll();
+
+		/* Set the socket's receive event */
+		if( pxSocket->xEventGroup != NULL )
+		{
+			xEventGroupSetBits( pxSocket->xEventGroup, eSOCKET_RECEIVE );
+		}
 
-			#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
+		#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+		{
+			if( ( pxSocket->pxSocketSet != NULL ) && ( ( pxSocket->xSelectBits & eSELECT_READ ) != 0 ) )
 			{
-				if( pxSocket->pxUserSemaphore != NULL )
-				{
-					xSemaphoreGive( pxSocket->pxUserSemaphore );
-				}
+				xEventGroupSetBits( pxSocket->pxSocketSet->xSelectGroup, eSELECT_READ );
 			}
-			#endif
+		}
+		#endif
 
-			#if( ipconfigUSE_DHCP == 1 )
+		#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
+		{
+			if( pxSocket->pxUserSemaphore != NULL )
 			{
-				if( xIsDHCPSocket( pxSocket ) )
-				{
-					xSendEventToIPTask( eDHCPEvent );
-				}
+				xSemaphoreGive( pxSocket->pxUserSemaphore );
+			}
+		}
+		#endif
+
+		#if( ipconfigUSE_DHCP == 1 )
+		{
+			if( xIsDHCPSocket( pxSocket ) )
+			{
+				xSendEventToIPTask( eDHCPEvent );
 			}
-			#endif
 		}
+		#endif
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xProcessReceivedUDPPacket( NetworkBufferDescriptor_t *pxNetworkBuffer, uint16_t usPort )
+{
+BaseType_t xReturn = pdPASS;
+FreeRTOS_Socket_t *pxSocket;
+
+UDPPacket_t *pxUDPPacket = (UDPPacket_t *) pxNetworkBuffer->pucEthernetBuffer;
+
+	/* Caller must check for minimum packet size. */
+	pxSocket = pxUDPSocketLookup( usPort );
+
+	if( pxSocket )
+	{
+
+		/* When refreshing the ARP cache with received UDP packets we must be
+		careful;  hundreds of broadcast messages may pass and if we're not
+		handling them, no use to fill the ARP cache with those IP addresses. */
+		vARPRefreshCacheEntry( &( pxUDPPacket->xEthernetHeader.xSourceAddress ), pxUDPPacket->xIPHeader.ulSourceIPAddress );
+
+		xReturn = prvDeliverUDPPacket( pxSocket, pxNetworkBuffer, usPort );
 	}
 	else
 	{
@@ -379,3 +619,47 @@ UDPPacket_t *pxUDPPacket = (UDPPacket_t *) pxNetworkBuffer->pucEthernetBuffer;
 	return xReturn;
 }
 /*-----------------------------------------------------------*/
+
+#if( ipconfigUDP_FAST_PATH == 1 )
+
+	BaseType_t xProcessReceivedUDPPacketFast( NetworkBufferDescriptor_t *pxNetworkBuffer, uint16_t usPort, size_t uxPayloadLength )
+	{
+	BaseType_t xReturn = pdFAIL;
+	FreeRTOS_Socket_t *pxSocket;
+	UDPPacket_t *pxUDPPacket = ( UDPPacket_t * ) pxNetworkBuffer->pucEthernetBuffer;
+
+		/* The IP-task binds and closes sockets with the scheduler suspended, so
+		the socket stays valid until xTaskResumeAll(). */
+		vTaskSuspendAll();
+		{
+			pxSocket = pxUDPSocketLookup( usPort );
+
+			if( ( pxSocket != NULL ) && ( pxSocket->u.xUDP.xFastPath != pdFALSE ) )
+			{
+				/* Fields in pxNetworkBuffer (usPort, ulIPAddress) are network order. */
+				pxNetworkBuffer->xDataLength = uxPayloadLength;
+				pxNetworkBuffer->usPort = pxUDPPacket->xUDPHeader.usSourcePort;
+				pxNetworkBuffer->ulIPAddress = pxUDPPacket->xIPHeader.ulSourceIPAddress;
+
+				/* The ARP cache belongs to the IP-task, which never blocks while
+				changing it.  A task below its priority can therefore only run
+				when the cache is consistent. */
+				if( uxTaskPriorityGet( NULL ) < ipconfigIP_TASK_PRIORITY )
+				{
+					vARPRefreshCacheEntry( &( pxUDPPacket->xEthernetHeader.xSourceAddress ), pxUDPPacket->xIPHeader.ulSourceIPAddress );
+				}
+
+				if( prvDeliverUDPPacket( pxSocket, pxNetworkBuffer, usPort ) == pdFAIL )
+				{
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+				}
+				xReturn = pdPASS;
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUDP_FAST_PATH */
+/*-----------------------------------------------------------*/
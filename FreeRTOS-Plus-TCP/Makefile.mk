@@ -5,7 +5,7 @@ $(LIBTCPIP_ROOT_DIR)/portable/NetworkInterface/MPC5748G \
 $(LIBTCPIP_ROOT_DIR)/portable/NetworkInterface/Common
 
 LIBTCPIP_SRCS := $(foreach v,$(LIBTCPIP_SRC_DIRS),$(wildcard $(v)/*.c))
-LIBTCPIP_SRCS += $(LIBTCPIP_ROOT_DIR)/portable/BufferManagement/BufferAllocation_1.c
+LIBTCPIP_SRCS += $(LIBTCPIP_ROOT_DIR)/portable/BufferManagement/BufferAllocation_3.c
 LIBTCPIP_ASMS := $(foreach v,$(LIBTCPIP_SRC_DIRS),$(wildcard $(v)/*.s))
 DEPS += $(patsubst %.c, %.d, $(notdir $(LIBTCPIP_SRCS)))
 LIBTCPIP_OBJS := $(patsubst %.c, %.o, $(notdir $(LIBTCPIP_SRCS))) $(patsubst %.s, %.o, $(notdir $(LIBTCPIP_ASMS)))
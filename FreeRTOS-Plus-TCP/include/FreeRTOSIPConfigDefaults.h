@@ -143,6 +143,15 @@ from the FreeRTOSIPConfig.h configuration header file. */
 		#define	ipconfigTCP_WIN_SEG_COUNT		( 256 )
 	#endif
 
+	/* Every TCP window keeps its Rx and its Tx segments in a ring sorted on
+	sequence number, so that ACK's and out-of-order data are found with a
+	binary search.  This is the maximum number of segments per direction of a
+	window, a window which needs more has to wait as if the pool was empty.
+	Must be a power of 2. */
+	#ifndef ipconfigTCP_WIN_RING_LENGTH
+		#define	ipconfigTCP_WIN_RING_LENGTH		( 64 )
+	#endif
+
 	#ifndef ipconfigIGNORE_UNKNOWN_PACKETS
 		/* When non-zero, TCP will not send RST packets in reply to
 		TCP packets which are unknown, or out-of-order. */
@@ -297,10 +306,31 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS		45
 #endif
 
+/* BufferAllocation_3.c: the first ipconfigNUM_SMALL_NETWORK_BUFFERS network
+buffers hold ipconfigSMALL_NETWORK_BUFFER_SIZE bytes, the others
+ipconfigNETWORK_BUFFER_SIZE bytes. */
+#ifndef ipconfigNUM_SMALL_NETWORK_BUFFERS
+	#define ipconfigNUM_SMALL_NETWORK_BUFFERS	0
+#endif
+
+#ifndef ipconfigSMALL_NETWORK_BUFFER_SIZE
+	#define ipconfigSMALL_NETWORK_BUFFER_SIZE	128
+#endif
+
+#ifndef ipconfigNETWORK_BUFFER_SIZE
+	#define ipconfigNETWORK_BUFFER_SIZE		ipTOTAL_ETHERNET_FRAME_SIZE
+#endif
+
 #ifndef ipconfigEVENT_QUEUE_LENGTH
 	#define ipconfigEVENT_QUEUE_LENGTH		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
 #endif
 
+/* Received PTP and control frames waiting for the IP-task, see
+xSendPriorityEventStructToIPTask(). */
+#ifndef ipconfigPRIORITY_EVENT_QUEUE_LENGTH
+	#define ipconfigPRIORITY_EVENT_QUEUE_LENGTH		ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS
+#endif
+
 #ifndef ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND
 	#define ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND 1
 #endif
@@ -342,6 +372,27 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigARP_USE_CLASH_DETECTION		1
 #endif
 
+#ifndef ipconfigDHCP_USE_LEASE_CACHE
+	/*
+	 * Only applicable when DHCP is in use:
+	 * After a reset, ask the application for the last lease (see
+	 * xApplicationDHCPLeaseLoad()) and confirm it with an INIT-REBOOT
+	 * request instead of going through a full discovery.
+	 */
+	#define ipconfigDHCP_USE_LEASE_CACHE		( 0 )
+#endif
+
+#ifndef ipconfigDHCP_INIT_REBOOT_TX_PERIOD
+	/* First retransmission period of the INIT-REBOOT request, in ticks.  The
+	period doubles until it exceeds ipconfigDHCP_INIT_REBOOT_MAX_TX_PERIOD, then
+	the static address passed to FreeRTOS_IPInit() is used. */
+	#define ipconfigDHCP_INIT_REBOOT_TX_PERIOD		( pdMS_TO_TICKS( 50u ) )
+#endif
+
+#ifndef ipconfigDHCP_INIT_REBOOT_MAX_TX_PERIOD
+	#define ipconfigDHCP_INIT_REBOOT_MAX_TX_PERIOD	( pdMS_TO_TICKS( 200u ) )
+#endif
+
 #ifndef ipconfigARP_USE_CLASH_DETECTION
 	#define ipconfigARP_USE_CLASH_DETECTION		0
 #endif
@@ -445,6 +496,67 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define	ipconfigETHERNET_DRIVER_FILTERS_PACKETS	( 0 )
 #endif
 
+/* Set to 1 when the network interface filters the received frames on the
+ports of the bound sockets. It must then implement
+vNetworkInterfaceBoundPortsChanged(), which is called after each bind and
+unbind, and may read the ports with uxSocketGetBoundPorts(). */
+#ifndef ipconfigETHERNET_DRIVER_FILTERS_PORTS
+	#define	ipconfigETHERNET_DRIVER_FILTERS_PORTS	( 0 )
+#endif
+
+/* Set to 1 to let the network interface hand UDP datagrams straight to the
+sockets that set FREERTOS_SO_UDP_FAST_PATH, by calling xProcessUDPFastPath()
+from its own task instead of going through the IP-task. */
+#ifndef ipconfigUDP_FAST_PATH
+	#define	ipconfigUDP_FAST_PATH	( 0 )
+#endif
+
+/* Set to 1 to let each UDP socket keep the Ethernet, IP and UDP headers of
+its last destination.  Sending again to the same host and port then copies
+these headers instead of looking up the ARP cache and the route. */
+#ifndef ipconfigUDP_DESTINATION_CACHE
+	#define ipconfigUDP_DESTINATION_CACHE	( 0 )
+#endif
+
+/* Set to 1 to reassemble received IPv4 fragments of UDP datagrams and to
+fragment UDP datagrams bigger than the MTU on send (FreeRTOS_IP_Fragment.c).
+The network interface must implement xNetworkInterfaceOutputSG() and
+BufferAllocation_3.c must provide ipconfigNUM_JUMBO_NETWORK_BUFFERS buffers
+of ipconfigJUMBO_NETWORK_BUFFER_SIZE bytes to hold the datagrams. */
+#ifndef ipconfigUSE_IP_FRAGMENTATION
+	#define ipconfigUSE_IP_FRAGMENTATION	( 0 )
+#endif
+
+/* Largest datagram sent or reassembled, IP header included. */
+#ifndef ipconfigIP_MAX_DATAGRAM_SIZE
+	#define ipconfigIP_MAX_DATAGRAM_SIZE	( 16384 )
+#endif
+
+/* Number of datagrams that can be reassembled at the same time, each one
+holds a jumbo buffer until it is complete or times out. */
+#ifndef ipconfigIP_REASSEMBLY_SLOTS
+	#define ipconfigIP_REASSEMBLY_SLOTS		( 2 )
+#endif
+
+#ifndef ipconfigIP_REASSEMBLY_TIMEOUT_MS
+	#define ipconfigIP_REASSEMBLY_TIMEOUT_MS	( 1000 )
+#endif
+
+/* BufferAllocation_3.c: the last ipconfigNUM_JUMBO_NETWORK_BUFFERS network
+buffers hold ipconfigJUMBO_NETWORK_BUFFER_SIZE bytes.  They are only handed
+out for requests that do not fit ipconfigNETWORK_BUFFER_SIZE. */
+#ifndef ipconfigNUM_JUMBO_NETWORK_BUFFERS
+	#define ipconfigNUM_JUMBO_NETWORK_BUFFERS	( 0 )
+#endif
+
+#ifndef ipconfigJUMBO_NETWORK_BUFFER_SIZE
+	#define ipconfigJUMBO_NETWORK_BUFFER_SIZE	( ipSIZE_OF_ETH_HEADER + ipconfigIP_MAX_DATAGRAM_SIZE )
+#endif
+
+#if( ( ipconfigUSE_IP_FRAGMENTATION != 0 ) && ( ipconfigNUM_JUMBO_NETWORK_BUFFERS == 0 ) )
+	#error ipconfigUSE_IP_FRAGMENTATION needs ipconfigNUM_JUMBO_NETWORK_BUFFERS
+#endif
+
 #ifndef ipconfigWATCHDOG_TIMER
 	/* This macro will be called in every loop the IP-task makes.  It may be
 	replaced by user-code that triggers a watchdog */
@@ -69,6 +69,11 @@ typedef enum
  */
 void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress, const uint32_t ulIPAddress );
 
+/* Incremented whenever a MAC address returned by eARPGetCacheEntry() may have
+become stale: an ARP cache row changed or expired, the cache was cleared or the
+local MAC address changed.  Used to validate the UDP destination caches. */
+extern uint32_t ulARPCacheGeneration;
+
 #if( ipconfigARP_USE_CLASH_DETECTION != 0 )
 	/* Becomes non-zero if another device responded to a gratuitos ARP message. */
 	extern BaseType_t xARPHadIPClash;
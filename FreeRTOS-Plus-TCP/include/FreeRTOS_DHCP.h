@@ -67,6 +67,28 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Configuration.htm
 */
 eDHCPCallbackAnswer_t xApplicationDHCPHook( eDHCPCallbackPhase_t eDHCPPhase, uint32_t ulIPAddress );
 
+#if( ipconfigDHCP_USE_LEASE_CACHE != 0 )
+	/* The part of a lease that survives a reset, all in network byte order. */
+	typedef struct xDHCP_LEASE
+	{
+		uint32_t ulIPAddress;
+		uint32_t ulNetMask;
+		uint32_t ulGatewayAddress;
+		uint32_t ulDNSServerAddress;
+		uint32_t ulDHCPServerAddress;
+	} DHCPLease_t;
+
+	/* Hooks that must be provided by the application if
+	ipconfigDHCP_USE_LEASE_CACHE is set to 1.  xApplicationDHCPLeaseLoad() is
+	called from the IP-task when DHCP starts and returns pdTRUE if *pxLease was
+	filled in.  vApplicationDHCPLeaseStore() is called from the IP-task when an
+	acknowledged lease differs from the cached one, or with NULL when the
+	server refused the cached lease.  It should not block: defer slow writes to
+	another task. */
+	BaseType_t xApplicationDHCPLeaseLoad( DHCPLease_t *pxLease );
+	void vApplicationDHCPLeaseStore( const DHCPLease_t *pxLease );
+#endif /* ipconfigDHCP_USE_LEASE_CACHE */
+
 #ifdef __cplusplus
 }	/* extern "C" */
 #endif
@@ -228,8 +228,15 @@ typedef union XPROT_PACKET
 } ProtocolPacket_t;
 
 
+/* The largest IP datagram that is sent or accepted, IP header included. */
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	#define ipMAX_IP_DATAGRAM_LENGTH	ipconfigIP_MAX_DATAGRAM_SIZE
+#else
+	#define ipMAX_IP_DATAGRAM_LENGTH	ipconfigNETWORK_MTU
+#endif
+
 /* The maximum UDP payload length. */
-#define ipMAX_UDP_PAYLOAD_LENGTH ( ( ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER ) - ipSIZE_OF_UDP_HEADER )
+#define ipMAX_UDP_PAYLOAD_LENGTH ( ( ipMAX_IP_DATAGRAM_LENGTH - ipSIZE_OF_IPv4_HEADER ) - ipSIZE_OF_UDP_HEADER )
 
 typedef enum
 {
@@ -254,6 +261,7 @@ typedef enum
 	eSocketCloseEvent,		/* 9: Send a message to the IP-task to close a socket. */
 	eSocketSelectEvent,		/*10: Send a message to the IP-task for select(). */
 	eSocketSignalEvent,		/*11: A socket must be signalled. */
+	eStackTxBatchEvent,		/*12: FreeRTOS_sendmmsg() has queued a chain of packets to transmit. */
 } eIPEvent_t;
 
 typedef struct IP_TASK_COMMANDS
@@ -564,6 +572,7 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		size_t uxTxStreamSize;
 		StreamBuffer_t *rxStream;
 		StreamBuffer_t *txStream;
+		const uint8_t *pucTxFileHead;	/* When not NULL, txStream only holds place holders for the flash data that ends here, see FreeRTOS_sendfile() */
 		#if( ipconfigUSE_TCP_WIN == 1 )
 			NetworkBufferDescriptor_t *pxAckMessage;
 		#endif /* ipconfigUSE_TCP_WIN */
@@ -592,6 +601,20 @@ BaseType_t xIPIsNetworkTaskReady( void );
 
 #endif /* ipconfigUSE_TCP */
 
+#if( ipconfigUDP_DESTINATION_CACHE != 0 )
+	/* The headers of the last datagram that a UDP socket sent.  They are
+	reused as long as the destination, the local addressing and the ARP cache
+	do not change.  Only accessed by the IP-task. */
+	typedef struct xUDP_DESTINATION_CACHE
+	{
+		UDPPacket_t xHeaders;			/* Lengths and checksums are left 0. */
+		uint32_t ulARPCacheGeneration;	/* ulARPCacheGeneration when the headers were built. */
+		uint32_t ulNetMask;
+		uint32_t ulGatewayAddress;
+		BaseType_t xValid;
+	} UDPDestinationCache_t;
+#endif /* ipconfigUDP_DESTINATION_CACHE */
+
 typedef struct UDPSOCKET
 {
 	List_t xWaitingPacketsList;	/* Incoming packets */
@@ -605,6 +628,12 @@ typedef struct UDPSOCKET
 											 */
 		FOnUDPSent_t pxHandleSent;
 	#endif /* ipconfigUSE_CALLBACKS */
+	#if( ipconfigUDP_FAST_PATH == 1 )
+		BaseType_t xFastPath;	/* Set with FREERTOS_SO_UDP_FAST_PATH. */
+	#endif /* ipconfigUDP_FAST_PATH */
+	#if( ipconfigUDP_DESTINATION_CACHE != 0 )
+		UDPDestinationCache_t xDestination;
+	#endif /* ipconfigUDP_DESTINATION_CACHE */
 } IPUDPSocket_t;
 
 typedef enum eSOCKET_EVENT {
@@ -680,6 +709,15 @@ FreeRTOS_Socket_t *pxUDPSocketLookup( UBaseType_t uxLocalPort );
  */
 void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer );
 
+/*
+ * Called for a batch of UDP packets from FreeRTOS_sendmmsg(), all to the same
+ * destination.  The buffers are chained through xBufferListItem.pxNext, which is
+ * not used while a buffer is on its way to the IP-task.
+ */
+void vProcessGeneratedUDPBatch( NetworkBufferDescriptor_t * const pxFirstBuffer );
+#define ipGET_NEXT_BATCH_BUFFER( pxBuffer ) ( ( NetworkBufferDescriptor_t * ) ( ( pxBuffer )->xBufferListItem.pxNext ) )
+#define ipSET_NEXT_BATCH_BUFFER( pxBuffer, pxNextBuffer ) ( ( pxBuffer )->xBufferListItem.pxNext = ( ListItem_t * ) ( pxNextBuffer ) )
+
 /*
  * Calculate the upper-layer checksum
  * Works both for UDP, ICMP and TCP packages
@@ -689,6 +727,10 @@ void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuff
  */
 uint16_t usGenerateProtocolChecksum( const uint8_t * const pucEthernetBuffer, size_t uxBufferLength, BaseType_t xOutgoingPacket );
 
+/* Returned by usGenerateProtocolChecksum() for a valid checksum of an incoming
+packet, or when the checksum does not need to be calculated. */
+#define ipCORRECT_CRC				0xffffu
+
 /*
  * An Ethernet frame has been updated (maybe it was an ARP request or a PING
  * request?) and is to be sent back to its source.
@@ -761,6 +803,44 @@ BaseType_t xSendEventToIPTask( eIPEvent_t eEvent );
  */
 BaseType_t xSendEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t xTimeout );
 
+/*
+ * The same as above, but a received frame goes to a separate queue that the
+ * IP-task empties first, so that it is processed before the frames already
+ * waiting (PTP, control).  The priority frames keep their order.
+ */
+BaseType_t xSendPriorityEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t xTimeout );
+
+#if( ipconfigETHERNET_DRIVER_FILTERS_PORTS == 1 )
+	/*
+	 * Copies the local ports of the bound UDP or TCP sockets to pusPorts, each
+	 * port once. Returns the number of ports, or uxMaxPorts + 1 if they do not
+	 * fit.
+	 */
+	UBaseType_t uxSocketGetBoundPorts( BaseType_t xProtocol, uint16_t *pusPorts, UBaseType_t uxMaxPorts );
+
+	/*
+	 * Implemented by the network interface, called after a socket was bound
+	 * or unbound so that the hardware filter can follow.
+	 */
+	void vNetworkInterfaceBoundPortsChanged( void );
+#endif /* ipconfigETHERNET_DRIVER_FILTERS_PORTS */
+
+#if( ipconfigUDP_FAST_PATH == 1 )
+	/*
+	 * Called by the network interface for a received frame, from its own task.
+	 * Returns pdPASS when the frame was a UDP datagram for a fast path socket,
+	 * the buffer is then consumed.  Otherwise the buffer is left unchanged and
+	 * must be sent to the IP-task as usual.
+	 */
+	BaseType_t xProcessUDPFastPath( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+
+	/*
+	 * Delivers a validated datagram if the socket bound to usPort is a fast
+	 * path socket.  Used by xProcessUDPFastPath().
+	 */
+	BaseType_t xProcessReceivedUDPPacketFast( NetworkBufferDescriptor_t *pxNetworkBuffer, uint16_t usPort, size_t uxPayloadLength );
+#endif /* ipconfigUDP_FAST_PATH */
+
 /*
  * Returns a pointer to the original NetworkBuffer from a pointer to a UDP
  * payload buffer.
@@ -810,6 +890,39 @@ void vIPReloadDHCPTimer( uint32_t ulLeaseTime );
 	void vIPSetDnsTimerEnableState( BaseType_t xEnableState );
 #endif
 
+/* The MF flag and the fragment offset of usFragmentOffset, in network order:
+non-zero for any fragment of a datagram. */
+#if( ipconfigBYTE_ORDER == pdFREERTOS_LITTLE_ENDIAN )
+	#define ipFRAGMENT_FLAGS_OFFSET_MASK	( ( uint16_t ) 0xff3f )
+#else
+	#define ipFRAGMENT_FLAGS_OFFSET_MASK	( ( uint16_t ) 0x3fff )
+#endif
+
+#if( ipconfigUSE_IP_FRAGMENTATION != 0 )
+	/*
+	 * Copies a received fragment into its reassembly slot.  Returns the
+	 * complete datagram, in a jumbo network buffer, when this fragment was the
+	 * last one missing, otherwise NULL.  The caller keeps the fragment.
+	 */
+	NetworkBufferDescriptor_t *pxIPReassemble( const NetworkBufferDescriptor_t * const pxFragment );
+
+	/*
+	 * Drops the datagrams that have not been completed in time.  Returns
+	 * pdTRUE while a datagram is still being reassembled.
+	 */
+	BaseType_t xIPReassemblyCheck( void );
+
+	/* Starts the IP-task timer that calls xIPReassemblyCheck(). */
+	void vIPReassemblyTimerStart( void );
+
+	/*
+	 * Sends a UDP datagram that is bigger than the MTU as fragments.  The
+	 * buffer holds the complete frame, with its headers filled in, and is
+	 * always taken over.
+	 */
+	void vIPFragmentAndSend( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+#endif /* ipconfigUSE_IP_FRAGMENTATION */
+
 /* Send the network-up event and start the ARP timer. */
 void vIPNetworkUpCalls( void );
 
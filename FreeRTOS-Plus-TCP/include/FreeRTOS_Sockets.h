@@ -130,6 +130,10 @@ FreeRTOS_setsockopt(). */
 	#define FREERTOS_SO_WAKEUP_CALLBACK	( 17 )
 #endif
 
+#if( ipconfigUDP_FAST_PATH == 1 )
+	#define FREERTOS_SO_UDP_FAST_PATH	( 18 )		/* Receive without the IP-task, parameter is pointer to BaseType_t. A receive handler is then called from the network interface task with the scheduler suspended. */
+#endif
+
 
 #define FREERTOS_NOT_LAST_IN_FRAGMENTED_PACKET 	( 0x80 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 #define FREERTOS_FRAGMENTED_PACKET				( 0x40 )  /* For internal use only, but also part of an 8-bit bitwise value. */
@@ -173,6 +177,16 @@ struct freertos_sockaddr
 	uint32_t sin_addr;
 };
 
+/* One datagram of FreeRTOS_recvmmsg() / FreeRTOS_sendmmsg().  Both work on zero
+copy buffers only: pvData is a UDP payload buffer as returned by
+FreeRTOS_GetUDPPayloadBuffer() or received with FREERTOS_ZERO_COPY. */
+struct freertos_mmsghdr
+{
+	void *pvData;						/* Start of the UDP payload. */
+	size_t xLength;						/* Length of the UDP payload. */
+	struct freertos_sockaddr xAddress;	/* Source address, set by FreeRTOS_recvmmsg(). */
+};
+
 #if ipconfigBYTE_ORDER == pdFREERTOS_LITTLE_ENDIAN
 
 	#define FreeRTOS_inet_addr_quick( ucOctet0, ucOctet1, ucOctet2, ucOctet3 )				\
@@ -220,6 +234,15 @@ typedef void *SocketSet_t;
 Socket_t FreeRTOS_socket( BaseType_t xDomain, BaseType_t xType, BaseType_t xProtocol );
 int32_t FreeRTOS_recvfrom(Socket_t xSocket, void *pvBuffer, size_t xBufferLength, BaseType_t xFlags, struct freertos_sockaddr *pxSourceAddress, int32_t *const time_s, int32_t *const time_ns);
 int32_t FreeRTOS_sendto(Socket_t xSocket, const void *pvBuffer, size_t xTotalDataLength, BaseType_t xFlags, const struct freertos_sockaddr *pxDestinationAddress, int32_t *const time_s, int32_t *const time_ns);
+/* Batch versions of the zero copy recvfrom/sendto.  FreeRTOS_recvmmsg() blocks
+like FreeRTOS_recvfrom() until at least one datagram is queued, then takes up to
+uxCount at once and returns how many; every pvData must be released with
+FreeRTOS_ReleaseUDPPayloadBuffer().  FreeRTOS_sendmmsg() passes the datagrams to
+the IP-task as one event, which resolves the MAC address and builds the headers
+once for the whole batch.  It returns uxCount when the buffers now belong to the
+stack, or 0 when they are still owned by the caller. */
+int32_t FreeRTOS_recvmmsg(Socket_t xSocket, struct freertos_mmsghdr *pxMessages, size_t uxCount, BaseType_t xFlags, int32_t *const time_s, int32_t *const time_ns);
+int32_t FreeRTOS_sendmmsg(Socket_t xSocket, const struct freertos_mmsghdr *pxMessages, size_t uxCount, BaseType_t xFlags, const struct freertos_sockaddr *pxDestinationAddress);
 BaseType_t FreeRTOS_bind( Socket_t xSocket, struct freertos_sockaddr *pxAddress, socklen_t xAddressLength );
 
 /* function to get the local address and IP port */
@@ -287,6 +310,30 @@ FreeRTOS_rx_size(). */
  */
 uint8_t *FreeRTOS_get_tx_head( Socket_t xSocket, BaseType_t *pxLength );
 
+/*
+ * For advanced applications only:
+ * After writing to the pointer returned by FreeRTOS_get_tx_head(), pass
+ * 'uxCount' bytes on for transmission.  Returns the number of bytes committed,
+ * which is never more than the '*pxLength' that FreeRTOS_get_tx_head() gave.
+ */
+BaseType_t FreeRTOS_tx_commit( Socket_t xSocket, size_t uxCount );
+
+/*
+ * For advanced applications only:
+ * Release 'uxCount' bytes that were obtained from the rxStream by calling
+ * FreeRTOS_recv() with the FREERTOS_ZERO_COPY flag.
+ */
+BaseType_t FreeRTOS_rx_release( Socket_t xSocket, size_t uxCount );
+
+/*
+ * Send 'uxDataLength' bytes which are stored in flash, or in any memory that
+ * doesn't change until the data has been acknowledged.  The data will not be
+ * copied into the txStream, but straight from 'pvFile' into the packets.
+ * Blocks like FreeRTOS_send().  Ordinary data can only be sent after all
+ * file data has been delivered, and vice versa.
+ */
+BaseType_t FreeRTOS_sendfile( Socket_t xSocket, const void *pvFile, size_t uxDataLength, BaseType_t xFlags );
+
 #endif /* ipconfigUSE_TCP */
 
 /*
@@ -68,6 +68,19 @@ typedef struct xTCP_SEGMENT
 #endif
 } TCPSegment_t;
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+/*
+ *	The Rx or Tx segments of a window, as indexes in the segment pool, in a
+ *	ring sorted on sequence number.  A segment is looked up with a binary search.
+ */
+typedef struct xTCP_SEGMENT_RING
+{
+	uint16_t usHead;					/* Slot of the segment with the lowest sequence number */
+	uint16_t usCount;					/* Number of segments in the ring */
+	uint16_t usSegments[ ipconfigTCP_WIN_RING_LENGTH ];
+} TCPSegmentRing_t;
+#endif
+
 typedef struct xTCP_WINSIZE
 {
 	uint32_t ulRxWindowLength;
@@ -125,7 +138,9 @@ typedef struct xTCP_WINDOW
 	TCPSegment_t *pxHeadSegment;		/* points to a segment which has not been transmitted and it's size is still growing (user data being added) */
 	uint32_t ulOptionsData[ipSIZE_TCP_OPTIONS/sizeof(uint32_t)];	/* Contains the options we send out */
 	List_t xTxSegments;					/* A linked list of all transmission segments, sorted on sequence number */
-	List_t xRxSegments;					/* A linked list of reception segments, order depends on sequence of arrival */
+	List_t xRxSegments;					/* A linked list of reception segments, sorted on sequence number */
+	TCPSegmentRing_t xTxRing;			/* The segments of xTxSegments, indexed on sequence number */
+	TCPSegmentRing_t xRxRing;			/* The segments of xRxSegments, indexed on sequence number */
 #else
 	/* For tiny TCP, there is only 1 outstanding TX segment */
 	TCPSegment_t xTxSegment;			/* Priority queue */
@@ -174,6 +174,12 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceRECVFROM_TIMEOUT()
 #endif
 
+/* A received UDP datagram is handed to the application, by FreeRTOS_recvfrom()
+or by calling the receive handler of the socket. */
+#ifndef iptraceUDP_APPLICATION_RECEIVE
+	#define iptraceUDP_APPLICATION_RECEIVE( pxNetworkBuffer )
+#endif
+
 #ifndef iptraceRECVFROM_INTERRUPTED
 	#define iptraceRECVFROM_INTERRUPTED()
 #endif
@@ -190,4 +196,21 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceSENDTO_DATA_TOO_LONG()
 #endif
 
+/* FreeRTOS_IP_Fragment.c, ipconfigUSE_IP_FRAGMENTATION. */
+#ifndef iptraceIP_FRAGMENT_DROPPED
+	#define iptraceIP_FRAGMENT_DROPPED( pxNetworkBuffer )
+#endif
+
+#ifndef iptraceIP_DATAGRAM_REASSEMBLED
+	#define iptraceIP_DATAGRAM_REASSEMBLED( pxNetworkBuffer )
+#endif
+
+#ifndef iptraceIP_REASSEMBLY_TIMEOUT
+	#define iptraceIP_REASSEMBLY_TIMEOUT( pxNetworkBuffer )
+#endif
+
+#ifndef iptraceIP_FRAGMENTATION_FAILED
+	#define iptraceIP_FRAGMENTATION_FAILED( pxNetworkBuffer )
+#endif
+
 #endif /* UDP_TRACE_MACRO_DEFAULTS_H */
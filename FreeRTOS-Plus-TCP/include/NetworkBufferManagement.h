@@ -45,6 +45,22 @@ UBaseType_t uxGetNumberOfFreeNetworkBuffers( void );
 /* Get the lowest number of free network buffers. */
 UBaseType_t uxGetMinimumFreeNetworkBuffers( void );
 
+/* Usage of one buffer size class, BufferAllocation_3.c only. */
+typedef struct xNETWORK_BUFFER_CLASS_STATS
+{
+	size_t uxBufferSize;		/* Bytes per buffer. */
+	UBaseType_t uxCount;		/* Buffers in the class. */
+	UBaseType_t uxFree;
+	UBaseType_t uxMinimumFree;	/* Low watermark of the free buffers. */
+	UBaseType_t uxMaximumUsed;	/* High watermark of the buffers in use. */
+	uint32_t ulFailed;			/* Requests for this class that got no buffer. */
+	uint32_t ulFallback;		/* Requests for this class served by a bigger one. */
+} NetworkBufferClassStats_t;
+
+/* Class 0 holds the small buffers, class 1 the full size ones and class 2 the
+jumbo ones.  Returns pdFAIL for an unknown class. */
+BaseType_t xGetNetworkBufferClassStats( UBaseType_t uxClass, NetworkBufferClassStats_t *pxStats );
+
 /* Copy a network buffer into a bigger buffer. */
 NetworkBufferDescriptor_t *pxDuplicateNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer,
 	BaseType_t xNewLength);
@@ -33,9 +33,21 @@ extern "C" {
 /* NOTE PUBLIC API FUNCTIONS. */
 BaseType_t xNetworkInterfaceInitialise( void );
 BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+/* With BufferAllocation_3.c the first ipconfigNUM_SMALL_NETWORK_BUFFERS buffers
+hold ipconfigSMALL_NETWORK_BUFFER_SIZE bytes, the others ipconfigNETWORK_BUFFER_SIZE. */
 void vNetworkInterfaceAllocateRAMToBuffers( NetworkBufferDescriptor_t pxNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ] );
 BaseType_t xGetPhyLinkStatus( void );
 
+/* Scatter-gather transmit, supported by the MPC5748G interface. The Ethernet,
+IP and UDP/TCP headers are in pxNetworkBuffer, which is always consumed. The
+payload is sent in place from pvPayload and must not be modified until
+pxPayloadDone( pvArg ) is called from the EMAC task. With
+ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM the checksum fields are left 0 and filled
+in by the MAC, otherwise they must already cover the payload. On pdFAIL the payload was not queued and is
+still owned by the caller, pxPayloadDone is not called. */
+typedef void ( * NetworkPayloadDone_t )( void *pvArg );
+BaseType_t xNetworkInterfaceOutputSG( NetworkBufferDescriptor_t * const pxNetworkBuffer, const void *pvPayload, size_t uxPayloadLength, NetworkPayloadDone_t pxPayloadDone, void *pvArg );
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
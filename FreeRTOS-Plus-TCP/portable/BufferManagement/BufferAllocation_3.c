@@ -0,0 +1,674 @@
+/*
+FreeRTOS+TCP V2.0.11
+Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/******************************************************************************
+ *
+ * Statically allocated network buffers in three size classes, for the e200
+ * cores.
+ *
+ * Like BufferAllocation_1.c the storage comes from
+ * vNetworkInterfaceAllocateRAMToBuffers(): the first
+ * ipconfigNUM_SMALL_NETWORK_BUFFERS descriptors get buffers of
+ * ipconfigSMALL_NETWORK_BUFFER_SIZE bytes, the last
+ * ipconfigNUM_JUMBO_NETWORK_BUFFERS buffers of
+ * ipconfigJUMBO_NETWORK_BUFFER_SIZE bytes and the others buffers of
+ * ipconfigNETWORK_BUFFER_SIZE bytes.  A request is served from the smallest
+ * class that fits, and from the full size class when the small one is
+ * exhausted.  The jumbo buffers only serve requests bigger than a full size
+ * buffer, reassembled and to be fragmented IP datagrams.
+ *
+ * Each class keeps its free buffers on a LIFO linked through
+ * xBufferListItem.pxNext, updated with lwarx/stwcx. so that tasks and
+ * interrupts can allocate and release without a critical section.  The
+ * reservation is local to the core: the buffers must only be used on the core
+ * running the IP-task, which is core 0 in this project.
+ *
+ * A task which finds no buffer and may block waits on the counting semaphore
+ * of the smallest class that serves its request.  A release gives the
+ * semaphore of its class when a task waits there, or of the small class when a
+ * full size buffer is released and only small requests wait, so the release
+ * of a buffer nobody waits for stays free of kernel calls.
+ *
+ ******************************************************************************/
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+/* For an Ethernet interrupt to be able to obtain a network buffer there must
+be at least this number of buffers available. */
+#define baINTERRUPT_BUFFER_GET_THRESHOLD	( 3 )
+
+#define baNUM_CLASSES						( 3 )
+#define baCLASS_SMALL						( 0 )
+#define baCLASS_LARGE						( 1 )
+#define baCLASS_JUMBO						( 2 )
+#define baNUM_LARGE_NETWORK_BUFFERS			( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - ipconfigNUM_SMALL_NETWORK_BUFFERS - ipconfigNUM_JUMBO_NETWORK_BUFFERS )
+
+/* xItemValue of a buffer's list item, the stack does not use it. */
+#define baBUFFER_IN_USE						( 0x0UL )
+#define baBUFFER_FREE						( 0xF8EEB0FFUL )
+
+#define baLINK_OFFSET						offsetof( NetworkBufferDescriptor_t, xBufferListItem.pxNext )
+
+#if( ( ipconfigNUM_SMALL_NETWORK_BUFFERS + ipconfigNUM_JUMBO_NETWORK_BUFFERS ) >= ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS )
+	#error ipconfigNUM_SMALL_NETWORK_BUFFERS must leave buffers for full size frames
+#endif
+
+#if( ipconfigSMALL_NETWORK_BUFFER_SIZE >= ipconfigNETWORK_BUFFER_SIZE )
+	#error ipconfigSMALL_NETWORK_BUFFER_SIZE must be smaller than ipconfigNETWORK_BUFFER_SIZE
+#endif
+
+#if( ( ipconfigNUM_JUMBO_NETWORK_BUFFERS > 0 ) && ( ipconfigJUMBO_NETWORK_BUFFER_SIZE <= ipconfigNETWORK_BUFFER_SIZE ) )
+	#error ipconfigJUMBO_NETWORK_BUFFER_SIZE must be bigger than ipconfigNETWORK_BUFFER_SIZE
+#endif
+
+typedef struct xBUFFER_CLASS
+{
+	NetworkBufferDescriptor_t * volatile pxFreeHead;
+	volatile UBaseType_t uxFree;
+	volatile UBaseType_t uxMinimumFree;
+	volatile uint32_t ulFailed;
+	volatile uint32_t ulFallback;
+	UBaseType_t uxCount;
+	size_t uxBufferSize;
+	NetworkBufferDescriptor_t *pxFirst;
+	volatile UBaseType_t uxWaiting;
+	SemaphoreHandle_t xWaitSemaphore;
+} BufferClass_t;
+
+/* Declares the pool of NetworkBufferDescriptor_t structures that are available
+to the system, the small buffers first and the jumbo buffers last. */
+static NetworkBufferDescriptor_t xNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+
+/* Ordered by buffer size. */
+static BufferClass_t xBufferClasses[ baNUM_CLASSES ];
+
+static BaseType_t xBuffersInitialised = pdFALSE;
+
+/* This constant is defined as false to let FreeRTOS_TCP_IP.c know that the
+network buffers have a variable size: resizing may be necessary */
+const BaseType_t xBufferAllocFixedSize = pdFALSE;
+
+#if( ipconfigTCP_IP_SANITY != 0 )
+	static char cIsLow = pdFALSE;
+	UBaseType_t bIsValidNetworkDescriptor( const NetworkBufferDescriptor_t * pxDesc );
+#else
+	static UBaseType_t bIsValidNetworkDescriptor( const NetworkBufferDescriptor_t * pxDesc );
+#endif /* ipconfigTCP_IP_SANITY */
+
+static void prvShowWarnings( void );
+
+/*-----------------------------------------------------------*/
+
+static portFORCE_INLINE NetworkBufferDescriptor_t *prvPopFreeBuffer( BufferClass_t *pxClass )
+{
+NetworkBufferDescriptor_t *pxHead;
+NetworkBufferDescriptor_t *pxNext;
+
+	/* An interrupt that changes the head in between takes the reservation and
+	the stwcx. fails, so the head can not be popped twice. */
+	__asm__ volatile
+	(
+		"1:	lwarx	%0, 0, %2		\n\t"
+		"	e_cmp16i	%0, 0		\n\t"
+		"	e_beq	2f				\n\t"
+		"	e_lwz	%1, %3(%0)		\n\t"
+		"	stwcx.	%1, 0, %2		\n\t"
+		"	e_bne	1b				\n\t"
+		"2:							\n\t"
+		: "=&b" ( pxHead ), "=&r" ( pxNext )
+		: "r" ( &( pxClass->pxFreeHead ) ), "n" ( baLINK_OFFSET )
+		: "cr0", "memory"
+	);
+
+	return pxHead;
+}
+/*-----------------------------------------------------------*/
+
+static portFORCE_INLINE void prvPushFreeBuffer( BufferClass_t *pxClass, NetworkBufferDescriptor_t *pxBuffer )
+{
+NetworkBufferDescriptor_t *pxHead;
+
+	__asm__ volatile
+	(
+		"1:	lwarx	%0, 0, %2		\n\t"
+		"	e_stw	%0, %3(%1)		\n\t"
+		"	stwcx.	%1, 0, %2		\n\t"
+		"	e_bne	1b				\n\t"
+		: "=&r" ( pxHead )
+		: "b" ( pxBuffer ), "r" ( &( pxClass->pxFreeHead ) ), "n" ( baLINK_OFFSET )
+		: "cr0", "memory"
+	);
+}
+/*-----------------------------------------------------------*/
+
+static portFORCE_INLINE UBaseType_t prvAtomicAdd( volatile UBaseType_t *puxValue, BaseType_t xDelta )
+{
+UBaseType_t uxResult;
+
+	__asm__ volatile
+	(
+		"1:	lwarx	%0, 0, %1		\n\t"
+		"	add		%0, %0, %2		\n\t"
+		"	stwcx.	%0, 0, %1		\n\t"
+		"	e_bne	1b				\n\t"
+		: "=&r" ( uxResult )
+		: "r" ( puxValue ), "r" ( xDelta )
+		: "cr0", "memory"
+	);
+
+	return uxResult;
+}
+/*-----------------------------------------------------------*/
+
+/* Returns pdTRUE when *pulValue was ulExpected and has been replaced. */
+static portFORCE_INLINE BaseType_t prvCompareAndSwap( volatile uint32_t *pulValue, uint32_t ulExpected, uint32_t ulNew )
+{
+uint32_t ulOld;
+
+	__asm__ volatile
+	(
+		"1:	lwarx	%0, 0, %1		\n\t"
+		"	cmpw	%0, %2			\n\t"
+		"	e_bne	2f				\n\t"
+		"	stwcx.	%3, 0, %1		\n\t"
+		"	e_bne	1b				\n\t"
+		"2:							\n\t"
+		: "=&r" ( ulOld )
+		: "r" ( pulValue ), "r" ( ulExpected ), "r" ( ulNew )
+		: "cr0", "memory"
+	);
+
+	return ( ulOld == ulExpected ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static BufferClass_t *prvGetBufferClass( const NetworkBufferDescriptor_t *pxDesc )
+{
+	if( pxDesc < xBufferClasses[ baCLASS_LARGE ].pxFirst )
+	{
+		return &( xBufferClasses[ baCLASS_SMALL ] );
+	}
+	if( pxDesc < xBufferClasses[ baCLASS_JUMBO ].pxFirst )
+	{
+		return &( xBufferClasses[ baCLASS_LARGE ] );
+	}
+	return &( xBufferClasses[ baCLASS_JUMBO ] );
+}
+/*-----------------------------------------------------------*/
+
+/* Take a buffer from the smallest class that can hold xRequestedSizeBytes and
+keeps more than uxReserve buffers free, NULL if there is none. */
+static NetworkBufferDescriptor_t *prvTakeBuffer( size_t xRequestedSizeBytes, UBaseType_t uxReserve )
+{
+NetworkBufferDescriptor_t *pxReturn = NULL;
+BufferClass_t *pxClass;
+UBaseType_t uxClass, uxFree;
+
+	for( uxClass = 0; uxClass < baNUM_CLASSES; uxClass++ )
+	{
+		pxClass = &( xBufferClasses[ uxClass ] );
+		if( ( xRequestedSizeBytes > pxClass->uxBufferSize ) || ( pxClass->uxFree <= uxReserve ) )
+		{
+			continue;
+		}
+		/* A frame must never take one of the few jumbo buffers. */
+		if( ( uxClass == baCLASS_JUMBO ) && ( xRequestedSizeBytes <= xBufferClasses[ baCLASS_LARGE ].uxBufferSize ) )
+		{
+			break;
+		}
+
+		pxReturn = prvPopFreeBuffer( pxClass );
+		if( pxReturn != NULL )
+		{
+			pxReturn->xBufferListItem.xItemValue = baBUFFER_IN_USE;
+			uxFree = prvAtomicAdd( &( pxClass->uxFree ), -1 );
+
+			/* For stats, latch the lowest number of free buffers since
+			booting.  A race with an interrupt only delays the update. */
+			if( pxClass->uxMinimumFree > uxFree )
+			{
+				pxClass->uxMinimumFree = uxFree;
+			}
+			if( ( uxClass > baCLASS_SMALL ) && ( xBufferClasses[ baCLASS_SMALL ].uxCount > 0 ) && ( xRequestedSizeBytes <= xBufferClasses[ baCLASS_SMALL ].uxBufferSize ) )
+			{
+				xBufferClasses[ baCLASS_SMALL ].ulFallback++;
+			}
+			break;
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+/* The class a task waits on for xRequestedSizeBytes, NULL if no class can
+serve the request. */
+static BufferClass_t *prvGetWaitClass( size_t xRequestedSizeBytes )
+{
+UBaseType_t uxClass;
+
+	for( uxClass = 0; uxClass < baNUM_CLASSES; uxClass++ )
+	{
+		if( ( xBufferClasses[ uxClass ].uxCount > 0 ) && ( xRequestedSizeBytes <= xBufferClasses[ uxClass ].uxBufferSize ) )
+		{
+			return &( xBufferClasses[ uxClass ] );
+		}
+	}
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCountFailure( size_t xRequestedSizeBytes )
+{
+	if( xRequestedSizeBytes <= xBufferClasses[ baCLASS_SMALL ].uxBufferSize )
+	{
+		xBufferClasses[ baCLASS_SMALL ].ulFailed++;
+	}
+	else if( xRequestedSizeBytes <= xBufferClasses[ baCLASS_LARGE ].uxBufferSize )
+	{
+		xBufferClasses[ baCLASS_LARGE ].ulFailed++;
+	}
+	else
+	{
+		xBufferClasses[ baCLASS_JUMBO ].ulFailed++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Returns pdFALSE when the buffer was free already.  pxHigherPriorityTaskWoken
+is NULL when called from a task. */
+static BaseType_t prvGiveBuffer( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t *pxHigherPriorityTaskWoken )
+{
+BufferClass_t *pxClass = prvGetBufferClass( pxNetworkBuffer );
+BufferClass_t *pxWaitClass = NULL;
+
+	if( prvCompareAndSwap( ( volatile uint32_t * ) &( pxNetworkBuffer->xBufferListItem.xItemValue ), baBUFFER_IN_USE, baBUFFER_FREE ) == pdFALSE )
+	{
+		return pdFALSE;
+	}
+	/* Counted before it is pushed and after it is popped, so that uxFree
+	never falls below the length of the list. */
+	( void ) prvAtomicAdd( &( pxClass->uxFree ), 1 );
+	prvPushFreeBuffer( pxClass, pxNetworkBuffer );
+
+	/* Read after the push: a waiter registers before it tries to take again,
+	so either it finds this buffer or it is woken. */
+	if( pxClass->uxWaiting != 0 )
+	{
+		pxWaitClass = pxClass;
+	}
+	else if( ( pxClass == &( xBufferClasses[ baCLASS_LARGE ] ) ) && ( xBufferClasses[ baCLASS_SMALL ].uxWaiting != 0 ) )
+	{
+		/* Small requests are served by the full size class as well. */
+		pxWaitClass = &( xBufferClasses[ baCLASS_SMALL ] );
+	}
+
+	if( pxWaitClass != NULL )
+	{
+		if( pxHigherPriorityTaskWoken == NULL )
+		{
+			( void ) xSemaphoreGive( pxWaitClass->xWaitSemaphore );
+		}
+		else
+		{
+			( void ) xSemaphoreGiveFromISR( pxWaitClass->xWaitSemaphore, pxHigherPriorityTaskWoken );
+		}
+	}
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigTCP_IP_SANITY != 0 )
+
+	/* HT: SANITY code will be removed as soon as the library is stable
+	 * and and ready to become public
+	 * Function below gives information about the use of buffers */
+	#define WARN_LOW		( 2 )
+	#define WARN_HIGH		( ( 5 * ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ) / 10 )
+
+	BaseType_t prvIsFreeBuffer( const NetworkBufferDescriptor_t *pxDescr )
+	{
+		return ( bIsValidNetworkDescriptor( pxDescr ) != 0 ) &&
+			( pxDescr->xBufferListItem.xItemValue == baBUFFER_FREE );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvShowWarnings( void )
+	{
+		UBaseType_t uxCount = uxGetNumberOfFreeNetworkBuffers( );
+		if( ( ( cIsLow == 0 ) && ( uxCount <= WARN_LOW ) ) || ( ( cIsLow != 0 ) && ( uxCount >= WARN_HIGH ) ) )
+		{
+			cIsLow = !cIsLow;
+			FreeRTOS_debug_printf( ( "*** Warning *** %s %lu buffers left\n", cIsLow ? "only" : "now", uxCount ) );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	UBaseType_t bIsValidNetworkDescriptor( const NetworkBufferDescriptor_t * pxDesc )
+	{
+		uint32_t offset = ( uint32_t ) ( ((const char *)pxDesc) - ((const char *)xNetworkBuffers) );
+		if( ( offset >= sizeof( xNetworkBuffers ) ) ||
+			( ( offset % sizeof( xNetworkBuffers[0] ) ) != 0 ) )
+			return pdFALSE;
+		return (UBaseType_t) (pxDesc - xNetworkBuffers) + 1;
+	}
+	/*-----------------------------------------------------------*/
+
+#else
+	static UBaseType_t bIsValidNetworkDescriptor (const NetworkBufferDescriptor_t * pxDesc)
+	{
+		( void ) pxDesc;
+		return ( UBaseType_t ) pdTRUE;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvShowWarnings( void )
+	{
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigTCP_IP_SANITY */
+
+BaseType_t xNetworkBuffersInitialise( void )
+{
+BaseType_t x;
+BufferClass_t *pxClass;
+
+	/* Only initialise the buffers if they have not been initialised before. */
+	if( xBuffersInitialised == pdFALSE )
+	{
+		/* The small buffers must hold a TCP packet with options, it may be
+		turned into a reply in place. */
+		configASSERT( ( ipconfigNUM_SMALL_NETWORK_BUFFERS == 0 ) || ( ipconfigSMALL_NETWORK_BUFFER_SIZE >= sizeof( TCPPacket_t ) ) );
+
+		xBufferClasses[ baCLASS_SMALL ].uxCount = ipconfigNUM_SMALL_NETWORK_BUFFERS;
+		xBufferClasses[ baCLASS_SMALL ].uxBufferSize = ipconfigSMALL_NETWORK_BUFFER_SIZE;
+		xBufferClasses[ baCLASS_SMALL ].pxFirst = &( xNetworkBuffers[ 0 ] );
+		xBufferClasses[ baCLASS_LARGE ].uxCount = baNUM_LARGE_NETWORK_BUFFERS;
+		xBufferClasses[ baCLASS_LARGE ].uxBufferSize = ipconfigNETWORK_BUFFER_SIZE;
+		xBufferClasses[ baCLASS_LARGE ].pxFirst = &( xNetworkBuffers[ ipconfigNUM_SMALL_NETWORK_BUFFERS ] );
+		/* Without jumbo buffers pxFirst points past the array, no
+		descriptor is found in the class. */
+		xBufferClasses[ baCLASS_JUMBO ].uxCount = ipconfigNUM_JUMBO_NETWORK_BUFFERS;
+		xBufferClasses[ baCLASS_JUMBO ].uxBufferSize = ipconfigJUMBO_NETWORK_BUFFER_SIZE;
+		xBufferClasses[ baCLASS_JUMBO ].pxFirst = &( xNetworkBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - ipconfigNUM_JUMBO_NETWORK_BUFFERS ] );
+
+		/* Initialise all the network buffers.  The buffer storage comes
+		from the network interface, and different hardware has different
+		requirements. */
+		vNetworkInterfaceAllocateRAMToBuffers( xNetworkBuffers );
+
+		for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+		{
+			/* Initialise and set the owner of the buffer list items. */
+			vListInitialiseItem( &( xNetworkBuffers[ x ].xBufferListItem ) );
+			listSET_LIST_ITEM_OWNER( &( xNetworkBuffers[ x ].xBufferListItem ), &xNetworkBuffers[ x ] );
+		}
+
+		/* Push in reverse, so that the buffers are handed out in address order. */
+		for( x = ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - 1; x >= 0; x-- )
+		{
+			pxClass = prvGetBufferClass( &( xNetworkBuffers[ x ] ) );
+			xNetworkBuffers[ x ].xBufferListItem.xItemValue = baBUFFER_FREE;
+			xNetworkBuffers[ x ].xBufferListItem.pxNext = ( ListItem_t * ) pxClass->pxFreeHead;
+			pxClass->pxFreeHead = &( xNetworkBuffers[ x ] );
+		}
+
+		for( x = 0; x < baNUM_CLASSES; x++ )
+		{
+			xBufferClasses[ x ].uxFree = xBufferClasses[ x ].uxCount;
+			xBufferClasses[ x ].uxMinimumFree = xBufferClasses[ x ].uxCount;
+			xBufferClasses[ x ].uxWaiting = 0;
+			if( xBufferClasses[ x ].uxCount > 0 )
+			{
+				/* A give per release a waiter may miss, bounded by the
+				buffers of the class. */
+				xBufferClasses[ x ].xWaitSemaphore = xSemaphoreCreateCounting( xBufferClasses[ x ].uxCount, 0 );
+				configASSERT( xBufferClasses[ x ].xWaitSemaphore );
+				if( xBufferClasses[ x ].xWaitSemaphore == NULL )
+				{
+					return pdFAIL;
+				}
+			}
+		}
+
+		xBuffersInitialised = pdTRUE;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxGetNetworkBufferWithDescriptor( size_t xRequestedSizeBytes, TickType_t xBlockTimeTicks )
+{
+NetworkBufferDescriptor_t *pxReturn;
+BufferClass_t *pxWaitClass;
+TimeOut_t xTimeOut;
+
+	pxReturn = prvTakeBuffer( xRequestedSizeBytes, 0 );
+
+	if( ( pxReturn == NULL ) && ( xBlockTimeTicks > 0 ) )
+	{
+		pxWaitClass = prvGetWaitClass( xRequestedSizeBytes );
+		if( pxWaitClass != NULL )
+		{
+			vTaskSetTimeOutState( &xTimeOut );
+			( void ) prvAtomicAdd( &( pxWaitClass->uxWaiting ), 1 );
+			for( ;; )
+			{
+				/* Taken again after registering, a buffer released in between
+				did not give the semaphore.  After a wake the buffer may have
+				gone to a task which did not wait, then block again. */
+				pxReturn = prvTakeBuffer( xRequestedSizeBytes, 0 );
+				if( ( pxReturn != NULL ) || ( xTaskCheckForTimeOut( &xTimeOut, &xBlockTimeTicks ) != pdFALSE ) )
+				{
+					break;
+				}
+				( void ) xSemaphoreTake( pxWaitClass->xWaitSemaphore, xBlockTimeTicks );
+			}
+			( void ) prvAtomicAdd( &( pxWaitClass->uxWaiting ), -1 );
+		}
+	}
+
+	if( pxReturn != NULL )
+	{
+		pxReturn->xDataLength = xRequestedSizeBytes;
+
+		#if( ipconfigTCP_IP_SANITY != 0 )
+		{
+			prvShowWarnings();
+		}
+		#endif /* ipconfigTCP_IP_SANITY */
+
+		#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
+		{
+			/* make sure the buffer is not linked */
+			pxReturn->pxNextBuffer = NULL;
+		}
+		#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+		if( xTCPWindowLoggingLevel > 3 )
+		{
+			FreeRTOS_debug_printf( ( "BUF_GET[%ld]: %p (%p)\n",
+				bIsValidNetworkDescriptor( pxReturn ),
+				pxReturn, pxReturn->pucEthernetBuffer ) );
+		}
+		iptraceNETWORK_BUFFER_OBTAINED( pxReturn );
+	}
+	else
+	{
+		prvCountFailure( xRequestedSizeBytes );
+		iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER();
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxNetworkBufferGetFromISR( size_t xRequestedSizeBytes )
+{
+NetworkBufferDescriptor_t *pxReturn;
+
+	/* As this is called from an interrupt, only take a buffer if there are at
+	least baINTERRUPT_BUFFER_GET_THRESHOLD buffers remaining.  This prevents,
+	to a certain degree at least, a rapidly executing interrupt exhausting
+	buffer and in so doing preventing tasks from continuing. */
+	pxReturn = prvTakeBuffer( xRequestedSizeBytes, baINTERRUPT_BUFFER_GET_THRESHOLD );
+
+	if( pxReturn != NULL )
+	{
+		pxReturn->xDataLength = xRequestedSizeBytes;
+		iptraceNETWORK_BUFFER_OBTAINED_FROM_ISR( pxReturn );
+	}
+	else
+	{
+		prvCountFailure( xRequestedSizeBytes );
+		iptraceFAILED_TO_OBTAIN_NETWORK_BUFFER_FROM_ISR();
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t vNetworkBufferReleaseFromISR( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	( void ) prvGiveBuffer( pxNetworkBuffer, &xHigherPriorityTaskWoken );
+	iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+
+	return xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+void vReleaseNetworkBufferAndDescriptor( NetworkBufferDescriptor_t * const pxNetworkBuffer )
+{
+	if( bIsValidNetworkDescriptor( pxNetworkBuffer ) == pdFALSE_UNSIGNED )
+	{
+		FreeRTOS_debug_printf( ( "vReleaseNetworkBufferAndDescriptor: Invalid buffer %p\n", pxNetworkBuffer ) );
+		return ;
+	}
+
+	if( prvGiveBuffer( pxNetworkBuffer, NULL ) == pdFALSE )
+	{
+		FreeRTOS_debug_printf( ( "vReleaseNetworkBufferAndDescriptor: %p ALREADY RELEASED (now %lu)\n",
+			pxNetworkBuffer, uxGetNumberOfFreeNetworkBuffers( ) ) );
+	}
+	else
+	{
+		prvShowWarnings();
+		if( xTCPWindowLoggingLevel > 3 )
+			FreeRTOS_debug_printf( ( "BUF_PUT[%ld]: %p (%p) (now %lu)\n",
+				bIsValidNetworkDescriptor( pxNetworkBuffer ),
+				pxNetworkBuffer, pxNetworkBuffer->pucEthernetBuffer,
+				uxGetNumberOfFreeNetworkBuffers( ) ) );
+	}
+	iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
+{
+UBaseType_t uxClass, uxCount = 0;
+
+	/* The classes may have hit their low watermark at different times, this
+	is a lower bound. */
+	for( uxClass = 0; uxClass < baNUM_CLASSES; uxClass++ )
+	{
+		uxCount += xBufferClasses[ uxClass ].uxMinimumFree;
+	}
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
+{
+UBaseType_t uxClass, uxCount = 0;
+
+	for( uxClass = 0; uxClass < baNUM_CLASSES; uxClass++ )
+	{
+		uxCount += xBufferClasses[ uxClass ].uxFree;
+	}
+	return uxCount;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xGetNetworkBufferClassStats( UBaseType_t uxClass, NetworkBufferClassStats_t *pxStats )
+{
+BufferClass_t *pxClass;
+
+	if( uxClass >= baNUM_CLASSES )
+	{
+		return pdFAIL;
+	}
+	pxClass = &( xBufferClasses[ uxClass ] );
+	pxStats->uxBufferSize = pxClass->uxBufferSize;
+	pxStats->uxCount = pxClass->uxCount;
+	pxStats->uxFree = pxClass->uxFree;
+	pxStats->uxMinimumFree = pxClass->uxMinimumFree;
+	pxStats->uxMaximumUsed = pxClass->uxCount - pxClass->uxMinimumFree;
+	pxStats->ulFailed = pxClass->ulFailed;
+	pxStats->ulFallback = pxClass->ulFallback;
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxNetworkBuffer, size_t xNewSizeBytes )
+{
+NetworkBufferDescriptor_t *pxNewBuffer;
+
+	if( xNewSizeBytes <= prvGetBufferClass( pxNetworkBuffer )->uxBufferSize )
+	{
+		pxNetworkBuffer->xDataLength = xNewSizeBytes;
+		return pxNetworkBuffer;
+	}
+
+	/* The storage belongs to the descriptor, move the data to a buffer of a
+	bigger class.  On failure the caller keeps the original buffer. */
+	pxNewBuffer = pxGetNetworkBufferWithDescriptor( xNewSizeBytes, 0 );
+	if( pxNewBuffer != NULL )
+	{
+		memcpy( pxNewBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
+		pxNewBuffer->ulIPAddress = pxNetworkBuffer->ulIPAddress;
+		pxNewBuffer->usPort = pxNetworkBuffer->usPort;
+		pxNewBuffer->usBoundPort = pxNetworkBuffer->usBoundPort;
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+	return pxNewBuffer;
+}
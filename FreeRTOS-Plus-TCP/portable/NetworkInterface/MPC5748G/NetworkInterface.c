@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
@@ -43,20 +44,100 @@
 #include "NetworkInterface.h"
 
 #include "enet_driver.h"
+#include "interrupt_manager.h"
 #include "phy.h"
 
 #define ETH_INSTANCE (0)
-#define ETH_USED_RING_CNT (1)
+#define ETH_USED_RING_CNT (3)
+
+#if (ETH_USED_RING_CNT > FEATURE_ENET_RING_COUNT)
+#error "ETH_USED_RING_CNT exceeds the number of ENET rings"
+#endif
 
 #define PHY_ADDRESS (1)
 
+/* Ring 0 takes everything the class matchers do not claim (bulk), ring 1 the
+PTP class and ring 2 the control class. The hardware classifies by VLAN priority
+only, untagged frames always land in ring 0 and are sorted in software. */
+#define niRING_BULK (0)
+#define niRING_PTP (1)
+#define niRING_CONTROL (2)
+
 #define ETH_RXBUFNB (8)
-#define ETH_TXBUFNB (8)
+#define ETH_TXBUFNB (16) // a scatter-gather frame takes two descriptors
+#define ETH_PTP_RXBUFNB (4)
+#define ETH_PTP_TXBUFNB (2)
+#define ETH_CONTROL_RXBUFNB (4)
+#define ETH_CONTROL_TXBUFNB (2)
 
 #define ETH_RX_BUF_SIZE (ENET_BUFF_ALIGN(ENET_FRAME_MAX_FRAMELEN))
 #define ETH_TX_BUF_SIZE (ENET_BUFF_ALIGN(ENET_FRAME_MAX_FRAMELEN))
 
-#define niEMAC_HANDLER_TASK_PRIORITY (configMAX_PRIORITIES - 1)
+/* The PTP and control handlers preempt the IP-task, the bulk handler runs below
+it so that a burst of bulk frames is throttled by the IP-task instead of starving
+the other rings. */
+#define niEMAC_PTP_TASK_PRIORITY (configMAX_PRIORITIES - 1)
+#define niEMAC_CONTROL_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#define niEMAC_BULK_TASK_PRIORITY (configMAX_PRIORITIES - 3)
+
+/* The PTP receive interrupt notifies its handler task, so it can not go above
+configMAX_API_CALL_INTERRUPT_PRIORITY. It takes the ceiling itself, ahead of the
+tick and of the other rings, which keep the default priority. */
+#define niPTP_RX_IRQ_PRIORITY (configMAX_API_CALL_INTERRUPT_PRIORITY)
+
+/* VLAN priorities (PCP) matched into the PTP and control rings. */
+#define niPTP_VLAN_PRIO {7, 6}
+#define niCONTROL_VLAN_PRIO {5, 4}
+
+/* UDP destination ports of the untagged control traffic, see
+prvClassifyFrame(). The bootloader takes the requests and the downloaded data
+(0x36) on the same port, only the datagrams with an IP total length below
+niCONTROL_MAX_IP_LENGTH are control traffic, the longer ones are bulk. It is a
+power of two so that the receive parser can match it. */
+#ifndef niCONTROL_UDP_PORTS
+	#define niCONTROL_UDP_PORTS {14229, 8183}
+#endif
+#define niCONTROL_MAX_IP_LENGTH (256U)
+
+/* Adaptive interrupt moderation of the bulk ring: the frame rate is sampled
+every niCOAL_SAMPLE_TICKS and the coalescing level is raised as soon as the rate
+crosses the entry rate of the next level, and lowered once it falls below half
+of the entry rate of the current one. The PTP and control rings always interrupt
+per frame. */
+#define niCOAL_SAMPLE_TICKS (pdMS_TO_TICKS(10))
+
+/* Time a sender waits for free TX descriptors before the frame is dropped. */
+#define niTX_DESC_WAIT_TICKS (pdMS_TO_TICKS(10))
+
+/* Receive parser: frames are accepted only for the ports of the bound sockets,
+ICMP and ARP for our address, see prvUpdateRxFilter(). */
+#define niPARSER_MAX_ENTRIES (64) // physical depth of the parser table
+#define niPARSER_MAX_PORTS (16) // per protocol
+#define niPARSER_WORD_TYPE (3) // ethertype, IP version/IHL, TOS or VLAN TCI
+#define niPARSER_WORD_IP_LENGTH (4) // IP total length, identification
+#define niPARSER_WORD_PROTO (5) // IP flags/fragment offset, TTL, protocol
+#define niPARSER_WORD_PORT (9) // UDP/TCP destination port, ARP target IP high
+#define niPARSER_WORD_ARP_TPA (10) // ARP target IP low
+#define niPARSER_ACCEPT (0)
+#define niPARSER_REJECT (1)
+#define niPARSER_LINK (2)
+
+/* Define niVERIFY_RX_CHECKSUM to 1 to check the hardware checksum verification
+of every received frame in software, mismatches are counted in
+ENET_RxCsumMismatchCnt. */
+#ifndef niVERIFY_RX_CHECKSUM
+	#define niVERIFY_RX_CHECKSUM (0)
+#endif
+
+/* Notification bit of the bulk handler task to reprogram the parser, the
+other bits are (1 << enet_event_t). */
+#define niNOTIFY_RX_FILTER (1UL << 31)
+
+#define niPTP_ETHERTYPE (0x88F7U)
+#define niIPv4_ETHERTYPE (0x0800U)
+#define niVLAN_ETHERTYPE (0x8100U)
+#define niPTP_EVENT_PORT (319U)
+#define niPTP_GENERAL_PORT (320U)
 
 /* Default the size of the stack used by the EMAC deferred handler task to twice
 the size of the stack used by the idle task - but allow this to be overridden in
@@ -67,18 +148,41 @@ FreeRTOSConfig.h as configMINIMAL_STACK_SIZE is a user definable constant. */
 /*-----------------------------------------------------------*/
 
 /*
- * A deferred interrupt handler task that processes
+ * A deferred interrupt handler task that processes the ring passed as
+ * parameter.
  */
 static void prvEMACHandlerTask(void *pvParameters);
 
 /*
- * See if there is a new packet and forward it to the IP-task.
+ * See if there is a new packet in the ring and forward it to the IP-task.
  */
-static void prvNetworkInterfaceInput(void);
+static uint32_t prvNetworkInterfaceInput(uint8_t ring);
 
-/* After packets have been sent, the network
-	buffers will be released. */
-//static void vClearTXBuffers(void);
+/*
+ * Returns the ring a frame of the bulk ring belongs to by its content.
+ */
+static uint8_t prvClassifyFrame(const uint8_t *pucFrame, uint32_t ulLength);
+
+/*
+ * Accounts the frames read from the bulk ring and adjusts the interrupt
+ * coalescing to the frame rate.
+ */
+static void prvAdaptCoalescing(uint32_t ulFrames);
+
+/*
+ * Programs the receive parser from the bound sockets and the IP address.
+ */
+static void prvUpdateRxFilter(void);
+
+/*
+ * Releases the buffers of all the transmitted descriptors of the bulk ring.
+ */
+static void prvReclaimTxBuffers(void);
+
+/*
+ * Queues the frame (and the scatter-gather payload) on the bulk ring.
+ */
+static BaseType_t prvTransmit(NetworkBufferDescriptor_t *pxDescriptor, const void *pvPayload, size_t uxPayloadLength, NetworkPayloadDone_t pxPayloadDone, void *pvArg);
 
 /*-----------------------------------------------------------*/
 
@@ -113,15 +217,63 @@ ALIGNED(FEATURE_ENET_BUFFDESCR_ALIGNMENT)
 NOINIT_DATA_SECTION static enet_buffer_descriptor_t DMARxDscrTab[ETH_RXBUFNB];
 ALIGNED(FEATURE_ENET_BUFFDESCR_ALIGNMENT)
 NOINIT_DATA_SECTION static enet_buffer_descriptor_t DMATxDscrTab[ETH_TXBUFNB];
+ALIGNED(FEATURE_ENET_BUFFDESCR_ALIGNMENT)
+NOINIT_DATA_SECTION static enet_buffer_descriptor_t DMARxPtpDscrTab[ETH_PTP_RXBUFNB];
+ALIGNED(FEATURE_ENET_BUFFDESCR_ALIGNMENT)
+NOINIT_DATA_SECTION static enet_buffer_descriptor_t DMATxPtpDscrTab[ETH_PTP_TXBUFNB];
+ALIGNED(FEATURE_ENET_BUFFDESCR_ALIGNMENT)
+NOINIT_DATA_SECTION static enet_buffer_descriptor_t DMARxCtrlDscrTab[ETH_CONTROL_RXBUFNB];
+ALIGNED(FEATURE_ENET_BUFFDESCR_ALIGNMENT)
+NOINIT_DATA_SECTION static enet_buffer_descriptor_t DMATxCtrlDscrTab[ETH_CONTROL_TXBUFNB];
+
+/* Holds the handles of the tasks used as deferred interrupt processors, one
+per ring. The handles are used so direct notifications can be sent to the task
+of the ring which raised the interrupt. */
+static TaskHandle_t xEMACTaskHandle[ETH_USED_RING_CNT] = {NULL};
+
+static const uint16_t usControlUdpPorts[] = niCONTROL_UDP_PORTS;
+static uint8_t ucPtpVlanPrio[] = niPTP_VLAN_PRIO;
+static uint8_t ucControlVlanPrio[] = niCONTROL_VLAN_PRIO;
+static const IRQn_Type xPtpRxIrqId[] = FEATURE_ENET_RX_1_IRQS; /* ring 1, niRING_PTP */
+static TickType_t xParserCountRead = 0;
+
+typedef struct
+{
+	uint32_t ulEntryRate; // frames per sample window to enter the level
+	uint8_t ucRxFrames;
+	uint16_t usRxTimeoutUs;
+	uint8_t ucTxFrames;
+	uint16_t usTxTimeoutUs;
+} CoalescingLevel_t;
+
+/* The frame thresholds stay below the ring depths (ETH_RXBUFNB, ETH_TXBUFNB),
+the timeouts bound the added latency. */
+static const CoalescingLevel_t xCoalescingLevels[] =
+{
+	{0, 0, 0, 0, 0}, // interrupt per frame
+	{20, 2, 30, 2, 100}, // 2k frames/s
+	{100, 4, 100, 4, 200}, // 10k frames/s
+	{400, 6, 250, 6, 500}, // 40k frames/s
+};
+static TickType_t xCoalSampleStart = 0;
+static uint32_t ulCoalSampleFrames = 0;
 
-/* Holds the handle of the task used as a deferred interrupt processor.  The
-handle is used so direct notifications can be sent to the task for all EMAC/DMA
-related interrupts. */
-static TaskHandle_t xEMACTaskHandle = NULL;
+/* What to release when a TX descriptor of the bulk ring completes, indexed
+like DMATxDscrTab. */
+typedef struct
+{
+	NetworkBufferDescriptor_t *pxBuffer;
+	NetworkPayloadDone_t pxPayloadDone;
+	void *pvArg;
+} TxSlot_t;
 
-//static enet_buffer_descriptor_t *xTxBufferDescQueue[ETH_TXBUFNB+1];
-//static int xTxBufferDescQueueReadIdx = 0;
-//static int xTxBufferDescQueueWriteIdx = 0;
+static TxSlot_t xTxSlots[ETH_TXBUFNB];
+/* Free running counters of the descriptors queued (senders, under
+xTxMutexLock) and reclaimed (bulk EMAC task only), so the reclaim needs no lock. */
+static volatile uint32_t ulTxQueued = 0;
+static volatile uint32_t ulTxReclaimed = 0;
+/* Counts the free TX descriptors, senders block on it when the ring is full. */
+static SemaphoreHandle_t xTxDescSemaphore = NULL;
 
 uint32_t ENET_RxFrameCnt = 0;
 uint32_t ENET_DroppedFrameCnt = 0;
@@ -129,6 +281,31 @@ uint32_t ENET_ProcessedFrameCnt = 0;
 uint32_t ENET_LostFrameCnt = 0;
 uint32_t ENET_TxFrameCnt = 0;
 uint32_t ENET_TxFailFrameCnt = 0;
+uint32_t ENET_RingRxFrameCnt[ETH_USED_RING_CNT] = {0}; // frames read from each ring
+uint32_t ENET_PriorityFrameCnt = 0; // frames queued ahead of the bulk traffic
+uint32_t ENET_RxIrqCnt = 0;
+uint32_t ENET_TxIrqCnt = 0;
+uint32_t ENET_CoalLevel = 0; // current index in xCoalescingLevels
+uint32_t ENET_CoalChangeCnt = 0;
+uint32_t ENET_CoalAdaptive = 1; // 0 - interrupt per frame, to measure the load without moderation
+uint32_t ENET_TxReclaimCnt = 0; // descriptors released after transmission
+uint32_t ENET_TxRingFullCnt = 0; // frames dropped after waiting for a descriptor
+uint32_t ENET_RxCsumErrCnt = 0; // frames dropped on the checksum status of the MAC
+uint32_t ENET_RxCsumMismatchCnt = 0; // see niVERIFY_RX_CHECKSUM
+uint32_t ENET_ChecksumOffload = 1; // 0 - checksums computed and checked in software, to measure the offload
+uint32_t ENET_RxCopyCnt = 0; // short frames copied into a small network buffer
+uint32_t ENET_FastPathCnt = 0; // UDP datagrams delivered without the IP-task
+#if (ipconfigMEASURE_RX_LATENCY != 0)
+/* Receive interrupt to application latency in us, [0] through the IP-task,
+[1] through the fast path. */
+uint32_t ENET_RxLatencyLastUs[2];
+uint32_t ENET_RxLatencyMaxUs[2];
+uint32_t ENET_RxLatencySumUs[2];
+uint32_t ENET_RxLatencyCnt[2];
+static volatile uint32_t ulRxIrqTimeUs[ETH_USED_RING_CNT];
+#endif
+uint32_t ENET_RxParserEntries = 0; // programmed parser rules, 0 - every frame is accepted
+uint32_t ENET_RxParserCnt[ENET_RX_PARSER_CNT_REJECT_2 + 1]; // indexed by enet_rx_parser_counter_t
 
 const unsigned char filter_vci_mac_sddr[4] = {0x22, 0x33, 0x44, 0x55};
 const unsigned char default_ptp_mac_addr[6] = {0x01, 0x00, 0x5e, 0x00, 0x01, 0x81};
@@ -155,87 +332,94 @@ static uint8_t *EthBufferAlloc(int size)
 	return ret;
 }
 
-static void EthBufferFree(uint8_t *data)
+void HAL_ETH_RxCpltCallback(uint8_t instance, enet_event_t event, uint8_t ring)
 {
-	NetworkBufferDescriptor_t *desc;
-	if (data != NULL)
+	(void)(instance);
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	if (ring >= ETH_USED_RING_CNT)
+	{
+		ring = niRING_BULK;
+	}
+	if (event == ENET_RX_EVENT)
 	{
-		desc = pxPacketBuffer_to_NetworkBuffer(data);
-		if (desc != NULL)
+		ENET_RxIrqCnt++;
+#if (ipconfigMEASURE_RX_LATENCY != 0)
+		if (ulRxIrqTimeUs[ring] == 0)
 		{
-			vReleaseNetworkBufferAndDescriptor(desc);
+			ulRxIrqTimeUs[ring] = (uint32_t)vPortGetTimeStampMicroSec() | 1U;
 		}
+#endif
 	}
-}
-
-void HAL_ETH_RxCpltCallback(uint8_t instance, enet_event_t event, uint8_t ring)
-{
-	(void)(instance);
-	(void)(ring);
-	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-	xTaskNotifyFromISR(xEMACTaskHandle, 1u<<event, eSetBits, &xHigherPriorityTaskWoken );
+	else if (event == ENET_TX_EVENT)
+	{
+		ENET_TxIrqCnt++;
+	}
+	xTaskNotifyFromISR(xEMACTaskHandle[ring], 1u<<event, eSetBits, &xHigherPriorityTaskWoken );
 	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 /*-----------------------------------------------------------*/
-//TODO:
 
-
-static void vClearCurrentTxBuffer(void)
-{
-	enet_buffer_descriptor_t *bd = ENET_DRV_GetCurrentTxBuffDesc(ETH_INSTANCE, 0);
-	if (ENET_DRV_GetTxBuffDescStatus(bd) == STATUS_SUCCESS)
-	{
-		EthTxBufferFreeHook(bd);
-		EthBufferFree(bd->buffer);
-		bd->buffer = NULL;
-	}
-}
-/*
-static void vClearTXBuffers(void)
+static void prvReclaimTxBuffers(void)
 {
 	enet_buffer_descriptor_t *bd;
-	status_t sts;
-	while (xTxBufferDescQueueReadIdx != xTxBufferDescQueueWriteIdx)
+	TxSlot_t *pxSlot;
+	uint32_t ulIndex;
+	while (ulTxReclaimed != ulTxQueued)
 	{
-#if (ipconfigZERO_COPY_TX_DRIVER != 0)
-		bd = xTxBufferDescQueue[xTxBufferDescQueueReadIdx];
-		sts = ENET_DRV_GetTxBuffDescStatus(bd);
-		if (sts == STATUS_SUCCESS)
+		ulIndex = ulTxReclaimed % ETH_TXBUFNB;
+		bd = &DMATxDscrTab[ulIndex];
+		if (ENET_DRV_GetTxBuffDescStatus(bd) == STATUS_BUSY)
 		{
-			EthBufferFree(bd->buffer);
-			bd->buffer = NULL;
+			break;
 		}
-		else if (sts == STATUS_BUSY)
+		EthTxBufferFreeHook(bd);
+		pxSlot = &xTxSlots[ulIndex];
+		if (pxSlot->pxBuffer != NULL)
 		{
-			break;
+			vReleaseNetworkBufferAndDescriptor(pxSlot->pxBuffer);
 		}
-		else
+		if (pxSlot->pxPayloadDone != NULL)
 		{
-			//should never here
+			pxSlot->pxPayloadDone(pxSlot->pvArg);
 		}
-#endif
-		xTxBufferDescQueueReadIdx = (xTxBufferDescQueueReadIdx + 1) % (sizeof(xTxBufferDescQueue) / sizeof(xTxBufferDescQueue[0]));
+		pxSlot->pxBuffer = NULL;
+		pxSlot->pxPayloadDone = NULL;
+		bd->buffer = NULL;
+		ulTxReclaimed++;
+		ENET_TxReclaimCnt++;
+		xSemaphoreGive(xTxDescSemaphore);
 	}
 }
-*/
 /*-----------------------------------------------------------*/
 
 BaseType_t xNetworkInterfaceInitialise(void)
 {
-	if (xEMACTaskHandle == NULL)
+	if (xEMACTaskHandle[niRING_BULK] == NULL)
 	{
 		if (xTxMutexLock == NULL)
 		{
 			xTxMutexLock = xSemaphoreCreateMutex();
 			configASSERT(xTxMutexLock);
 		}
+		if (xTxDescSemaphore == NULL)
+		{
+			xTxDescSemaphore = xSemaphoreCreateCounting(ETH_TXBUFNB, ETH_TXBUFNB);
+			configASSERT(xTxDescSemaphore);
+		}
 
 		/* Initialise ETH */
-		xETH_Config.interrupts = ENET_RX_FRAME_INTERRUPT;
+		xETH_Config.interrupts = ENET_RX_FRAME_INTERRUPT | ENET_RX_FRAME_1_INTERRUPT | ENET_RX_FRAME_2_INTERRUPT | ENET_TX_FRAME_INTERRUPT;
 		xETH_Config.maxFrameLen = ENET_FRAME_MAX_FRAMELEN;
 		xETH_Config.rxAccelerConfig = ENET_RX_ACCEL_ENABLE_MAC_CHECK;
-		xETH_Config.txAccelerConfig = 0;//ENET_TX_ACCEL_INSERT_IP_CHECKSUM;// | ENET_TX_ACCEL_INSERT_PROTO_CHECKSUM;
+#if (ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM != 0)
+		xETH_Config.rxAccelerConfig |= ENET_RX_ACCEL_ENABLE_IP_CHECK | ENET_RX_ACCEL_ENABLE_PROTO_CHECK;
+#endif
+#if (ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM != 0)
+		xETH_Config.txAccelerConfig = ENET_TX_ACCEL_INSERT_IP_CHECKSUM | ENET_TX_ACCEL_INSERT_PROTO_CHECKSUM;
+#else
+		xETH_Config.txAccelerConfig = 0;
+#endif
 		xETH_Config.callback = HAL_ETH_RxCpltCallback;
 		xETH_Config.miiSpeed = ENET_MII_SPEED_100M;
 		xETH_Config.miiDuplex = ENET_MII_FULL_DUPLEX;
@@ -257,50 +441,528 @@ BaseType_t xNetworkInterfaceInitialise(void)
 		xETH_Buffer_Config[0].txRingAligned = DMATxDscrTab;
 		xETH_Buffer_Config[0].rxBufferAligned = NULL;
 		xETH_Buffer_Config[0].rxBufferAllocator = EthBufferAlloc;
+		xETH_Buffer_Config[niRING_PTP].rxRingSize = ETH_PTP_RXBUFNB;
+		xETH_Buffer_Config[niRING_PTP].txRingSize = ETH_PTP_TXBUFNB;
+		xETH_Buffer_Config[niRING_PTP].rxRingAligned = DMARxPtpDscrTab;
+		xETH_Buffer_Config[niRING_PTP].txRingAligned = DMATxPtpDscrTab;
+		xETH_Buffer_Config[niRING_PTP].rxBufferAligned = NULL;
+		xETH_Buffer_Config[niRING_PTP].rxBufferAllocator = EthBufferAlloc;
+		xETH_Buffer_Config[niRING_CONTROL].rxRingSize = ETH_CONTROL_RXBUFNB;
+		xETH_Buffer_Config[niRING_CONTROL].txRingSize = ETH_CONTROL_TXBUFNB;
+		xETH_Buffer_Config[niRING_CONTROL].rxRingAligned = DMARxCtrlDscrTab;
+		xETH_Buffer_Config[niRING_CONTROL].txRingAligned = DMATxCtrlDscrTab;
+		xETH_Buffer_Config[niRING_CONTROL].rxBufferAligned = NULL;
+		xETH_Buffer_Config[niRING_CONTROL].rxBufferAllocator = EthBufferAlloc;
 
 		ENET_DRV_Init(ETH_INSTANCE, &xETH_State, &xETH_Config, xETH_Buffer_Config, FreeRTOS_GetMACAddress());
+		ENET_DRV_ConfigClassMatch(ETH_INSTANCE, niRING_PTP, sizeof(ucPtpVlanPrio), ucPtpVlanPrio);
+		ENET_DRV_ConfigClassMatch(ETH_INSTANCE, niRING_CONTROL, sizeof(ucControlVlanPrio), ucControlVlanPrio);
+		/* A full bulk ring must not hold back the frames of the other rings
+		behind it in the RX FIFO. */
+		ENET_DRV_ConfigRxFlush(ETH_INSTANCE, niRING_BULK, true);
+		ENET_DRV_ConfigTxScheme(ETH_INSTANCE, ENET_ROUND_ROBIN_SCHEME);
+#if (ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM != 0)
+		/* The checksums can only be inserted once the whole frame is in the FIFO. */
+		ENET_DRV_EnableTxStoreAndForward(ETH_INSTANCE);
+#endif
 		ENET_DRV_SetMulticastForward(ETH_INSTANCE, default_ptp_mac_addr, true);
 		ENET_DRV_SetMulticastForward(ETH_INSTANCE, peer_ptp_mac_addr, true);
 		ENET_DRV_EnableMDIO(ETH_INSTANCE, false);
-		xTaskCreate(prvEMACHandlerTask, "EMAC", configEMAC_TASK_STACK_SIZE, NULL, niEMAC_HANDLER_TASK_PRIORITY, &xEMACTaskHandle);
-	} /* if( xEMACTaskHandle == NULL ) */
+		INT_SYS_SetPriority(xPtpRxIrqId[ETH_INSTANCE], niPTP_RX_IRQ_PRIORITY);
+		xTaskCreate(prvEMACHandlerTask, "EMAC-PTP", configEMAC_TASK_STACK_SIZE, (void *)niRING_PTP, niEMAC_PTP_TASK_PRIORITY, &xEMACTaskHandle[niRING_PTP]);
+		xTaskCreate(prvEMACHandlerTask, "EMAC-CTL", configEMAC_TASK_STACK_SIZE, (void *)niRING_CONTROL, niEMAC_CONTROL_TASK_PRIORITY, &xEMACTaskHandle[niRING_CONTROL]);
+		xTaskCreate(prvEMACHandlerTask, "EMAC", configEMAC_TASK_STACK_SIZE, (void *)niRING_BULK, niEMAC_BULK_TASK_PRIORITY, &xEMACTaskHandle[niRING_BULK]);
+		/* Sockets may have been bound before the interface came up. */
+		vNetworkInterfaceBoundPortsChanged();
+	} /* if( xEMACTaskHandle[niRING_BULK] == NULL ) */
 	return pdPASS;
 }
 
-BaseType_t xNetworkInterfaceOutput(NetworkBufferDescriptor_t *const pxDescriptor, BaseType_t bReleaseAfterSend)
+#if (ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM != 0)
+/* Fills in the checksums the MAC would insert, for ENET_ChecksumOffload == 0.
+The protocol checksum of a fragment was computed over the whole datagram by
+vIPFragmentAndSend(), a fragment only needs its IP header checksum. */
+static void prvTxChecksum(const enet_buffer_t *pxBuff, uint8_t ucCount)
+{
+	IPPacket_t *pxIPPacket = (IPPacket_t *)pxBuff[0].data;
+	IPHeader_t *pxIPHeader = &(pxIPPacket->xIPHeader);
+	if ((pxBuff[0].length < (ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER)) || (pxIPPacket->xEthernetHeader.usFrameType != ipIPv4_FRAME_TYPE))
+	{
+		return;
+	}
+	if (ucCount == 1)
+	{
+		(void)usGenerateProtocolChecksum(pxBuff[0].data, pxBuff[0].length, pdTRUE);
+	}
+	pxIPHeader->usHeaderChecksum = 0U;
+	pxIPHeader->usHeaderChecksum = usGenerateChecksum(0UL, (uint8_t *)&(pxIPHeader->ucVersionHeaderLength), (size_t)((pxIPHeader->ucVersionHeaderLength & 0x0FU) << 2));
+	pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons(pxIPHeader->usHeaderChecksum);
+}
+#endif /* ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM */
+
+static BaseType_t prvTransmit(NetworkBufferDescriptor_t *pxDescriptor, const void *pvPayload, size_t uxPayloadLength, NetworkPayloadDone_t pxPayloadDone, void *pvArg)
 {
 	BaseType_t xReturn = pdFAIL;
-	enet_buffer_t buff;
-	buff.length = pxDescriptor->xDataLength;
-	buff.data = pxDescriptor->pucEthernetBuffer;
-	xSemaphoreTake(xTxMutexLock, portMAX_DELAY);
-	vClearCurrentTxBuffer();
-	//vClearTXBuffers();
-	//xTxBufferDescQueue[xTxBufferDescQueueWriteIdx] = ENET_DRV_GetCurrentTxBuffDesc(ETH_INSTANCE, 0);
-	EthTxBufferOutHook(&buff);
-	if (STATUS_SUCCESS == ENET_DRV_SendFrame(ETH_INSTANCE, 0, &buff, NULL))
-	{
-		bReleaseAfterSend = pdFALSE;
-		xReturn = pdPASS;
-		//xTxBufferDescQueueWriteIdx = (xTxBufferDescQueueWriteIdx + 1) % (sizeof(xTxBufferDescQueue) / sizeof(xTxBufferDescQueue[0]));
+	enet_buffer_t buff[2];
+#if (ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM != 0)
+	enet_tx_options_t xOptions;
+#endif
+	enet_tx_options_t *pxOptions = NULL;
+	uint8_t count = 1;
+	uint8_t i;
+	uint32_t ulIndex;
+	status_t sts;
+	buff[0].length = pxDescriptor->xDataLength;
+	buff[0].data = pxDescriptor->pucEthernetBuffer;
+	if (pvPayload != NULL)
+	{
+		buff[1].length = (uint16_t)uxPayloadLength;
+		buff[1].data = (uint8_t *)pvPayload;
+		count = 2;
+	}
+#if (ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM != 0)
+	memset(&xOptions, 0, sizeof(xOptions));
+	if (ENET_ChecksumOffload == 0)
+	{
+		prvTxChecksum(buff, count);
+		xOptions.noIpChecksum = true;
+		xOptions.noProtoChecksum = true;
+		pxOptions = &xOptions;
+	}
+	else if (count > 1)
+	{
+		/* Only IP fragments are sent in two buffers. Their protocol checksum
+		covers the whole datagram and was computed by vIPFragmentAndSend(), the
+		MAC must not insert one over the fragment; the IP header checksum is
+		per fragment and still inserted. */
+		xOptions.noProtoChecksum = true;
+		pxOptions = &xOptions;
+	}
+#endif /* ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM */
+	/* Reserve the descriptors first, the EMAC task gives them back as the
+	frames complete. */
+	for (i = 0; i < count; i++)
+	{
+		if (xSemaphoreTake(xTxDescSemaphore, niTX_DESC_WAIT_TICKS) != pdTRUE)
+		{
+			break;
+		}
+	}
+	if (i == count)
+	{
+		xSemaphoreTake(xTxMutexLock, portMAX_DELAY);
+		ulIndex = ulTxQueued % ETH_TXBUFNB;
+		xTxSlots[ulIndex].pxBuffer = pxDescriptor;
+		if (count > 1)
+		{
+			ulIndex = (ulIndex + 1) % ETH_TXBUFNB;
+			xTxSlots[ulIndex].pxPayloadDone = pxPayloadDone;
+			xTxSlots[ulIndex].pvArg = pvArg;
+		}
+		EthTxBufferOutHook(&buff[0]);
+		if (count > 1)
+		{
+			sts = ENET_DRV_SendMultiBufferFrame(ETH_INSTANCE, niRING_BULK, buff, count, pxOptions);
+		}
+		else
+		{
+			sts = ENET_DRV_SendFrame(ETH_INSTANCE, niRING_BULK, buff, pxOptions);
+		}
+		if (STATUS_SUCCESS == sts)
+		{
+			ulTxQueued += count;
+			ENET_TxFrameCnt++;
+			xReturn = pdPASS;
+		}
+		else
+		{
+			/* Should not happen, the descriptors were reserved. */
+			xTxSlots[ulTxQueued % ETH_TXBUFNB].pxBuffer = NULL;
+			xTxSlots[ulIndex].pxPayloadDone = NULL;
+		}
+		xSemaphoreGive(xTxMutexLock);
 	}
 	else
 	{
-		bReleaseAfterSend = pdTRUE;
+		ENET_TxRingFullCnt++;
 	}
-	xSemaphoreGive(xTxMutexLock);
-	if (bReleaseAfterSend != pdFALSE)
+	if (xReturn == pdFAIL)
 	{
+		while (i > 0)
+		{
+			xSemaphoreGive(xTxDescSemaphore);
+			i--;
+		}
+		ENET_TxFailFrameCnt++;
 		vReleaseNetworkBufferAndDescriptor(pxDescriptor);
 	}
 	return xReturn;
 }
+
+BaseType_t xNetworkInterfaceOutput(NetworkBufferDescriptor_t *const pxDescriptor, BaseType_t bReleaseAfterSend)
+{
+	/* Zero-copy driver, the buffer is always taken over. */
+	(void)bReleaseAfterSend;
+	return prvTransmit(pxDescriptor, NULL, 0, NULL, NULL);
+}
+
+BaseType_t xNetworkInterfaceOutputSG(NetworkBufferDescriptor_t *const pxNetworkBuffer, const void *pvPayload, size_t uxPayloadLength, NetworkPayloadDone_t pxPayloadDone, void *pvArg)
+{
+	if ((pvPayload == NULL) || (uxPayloadLength == 0) ||
+		((pxNetworkBuffer->xDataLength + uxPayloadLength) > ipTOTAL_ETHERNET_FRAME_SIZE))
+	{
+		vReleaseNetworkBufferAndDescriptor(pxNetworkBuffer);
+		return pdFAIL;
+	}
+	return prvTransmit(pxNetworkBuffer, pvPayload, uxPayloadLength, pxPayloadDone, pvArg);
+}
 /*-----------------------------------------------------------*/
 
-void prvNetworkInterfaceInput(void)
+static void prvParserRule(uint8_t ucAction, uint8_t ucArg, uint8_t ucWord, uint32_t ulMask, uint32_t ulValue)
+{
+	enet_rx_parser_rule_t rule;
+	rule.compareValue = ulValue & ulMask;
+	rule.compareMask = ulMask;
+	rule.compareOffset = ucWord;
+	if (ucAction == niPARSER_ACCEPT)
+	{
+		ENET_DRV_RxParserAddAcceptRule(ETH_INSTANCE, ucArg, &rule);
+	}
+	else if (ucAction == niPARSER_REJECT)
+	{
+		ENET_DRV_RxParserAddRejectRule(ETH_INSTANCE, &rule);
+	}
+	else
+	{
+		ENET_DRV_RxParserAddLinkingRule(ETH_INSTANCE, ucArg, &rule);
+	}
+	ENET_RxParserEntries++;
+}
+
+static uint8_t prvUdpPortRing(uint16_t usPort)
+{
+	uint32_t i;
+	if ((usPort == niPTP_EVENT_PORT) || (usPort == niPTP_GENERAL_PORT))
+	{
+		return niRING_PTP;
+	}
+	for (i = 0; i < (sizeof(usControlUdpPorts) / sizeof(usControlUdpPorts[0])); i++)
+	{
+		if (usPort == usControlUdpPorts[i])
+		{
+			return niRING_CONTROL;
+		}
+	}
+	return niRING_BULK;
+}
+
+/* The table is laid out as a decision tree, the branches sit behind a
+reject-all entry so that they are only reached through their linking rule:
+
+	ARP -> A, IPv4 with a 20 byte header -> I, VLAN tagged -> ring by PCP,
+	untagged L2 PTP -> PTP ring, reject
+	A: target IP == ours -> accept (any ARP while we have no address), reject
+	I: not first fragment -> accept, ICMP -> accept, UDP -> U, TCP -> T, reject
+	U: destination port == control port -> C, == bound port -> accept to its ring, reject
+	C: IP total length < niCONTROL_MAX_IP_LENGTH -> accept to control, accept
+	T: destination port == bound port -> accept, reject
+*/
+static void prvUpdateRxFilter(void)
+{
+	enet_rx_parser_config_t config;
+	uint16_t usUdpPorts[niPARSER_MAX_PORTS];
+	uint16_t usTcpPorts[niPARSER_MAX_PORTS];
+	UBaseType_t uxUdpCnt;
+	UBaseType_t uxTcpCnt = 0;
+	uint32_t ulIP = FreeRTOS_ntohl(*ipLOCAL_IP_ADDRESS_POINTER);
+	uint8_t ucArp, ucIp, ucUdp, ucCtl, ucTcp, ucEnd;
+	uint8_t ucRing;
+	UBaseType_t i;
+
+	uxUdpCnt = uxSocketGetBoundPorts(FREERTOS_IPPROTO_UDP, usUdpPorts, niPARSER_MAX_PORTS);
+#if (ipconfigUSE_TCP == 1)
+	uxTcpCnt = uxSocketGetBoundPorts(FREERTOS_IPPROTO_TCP, usTcpPorts, niPARSER_MAX_PORTS);
+#endif
+	ENET_DRV_RxParserDeinit(ETH_INSTANCE);
+	ENET_RxParserEntries = 0;
+	if ((uxUdpCnt > niPARSER_MAX_PORTS) || (uxTcpCnt > niPARSER_MAX_PORTS))
+	{
+		/* Too many sockets, leave the filtering to the stack. */
+		return;
+	}
+	ucArp = 2 + sizeof(ucPtpVlanPrio) + sizeof(ucControlVlanPrio) + 1 + 1 + 1;
+	ucIp = ucArp + ((ulIP != 0) ? 4 : 1);
+	ucUdp = ucIp + 6;
+	ucCtl = ucUdp + uxUdpCnt + 1;
+	ucTcp = ucCtl + 2;
+	ucEnd = ucTcp + uxTcpCnt + 1;
+	configASSERT(ucEnd <= niPARSER_MAX_ENTRIES);
+	(void)ucEnd;
+
+	/* The table is written while the parser is off, it is enabled at the end
+	so that no frame is classified against a partial table. */
+	prvParserRule(niPARSER_LINK, ucArp, niPARSER_WORD_TYPE, 0xFFFF0000UL, 0x08060000UL);
+	prvParserRule(niPARSER_LINK, ucIp, niPARSER_WORD_TYPE, 0xFFFFFF00UL, 0x08004500UL);
+	for (i = 0; i < sizeof(ucPtpVlanPrio); i++)
+	{
+		prvParserRule(niPARSER_ACCEPT, niRING_PTP, niPARSER_WORD_TYPE, 0xFFFFE000UL, (niVLAN_ETHERTYPE << 16) | ((uint32_t)ucPtpVlanPrio[i] << 13));
+	}
+	for (i = 0; i < sizeof(ucControlVlanPrio); i++)
+	{
+		prvParserRule(niPARSER_ACCEPT, niRING_CONTROL, niPARSER_WORD_TYPE, 0xFFFFE000UL, (niVLAN_ETHERTYPE << 16) | ((uint32_t)ucControlVlanPrio[i] << 13));
+	}
+	prvParserRule(niPARSER_ACCEPT, niRING_BULK, niPARSER_WORD_TYPE, 0xFFFF0000UL, niVLAN_ETHERTYPE << 16);
+	prvParserRule(niPARSER_ACCEPT, niRING_PTP, niPARSER_WORD_TYPE, 0xFFFF0000UL, niPTP_ETHERTYPE << 16);
+	prvParserRule(niPARSER_REJECT, 0, 0, 0, 0);
+
+	/* A: ARP */
+	if (ulIP != 0)
+	{
+		prvParserRule(niPARSER_LINK, ucArp + 2, niPARSER_WORD_PORT, 0x0000FFFFUL, ulIP >> 16);
+		prvParserRule(niPARSER_REJECT, 0, 0, 0, 0);
+		prvParserRule(niPARSER_ACCEPT, niRING_BULK, niPARSER_WORD_ARP_TPA, 0xFFFF0000UL, ulIP << 16);
+		prvParserRule(niPARSER_REJECT, 0, 0, 0, 0);
+	}
+	else
+	{
+		prvParserRule(niPARSER_ACCEPT, niRING_BULK, 0, 0, 0);
+	}
+
+	/* I: IPv4, the stack drops what it can not reassemble */
+	prvParserRule(niPARSER_LINK, ucIp + 2, niPARSER_WORD_PROTO, 0x1FFF0000UL, 0);
+	prvParserRule(niPARSER_ACCEPT, niRING_BULK, 0, 0, 0);
+	prvParserRule(niPARSER_ACCEPT, niRING_BULK, niPARSER_WORD_PROTO, 0x000000FFUL, ipPROTOCOL_ICMP);
+	prvParserRule(niPARSER_LINK, ucUdp, niPARSER_WORD_PROTO, 0x000000FFUL, ipPROTOCOL_UDP);
+	prvParserRule(niPARSER_LINK, ucTcp, niPARSER_WORD_PROTO, 0x000000FFUL, ipPROTOCOL_TCP);
+	prvParserRule(niPARSER_REJECT, 0, 0, 0, 0);
+
+	/* U: UDP */
+	for (i = 0; i < uxUdpCnt; i++)
+	{
+		ucRing = prvUdpPortRing(usUdpPorts[i]);
+		if (ucRing == niRING_CONTROL)
+		{
+			prvParserRule(niPARSER_LINK, ucCtl, niPARSER_WORD_PORT, 0xFFFF0000UL, (uint32_t)usUdpPorts[i] << 16);
+		}
+		else
+		{
+			prvParserRule(niPARSER_ACCEPT, ucRing, niPARSER_WORD_PORT, 0xFFFF0000UL, (uint32_t)usUdpPorts[i] << 16);
+		}
+	}
+	prvParserRule(niPARSER_REJECT, 0, 0, 0, 0);
+
+	/* C: control port, the long datagrams are bulk data */
+	prvParserRule(niPARSER_ACCEPT, niRING_CONTROL, niPARSER_WORD_IP_LENGTH, (uint32_t)(0x10000UL - niCONTROL_MAX_IP_LENGTH) << 16, 0);
+	prvParserRule(niPARSER_ACCEPT, niRING_BULK, 0, 0, 0);
+
+	/* T: TCP */
+	for (i = 0; i < uxTcpCnt; i++)
+	{
+		prvParserRule(niPARSER_ACCEPT, niRING_BULK, niPARSER_WORD_PORT, 0xFFFF0000UL, (uint32_t)usTcpPorts[i] << 16);
+	}
+	prvParserRule(niPARSER_REJECT, 0, 0, 0, 0);
+	configASSERT(ENET_RxParserEntries == ucEnd);
+
+	config.acceptEndError = true;
+	config.endErrorQueue = niRING_BULK;
+	config.clearCounters = false;
+	config.inverseByteOrder = false;
+	ENET_DRV_RxParserInit(ETH_INSTANCE, &config);
+}
+
+static void prvReadRxParserCounters(void)
+{
+	uint32_t i;
+	for (i = 0; i < (sizeof(ENET_RxParserCnt) / sizeof(ENET_RxParserCnt[0])); i++)
+	{
+		ENET_RxParserCnt[i] = ENET_DRV_RxParserGetCount(ETH_INSTANCE, (enet_rx_parser_counter_t)i);
+	}
+	xParserCountRead = xTaskGetTickCount();
+}
+
+void vNetworkInterfaceBoundPortsChanged(void)
+{
+	/* Reprogrammed by the bulk handler task, the callers may be any task. */
+	if (xEMACTaskHandle[niRING_BULK] != NULL)
+	{
+		xTaskNotify(xEMACTaskHandle[niRING_BULK], niNOTIFY_RX_FILTER, eSetBits);
+	}
+}
+
+/* Returns pdFALSE if the MAC reported a wrong IP header or TCP/UDP/ICMP checksum.
+The MAC discards these frames itself when the RX accelerator checks are on, this
+also covers the frames it does not discard. The error bits are set as well for
+non-IP frames and unknown protocols, so they only count for those it checked. */
+static BaseType_t prvRxChecksumValid(const uint8_t *pucFrame, uint32_t ulLength, const enet_rx_enh_info_t *pxInfo)
+{
+	const IPPacket_t *pxIPPacket = (const IPPacket_t *)pucFrame;
+	uint8_t ucProtocol;
+	if ((ulLength < (ipSIZE_OF_ETH_HEADER + ipSIZE_OF_IPv4_HEADER)) || (pxIPPacket->xEthernetHeader.usFrameType != ipIPv4_FRAME_TYPE))
+	{
+		return pdTRUE;
+	}
+	ucProtocol = pxIPPacket->xIPHeader.ucProtocol;
+	if (ENET_ChecksumOffload == 0)
+	{
+		/* The status of the MAC is not used, the frames it discards itself
+		never get here. */
+		if (usGenerateChecksum(0UL, (const uint8_t *)&(pxIPPacket->xIPHeader), (size_t)((pxIPPacket->xIPHeader.ucVersionHeaderLength & 0x0FU) << 2)) != ipCORRECT_CRC)
+		{
+			return pdFALSE;
+		}
+		if (!pxInfo->ipv4Frag && ((ucProtocol == ipPROTOCOL_UDP) || (ucProtocol == ipPROTOCOL_TCP) || (ucProtocol == ipPROTOCOL_ICMP)))
+		{
+			return (usGenerateProtocolChecksum(pucFrame, ulLength, pdFALSE) == ipCORRECT_CRC) ? pdTRUE : pdFALSE;
+		}
+		return pdTRUE;
+	}
+	if ((pxInfo->errMask & ENET_RX_ENH_ERR_IPHDR_CHECKSUM) != 0)
+	{
+		return pdFALSE;
+	}
+	if (((pxInfo->errMask & ENET_RX_ENH_ERR_PROTO_CHECKSUM) != 0) && !pxInfo->ipv4Frag &&
+		((ucProtocol == ipPROTOCOL_UDP) || (ucProtocol == ipPROTOCOL_TCP) || (ucProtocol == ipPROTOCOL_ICMP)))
+	{
+		return pdFALSE;
+	}
+#if (niVERIFY_RX_CHECKSUM != 0)
+	if (!pxInfo->ipv4Frag && (usGenerateProtocolChecksum((uint8_t *)pucFrame, ulLength, pdFALSE) != 0xFFFFU))
+	{
+		ENET_RxCsumMismatchCnt++;
+	}
+#endif
+	return pdTRUE;
+}
+
+static uint8_t prvClassifyFrame(const uint8_t *pucFrame, uint32_t ulLength)
+{
+	uint32_t ulOffset = 12U; // ethertype
+	uint32_t ulIpHeaderLen;
+	uint32_t ulIpLength;
+	uint16_t usType;
+	uint16_t usPort;
+	uint8_t ucRing;
+
+	usType = ((uint16_t)pucFrame[ulOffset] << 8) | pucFrame[ulOffset + 1U];
+	if ((usType == niVLAN_ETHERTYPE) && (ulLength >= (ulOffset + 6U)))
+	{
+		ulOffset += 4U;
+		usType = ((uint16_t)pucFrame[ulOffset] << 8) | pucFrame[ulOffset + 1U];
+	}
+	if (usType == niPTP_ETHERTYPE)
+	{
+		return niRING_PTP;
+	}
+	ulOffset += 2U; // IP header
+	if ((usType != niIPv4_ETHERTYPE) || (ulLength < (ulOffset + ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_UDP_HEADER)))
+	{
+		return niRING_BULK;
+	}
+	/* Only the first fragment holds the UDP header. */
+	if ((pucFrame[ulOffset + 9U] != ipPROTOCOL_UDP) || (((pucFrame[ulOffset + 6U] & 0x1FU) | pucFrame[ulOffset + 7U]) != 0U))
+	{
+		return niRING_BULK;
+	}
+	ulIpHeaderLen = (uint32_t)(pucFrame[ulOffset] & 0x0FU) << 2;
+	if (ulLength < (ulOffset + ulIpHeaderLen + ipSIZE_OF_UDP_HEADER))
+	{
+		return niRING_BULK;
+	}
+	ulIpLength = ((uint32_t)pucFrame[ulOffset + 2U] << 8) | pucFrame[ulOffset + 3U];
+	ulOffset += ulIpHeaderLen + 2U; // UDP destination port
+	usPort = ((uint16_t)pucFrame[ulOffset] << 8) | pucFrame[ulOffset + 1U];
+	ucRing = prvUdpPortRing(usPort);
+	if ((ucRing == niRING_CONTROL) && (ulIpLength >= niCONTROL_MAX_IP_LENGTH))
+	{
+		/* Data transfer on a control port. */
+		ucRing = niRING_BULK;
+	}
+	return ucRing;
+}
+
+static void prvSetCoalescingLevel(uint32_t ulLevel)
+{
+	const CoalescingLevel_t *pxLevel = &xCoalescingLevels[ulLevel];
+	if (ulLevel == 0)
+	{
+		ENET_DRV_DisableRxInterruptCoalescing(ETH_INSTANCE, niRING_BULK);
+		ENET_DRV_DisableTxInterruptCoalescing(ETH_INSTANCE, niRING_BULK);
+	}
+	else
+	{
+		ENET_DRV_EnableRxInterruptCoalescing(ETH_INSTANCE, niRING_BULK, pxLevel->ucRxFrames, pxLevel->usRxTimeoutUs);
+		ENET_DRV_EnableTxInterruptCoalescing(ETH_INSTANCE, niRING_BULK, pxLevel->ucTxFrames, pxLevel->usTxTimeoutUs);
+	}
+	ENET_CoalLevel = ulLevel;
+	ENET_CoalChangeCnt++;
+}
+
+static void prvAdaptCoalescing(uint32_t ulFrames)
+{
+	TickType_t xNow = xTaskGetTickCount();
+	uint32_t ulLevel = ENET_CoalLevel;
+	ulCoalSampleFrames += ulFrames;
+	if ((xNow - xCoalSampleStart) < niCOAL_SAMPLE_TICKS)
+	{
+		return;
+	}
+	/* Normalise to the sample window, the task may have slept longer. */
+	ulCoalSampleFrames = (ulCoalSampleFrames * niCOAL_SAMPLE_TICKS) / (xNow - xCoalSampleStart);
+	if (ENET_CoalAdaptive == 0)
+	{
+		ulLevel = 0;
+	}
+	else
+	{
+		while (((ulLevel + 1) < (sizeof(xCoalescingLevels) / sizeof(xCoalescingLevels[0]))) &&
+			   (ulCoalSampleFrames >= xCoalescingLevels[ulLevel + 1].ulEntryRate))
+		{
+			ulLevel++;
+		}
+		while ((ulLevel > 0) && (ulCoalSampleFrames < (xCoalescingLevels[ulLevel].ulEntryRate / 2)))
+		{
+			ulLevel--;
+		}
+	}
+	if (ulLevel != ENET_CoalLevel)
+	{
+		prvSetCoalescingLevel(ulLevel);
+	}
+	xCoalSampleStart = xNow;
+	ulCoalSampleFrames = 0;
+}
+
+#if (ipconfigMEASURE_RX_LATENCY != 0)
+/* The interrupt time and the path travel with the buffer in the padding,
+behind the descriptor pointer. */
+#define niRX_LATENCY_STAMP(pxNetworkBuffer) ((uint32_t *)((pxNetworkBuffer)->pucEthernetBuffer - ipBUFFER_PADDING + sizeof(void *)))
+
+void vNetworkInterfaceRxLatencySample(const struct xNETWORK_BUFFER *pxNetworkBuffer)
+{
+	uint32_t *pulStamp = niRX_LATENCY_STAMP(pxNetworkBuffer);
+	uint32_t ulPath = pulStamp[1];
+	uint32_t ulLatency;
+	if ((pulStamp[0] != 0) && (ulPath < 2))
+	{
+		ulLatency = (uint32_t)vPortGetTimeStampMicroSec() - pulStamp[0];
+		pulStamp[0] = 0;
+		ENET_RxLatencyLastUs[ulPath] = ulLatency;
+		if (ulLatency > ENET_RxLatencyMaxUs[ulPath])
+		{
+			ENET_RxLatencyMaxUs[ulPath] = ulLatency;
+		}
+		ENET_RxLatencySumUs[ulPath] += ulLatency;
+		ENET_RxLatencyCnt[ulPath]++;
+	}
+}
+#endif
+
+static uint32_t prvNetworkInterfaceInput(uint8_t ring)
 {
 	uint8_t instance = ETH_INSTANCE;
-	uint8_t ring = 0;
+	uint32_t ulFrames = 0;
+	uint8_t frame_class;
+	BaseType_t xSent;
 	status_t sts;
 	enet_buffer_t buff;
 	enet_rx_enh_info_t info;
@@ -308,24 +970,93 @@ void prvNetworkInterfaceInput(void)
 	NetworkBufferDescriptor_t * nb_new;
 	uint8_t *tmp_p;
 	xIPStackEvent_t rx_event;
+#if (ipconfigMEASURE_RX_LATENCY != 0)
+	/* All frames of this pass are charged from the first interrupt. */
+	uint32_t ulIrqTime = ulRxIrqTimeUs[ring];
+	ulRxIrqTimeUs[ring] = 0;
+#endif
 	sts = ENET_DRV_ReadFrame(instance, ring, &buff, &info);
 	while (sts == STATUS_SUCCESS)
 	{
 		ENET_RxFrameCnt++;
+		ENET_RingRxFrameCnt[ring]++;
+		ulFrames++;
 		if ((buff.length > ipSIZE_OF_ETH_HEADER) && (buff.length <= ipTOTAL_ETHERNET_FRAME_SIZE))
 		{
-			if (eConsiderFrameForProcessing(buff.data) == eProcessBuffer)
+			if (prvRxChecksumValid(buff.data, buff.length, &info) == pdFALSE)
 			{
-				nb_new = pxGetNetworkBufferWithDescriptor(ETH_RX_BUF_SIZE, 0);
-				if (nb_new != NULL)
+				ENET_RxCsumErrCnt++;
+				ENET_DroppedFrameCnt++;
+			}
+			else if (eConsiderFrameForProcessing(buff.data) == eProcessBuffer)
+			{
+				nb_rcvd = NULL;
+#if (ipconfigNUM_SMALL_NETWORK_BUFFERS > 0)
+				if (buff.length <= ipconfigSMALL_NETWORK_BUFFER_SIZE)
+				{
+					/* ARP, ICMP echo and TCP acks are copied, the full size
+					buffer stays in the ring. */
+					nb_rcvd = pxGetNetworkBufferWithDescriptor(buff.length, 0);
+					if (nb_rcvd != NULL)
+					{
+						memcpy(nb_rcvd->pucEthernetBuffer, buff.data, buff.length);
+						ENET_RxCopyCnt++;
+					}
+				}
+#endif
+				if (nb_rcvd == NULL)
+				{
+					nb_new = pxGetNetworkBufferWithDescriptor(ETH_RX_BUF_SIZE, 0);
+					if (nb_new != NULL)
+					{
+						tmp_p = buff.data;
+						buff.data = nb_new->pucEthernetBuffer;
+						nb_rcvd = pxPacketBuffer_to_NetworkBuffer(tmp_p);
+						nb_rcvd->xDataLength = buff.length;
+					}
+				}
+#if (ipconfigMEASURE_RX_LATENCY != 0)
+				if (nb_rcvd != NULL)
 				{
-					tmp_p = buff.data;
-					buff.data = nb_new->pucEthernetBuffer;
-					nb_rcvd = pxPacketBuffer_to_NetworkBuffer(tmp_p);
-					nb_rcvd->xDataLength = buff.length;
+					niRX_LATENCY_STAMP(nb_rcvd)[0] = ulIrqTime;
+					niRX_LATENCY_STAMP(nb_rcvd)[1] = 1;
+				}
+#endif
+#if (ipconfigUDP_FAST_PATH == 1)
+				/* Datagrams for a fast path socket are delivered from here,
+				the others go on to the IP-task. */
+				if ((nb_rcvd != NULL) && (xProcessUDPFastPath(nb_rcvd) != pdFAIL))
+				{
+					ENET_FastPathCnt++;
+					ENET_ProcessedFrameCnt++;
+					iptraceNETWORK_INTERFACE_RECEIVE();
+				}
+				else
+#endif
+				if (nb_rcvd != NULL)
+				{
+#if (ipconfigMEASURE_RX_LATENCY != 0)
+					niRX_LATENCY_STAMP(nb_rcvd)[1] = 0;
+#endif
 					rx_event.eEventType = eNetworkRxEvent;
 					rx_event.pvData = ( void * ) nb_rcvd;
-					if( xSendEventStructToIPTask( &rx_event, 0 ) == pdFALSE )
+					frame_class = ring;
+					if (frame_class == niRING_BULK)
+					{
+						frame_class = prvClassifyFrame(nb_rcvd->pucEthernetBuffer, buff.length);
+					}
+					if (frame_class != niRING_BULK)
+					{
+						/* PTP and control frames overtake the bulk frames
+						already waiting in the IP-task queue. */
+						xSent = xSendPriorityEventStructToIPTask( &rx_event, 0 );
+						ENET_PriorityFrameCnt++;
+					}
+					else
+					{
+						xSent = xSendEventStructToIPTask( &rx_event, 0 );
+					}
+					if( xSent == pdFALSE )
 					{
 						vReleaseNetworkBufferAndDescriptor(nb_rcvd);
 						ENET_LostFrameCnt++;
@@ -355,15 +1086,21 @@ void prvNetworkInterfaceInput(void)
 		ENET_DRV_ProvideRxBuff(instance, ring, &buff);
 		sts = ENET_DRV_ReadFrame(instance, ring, &buff, &info);
 	}
+	return ulFrames;
 }
 
-/* Uncomment this in case BufferAllocation_1.c is used. */
-
-#define niBUFFER_1_PACKET_SIZE (1536+64)
+/* BufferAllocation_3.c: the small buffers first, then the full size ones and
+the jumbo ones last. The padding keeps every pucEthernetBuffer at
+FEATURE_ENET_BUFF_ALIGNMENT. */
+#define niSMALL_PACKET_SIZE ENET_BUFF_ALIGN(ipBUFFER_PADDING + ipconfigSMALL_NETWORK_BUFFER_SIZE)
+#define niLARGE_PACKET_SIZE ENET_BUFF_ALIGN(ipBUFFER_PADDING + ipconfigNETWORK_BUFFER_SIZE)
+#define niJUMBO_PACKET_SIZE ENET_BUFF_ALIGN(ipBUFFER_PADDING + ipconfigJUMBO_NETWORK_BUFFER_SIZE)
+#define niNUM_LARGE_BUFFERS (ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - ipconfigNUM_SMALL_NETWORK_BUFFERS - ipconfigNUM_JUMBO_NETWORK_BUFFERS)
+#define niFIRST_JUMBO_BUFFER (ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS - ipconfigNUM_JUMBO_NETWORK_BUFFERS)
 
 void vNetworkInterfaceAllocateRAMToBuffers(NetworkBufferDescriptor_t pxNetworkBuffers[ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS])
 {
-	ALIGNED(FEATURE_ENET_BUFF_ALIGNMENT) NOINIT_DATA_SECTION static uint8_t ucNetworkPackets[ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS * niBUFFER_1_PACKET_SIZE];
+	ALIGNED(FEATURE_ENET_BUFF_ALIGNMENT) NOINIT_DATA_SECTION static uint8_t ucNetworkPackets[(ipconfigNUM_SMALL_NETWORK_BUFFERS * niSMALL_PACKET_SIZE) + (niNUM_LARGE_BUFFERS * niLARGE_PACKET_SIZE) + (ipconfigNUM_JUMBO_NETWORK_BUFFERS * niJUMBO_PACKET_SIZE)];
 	uint8_t *ucRAMBuffer = ucNetworkPackets;
 	uint32_t ul;
 
@@ -371,7 +1108,18 @@ void vNetworkInterfaceAllocateRAMToBuffers(NetworkBufferDescriptor_t pxNetworkBu
 	{
 		pxNetworkBuffers[ul].pucEthernetBuffer = ucRAMBuffer + ipBUFFER_PADDING;
 		*((unsigned *)ucRAMBuffer) = (unsigned)(&(pxNetworkBuffers[ul]));
-		ucRAMBuffer += niBUFFER_1_PACKET_SIZE;
+		if (ul < ipconfigNUM_SMALL_NETWORK_BUFFERS)
+		{
+			ucRAMBuffer += niSMALL_PACKET_SIZE;
+		}
+		else if (ul < niFIRST_JUMBO_BUFFER)
+		{
+			ucRAMBuffer += niLARGE_PACKET_SIZE;
+		}
+		else
+		{
+			ucRAMBuffer += niJUMBO_PACKET_SIZE;
+		}
 	}
 }
 /*-----------------------------------------------------------*/
@@ -379,9 +1127,9 @@ void vNetworkInterfaceAllocateRAMToBuffers(NetworkBufferDescriptor_t pxNetworkBu
 static void prvEMACHandlerTask(void *pvParameters)
 {
 	uint32_t flags;
-	const TickType_t ulMaxBlockTime = portMAX_DELAY;//pdMS_TO_TICKS(100UL);
-	/* Remove compiler warnings about unused parameters. */
-	(void)pvParameters;
+	TickType_t ulMaxBlockTime = portMAX_DELAY;//pdMS_TO_TICKS(100UL);
+	uint8_t ring = (uint8_t)(uint32_t)pvParameters;
+	uint32_t ulFrames;
 	for (;;)
 	{
 		//if (pdTRUE == xTaskNotifyWait( 0x00, 0xFFFFFFFF, &flags, ulMaxBlockTime ))
@@ -390,7 +1138,23 @@ static void prvEMACHandlerTask(void *pvParameters)
 			RND_Seed ^= xTaskGetTickCount();
 			//if (flags & )
 			//{
-			prvNetworkInterfaceInput();
+			ulFrames = prvNetworkInterfaceInput(ring);
+			if (ring == niRING_BULK)
+			{
+				prvReclaimTxBuffers();
+				if ((flags & niNOTIFY_RX_FILTER) != 0)
+				{
+					prvUpdateRxFilter();
+				}
+				if ((xTaskGetTickCount() - xParserCountRead) >= niCOAL_SAMPLE_TICKS)
+				{
+					prvReadRxParserCounters();
+				}
+				prvAdaptCoalescing(ulFrames);
+				/* While coalescing, wake up at the end of the sample window
+				even without interrupt to fall back when the traffic stops. */
+				ulMaxBlockTime = (ENET_CoalLevel != 0) ? niCOAL_SAMPLE_TICKS : portMAX_DELAY;
+			}
 			//}
 			//else
 			//{
@@ -424,7 +1188,11 @@ uint32_t uxRand( void )
 
 void vApplicationIPNetworkEventHook( eIPCallbackEvent_t eNetworkEvent )
 {
-	(void)(eNetworkEvent);
+	if (eNetworkEvent == eNetworkUp)
+	{
+		/* The ARP rule follows the IP address. */
+		vNetworkInterfaceBoundPortsChanged();
+	}
 }
 
 uint32_t ulApplicationGetNextSequenceNumber( uint32_t ulSourceAddress,
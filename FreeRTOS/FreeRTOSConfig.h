@@ -167,6 +167,16 @@
  *----------------------------------------------------------*/
 
 #define configSMP_CORE_NUMBER (3)
+/* Tasks with more than one core in their affinity mask are handed over to an
+idle core of the mask, see vTaskCoreAffinitySet(). */
+#define configUSE_CORE_AFFINITY 1
+#define configTASK_MIGRATION_PERIOD 10
+/* Lock-free item channels between the cores, see core_channel.h */
+#define configUSE_CORE_CHANNELS 1
+/* SEMA42 gate used by the kernel, the application gates are in boot_board.h */
+#define configKERNEL_SEMA42_GATE (15U)
+/* SEMA42 gate of the heap blocks freed on another core than their owner */
+#define configHEAP_SEMA42_GATE (14U)
 #define configUSE_PREEMPTION 1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
 #define configCPU_CLOCK_HZ (40000000UL)
@@ -192,7 +202,9 @@
 #define configSUPPORT_STATIC_ALLOCATION 0
 #define configSUPPORT_DYNAMIC_ALLOCATION 1
 
-#define configTOTAL_HEAP_SIZE ((size_t)65536)
+#define configTOTAL_HEAP_SIZE ((size_t)90112)
+/* heap_tlsf.c arena of each core, core 0 runs the IP stack and the boot tasks */
+#define configHEAP_ARENA_SIZES {65536U, 12288U, 12288U}
 
 #define configAPPLICATION_ALLOCATED_HEAP 0
 
@@ -203,10 +215,29 @@
 #define configUSE_MALLOC_FAILED_HOOK 0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK 0
 
-/* Run time and task stats gathering related definitions. */
+/* Run time and task stats gathering related definitions.  The run time is
+counted in time stamp ticks, it is only on in the build of the network load
+benchmark (-DconfigGENERATE_RUN_TIME_STATS=1), the switch in and out of the
+tasks pays for the read of the time stamp. */
+#ifndef configGENERATE_RUN_TIME_STATS
 #define configGENERATE_RUN_TIME_STATS 0
+#endif
+#if (configGENERATE_RUN_TIME_STATS == 1)
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() ((uint32_t)ullPortGetTimeStampTicks())
+#endif
 #define configUSE_TRACE_FACILITY 0
 #define configUSE_STATS_FORMATTING_FUNCTIONS 0
+/* Binary trace of the kernel events into one ring per core, streamed by the
+application, see trace_recorder.h.  16 bytes per event.  The rings take about
+50 KB of shared RAM and the ISR entry gets the hooks of portasm.s, so only a
+trace build sets it, with -DconfigUSE_TRACE_RECORDER=1 for the C and the
+assembler sources. */
+#ifndef configUSE_TRACE_RECORDER
+#define configUSE_TRACE_RECORDER 0
+#endif
+#define configTRACE_RING_LENGTH 1024
+#define configTRACE_MAX_NAMES 32
 
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES 0
@@ -217,6 +248,9 @@
 #define configTIMER_TASK_PRIORITY (3)
 #define configTIMER_QUEUE_LENGTH 10
 #define configTIMER_TASK_STACK_DEPTH 128
+/* Active timers in a hierarchical timer wheel instead of a sorted list, see
+timers.c */
+#define configUSE_TIMER_WHEEL 1
 
 /* Optional functions - most linkers will remove unused functions anyway. */
 #define INCLUDE_vTaskPrioritySet 1
@@ -282,11 +316,24 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 /* The highest interrupt priority that can be used by any interrupt service
 routine that makes calls to interrupt safe FreeRTOS API functions.  DO NOT CALL
 INTERRUPT SAFE FREERTOS API FUNCTIONS FROM ANY INTERRUPT THAT HAS A HIGHER
-PRIORITY THAN THIS! (higher priorities are lower numeric values. */
-#define configMAX_API_CALL_INTERRUPT_PRIORITY (15)
+PRIORITY THAN THIS! (on the INTC higher priorities are higher numeric values,
+15 is the highest.)  The critical sections raise INTC_CPR to this value, so
+priorities 9 to 15 are left to the interrupts that must never wait for the
+kernel, such as the PTP PIT correction stop (9) and the ENET 1588 timer period
+(10).  The PTP receive ring notifies its task and sits at this ceiling. */
+#define configMAX_API_CALL_INTERRUPT_PRIORITY (8)
 
 #define NOINIT_DATA_SECTION __attribute__((section(".noinit")))
+/* Zero initialised data accessed by more than one core, kept in one block of
+   the linker script so that it can be mapped cache-inhibited. */
+#define SHARED_DATA_SECTION __attribute__((section(".shared_ram")))
 
 //#define NOINIT_DATA_SECTION
 
+/* The trace hook macros must be defined before FreeRTOS.h defines the empty
+ones. */
+#if (configUSE_TRACE_RECORDER == 1) && defined(__GNUC__) && !defined(__ASSEMBLER__)
+#include "trace_recorder.h"
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
@@ -6,7 +6,7 @@ $(LIBRTOS_ROOT_DIR)/osif
 #$(LIBRTOS_ROOT_DIR)/Source/portable/Common
 #$(LIBRTOS_ROOT_DIR)/portable/MemMang
 
-LIBRTOS_SRCS := $(foreach v,$(LIBRTOS_SRC_DIRS),$(wildcard $(v)/*.c)) $(LIBRTOS_ROOT_DIR)/Source/portable/MemMang/heap_4.c
+LIBRTOS_SRCS := $(foreach v,$(LIBRTOS_SRC_DIRS),$(wildcard $(v)/*.c)) $(LIBRTOS_ROOT_DIR)/Source/portable/MemMang/heap_tlsf.c
 LIBRTOS_ASMS := $(foreach v,$(LIBRTOS_SRC_DIRS),$(wildcard $(v)/*.s))
 DEPS += $(patsubst %.c, %.d, $(notdir $(LIBRTOS_SRCS)))
 LIBRTOS_OBJS := $(patsubst %.c, %.o, $(notdir $(LIBRTOS_SRCS))) $(patsubst %.s, %.o, $(notdir $(LIBRTOS_ASMS)))
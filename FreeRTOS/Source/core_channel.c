@@ -0,0 +1,505 @@
+/*
+ * FreeRTOS Kernel V10.0.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "core_channel.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if ( configUSE_CORE_CHANNELS == 1 )
+
+#define coreCHANNEL_CORE_MASK( uxCoreID )	( ( UBaseType_t ) 1 << ( uxCoreID ) )
+
+/*
+ * The channels created on each core.  A list is only extended by its own core,
+ * so the inter-core yield interrupt of any core can walk all the lists without
+ * a lock.
+ */
+SHARED_DATA_SECTION static CoreChannel_t * volatile pxCoreChannelLists[ configSMP_CORE_NUMBER ];
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Copies pvItem into the lane if it is not full.  Called by the producer core
+ * with interrupts masked.
+ */
+static BaseType_t prvWriteToLane( const CoreChannel_t * const pxChannel, CoreChannelLane_t * const pxLane, const void *pvItem ) PRIVILEGED_FUNCTION;
+
+/*
+ * Copies the next item of the first lane that is not empty into pvBuffer and
+ * returns the lane, NULL if the channel is empty.  Called by the consumer.
+ */
+static CoreChannelLane_t *prvReadFromChannel( CoreChannel_t * const pxChannel, void *pvBuffer ) PRIVILEGED_FUNCTION;
+
+static BaseType_t prvLaneIsFull( const CoreChannel_t * const pxChannel, const CoreChannelLane_t * const pxLane ) PRIVILEGED_FUNCTION;
+static BaseType_t prvChannelIsEmpty( const CoreChannel_t * const pxChannel ) PRIVILEGED_FUNCTION;
+
+/*
+ * Wakes xTask, a task of core uxCoreID blocked on a channel.  A task of the
+ * calling core is notified directly, a task of another core by the inter-core
+ * yield interrupt of its core.  Called from a task.
+ */
+static void prvNotifyTask( TaskHandle_t xTask, UBaseType_t uxCoreID ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+CoreChannelHandle_t xCoreChannelCreateStatic( CoreChannel_t *pxChannelBuffer,
+											  uint8_t *pucStorageBuffer,
+											  uint32_t ulLength,
+											  uint32_t ulItemSize,
+											  UBaseType_t uxProducerCoreMask,
+											  UBaseType_t uxConsumerCore )
+{
+CoreChannel_t *pxChannel = NULL;
+UBaseType_t uxCoreID, uxLane;
+uint8_t *pucLaneStorage = pucStorageBuffer;
+
+	configASSERT( pxChannelBuffer );
+	configASSERT( pucStorageBuffer );
+	configASSERT( ( ulLength != 0UL ) && ( ( ulLength & ( ulLength - 1UL ) ) == 0UL ) );
+	configASSERT( ulItemSize != 0UL );
+	configASSERT( uxProducerCoreMask != 0U );
+	configASSERT( ( uxProducerCoreMask & ~( coreCHANNEL_CORE_MASK( configSMP_CORE_NUMBER ) - 1U ) ) == 0U );
+	configASSERT( uxConsumerCore < configSMP_CORE_NUMBER );
+
+	if( ( pxChannelBuffer != NULL ) && ( pucStorageBuffer != NULL ) &&
+		( ulLength != 0UL ) && ( ( ulLength & ( ulLength - 1UL ) ) == 0UL ) &&
+		( ulItemSize != 0UL ) && ( uxProducerCoreMask != 0U ) && ( uxConsumerCore < configSMP_CORE_NUMBER ) )
+	{
+		pxChannel = pxChannelBuffer;
+		( void ) memset( ( void * ) pxChannel, 0x00, sizeof( CoreChannel_t ) );
+
+		/* The storage is split between the producer cores. */
+		for( uxLane = 0; uxLane < configSMP_CORE_NUMBER; uxLane++ )
+		{
+			if( ( uxProducerCoreMask & coreCHANNEL_CORE_MASK( uxLane ) ) != 0U )
+			{
+				pxChannel->xLanes[ uxLane ].pucStorage = pucLaneStorage;
+				pucLaneStorage += ulLength * ulItemSize;
+			}
+		}
+
+		pxChannel->ulLength = ulLength;
+		pxChannel->ulItemSize = ulItemSize;
+		pxChannel->uxProducerCoreMask = uxProducerCoreMask;
+		pxChannel->uxConsumerCore = uxConsumerCore;
+
+		uxCoreID = ( UBaseType_t ) ucPortGetCoreId();
+		taskENTER_CRITICAL();
+		{
+			/* The channel is complete before the other cores can find it. */
+			pxChannel->pxNext = pxCoreChannelLists[ uxCoreID ];
+			portMEMORY_BARRIER();
+			pxCoreChannelLists[ uxCoreID ] = pxChannel;
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	return pxChannel;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCoreChannelSend( CoreChannelHandle_t xChannel, const void *pvItem, TickType_t xTicksToWait )
+{
+CoreChannel_t * const pxChannel = xChannel;
+CoreChannelLane_t *pxLane;
+TaskHandle_t xTask;
+TimeOut_t xTimeOut;
+BaseType_t xReturn, xWaiting, xTimedOut, xEntryTimeSet = pdFALSE;
+const UBaseType_t uxCoreID = ( UBaseType_t ) ucPortGetCoreId();
+
+	configASSERT( pxChannel );
+	configASSERT( pvItem );
+	configASSERT( ( pxChannel->uxProducerCoreMask & coreCHANNEL_CORE_MASK( uxCoreID ) ) != 0U );
+
+	pxLane = &( pxChannel->xLanes[ uxCoreID ] );
+
+	for( ;; )
+	{
+		xWaiting = pdFALSE;
+
+		taskENTER_CRITICAL();
+		{
+			xReturn = prvWriteToLane( pxChannel, pxLane, pvItem );
+
+			if( ( xReturn == pdFAIL ) && ( xTicksToWait != ( TickType_t ) 0 ) && ( pxLane->xTaskWaitingToSend == NULL ) )
+			{
+				/* Clear a notification left by an earlier wait before the
+				consumer can see this task. */
+				( void ) xTaskNotifyStateClear( NULL );
+				pxLane->xTaskWaitingToSend = xTaskGetCurrentTaskHandle();
+				xWaiting = pdTRUE;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( xReturn != pdFAIL )
+		{
+			/* The head was written before the waiting task is read, the
+			consumer does the opposite before it blocks. */
+			portMEMORY_BARRIER();
+			xTask = pxChannel->xTaskWaitingToReceive;
+			if( xTask != NULL )
+			{
+				prvNotifyTask( xTask, pxChannel->uxConsumerCore );
+			}
+			break;
+		}
+
+		xTimedOut = pdFALSE;
+
+		if( xTicksToWait == ( TickType_t ) 0 )
+		{
+			xTimedOut = pdTRUE;
+		}
+		else if( xEntryTimeSet == pdFALSE )
+		{
+			vTaskSetTimeOutState( &xTimeOut );
+			xEntryTimeSet = pdTRUE;
+		}
+		else if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+		{
+			xTimedOut = pdTRUE;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		if( xWaiting != pdFALSE )
+		{
+			if( xTimedOut == pdFALSE )
+			{
+				portMEMORY_BARRIER();
+				if( prvLaneIsFull( pxChannel, pxLane ) != pdFALSE )
+				{
+					( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+				}
+			}
+			pxLane->xTaskWaitingToSend = NULL;
+		}
+		else if( xTimedOut == pdFALSE )
+		{
+			/* Another task of this core is already waiting for the consumer. */
+			vTaskDelay( ( TickType_t ) 1 );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		if( xTimedOut != pdFALSE )
+		{
+			xReturn = errQUEUE_FULL;
+			break;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCoreChannelSendFromISR( CoreChannelHandle_t xChannel, const void *pvItem, BaseType_t *pxHigherPriorityTaskWoken )
+{
+CoreChannel_t * const pxChannel = xChannel;
+BaseType_t xReturn;
+TaskHandle_t xTask;
+UBaseType_t uxSavedInterruptStatus;
+const UBaseType_t uxCoreID = ( UBaseType_t ) ucPortGetCoreId();
+
+	configASSERT( pxChannel );
+	configASSERT( pvItem );
+	configASSERT( ( pxChannel->uxProducerCoreMask & coreCHANNEL_CORE_MASK( uxCoreID ) ) != 0U );
+
+	uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		xReturn = prvWriteToLane( pxChannel, &( pxChannel->xLanes[ uxCoreID ] ), pvItem );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	if( xReturn != pdFAIL )
+	{
+		portMEMORY_BARRIER();
+		xTask = pxChannel->xTaskWaitingToReceive;
+
+		if( xTask != NULL )
+		{
+			if( pxChannel->uxConsumerCore == uxCoreID )
+			{
+				( void ) xTaskNotifyFromISR( xTask, ( uint32_t ) 0, eNoAction, pxHigherPriorityTaskWoken );
+			}
+			else
+			{
+				portYIELD_CORE( pxChannel->uxConsumerCore );
+			}
+		}
+	}
+	else
+	{
+		xReturn = errQUEUE_FULL;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCoreChannelReceive( CoreChannelHandle_t xChannel, void *pvBuffer, TickType_t xTicksToWait )
+{
+CoreChannel_t * const pxChannel = xChannel;
+CoreChannelLane_t *pxLane;
+TaskHandle_t xTask;
+TimeOut_t xTimeOut;
+BaseType_t xReturn = errQUEUE_EMPTY, xEntryTimeSet = pdFALSE;
+
+	configASSERT( pxChannel );
+	configASSERT( pvBuffer );
+	configASSERT( pxChannel->uxConsumerCore == ( UBaseType_t ) ucPortGetCoreId() );
+
+	for( ;; )
+	{
+		pxLane = prvReadFromChannel( pxChannel, pvBuffer );
+
+		if( pxLane != NULL )
+		{
+			/* The tail was written before the waiting task is read. */
+			portMEMORY_BARRIER();
+			xTask = pxLane->xTaskWaitingToSend;
+			if( xTask != NULL )
+			{
+				prvNotifyTask( xTask, ( UBaseType_t ) ( pxLane - pxChannel->xLanes ) );
+			}
+			xReturn = pdPASS;
+			break;
+		}
+
+		if( xTicksToWait == ( TickType_t ) 0 )
+		{
+			break;
+		}
+		else if( xEntryTimeSet == pdFALSE )
+		{
+			vTaskSetTimeOutState( &xTimeOut );
+			xEntryTimeSet = pdTRUE;
+		}
+		else if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+		{
+			break;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		( void ) xTaskNotifyStateClear( NULL );
+		pxChannel->xTaskWaitingToReceive = xTaskGetCurrentTaskHandle();
+
+		/* Either a producer writing from now on sees the waiting task, or its
+		item is seen here. */
+		portMEMORY_BARRIER();
+		if( prvChannelIsEmpty( pxChannel ) != pdFALSE )
+		{
+			( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+		}
+		pxChannel->xTaskWaitingToReceive = NULL;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxCoreChannelItemsWaiting( CoreChannelHandle_t xChannel )
+{
+const CoreChannel_t * const pxChannel = xChannel;
+UBaseType_t uxLane, uxItems = 0;
+
+	configASSERT( pxChannel );
+
+	for( uxLane = 0; uxLane < configSMP_CORE_NUMBER; uxLane++ )
+	{
+		uxItems += ( UBaseType_t ) ( pxChannel->xLanes[ uxLane ].ulHead - pxChannel->xLanes[ uxLane ].ulTail );
+	}
+
+	return uxItems;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCoreChannelServiceFromISR( void )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+const UBaseType_t uxCoreID = ( UBaseType_t ) ucPortGetCoreId();
+UBaseType_t uxList;
+CoreChannel_t *pxChannel;
+CoreChannelLane_t *pxLane;
+TaskHandle_t xTask;
+
+	/* The interrupt does not tell which channel changed, the channels that
+	have a task of this core waiting are checked. */
+	for( uxList = 0; uxList < configSMP_CORE_NUMBER; uxList++ )
+	{
+		for( pxChannel = pxCoreChannelLists[ uxList ]; pxChannel != NULL; pxChannel = pxChannel->pxNext )
+		{
+			if( pxChannel->uxConsumerCore == uxCoreID )
+			{
+				xTask = pxChannel->xTaskWaitingToReceive;
+				if( ( xTask != NULL ) && ( prvChannelIsEmpty( pxChannel ) == pdFALSE ) )
+				{
+					( void ) xTaskNotifyFromISR( xTask, ( uint32_t ) 0, eNoAction, &xHigherPriorityTaskWoken );
+				}
+			}
+
+			if( ( pxChannel->uxProducerCoreMask & coreCHANNEL_CORE_MASK( uxCoreID ) ) != 0U )
+			{
+				pxLane = &( pxChannel->xLanes[ uxCoreID ] );
+				xTask = pxLane->xTaskWaitingToSend;
+				if( ( xTask != NULL ) && ( prvLaneIsFull( pxChannel, pxLane ) == pdFALSE ) )
+				{
+					( void ) xTaskNotifyFromISR( xTask, ( uint32_t ) 0, eNoAction, &xHigherPriorityTaskWoken );
+				}
+			}
+		}
+	}
+
+	return xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvWriteToLane( const CoreChannel_t * const pxChannel, CoreChannelLane_t * const pxLane, const void *pvItem )
+{
+BaseType_t xReturn = pdFAIL;
+const uint32_t ulHead = pxLane->ulHead;
+
+	if( ( ulHead - pxLane->ulTail ) < pxChannel->ulLength )
+	{
+		( void ) memcpy( ( void * ) &( pxLane->pucStorage[ ( ulHead & ( pxChannel->ulLength - 1UL ) ) * pxChannel->ulItemSize ] ), pvItem, ( size_t ) pxChannel->ulItemSize );
+
+		/* The item is complete before the consumer can see it. */
+		portMEMORY_BARRIER();
+		pxLane->ulHead = ulHead + 1UL;
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static CoreChannelLane_t *prvReadFromChannel( CoreChannel_t * const pxChannel, void *pvBuffer )
+{
+CoreChannelLane_t *pxLane = NULL;
+UBaseType_t uxLane = pxChannel->uxNextLane, uxChecked;
+uint32_t ulTail;
+
+	/* The lanes are read in turn, a busy producer core can not starve the
+	others. */
+	for( uxChecked = 0; ( uxChecked < configSMP_CORE_NUMBER ) && ( pxLane == NULL ); uxChecked++ )
+	{
+		if( pxChannel->xLanes[ uxLane ].ulHead != pxChannel->xLanes[ uxLane ].ulTail )
+		{
+			pxLane = &( pxChannel->xLanes[ uxLane ] );
+		}
+		else
+		{
+			uxLane = ( uxLane + 1U ) % configSMP_CORE_NUMBER;
+		}
+	}
+
+	if( pxLane != NULL )
+	{
+		ulTail = pxLane->ulTail;
+
+		/* The item is read after the head that published it, and the slot is
+		given back after the item was read. */
+		portMEMORY_BARRIER();
+		( void ) memcpy( pvBuffer, ( const void * ) &( pxLane->pucStorage[ ( ulTail & ( pxChannel->ulLength - 1UL ) ) * pxChannel->ulItemSize ] ), ( size_t ) pxChannel->ulItemSize );
+		portMEMORY_BARRIER();
+		pxLane->ulTail = ulTail + 1UL;
+
+		pxChannel->uxNextLane = ( uxLane + 1U ) % configSMP_CORE_NUMBER;
+	}
+
+	return pxLane;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvLaneIsFull( const CoreChannel_t * const pxChannel, const CoreChannelLane_t * const pxLane )
+{
+BaseType_t xReturn;
+
+	if( ( pxLane->ulHead - pxLane->ulTail ) >= pxChannel->ulLength )
+	{
+		xReturn = pdTRUE;
+	}
+	else
+	{
+		xReturn = pdFALSE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvChannelIsEmpty( const CoreChannel_t * const pxChannel )
+{
+BaseType_t xReturn = pdTRUE;
+UBaseType_t uxLane;
+
+	for( uxLane = 0; uxLane < configSMP_CORE_NUMBER; uxLane++ )
+	{
+		if( pxChannel->xLanes[ uxLane ].ulHead != pxChannel->xLanes[ uxLane ].ulTail )
+		{
+			xReturn = pdFALSE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvNotifyTask( TaskHandle_t xTask, UBaseType_t uxCoreID )
+{
+	if( uxCoreID == ( UBaseType_t ) ucPortGetCoreId() )
+	{
+		( void ) xTaskNotify( xTask, ( uint32_t ) 0, eNoAction );
+	}
+	else
+	{
+		portYIELD_CORE( uxCoreID );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_CORE_CHANNELS */
@@ -822,6 +822,68 @@ extern "C" {
 	#define configUSE_POSIX_ERRNO 0
 #endif
 
+#ifndef configUSE_CORE_AFFINITY
+	#define configUSE_CORE_AFFINITY 0
+#endif
+
+#if ( configUSE_CORE_AFFINITY == 1 )
+	#ifndef configTASK_MIGRATION_PERIOD
+		/* Ticks between two checks of a core for ready tasks that can be
+		handed over to an idle core. */
+		#define configTASK_MIGRATION_PERIOD 10
+	#endif
+
+	#if !defined( portYIELD_CORE ) || !defined( portGET_MIGRATION_LOCK ) || !defined( portRELEASE_MIGRATION_LOCK )
+		#error configUSE_CORE_AFFINITY requires portYIELD_CORE(), portGET_MIGRATION_LOCK() and portRELEASE_MIGRATION_LOCK() from the port layer.
+	#endif
+#endif
+
+#ifndef configUSE_CORE_CHANNELS
+	#define configUSE_CORE_CHANNELS 0
+#endif
+
+#if ( configUSE_CORE_CHANNELS == 1 )
+	#if !defined( portYIELD_CORE ) || !defined( portMEMORY_BARRIER )
+		#error configUSE_CORE_CHANNELS requires portYIELD_CORE() and portMEMORY_BARRIER() from the port layer.
+	#endif
+
+	#if ( configUSE_TASK_NOTIFICATIONS != 1 )
+		#error configUSE_CORE_CHANNELS requires configUSE_TASK_NOTIFICATIONS, the tasks blocked on a channel wait for a notification.
+	#endif
+#endif
+
+#ifndef configUSE_TIMER_WHEEL
+	#define configUSE_TIMER_WHEEL 0
+#endif
+
+#if ( configUSE_TIMER_WHEEL == 1 ) && ( configUSE_16_BIT_TICKS == 1 )
+	#error configUSE_TIMER_WHEEL requires 32 bit ticks.
+#endif
+
+#ifndef configUSE_TRACE_RECORDER
+	#define configUSE_TRACE_RECORDER 0
+#endif
+
+#if ( configUSE_TRACE_RECORDER == 1 )
+	#ifndef configTRACE_RING_LENGTH
+		#define configTRACE_RING_LENGTH 512
+	#endif
+
+	#ifndef configTRACE_MAX_NAMES
+		#define configTRACE_MAX_NAMES 32
+	#endif
+
+	#if ( ( configTRACE_RING_LENGTH & ( configTRACE_RING_LENGTH - 1 ) ) != 0 )
+		#error configTRACE_RING_LENGTH must be a power of two.
+	#endif
+#endif
+
+#ifndef SHARED_DATA_SECTION
+	/* Section of the kernel data accessed by more than one core without a
+	lock, see core_channel.h. */
+	#define SHARED_DATA_SECTION
+#endif
+
 #ifndef portTICK_TYPE_IS_ATOMIC
 	#define portTICK_TYPE_IS_ATOMIC 0
 #endif
@@ -0,0 +1,228 @@
+/*
+ * FreeRTOS Kernel V10.0.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * Core channels pass fixed size items from tasks or interrupts of one or more
+ * producer cores to a task of a consumer core.  The kernel objects (queues,
+ * semaphores, ...) belong to the core that created them and can not be used
+ * from another core, a channel is the way to hand data over between cores.
+ *
+ * A channel holds one ring (lane) per producer core.  The head index of a
+ * lane is only written by its producer core and the tail index only by the
+ * consumer core, so the cores never wait for each other and no SEMA42 gate is
+ * taken.  Several writers on the same producer core are serialised by a
+ * critical section of that core.  A channel with one producer core is a
+ * single-producer/single-consumer ring, the consumer reads the lanes of a
+ * multi-producer channel in turn.
+ *
+ * ***NOTE***:  There must be only one reader, a task that stays on the consumer
+ * core (see vTaskCoreAffinitySet()).  A task blocked on a channel waits for a
+ * task notification, exactly like a task blocked on a stream buffer, so it
+ * must not use xTaskNotifyWait() for another purpose at the same time.  A
+ * task of another core is woken through the inter-core yield interrupt of its
+ * core (portYIELD_CORE()).
+ *
+ * The channel and its storage must be in memory that all cores access without
+ * a cache, declare them with SHARED_DATA_SECTION.  Channels can not be
+ * deleted.
+ */
+
+#ifndef CORE_CHANNEL_H
+#define CORE_CHANNEL_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h must appear in source files before include core_channel.h"
+#endif
+
+#include "task.h"
+
+#if defined( __cplusplus )
+extern "C" {
+#endif
+
+/* The ring written by one producer core. */
+typedef struct xCORE_CHANNEL_LANE
+{
+	volatile uint32_t ulHead;					/*< Number of items written, only updated by the producer core. */
+	volatile uint32_t ulTail;					/*< Number of items read, only updated by the consumer core. */
+	volatile TaskHandle_t xTaskWaitingToSend;	/*< Task of the producer core blocked on a full lane, or NULL. */
+	uint8_t *pucStorage;						/*< ulLength items, NULL when the core is not a producer. */
+} CoreChannelLane_t;
+
+/*
+ * The channel is declared here so that it can be allocated statically in the
+ * shared section.  Its members must only be accessed through the API below.
+ */
+typedef struct xCORE_CHANNEL
+{
+	CoreChannelLane_t xLanes[ configSMP_CORE_NUMBER ];	/*< Indexed by producer core. */
+	volatile TaskHandle_t xTaskWaitingToReceive;		/*< Task of the consumer core blocked on an empty channel, or NULL. */
+	uint32_t ulLength;									/*< Number of items of each lane, a power of two. */
+	uint32_t ulItemSize;
+	UBaseType_t uxProducerCoreMask;
+	UBaseType_t uxConsumerCore;
+	UBaseType_t uxNextLane;								/*< Lane the consumer reads first. */
+	struct xCORE_CHANNEL * volatile pxNext;				/*< Next channel created on the same core. */
+} CoreChannel_t;
+
+/**
+ * Type by which core channels are referenced.  For example, a call to
+ * xCoreChannelCreateStatic() returns a CoreChannelHandle_t variable that can
+ * then be used as a parameter to xCoreChannelSend(), xCoreChannelReceive(),
+ * etc.
+ */
+typedef CoreChannel_t * CoreChannelHandle_t;
+
+/*
+ * Size in bytes of the storage of a channel of uxProducerCores producer cores.
+ */
+#define coreCHANNEL_STORAGE_SIZE( ulLength, ulItemSize, uxProducerCores ) \
+	( ( size_t ) ( ulLength ) * ( size_t ) ( ulItemSize ) * ( size_t ) ( uxProducerCores ) )
+
+/**
+ * core_channel.h
+ *
+<pre>
+CoreChannelHandle_t xCoreChannelCreateStatic( CoreChannel_t *pxChannelBuffer,
+                                              uint8_t *pucStorageBuffer,
+                                              uint32_t ulLength,
+                                              uint32_t ulItemSize,
+                                              UBaseType_t uxProducerCoreMask,
+                                              UBaseType_t uxConsumerCore );
+</pre>
+ *
+ * Creates a channel in statically allocated memory.  The channel can be used
+ * from every core as soon as the function has returned, so it is normally
+ * created before the handle is published to the other cores.
+ *
+ * @param pxChannelBuffer The channel, declared with SHARED_DATA_SECTION.
+ *
+ * @param pucStorageBuffer At least coreCHANNEL_STORAGE_SIZE( ulLength,
+ * ulItemSize, number of bits set in uxProducerCoreMask ) bytes, declared with
+ * SHARED_DATA_SECTION.
+ *
+ * @param ulLength The number of items each producer core can write before the
+ * consumer reads them.  Must be a power of two.
+ *
+ * @param ulItemSize The size in bytes of an item, items are copied.
+ *
+ * @param uxProducerCoreMask Bit n is set when core n writes to the channel.
+ *
+ * @param uxConsumerCore The core of the task that reads the channel.
+ *
+ * @return The handle of the channel, NULL if a parameter is not valid.
+ */
+CoreChannelHandle_t xCoreChannelCreateStatic( CoreChannel_t *pxChannelBuffer,
+											  uint8_t *pucStorageBuffer,
+											  uint32_t ulLength,
+											  uint32_t ulItemSize,
+											  UBaseType_t uxProducerCoreMask,
+											  UBaseType_t uxConsumerCore ) PRIVILEGED_FUNCTION;
+
+/**
+ * core_channel.h
+ *
+<pre>
+BaseType_t xCoreChannelSend( CoreChannelHandle_t xChannel, const void *pvItem, TickType_t xTicksToWait );
+</pre>
+ *
+ * Copies an item into the lane of the calling core.  Only one task of a core
+ * blocks on a full lane, the other tasks of the same core check the lane
+ * again once per tick.
+ *
+ * @param xChannel The channel, the calling core must be one of its producers.
+ *
+ * @param pvItem The item to copy, ulItemSize bytes.
+ *
+ * @param xTicksToWait The maximum time to wait for a free slot.
+ *
+ * @return pdPASS if the item was written, errQUEUE_FULL otherwise.
+ */
+BaseType_t xCoreChannelSend( CoreChannelHandle_t xChannel, const void *pvItem, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * core_channel.h
+ *
+<pre>
+BaseType_t xCoreChannelSendFromISR( CoreChannelHandle_t xChannel, const void *pvItem, BaseType_t *pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * Interrupt safe version of xCoreChannelSend(), it does not block.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if the consumer task runs on
+ * the calling core, was woken and has a priority above the running task.  A
+ * context switch should then be requested before the interrupt is exited.
+ *
+ * @return pdPASS if the item was written, errQUEUE_FULL otherwise.
+ */
+BaseType_t xCoreChannelSendFromISR( CoreChannelHandle_t xChannel, const void *pvItem, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * core_channel.h
+ *
+<pre>
+BaseType_t xCoreChannelReceive( CoreChannelHandle_t xChannel, void *pvBuffer, TickType_t xTicksToWait );
+</pre>
+ *
+ * Copies the next item of the channel.  Only the consumer task may call it.
+ *
+ * @param pvBuffer The buffer the item is copied to, ulItemSize bytes.
+ *
+ * @param xTicksToWait The maximum time to wait for an item.
+ *
+ * @return pdPASS if an item was read, errQUEUE_EMPTY otherwise.
+ */
+BaseType_t xCoreChannelReceive( CoreChannelHandle_t xChannel, void *pvBuffer, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * core_channel.h
+ *
+<pre>
+UBaseType_t uxCoreChannelItemsWaiting( CoreChannelHandle_t xChannel );
+</pre>
+ *
+ * @return The number of items written to the channel and not read yet.  The
+ * value is only exact on the consumer core, the producers can add items
+ * meanwhile.
+ */
+UBaseType_t uxCoreChannelItemsWaiting( CoreChannelHandle_t xChannel ) PRIVILEGED_FUNCTION;
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS ONLY INTENDED
+ * FOR USE BY THE PORT LAYER.
+ *
+ * Called from the inter-core yield interrupt, with interrupts masked.  Wakes
+ * the tasks of the calling core that wait on a channel which became ready,
+ * returns pdTRUE if a context switch is required.
+ */
+BaseType_t xCoreChannelServiceFromISR( void ) PRIVILEGED_FUNCTION;
+
+#if defined( __cplusplus )
+}
+#endif
+
+#endif /* !defined( CORE_CHANNEL_H ) */
@@ -792,6 +792,34 @@ BaseType_t xMessageBufferReceiveCompletedFromISR( MessageBufferHandle_t xStreamB
  */
 #define xMessageBufferReceiveCompletedFromISR( xMessageBuffer, pxHigherPriorityTaskWoken ) xStreamBufferReceiveCompletedFromISR( ( StreamBufferHandle_t ) xMessageBuffer, pxHigherPriorityTaskWoken )
 
+/**
+ * message_buffer.h
+ *
+<pre>
+size_t xMessageBufferReserve( MessageBufferHandle_t xMessageBuffer, size_t xDataLengthBytes, StreamBufferSpan_t * const pxSpans, TickType_t xTicksToWait );
+size_t xMessageBufferCommit( MessageBufferHandle_t xMessageBuffer, size_t xDataLengthBytes );
+size_t xMessageBufferPeekContiguous( MessageBufferHandle_t xMessageBuffer, StreamBufferSpan_t * const pxSpans, TickType_t xTicksToWait );
+size_t xMessageBufferConsume( MessageBufferHandle_t xMessageBuffer, size_t xDataLengthBytes );
+</pre>
+ *
+ * Zero copy send and receive of messages, see xStreamBufferReserve(),
+ * xStreamBufferCommit(), xStreamBufferPeekContiguous() and
+ * xStreamBufferConsume().  A message is reserved whole and gets the length
+ * given to the commit.  The peek hands out the next message and the consume
+ * removes it whole.  The FromISR versions follow the stream buffer ones.
+ *
+ * \defgroup xMessageBufferReserve xMessageBufferReserve
+ * \ingroup MessageBufferManagement
+ */
+#define xMessageBufferReserve( xMessageBuffer, xDataLengthBytes, pxSpans, xTicksToWait ) xStreamBufferReserve( ( StreamBufferHandle_t ) xMessageBuffer, xDataLengthBytes, pxSpans, xTicksToWait )
+#define xMessageBufferReserveFromISR( xMessageBuffer, xDataLengthBytes, pxSpans ) xStreamBufferReserveFromISR( ( StreamBufferHandle_t ) xMessageBuffer, xDataLengthBytes, pxSpans )
+#define xMessageBufferCommit( xMessageBuffer, xDataLengthBytes ) xStreamBufferCommit( ( StreamBufferHandle_t ) xMessageBuffer, xDataLengthBytes )
+#define xMessageBufferCommitFromISR( xMessageBuffer, xDataLengthBytes, pxHigherPriorityTaskWoken ) xStreamBufferCommitFromISR( ( StreamBufferHandle_t ) xMessageBuffer, xDataLengthBytes, pxHigherPriorityTaskWoken )
+#define xMessageBufferPeekContiguous( xMessageBuffer, pxSpans, xTicksToWait ) xStreamBufferPeekContiguous( ( StreamBufferHandle_t ) xMessageBuffer, pxSpans, xTicksToWait )
+#define xMessageBufferPeekContiguousFromISR( xMessageBuffer, pxSpans ) xStreamBufferPeekContiguousFromISR( ( StreamBufferHandle_t ) xMessageBuffer, pxSpans )
+#define xMessageBufferConsume( xMessageBuffer, xDataLengthBytes ) xStreamBufferConsume( ( StreamBufferHandle_t ) xMessageBuffer, xDataLengthBytes )
+#define xMessageBufferConsumeFromISR( xMessageBuffer, xDataLengthBytes, pxHigherPriorityTaskWoken ) xStreamBufferConsumeFromISR( ( StreamBufferHandle_t ) xMessageBuffer, xDataLengthBytes, pxHigherPriorityTaskWoken )
+
 #if defined( __cplusplus )
 } /* extern "C" */
 #endif
@@ -139,6 +139,18 @@ typedef struct HeapRegion
 void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) PRIVILEGED_FUNCTION;
 
 
+/* Used to pass information about the heap out of vPortGetHeapStats(). */
+typedef struct xHeapStats
+{
+	size_t xAvailableHeapSpaceInBytes;		/* The total heap size currently available - this is the sum of all the free blocks, not the largest block that can be allocated. */
+	size_t xSizeOfLargestFreeBlockInBytes; 	/* The maximum size, in bytes, of all the free blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xSizeOfSmallestFreeBlockInBytes; /* The minimum size, in bytes, of all the free blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xNumberOfFreeBlocks;				/* The number of free memory blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xMinimumEverFreeBytesRemaining;	/* The minimum amount of total free memory (sum of all free blocks) there has been in the heap since the system booted. */
+	size_t xNumberOfSuccessfulAllocations;	/* The number of calls to pvPortMalloc() that have returned a valid memory block. */
+	size_t xNumberOfSuccessfulFrees;		/* The number of calls to vPortFree() that has successfully freed a block of memory. */
+} HeapStats_t;
+
 /*
  * Map to the memory management routines required for the port.
  */
@@ -148,6 +160,12 @@ void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * Fills pxHeapStats with the state of the heap.  heap_tlsf.c reports the arena
+ * of the calling core.
+ */
+void vPortGetHeapStats( HeapStats_t *pxHeapStats ) PRIVILEGED_FUNCTION;
+
 /*
  * Setup the hardware ready for the scheduler to take control.  This generally
  * sets up a tick interrupt and sets timers for the correct tick frequency.
@@ -178,6 +196,13 @@ void vPortEndScheduler( void ) PRIVILEGED_FUNCTION;
 	uint64_t vPortGetTimeStampMicroSec(void);
 	uint64_t vPortGetTimeStampNanoSec(void);
 
+	/* Raw timestamp: ticks of configCPU_CLOCK_HZ since the scheduler started
+	on core 0, for the hot paths that leave the conversion to the host or to
+	later.  No division, consistent across the cores. */
+	uint64_t ullPortGetTimeStampTicks(void);
+	uint64_t ullPortTimeStampTicksToNanoSec(uint64_t ticks);
+	uint64_t ullPortTimeStampTicksToMicroSec(uint64_t ticks);
+
 #ifdef __cplusplus
 }
 #endif
@@ -64,6 +64,18 @@ extern "C" {
 struct StreamBufferDef_t;
 typedef struct StreamBufferDef_t * StreamBufferHandle_t;
 
+/**
+ * Part of the storage area of a stream buffer, as handed out by
+ * xStreamBufferReserve() and xStreamBufferPeekContiguous().  Those functions
+ * fill an array of two spans: the bytes that wrap back to the start of the
+ * storage area are in the second span, which is zero bytes long otherwise.
+ */
+typedef struct StreamBufferSpanDef_t
+{
+	uint8_t *pucData;
+	size_t xLength;
+} StreamBufferSpan_t;
+
 
 /**
  * message_buffer.h
@@ -829,6 +841,218 @@ BaseType_t xStreamBufferReceiveCompletedFromISR( StreamBufferHandle_t xStreamBuf
  */
 BaseType_t xStreamBufferReceiveCompletedFromISR( StreamBufferHandle_t xStreamBuffer, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
 
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferReserve( StreamBufferHandle_t xStreamBuffer,
+                             size_t xDataLengthBytes,
+                             StreamBufferSpan_t * const pxSpans,
+                             TickType_t xTicksToWait );
+</pre>
+ *
+ * Zero copy alternative to xStreamBufferSend().  Hands out up to
+ * xDataLengthBytes bytes of free space of the stream buffer, which the sender
+ * writes in place before it makes them available to the receiver with
+ * xStreamBufferCommit().  The same rules as xStreamBufferSend() apply: only
+ * one task or interrupt writes to a stream buffer, and a reservation is
+ * committed before the next one is made.
+ *
+ * For a stream buffer as many bytes as there is space for are reserved.  For
+ * a message buffer the whole message is reserved, or nothing.
+ *
+ * Use xStreamBufferReserveFromISR() to reserve space from an interrupt.
+ *
+ * @param xStreamBuffer The handle of the stream buffer to write to.
+ *
+ * @param xDataLengthBytes The number of bytes wanted.
+ *
+ * @param pxSpans An array of two spans that receive the reserved space, the
+ * first from the head of the buffer and the second from the start of the
+ * storage area if the space wraps.
+ *
+ * @param xTicksToWait The maximum amount of time the calling task should
+ * remain in the Blocked state to wait for xDataLengthBytes of free space, as
+ * in xStreamBufferSend().
+ *
+ * @return The number of bytes reserved, the total length of the two spans.
+ *
+ * \defgroup xStreamBufferReserve xStreamBufferReserve
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReserve( StreamBufferHandle_t xStreamBuffer,
+							 size_t xDataLengthBytes,
+							 StreamBufferSpan_t * const pxSpans,
+							 TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferReserveFromISR( StreamBufferHandle_t xStreamBuffer,
+                                    size_t xDataLengthBytes,
+                                    StreamBufferSpan_t * const pxSpans );
+</pre>
+ *
+ * A version of xStreamBufferReserve() that can be called from an interrupt
+ * service routine (ISR).  It does not block.
+ *
+ * \defgroup xStreamBufferReserveFromISR xStreamBufferReserveFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReserveFromISR( StreamBufferHandle_t xStreamBuffer,
+									size_t xDataLengthBytes,
+									StreamBufferSpan_t * const pxSpans ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferCommit( StreamBufferHandle_t xStreamBuffer, size_t xDataLengthBytes );
+</pre>
+ *
+ * Makes the first xDataLengthBytes bytes of the last reservation available to
+ * the receiver, and unblocks a receiving task once the trigger level is
+ * reached.  Fewer bytes than were reserved can be committed, including zero
+ * to drop the reservation.  A message buffer gets a message of
+ * xDataLengthBytes bytes.
+ *
+ * Use xStreamBufferCommitFromISR() to commit from an interrupt.
+ *
+ * @param xStreamBuffer The handle of the stream buffer the space was reserved
+ * in.
+ *
+ * @param xDataLengthBytes The number of bytes written from the start of the
+ * reserved spans, no more than xStreamBufferReserve() returned.
+ *
+ * @return The number of bytes committed.
+ *
+ * \defgroup xStreamBufferCommit xStreamBufferCommit
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferCommit( StreamBufferHandle_t xStreamBuffer, size_t xDataLengthBytes ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferCommitFromISR( StreamBufferHandle_t xStreamBuffer,
+                                   size_t xDataLengthBytes,
+                                   BaseType_t * const pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * A version of xStreamBufferCommit() that can be called from an interrupt
+ * service routine (ISR).  *pxHigherPriorityTaskWoken is set as by
+ * xStreamBufferSendFromISR().
+ *
+ * \defgroup xStreamBufferCommitFromISR xStreamBufferCommitFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferCommitFromISR( StreamBufferHandle_t xStreamBuffer,
+								   size_t xDataLengthBytes,
+								   BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferPeekContiguous( StreamBufferHandle_t xStreamBuffer,
+                                    StreamBufferSpan_t * const pxSpans,
+                                    TickType_t xTicksToWait );
+</pre>
+ *
+ * Zero copy alternative to xStreamBufferReceive().  Hands out the data of the
+ * stream buffer in place, for example to a DMA or a zero copy socket send,
+ * without removing it.  The receiver then removes the bytes it is done with
+ * using xStreamBufferConsume().  Only one task or interrupt reads from a
+ * stream buffer.
+ *
+ * For a stream buffer all the bytes available are handed out.  For a message
+ * buffer the next message is handed out, without its length.
+ *
+ * Use xStreamBufferPeekContiguousFromISR() to peek from an interrupt.
+ *
+ * @param xStreamBuffer The handle of the stream buffer to read from.
+ *
+ * @param pxSpans An array of two spans that receive the data, the first from
+ * the tail of the buffer and the second from the start of the storage area if
+ * the data wraps.
+ *
+ * @param xTicksToWait The maximum amount of time the calling task should
+ * remain in the Blocked state to wait for data, as in xStreamBufferReceive().
+ *
+ * @return The number of bytes handed out, the total length of the two spans.
+ *
+ * \defgroup xStreamBufferPeekContiguous xStreamBufferPeekContiguous
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferPeekContiguous( StreamBufferHandle_t xStreamBuffer,
+									StreamBufferSpan_t * const pxSpans,
+									TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferPeekContiguousFromISR( StreamBufferHandle_t xStreamBuffer,
+                                           StreamBufferSpan_t * const pxSpans );
+</pre>
+ *
+ * A version of xStreamBufferPeekContiguous() that can be called from an
+ * interrupt service routine (ISR).  It does not block.
+ *
+ * \defgroup xStreamBufferPeekContiguousFromISR xStreamBufferPeekContiguousFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferPeekContiguousFromISR( StreamBufferHandle_t xStreamBuffer,
+										   StreamBufferSpan_t * const pxSpans ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferConsume( StreamBufferHandle_t xStreamBuffer, size_t xDataLengthBytes );
+</pre>
+ *
+ * Removes xDataLengthBytes bytes handed out by xStreamBufferPeekContiguous()
+ * from the stream buffer, and unblocks a task waiting for space.  The spans
+ * must not be used afterwards.  A message buffer removes the whole message,
+ * xDataLengthBytes must be its length as returned by the peek.
+ *
+ * Use xStreamBufferConsumeFromISR() to consume from an interrupt.
+ *
+ * @param xStreamBuffer The handle of the stream buffer being read.
+ *
+ * @param xDataLengthBytes The number of bytes removed from the start of the
+ * peeked spans.
+ *
+ * @return The number of bytes removed.
+ *
+ * \defgroup xStreamBufferConsume xStreamBufferConsume
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferConsume( StreamBufferHandle_t xStreamBuffer, size_t xDataLengthBytes ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferConsumeFromISR( StreamBufferHandle_t xStreamBuffer,
+                                    size_t xDataLengthBytes,
+                                    BaseType_t * const pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * A version of xStreamBufferConsume() that can be called from an interrupt
+ * service routine (ISR).  *pxHigherPriorityTaskWoken is set as by
+ * xStreamBufferReceiveFromISR().
+ *
+ * \defgroup xStreamBufferConsumeFromISR xStreamBufferConsumeFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferConsumeFromISR( StreamBufferHandle_t xStreamBuffer,
+									size_t xDataLengthBytes,
+									BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
 /* Functions below here are not part of the public API. */
 StreamBufferHandle_t xStreamBufferGenericCreate( size_t xBufferSizeBytes,
 												 size_t xTriggerLevelBytes,
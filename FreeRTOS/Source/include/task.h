@@ -162,6 +162,13 @@ typedef enum
  */
 #define tskIDLE_PRIORITY			( ( UBaseType_t ) 0U )
 
+/**
+ * Affinity mask that lets a task run on any core, see vTaskCoreAffinitySet().
+ *
+ * \ingroup TaskUtils
+ */
+#define tskNO_AFFINITY				( ( UBaseType_t ) -1 )
+
 /**
  * task. h
  *
@@ -1012,6 +1019,72 @@ void vTaskGetInfo( TaskHandle_t xTask, TaskStatus_t *pxTaskStatus, BaseType_t xG
  */
 void vTaskPrioritySet( TaskHandle_t xTask, UBaseType_t uxNewPriority ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * <pre>void vTaskCoreAffinitySet( TaskHandle_t xTask, UBaseType_t uxCoreAffinityMask );</pre>
+ *
+ * configUSE_CORE_AFFINITY must be defined as 1 for this function to be
+ * available.
+ *
+ * Sets the cores a task may run on, bit n standing for core n.  A task is
+ * created bound to the core that created it.  A task whose mask holds more
+ * than one core is handed over by its core's scheduler to another core of the
+ * mask when that core is idle and the task is ready but waiting for the
+ * processor.  A task whose mask no longer holds its current core is moved at
+ * the next check of that core, or at once if it is the calling task.  The
+ * check runs every configTASK_MIGRATION_PERIOD ticks.
+ *
+ * Each core still runs its own kernel, so queues, semaphores, event groups and
+ * notifications only work between tasks of the same core.  A task given more
+ * than one core must not use them with tasks that stay bound to a core, and a
+ * task holding a mutex is never moved.  The cores without a floating point
+ * unit (core 2, an e200z2) are taken out of the mask of a task that called
+ * vTaskUsesFPU().
+ *
+ * @param xTask Handle of the task.  Passing NULL sets the mask of the calling
+ * task.
+ *
+ * @param uxCoreAffinityMask Cores the task may run on, tskNO_AFFINITY for all
+ * of them.
+ *
+ * \defgroup vTaskCoreAffinitySet vTaskCoreAffinitySet
+ * \ingroup TaskCtrl
+ */
+void vTaskCoreAffinitySet( TaskHandle_t xTask, UBaseType_t uxCoreAffinityMask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>UBaseType_t vTaskCoreAffinityGet( TaskHandle_t xTask );</pre>
+ *
+ * configUSE_CORE_AFFINITY must be defined as 1 for this function to be
+ * available.
+ *
+ * @param xTask Handle of the task.  Passing NULL queries the calling task.
+ *
+ * @return The cores the task may run on, bit n standing for core n.
+ *
+ * \defgroup vTaskCoreAffinityGet vTaskCoreAffinityGet
+ * \ingroup TaskCtrl
+ */
+UBaseType_t vTaskCoreAffinityGet( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <pre>void vTaskUsesFPU( void );</pre>
+ *
+ * Only available when the port defines portFPU_CORE_MASK, the cores which have
+ * a floating point unit.  Called through portTASK_USES_FLOATING_POINT() by a
+ * task before it uses floating point.  The task gets a floating point context
+ * and its affinity mask is limited to portFPU_CORE_MASK, now and by any later
+ * vTaskCoreAffinitySet().  Must be called on a core of portFPU_CORE_MASK.
+ *
+ * \defgroup vTaskUsesFPU vTaskUsesFPU
+ * \ingroup TaskCtrl
+ */
+#ifdef portFPU_CORE_MASK
+	void vTaskUsesFPU( void ) PRIVILEGED_FUNCTION;
+#endif
+
 /**
  * task. h
  * <pre>void vTaskSuspend( TaskHandle_t xTaskToSuspend );</pre>
@@ -1536,6 +1609,16 @@ BaseType_t xTaskCallApplicationTaskHook( TaskHandle_t xTask, void *pvParameter )
  */
 TaskHandle_t xTaskGetIdleTaskHandle( void ) PRIVILEGED_FUNCTION;
 
+/**
+ * ulTaskGetIdleRunTimeCounter() is only available if
+ * configGENERATE_RUN_TIME_STATS is set to 1 in FreeRTOSConfig.h.
+ *
+ * Returns the run time counter of the idle task of the calling core, in units
+ * of portGET_RUN_TIME_COUNTER_VALUE().  The difference of two readings over
+ * the elapsed run time counter is the idle share of the core.
+ */
+uint32_t ulTaskGetIdleRunTimeCounter( void ) PRIVILEGED_FUNCTION;
+
 /**
  * configUSE_TRACE_FACILITY must be defined as 1 in FreeRTOSConfig.h for
  * uxTaskGetSystemState() to be available.
@@ -2306,6 +2389,21 @@ void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem, const Tick
  */
 portDONT_DISCARD void vTaskSwitchContext( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS ONLY
+ * INTENDED FOR USE WHEN IMPLEMENTING A PORT OF THE SCHEDULER AND IS
+ * AN INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED.
+ *
+ * Called by the portable layer from the interrupt raised by portYIELD_CORE()
+ * when configUSE_CORE_AFFINITY is 1.  Moves the tasks handed over by other
+ * cores into the ready lists of the calling core.  Returns pdTRUE if one of
+ * them has a priority above the running task, in which case a context switch
+ * is required.
+ */
+BaseType_t xTaskReceiveMigratedTasks( void ) PRIVILEGED_FUNCTION;
+
 /*
  * THESE FUNCTIONS MUST NOT BE USED FROM APPLICATION CODE.  THEY ARE USED BY
  * THE EVENT BITS MODULE.
@@ -0,0 +1,231 @@
+/*
+ * FreeRTOS Kernel V10.0.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * Binary trace recorder.  The trace hook macros of the kernel, the interrupt
+ * entry and exit of the port and the network buffer iptrace macros write
+ * fixed size events into one ring per core.  An event is timestamped with the
+ * count of STM_0, which runs for all the cores, so the rings merge into one
+ * timeline.
+ *
+ * A ring is only written by its own core, with MSR[EE] cleared for the few
+ * instructions of the write, and only read by one task (the stream task of the
+ * application), so no lock is taken between the cores.  An event that finds
+ * its ring full is counted as dropped.  Nothing is recorded until
+ * vTraceRecorderStart() is called, the hooks then cost one test of a shared
+ * flag.
+ *
+ * This header is included at the end of FreeRTOSConfig.h so that the hook
+ * macros are defined before FreeRTOS.h gives them their empty defaults.  It
+ * must therefore not include any other kernel header.
+ */
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <stdint.h>
+
+#if defined( __cplusplus )
+extern "C" {
+#endif
+
+/* Event types, the layout of TraceEvent_t is the wire format of the stream. */
+#define traceREC_TASK_SWITCHED_IN		( 1U )	/*< ulObject: TCB, usArg: priority. */
+#define traceREC_TASK_READY				( 2U )	/*< ulObject: TCB, usArg: priority. */
+#define traceREC_TASK_CREATE			( 3U )	/*< ulObject: TCB, usArg: priority. */
+#define traceREC_TASK_DELETE			( 4U )	/*< ulObject: TCB. */
+#define traceREC_TASK_DELAY				( 5U )	/*< ulObject: running TCB, ulData: tick to wake. */
+#define traceREC_TASK_NOTIFY			( 6U )	/*< ulObject: notified TCB, ucArg: 1 from an interrupt. */
+#define traceREC_TASK_NOTIFY_WAIT		( 7U )	/*< ulObject: running TCB, blocks on a notification. */
+#define traceREC_TICK					( 8U )	/*< ulData: tick count. */
+#define traceREC_ISR_ENTER				( 9U )	/*< usArg: INTC vector. */
+#define traceREC_ISR_EXIT				( 10U )	/*< usArg: INTC vector. */
+#define traceREC_QUEUE_SEND				( 11U )	/*< ulObject: queue, ulData: items waiting, ucArg: 1 from an interrupt. */
+#define traceREC_QUEUE_SEND_FAILED		( 12U )
+#define traceREC_QUEUE_SEND_BLOCK		( 13U )
+#define traceREC_QUEUE_RECEIVE			( 14U )
+#define traceREC_QUEUE_RECEIVE_FAILED	( 15U )
+#define traceREC_QUEUE_RECEIVE_BLOCK	( 16U )
+#define traceREC_STREAM_SEND			( 17U )	/*< ulObject: stream buffer, ulData: bytes, ucArg: 1 from an interrupt. */
+#define traceREC_STREAM_RECEIVE			( 18U )
+#define traceREC_STREAM_SEND_BLOCK		( 19U )
+#define traceREC_STREAM_RECEIVE_BLOCK	( 20U )
+#define traceREC_NET_BUFFER_GET			( 21U )	/*< ulObject: network buffer, NULL when the pool was empty, ucArg: 1 from an interrupt. */
+#define traceREC_NET_BUFFER_RELEASE		( 22U )	/*< ulObject: network buffer. */
+#define traceREC_USER					( 64U )	/*< Application events, traceREC_USER + n. */
+
+/* Event of the rings, 16 bytes. */
+typedef struct xTRACE_EVENT
+{
+	uint32_t ulTimeStamp;	/*< STM_0 count. */
+	uint8_t ucType;			/*< traceREC_... */
+	uint8_t ucArg;
+	uint16_t usArg;
+	uint32_t ulObject;		/*< Address of the kernel object, or 0. */
+	uint32_t ulData;
+} TraceEvent_t;
+
+/* Length of the names of the name table, names are cut to fit. */
+#define traceNAME_LENGTH				( 12U )
+
+/* Entry of the name table of a core. */
+typedef struct xTRACE_NAME
+{
+	uint32_t ulObject;
+	char pcName[ traceNAME_LENGTH ];	/*< Not terminated when the name fills it. */
+} TraceName_t;
+
+/*
+ * The flag tested by the hooks before they call into the recorder, set by
+ * vTraceRecorderStart().
+ */
+extern volatile uint32_t ulTraceRecorderEnabled;
+
+/*
+ * The task that streams the rings, set by vTraceRecorderSetStreamTask(), or
+ * NULL.
+ */
+extern void * volatile pvTraceRecorderStreamTask;
+
+/*
+ * Writes an event to the ring of the calling core.  Can be called from any
+ * task or interrupt, also from the interrupts above
+ * configMAX_API_CALL_INTERRUPT_PRIORITY, and from the application with a type
+ * from traceREC_USER.
+ */
+void vTraceRecordEvent( uint8_t ucType, uint8_t ucArg, uint16_t usArg, uint32_t ulObject, uint32_t ulData );
+
+/*
+ * Adds a name to the name table of the calling core, for instance the name of
+ * a queue or of a stream buffer.  The task names are added when the tasks are
+ * created.  A later entry for the same object replaces the earlier one in the
+ * decoder.  Names are kept while the recorder is stopped.
+ */
+void vTraceSetObjectName( const void *pvObject, const char *pcName );
+
+/*
+ * Starts the STM_0 counter if needed and enables the hooks on all the cores,
+ * or disables them.  The events already in the rings are kept.
+ */
+void vTraceRecorderStart( void );
+void vTraceRecorderStop( void );
+
+/*
+ * Called by the interrupt handler of the port around the handler of a vector.
+ */
+void vTraceISREnter( uint32_t ulVector );
+void vTraceISRExit( uint32_t ulVector );
+
+/*
+ * THESE FUNCTIONS ARE ONLY INTENDED FOR THE TASK THAT STREAMS THE RINGS, THERE
+ * MUST BE ONE SUCH TASK.
+ *
+ * Sets the stream task, pvTask is its handle.  The events recorded with
+ * traceRECORD_NOT_STREAM() are skipped in that task: the network buffers of
+ * each datagram it sends would otherwise add events to the rings it drains.
+ */
+void vTraceRecorderSetStreamTask( void *pvTask );
+
+/*
+ * Copies up to uxMaxEvents events of the ring of core uxCore to pxEvents and
+ * frees them, returns the number of events copied.  *pulDropped is set to the
+ * number of events lost on that core since the start.
+ */
+uint32_t ulTraceRecorderRead( uint32_t ulCore, TraceEvent_t *pxEvents, uint32_t ulMaxEvents, uint32_t *pulDropped );
+
+/*
+ * Returns the name table of core ulCore and sets *pulCount to its number of
+ * entries.  The entries below *pulCount do not change any more.
+ */
+const TraceName_t *pxTraceRecorderGetNames( uint32_t ulCore, uint32_t *pulCount );
+
+/* Current STM_0 count, the time base of the events. */
+uint32_t ulTraceRecorderGetTimeStamp( void );
+
+#define traceRECORD( ucType, ucArg, usArg, ulObject, ulData )																	\
+	do																															\
+	{																															\
+		if( ulTraceRecorderEnabled != 0U )																						\
+		{																														\
+			vTraceRecordEvent( ( uint8_t ) ( ucType ), ( uint8_t ) ( ucArg ), ( uint16_t ) ( usArg ), ( uint32_t ) ( ulObject ), ( uint32_t ) ( ulData ) );	\
+		}																														\
+	} while( 0 )
+
+/* As traceRECORD(), but not from the stream task.  For the task context only,
+where task.h is included. */
+#define traceRECORD_NOT_STREAM( ucType, ucArg, usArg, ulObject, ulData )															\
+	do																															\
+	{																															\
+		if( ( ulTraceRecorderEnabled != 0U ) && ( ( void * ) xTaskGetCurrentTaskHandle() != pvTraceRecorderStreamTask ) )		\
+		{																														\
+			vTraceRecordEvent( ( uint8_t ) ( ucType ), ( uint8_t ) ( ucArg ), ( uint16_t ) ( usArg ), ( uint32_t ) ( ulObject ), ( uint32_t ) ( ulData ) );	\
+		}																														\
+	} while( 0 )
+
+/* Kernel hooks.  They are expanded in tasks.c, queue.c and stream_buffer.c,
+where pxCurrentTCB, pxTCB and pxQueue are the names of the objects. */
+#define traceTASK_SWITCHED_IN()					traceRECORD( traceREC_TASK_SWITCHED_IN, 0, pxCurrentTCB->uxPriority, pxCurrentTCB, 0 )
+#define traceMOVED_TASK_TO_READY_STATE( pxTCB )	traceRECORD( traceREC_TASK_READY, 0, ( pxTCB )->uxPriority, ( pxTCB ), 0 )
+#define traceTASK_CREATE( pxNewTCB )																							\
+	do																															\
+	{																															\
+		vTraceSetObjectName( ( pxNewTCB ), ( pxNewTCB )->pcTaskName );															\
+		traceRECORD( traceREC_TASK_CREATE, 0, ( pxNewTCB )->uxPriority, ( pxNewTCB ), 0 );										\
+	} while( 0 )
+#define traceTASK_DELETE( pxTCB )				traceRECORD( traceREC_TASK_DELETE, 0, 0, ( pxTCB ), 0 )
+#define traceTASK_DELAY()						traceRECORD( traceREC_TASK_DELAY, 0, 0, pxCurrentTCB, xTickCount + xTicksToDelay )
+#define traceTASK_DELAY_UNTIL( xTimeToWake )	traceRECORD( traceREC_TASK_DELAY, 0, 0, pxCurrentTCB, ( xTimeToWake ) )
+#define traceTASK_NOTIFY()						traceRECORD( traceREC_TASK_NOTIFY, 0, 0, pxTCB, 0 )
+#define traceTASK_NOTIFY_FROM_ISR()				traceRECORD( traceREC_TASK_NOTIFY, 1, 0, pxTCB, 0 )
+#define traceTASK_NOTIFY_GIVE_FROM_ISR()		traceRECORD( traceREC_TASK_NOTIFY, 1, 0, pxTCB, 0 )
+#define traceTASK_NOTIFY_TAKE_BLOCK()			traceRECORD( traceREC_TASK_NOTIFY_WAIT, 0, 0, pxCurrentTCB, 0 )
+#define traceTASK_NOTIFY_WAIT_BLOCK()			traceRECORD( traceREC_TASK_NOTIFY_WAIT, 0, 0, pxCurrentTCB, 0 )
+#define traceTASK_INCREMENT_TICK( xTickCount )	traceRECORD( traceREC_TICK, 0, 0, 0, ( xTickCount ) )
+
+#define traceQUEUE_SEND( pxQueue )							traceRECORD( traceREC_QUEUE_SEND, 0, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_SEND_FAILED( pxQueue )					traceRECORD( traceREC_QUEUE_SEND_FAILED, 0, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+#define traceBLOCKING_ON_QUEUE_SEND( pxQueue )				traceRECORD( traceREC_QUEUE_SEND_BLOCK, 0, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue )					traceRECORD( traceREC_QUEUE_SEND, 1, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue )			traceRECORD( traceREC_QUEUE_SEND_FAILED, 1, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_RECEIVE( pxQueue )						traceRECORD( traceREC_QUEUE_RECEIVE, 0, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_RECEIVE_FAILED( pxQueue )				traceRECORD( traceREC_QUEUE_RECEIVE_FAILED, 0, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue )			traceRECORD( traceREC_QUEUE_RECEIVE_BLOCK, 0, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue )				traceRECORD( traceREC_QUEUE_RECEIVE, 1, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_RECEIVE_FROM_ISR_FAILED( pxQueue )		traceRECORD( traceREC_QUEUE_RECEIVE_FAILED, 1, 0, ( pxQueue ), ( pxQueue )->uxMessagesWaiting )
+
+#define traceSTREAM_BUFFER_SEND( xStreamBuffer, xBytesSent )						traceRECORD( traceREC_STREAM_SEND, 0, 0, ( xStreamBuffer ), ( xBytesSent ) )
+#define traceSTREAM_BUFFER_SEND_FROM_ISR( xStreamBuffer, xBytesSent )				traceRECORD( traceREC_STREAM_SEND, 1, 0, ( xStreamBuffer ), ( xBytesSent ) )
+#define traceBLOCKING_ON_STREAM_BUFFER_SEND( xStreamBuffer )						traceRECORD( traceREC_STREAM_SEND_BLOCK, 0, 0, ( xStreamBuffer ), 0 )
+#define traceSTREAM_BUFFER_RECEIVE( xStreamBuffer, xReceivedLength )				traceRECORD( traceREC_STREAM_RECEIVE, 0, 0, ( xStreamBuffer ), ( xReceivedLength ) )
+#define traceSTREAM_BUFFER_RECEIVE_FROM_ISR( xStreamBuffer, xReceivedLength )		traceRECORD( traceREC_STREAM_RECEIVE, 1, 0, ( xStreamBuffer ), ( xReceivedLength ) )
+#define traceBLOCKING_ON_STREAM_BUFFER_RECEIVE( xStreamBuffer )						traceRECORD( traceREC_STREAM_RECEIVE_BLOCK, 0, 0, ( xStreamBuffer ), 0 )
+
+#if defined( __cplusplus )
+}
+#endif
+
+#endif /* !defined( TRACE_RECORDER_H ) */
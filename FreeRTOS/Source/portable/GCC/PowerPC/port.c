@@ -34,6 +34,12 @@
 #include "queue.h"
 #include "timers.h"
 #include "event_groups.h"
+#if (configUSE_CORE_AFFINITY == 1)
+#include "sema42_driver.h"
+#endif
+#if (configUSE_CORE_CHANNELS == 1)
+#include "core_channel.h"
+#endif
 
 /*-----------------------------------------------------------*/
 
@@ -54,6 +60,13 @@
 //uint32_t *pxSystemStackPointer = NULL;
 uint32_t *pxSystemStackPointer_SMP[configSMP_CORE_NUMBER] = {NULL};
 
+/* Non-zero while the running task has a floating point context, saved in and
+   restored from the task frame by portasm.s */
+uint32_t ulPortTaskHasFPUContext_SMP[configSMP_CORE_NUMBER] = {0U};
+
+/* SPR number of the EFPU2 status and control register */
+#define portSPEFSCR 512
+
 /*
  * Function to start the scheduler running by starting the highest
  * priority task that has thus far been created
@@ -62,9 +75,13 @@ extern void vPortStartFirstTask(void);
 
 /*-----------------------------------------------------------*/
 
-/* The stack frame created on an interrupt (size 0x98):
+/* The stack frame created on an interrupt (size 0xA0):
  * ----------------------------------
- *      | last backchain  | <- SP + 0x98
+ *      | last backchain  | <- SP + 0xA0
+ *      |-----------------|
+ *      |     SPEFSCR     | <- SP + 0x9C (Only saved when the FPU flag is set)
+ *      |-----------------|
+ *      |    FPU flag     | <- SP + 0x98
  *      |-----------------|
  *      | R0, 3-12, 14-31 | <- (SP + 0x24) to (SP + 0x94)
  *      |                 | R31 is stored in higher memory, R0 in lower memory
@@ -112,6 +129,11 @@ portSTACK_TYPE *pxPortInitialiseStack(portSTACK_TYPE *pxTopOfStack, TaskFunction
     *pxTopOfStack = 0x0L; /* Root backchain */
     pxBackchain = pxTopOfStack;
 
+    pxTopOfStack--;
+    *pxTopOfStack = 0x0L; /* SPEFSCR - 0x9C */
+    pxTopOfStack--;
+    *pxTopOfStack = 0x0L; /* FPU flag - 0x98, integer-only until vPortTaskUsesFPU() */
+
     pxTopOfStack--;
     *pxTopOfStack = 0x1FL; /* r31  - 0x94 */
     pxTopOfStack--;
@@ -203,12 +225,21 @@ portSTACK_TYPE *pxPortInitialiseStack(portSTACK_TYPE *pxTopOfStack, TaskFunction
 
 /*-----------------------------------------------------------*/
 extern void prvPortTimerSetup(void (*)(void), uint32_t coreId, uint32_t);
+#if ((configUSE_CORE_AFFINITY == 1) || (configUSE_CORE_CHANNELS == 1))
+extern void prvPortYieldCoreSetup(void (*)(void), uint32_t coreId);
+extern void prvPortYieldCoreRaise(uint32_t coreId);
+extern void prvPortYieldCoreClear(uint32_t coreId);
+static void vPortYieldCoreISR(void);
+#endif
 /* Note that you must setup and
  * install the timer interrupt before calling this
  */
 portBASE_TYPE xPortStartScheduler(void)
 {
     prvPortTimerSetup(vPortTickISR, ucPortGetCoreId(), TICK_INTERVAL);
+#if ((configUSE_CORE_AFFINITY == 1) || (configUSE_CORE_CHANNELS == 1))
+    prvPortYieldCoreSetup(vPortYieldCoreISR, ucPortGetCoreId());
+#endif
 
     vPortStartFirstTask();
 
@@ -259,6 +290,78 @@ void vPortTickISR(void)
     vPortUnmaskInterrupts(uxSavedInterruptStatus);
 }
 
+#if ((configUSE_CORE_AFFINITY == 1) || (configUSE_CORE_CHANNELS == 1))
+static void vPortYieldCoreISR(void)
+{
+    BaseType_t xSwitchRequired = pdFALSE;
+    UBaseType_t uxSavedInterruptStatus = ulPortMaskInterruptsFromISR();
+
+    /* Cleared before the shared state is read, an update made meanwhile raises it again */
+    prvPortYieldCoreClear(ucPortGetCoreId());
+#if (configUSE_CORE_AFFINITY == 1)
+    xSwitchRequired = xTaskReceiveMigratedTasks();
+#endif
+#if (configUSE_CORE_CHANNELS == 1)
+    if (xCoreChannelServiceFromISR() != pdFALSE)
+    {
+        xSwitchRequired = pdTRUE;
+    }
+#endif
+    if (xSwitchRequired != pdFALSE)
+    {
+        vTaskSwitchContext();
+    }
+
+    vPortUnmaskInterrupts(uxSavedInterruptStatus);
+}
+
+void vPortYieldCore(UBaseType_t uxCoreID)
+{
+    /* Make the shared state update visible before the other core is interrupted */
+    __asm__ volatile ("mbar" : : : "memory");
+    prvPortYieldCoreRaise(uxCoreID);
+}
+#endif
+
+#if (configUSE_CORE_AFFINITY == 1)
+
+void vPortGetMigrationLock(void)
+{
+    while (SEMA42_DRV_LockGate(0U, configKERNEL_SEMA42_GATE) != STATUS_SUCCESS)
+    {
+    }
+}
+
+void vPortReleaseMigrationLock(void)
+{
+    __asm__ volatile ("mbar" : : : "memory");
+    (void)SEMA42_DRV_UnlockGate(0U, configKERNEL_SEMA42_GATE);
+}
+#endif
+
+#ifdef configASSERT
+void vPortValidateInterruptPriority(void)
+{
+    /* Reading INTC_IACKR raised CPR to the priority of the running interrupt.
+     * An interrupt above configMAX_API_CALL_INTERRUPT_PRIORITY preempts the
+     * critical sections, its API calls would corrupt the kernel lists */
+    configASSERT(portINTC_CPR(ucPortGetCoreId()) <= configMAX_API_CALL_INTERRUPT_PRIORITY);
+}
+#endif
+
+void vPortTaskUsesFPU(void)
+{
+    /* SPEFSCR only exists on the e200z4 cores */
+    configASSERT(((1UL << ucPortGetCoreId()) & portFPU_CORE_MASK) != 0U);
+
+    portENTER_CRITICAL();
+    /* Round to nearest, no floating point exception enabled. Saved and
+     * restored with the task context from the next switch on */
+    portSetSPR(portSPEFSCR, 0UL);
+    ulPortTaskHasFPUContext_SMP[ucPortGetCoreId()] = 1U;
+    portEXIT_CRITICAL();
+}
+
 void vPortTaskEnterCritical(void)
 {
     /* Disable interrupts to create critical section */
@@ -32,8 +32,10 @@
 #include "FreeRTOSConfig.h"
 #include "cpu_defines.h"
 /*
-      STACK FRAME DESIGN: Depth: (0x98, or 152 bytes modulo 8 bytes = 19)
+      STACK FRAME DESIGN: Depth: (0xA0, or 160 bytes modulo 8 bytes = 20)
               ************* ______________
+    0x9C     *  SPEFSCR  *    ^           Only saved when the FPU flag is set
+    0x98     *  FPU flag * ___v__________ Set for the tasks that called vPortTaskUsesFPU()
     0x94     *  GPR31    *    ^
     0x90     *  GPR30    *    |
     0x8C     *  GPR29    *    |
@@ -83,7 +85,12 @@
 
 .extern pxCurrentTCB_SMP
 .extern pxSystemStackPointer_SMP
+.extern ulPortTaskHasFPUContext_SMP
 .extern vTaskSwitchContext
+#if defined(configUSE_TRACE_RECORDER) && (configUSE_TRACE_RECORDER == 1)
+.extern vTraceISREnter
+.extern vTraceISRExit
+#endif
 
 # Address of the INTC_CPR0 register
 .equ    INTC_CPR0_ADDR,  INTC_CPR_ADDR_BASE
@@ -96,6 +103,9 @@
 
 .equ    INTC_OFFSET, INTC_OFFSET_NUM
 
+# SPR number of the EFPU2 status and control register (e200z4 only)
+.equ    SPEFSCR, 512
+
 # Take out the processor used and add the offset of the processor to the reg
 .macro portGET_OFFSET_PROCESSOR    reg
     mfspr         r6, 286
@@ -109,8 +119,8 @@
 # See e200z4 Core Reference Manual Rev 2 section 2.4.9 "Hardware Implementation Dependent Register 0 (HID0)" Table 8
 # See e200z0 Core Reference Manual Rev 0 section 2.3.9 "Hardware Implementation Dependent Register 0 (HID0)" Table 2-8
 .macro portSAVE_CONTEXT
-    e_stw         r1, -0x98 (r1)          # Store backchain
-    e_sub16i      r1, r1, 0x98            # Allocate stack
+    e_stw         r1, -0xA0 (r1)          # Store backchain
+    e_sub16i      r1, r1, 0xA0            # Allocate stack
 
     e_stmvsrrw    0x0c (r1)               # Save SRR[0-1]
     e_stmvsprw    0x14 (r1)               # Save CR, LR, CTR, XER
@@ -119,6 +129,43 @@
 
     mfsprg        r4, 1
     se_stw        r4, 0x08 (r1)           # Save nested critical section count from SPRG1
+
+    portSAVE_FPU_CONTEXT
+.endm
+
+# Saves SPEFSCR if the running task uses floating point (r4,r6,r7 used as scratch registers)
+# The EFPU2 computes in the GPRs, SPEFSCR (rounding mode, sticky flags) is its only other state.
+# Integer-only tasks only pay for the flag.
+.macro portSAVE_FPU_CONTEXT
+    portLOAD_FPU_CONTEXT_FLAG_ADDRESS  r6
+    se_lwz        r4, 0x00 (r6)
+    e_stw         r4, 0x98 (r1)           # Save the FPU flag of the task
+    se_cmpi       r4, 0
+    se_beq        .Lno_fpu_save\@
+    mfspr         r4, SPEFSCR
+    e_stw         r4, 0x9C (r1)           # Save SPEFSCR
+.Lno_fpu_save\@:
+.endm
+
+# Restores SPEFSCR if the task of the frame uses floating point (r4,r6,r7 used as scratch registers)
+.macro portRESTORE_FPU_CONTEXT
+    portLOAD_FPU_CONTEXT_FLAG_ADDRESS  r6
+    e_lwz         r4, 0x98 (r1)
+    se_stw        r4, 0x00 (r6)           # The FPU flag follows the task
+    se_cmpi       r4, 0
+    se_beq        .Lno_fpu_restore\@
+    e_lwz         r4, 0x9C (r1)
+    mtspr         SPEFSCR, r4             # Restore SPEFSCR
+.Lno_fpu_restore\@:
+.endm
+
+# Macro to get the address of the FPU flag of the calling core (r7 used as scratch register)
+.macro portLOAD_FPU_CONTEXT_FLAG_ADDRESS  reg
+    mfspr   r7, 286
+    e_lis   \reg, ulPortTaskHasFPUContext_SMP@ha
+    e_la    \reg, ulPortTaskHasFPUContext_SMP@l(\reg)
+    se_slwi r7, 2
+    add     \reg, r7, \reg
 .endm
 
 # Restores registers from task stack and clears any outstanding reservation
@@ -128,12 +175,14 @@
                                           # See Power ISA Version 2.06B Revision B (July 23, 2010) section 1.7.3.1 "Reservations",
                                           # specifically the programming note in the bottom right corner of page 662
 
+    portRESTORE_FPU_CONTEXT
+
     e_lmvsrrw     0x0c (r1)               # Restore SRR[0-1]
     e_lmvsprw     0x14 (r1)               # Restore CR, LR, CTR, XER
     e_lmvgprw     0x24 (r1)               # Restore GPRs, r[0, 3-12]
     e_lmw         r14, 0x50 (r1)          # Restore GPRs, r[14-31]
 
-    e_add16i      r1, r1, 0x98            # Reclaim stack space
+    e_add16i      r1, r1, 0xA0            # Reclaim stack space
 .endm
 
 # Restores critical nesting count from stack (returns value in r4)
@@ -274,12 +323,27 @@
 
             portENABLE_GLOBAL_INTERRUPTS            # Set MSR[EE] (must wait a couple clocks after reading IACKR)
 
+#if defined(configUSE_TRACE_RECORDER) && (configUSE_TRACE_RECORDER == 1)
+                                                    # r30 and r31 are saved in the frame, they survive the calls
+            se_lwz      r31, 0x0(r3)                # Read ISR address from Interrupt Vector Table using pointer
+            e_rlwinm    r30, r3, 30, 32-INTC_IACKR_INTVEC_BITWIDTH, 31
+                                                    # Rotate INTVEC into the lowest bits of the register, mask off non-INTVEC bits
+                                                    # NOTE: On MPC56xx, above instruction assumes INTC_MCR[VTES] = 0
+            se_mr       r3, r30
+            e_bl        vTraceISREnter              # Record the entry of the vector
+            se_mtLR     r31                         # Copy ISR address to LR for next branch
+            se_mr       r3, r30
+            se_blrl                                 # Branch to ISR with return to next instruction
+            se_mr       r3, r30
+            e_bl        vTraceISRExit               # Record the exit of the vector
+#else
             se_lwz      r4, 0x0(r3)                 # Read ISR address from Interrupt Vector Table using pointer
             se_mtLR     r4                          # Copy ISR address to LR for next branch
             e_rlwinm    r3, r3, 30, 32-INTC_IACKR_INTVEC_BITWIDTH, 31
                                                     # Rotate INTVEC into the lowest bits of the register, mask off non-INTVEC bits
                                                     # NOTE: On MPC56xx, above instruction assumes INTC_MCR[VTES] = 0
             se_blrl                                 # Branch to ISR with return to next instruction (epilogue)
+#endif
 
         epilogue:
             mbar                                    # Ensure all memory operations from ISR have completed
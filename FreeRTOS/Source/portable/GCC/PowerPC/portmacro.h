@@ -118,6 +118,41 @@ void vPortTickISR( void );
                                 while (0)
 /* lint -e9036 "Conditional expression should have essentially Boolean type" */
 
+/* Full barrier between the accesses of the cores to shared memory, a store
+   before it is visible to the other cores before any load after it. */
+#define portMEMORY_BARRIER()        __asm__ volatile ("msync" : : : "memory")
+
+#if ( ( configUSE_CORE_AFFINITY == 1 ) || ( configUSE_CORE_CHANNELS == 1 ) )
+    /* Inter-core yield: raises the software settable interrupt of the given
+       core, whose handler takes the tasks handed over to it and wakes the
+       tasks waiting on a core channel. Callable from an interrupt. */
+    void vPortYieldCore( UBaseType_t uxCoreID );
+
+    #define portYIELD_CORE( xCoreID )       vPortYieldCore( xCoreID )
+#endif
+
+#if ( configUSE_CORE_AFFINITY == 1 )
+    /* SEMA42 gate configKERNEL_SEMA42_GATE guarding the lists of tasks handed
+       over between cores. Only taken with interrupts disabled. */
+    void vPortGetMigrationLock( void );
+    void vPortReleaseMigrationLock( void );
+
+    #define portGET_MIGRATION_LOCK()        vPortGetMigrationLock()
+    #define portRELEASE_MIGRATION_LOCK()    vPortReleaseMigrationLock()
+#endif
+
+/* Floating point context. The EFPU2 of the e200z4 cores computes in the GPRs,
+   so its only state besides them is SPEFSCR. It is switched for the tasks
+   that called portTASK_USES_FLOATING_POINT(), the other tasks leave it to
+   the last floating point task of the core. The e200z2 (core 2) has no FPU:
+   vTaskUsesFPU() records the floating point task in its TCB and keeps core 2
+   out of its affinity mask. */
+#define portFPU_CORE_MASK           ( 0x3U )
+
+void vPortTaskUsesFPU( void );
+
+#define portTASK_USES_FLOATING_POINT()  vTaskUsesFPU()
+
 /*-----------------------------------------------------------*/
 
 /* Interrupt control macros - disable interrupts and system call */
@@ -142,6 +177,15 @@ void vPortTickISR( void );
 void vPortTaskEnterCritical(void);
 void vPortTaskExitCritical(void);
 
+#ifdef configASSERT
+    /* Asserts that an interrupt calling the API is masked by the critical
+       sections, that is has a priority of at most
+       configMAX_API_CALL_INTERRUPT_PRIORITY. */
+    void vPortValidateInterruptPriority( void );
+
+    #define portASSERT_IF_INTERRUPT_PRIORITY_INVALID()  vPortValidateInterruptPriority()
+#endif
+
 /*-----------------------------------------------------------*/
 
 #ifndef portFORCE_INLINE
@@ -20,14 +20,22 @@
 #include "device_registers.h"
 #include "FreeRTOSConfig.h"
 #include "interrupt_manager.h"
+#include "porttimestamp.h"
 
 /* PowerPC specific: pit channel to use 0-15 */
 #define configUSE_PIT_CHANNEL (3u)
 #define configUSE_SS0_CHANNEL (SS0_IRQn)
+/* Software settable interrupt used as core 1 tick, raised from the core 0 tick */
+#define configUSE_SS1_CHANNEL (SS1_IRQn)
+/* Software settable interrupts used as inter-core yield, SS2 + n for core n */
+#define configUSE_SS_YIELD_CHANNEL(coreId) ((IRQn_Type)((uint32_t)SS2_IRQn + (coreId)))
 
 /* functions required by port.c */
 extern void prvPortTimerSetup(void *paramF, uint32_t coreId, uint32_t tick_interval);
 extern void prvPortTimerReset(uint32_t coreId);
+extern void prvPortYieldCoreSetup(void *paramF, uint32_t coreId);
+extern void prvPortYieldCoreRaise(uint32_t coreId);
+extern void prvPortYieldCoreClear(uint32_t coreId);
 
 /* Workaround for MPC574xP platforms where PIT is PIT_0 defined in header */
 #if defined(PIT_0)
@@ -48,6 +56,7 @@ void prvPortTimerSetup(void *paramF, uint32_t coreId, uint32_t tick_interval)
 		INT_SYS_InstallHandler(pitIrqId[0U][configUSE_PIT_CHANNEL], (isr_t)paramF, NULL);
 		INT_SYS_DisableIRQ_MC_All(pitIrqId[0U][configUSE_PIT_CHANNEL]);
 		INT_SYS_DisableIRQ_MC_All(configUSE_SS0_CHANNEL);
+		INT_SYS_DisableIRQ_MC_All(configUSE_SS1_CHANNEL);
 
 		INT_SYS_EnableIRQ(pitIrqId[0U][configUSE_PIT_CHANNEL]);
 		INT_SYS_SetPriority(pitIrqId[0U][configUSE_PIT_CHANNEL], 1);
@@ -71,6 +80,11 @@ void prvPortTimerSetup(void *paramF, uint32_t coreId, uint32_t tick_interval)
 #error configUSE_PIT_CHANNEL cannot be 0 or 1, these channels are used as timestamp timer
 #endif
 		break;
+	case 1U:
+		INT_SYS_InstallHandler(configUSE_SS1_CHANNEL, (isr_t)paramF, NULL);
+		INT_SYS_EnableIRQ(configUSE_SS1_CHANNEL);
+		INT_SYS_SetPriority(configUSE_SS1_CHANNEL, 1);
+		break;
 	case 2U:
 		INT_SYS_InstallHandler(configUSE_SS0_CHANNEL, (isr_t)paramF, NULL);
 		INT_SYS_EnableIRQ(configUSE_SS0_CHANNEL);
@@ -88,7 +102,13 @@ void prvPortTimerReset(uint32_t coreId)
 	case 0U:
 		/* clear PIT channel IRQ flag */
 		PIT->TIMER[configUSE_PIT_CHANNEL].TFLG = PIT_TFLG_TIF(1u);
+		/* forward the tick to core 1 and core 2 */
+		INTC->SSCIR[configUSE_SS1_CHANNEL] = INTC_SSCIR_SET_MASK;
 		INTC->SSCIR[configUSE_SS0_CHANNEL] = INTC_SSCIR_SET_MASK;
+		break;
+	case 1U:
+		INTC->SSCIR[configUSE_SS1_CHANNEL] = INTC_SSCIR_CLR_MASK;
+		break;
 	case 2U:
 		/* Clear the interrupt */
 		INTC->SSCIR[configUSE_SS0_CHANNEL] = INTC_SSCIR_CLR_MASK;
@@ -98,38 +118,74 @@ void prvPortTimerReset(uint32_t coreId)
 	}
 }
 
+void prvPortYieldCoreSetup(void *paramF, uint32_t coreId)
+{
+	DEV_ASSERT(coreId < configSMP_CORE_NUMBER);
+	INT_SYS_InstallHandler(configUSE_SS_YIELD_CHANNEL(coreId), (isr_t)paramF, NULL);
+	INT_SYS_EnableIRQ(configUSE_SS_YIELD_CHANNEL(coreId));
+	/* same priority as the tick, so it is masked by the critical sections */
+	INT_SYS_SetPriority(configUSE_SS_YIELD_CHANNEL(coreId), 1);
+}
+
+void prvPortYieldCoreRaise(uint32_t coreId)
+{
+	INTC->SSCIR[configUSE_SS_YIELD_CHANNEL(coreId)] = INTC_SSCIR_SET_MASK;
+}
+
+void prvPortYieldCoreClear(uint32_t coreId)
+{
+	INTC->SSCIR[configUSE_SS_YIELD_CHANNEL(coreId)] = INTC_SSCIR_CLR_MASK;
+}
+
+/* Lifetime timer: channel 1 chained to channel 0, both counting down from
+ * 0xFFFFFFFF at configCPU_CLOCK_HZ, see prvPortTimerSetup(). */
+#define portTIMESTAMP_HIGH_CHANNEL (1u)
+#define portTIMESTAMP_LOW_CHANNEL (0u)
+
+uint64_t ullPortGetTimeStampTicks(void)
+{
+	uint32_t high;
+	uint32_t low;
+	/* The LTMR64H/LTMR64L latch is a single shadow register shared by the
+	 * cores and the nested interrupts: a read of LTMR64H from anywhere else
+	 * between the two loads hands over another low word. The channel values
+	 * are read instead, again until the high word did not change across the
+	 * read of the low one. */
+	do
+	{
+		high = PIT->TIMER[portTIMESTAMP_HIGH_CHANNEL].CVAL;
+		low = PIT->TIMER[portTIMESTAMP_LOW_CHANNEL].CVAL;
+	} while (PIT->TIMER[portTIMESTAMP_HIGH_CHANNEL].CVAL != high);
+	/* counting down from all ones */
+	return ~(((uint64_t)high << 32) | low);
+}
+
+uint64_t ullPortTimeStampTicksToNanoSec(uint64_t ticks)
+{
+	return portTS_CONVERT(ticks, 1000000000u);
+}
+
+uint64_t ullPortTimeStampTicksToMicroSec(uint64_t ticks)
+{
+	return portTS_CONVERT(ticks, 1000000u);
+}
+
 uint32_t vPortGetTimeStampSec(void)
 {
-	uint64_t ret;
-	ret = (((uint64_t)(0xFFFFFFFF - PIT->LTMR64H)) << 32);
-	ret += (0xFFFFFFFF - PIT->LTMR64L);
-	ret /= (configCPU_CLOCK_HZ);
-	return ((uint32_t)ret);
+	return (uint32_t)portTS_CONVERT(ullPortGetTimeStampTicks(), 1u);
 }
 
 uint32_t vPortGetTimeStampMilliSec(void)
 {
-	uint64_t ret;
-	ret = (((uint64_t)(0xFFFFFFFF - PIT->LTMR64H)) << 32);
-	ret += (0xFFFFFFFF - PIT->LTMR64L);
-	ret /= (configCPU_CLOCK_HZ / 1000);
-	return ((uint32_t)ret);
+	return (uint32_t)portTS_CONVERT(ullPortGetTimeStampTicks(), 1000u);
 }
 
 uint64_t vPortGetTimeStampMicroSec(void)
 {
-	uint64_t ret;
-	ret = (((uint64_t)(0xFFFFFFFF - PIT->LTMR64H)) << 32);
-	ret += (0xFFFFFFFF - PIT->LTMR64L);
-	ret /= (configCPU_CLOCK_HZ / 1000000);
-	return ret;
+	return ullPortTimeStampTicksToMicroSec(ullPortGetTimeStampTicks());
 }
 
 uint64_t vPortGetTimeStampNanoSec(void)
 {
-	uint64_t ret;
-	ret = (((uint64_t)(0xFFFFFFFF - PIT->LTMR64H)) << 32);
-	ret += (0xFFFFFFFF - PIT->LTMR64L);
-	ret = ret * (1000000000UL / configCPU_CLOCK_HZ);
-	return ret;
+	return ullPortTimeStampTicksToNanoSec(ullPortGetTimeStampTicks());
 }
@@ -0,0 +1,62 @@
+/* Conversion of the timestamp ticks of porttimer.c, without any access to
+ * the hardware so that the host bench (sample_boot/tool/ts_bench) builds it
+ * as it is. */
+
+#ifndef PORTTIMESTAMP_H
+#define PORTTIMESTAMP_H
+
+#include <stdint.h>
+#include "FreeRTOSConfig.h"
+
+/* Multiply-shift conversion of the ticks to units of 1/N s:
+ * ticks * N / f = ticks * INT + ((ticks * FRAC) >> 96), INT = N / f and FRAC
+ * the 96 bits of 2^96 * (N % f) / f rounded up, from three 32-bit steps of
+ * long division. The rounding error stays below 2^-32 for any 64-bit ticks,
+ * less than 1 / f, so the result is the exact quotient. */
+#define portTS_DIV(x) (((uint64_t)(x) << 32) / (uint64_t)configCPU_CLOCK_HZ)
+#define portTS_MOD(x) (((uint64_t)(x) << 32) % (uint64_t)configCPU_CLOCK_HZ)
+#define portTS_INT(n) ((uint64_t)(n) / (uint64_t)configCPU_CLOCK_HZ)
+#define portTS_REM(n) ((uint64_t)(n) % (uint64_t)configCPU_CLOCK_HZ)
+#define portTS_FRAC_HI(n) ((portTS_DIV(portTS_REM(n)) << 32) | portTS_DIV(portTS_MOD(portTS_REM(n))))
+#define portTS_FRAC_LO(n) (portTS_DIV(portTS_MOD(portTS_MOD(portTS_REM(n)))) + \
+						   ((portTS_MOD(portTS_MOD(portTS_MOD(portTS_REM(n)))) != 0u) ? 1u : 0u))
+
+/* (ticks * (fracHi * 2^32 + fracLo)) >> 96 with 32x32 multiplies only */
+static inline uint64_t prvTimeStampFraction(uint64_t ticks, uint64_t ullFracHi, uint32_t ulFracLo)
+{
+	uint64_t tlo = ticks & 0xFFFFFFFFu;
+	uint64_t thi = ticks >> 32;
+	uint64_t flo = ullFracHi & 0xFFFFFFFFu;
+	uint64_t fhi = ullFracHi >> 32;
+	uint64_t ll = tlo * flo;
+	uint64_t lh = tlo * fhi;
+	uint64_t hl = thi * flo;
+	uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFu) + (hl & 0xFFFFFFFFu);
+	uint64_t high = (thi * fhi) + (lh >> 32) + (hl >> 32) + (mid >> 32);
+	uint64_t low = (mid << 32) | (ll & 0xFFFFFFFFu);
+	/* ticks * fracLo >> 32, added to the low word of ticks * fracHi */
+	uint64_t tail = ((tlo * ulFracLo) >> 32) + (thi * ulFracLo);
+	if ((low + tail) < low)
+	{
+		high++;
+	}
+	return high;
+}
+
+static inline uint64_t prvTimeStampConvert(uint64_t ticks, uint64_t ullInt, uint64_t ullFracHi, uint32_t ulFracLo)
+{
+	uint64_t ret = 0u;
+	if ((ullFracHi != 0u) || (ulFracLo != 0u))
+	{
+		ret = prvTimeStampFraction(ticks, ullFracHi, ulFracLo);
+	}
+	if (ullInt != 0u)
+	{
+		ret += ticks * ullInt;
+	}
+	return ret;
+}
+
+#define portTS_CONVERT(ticks, n) prvTimeStampConvert((ticks), portTS_INT(n), portTS_FRAC_HI(n), (uint32_t)portTS_FRAC_LO(n))
+
+#endif /* PORTTIMESTAMP_H */
@@ -0,0 +1,703 @@
+/*
+ * FreeRTOS Kernel V10.0.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * An implementation of pvPortMalloc() and vPortFree() with the API of heap_4.c
+ * that allocates and frees in constant time, using a two level segregated fit
+ * (TLSF) index of the free blocks.
+ *
+ * The heap is split into one arena per core and a core only allocates from its
+ * own arena, so the cores never wait for each other in pvPortMalloc().  A
+ * block freed on another core than the one that owns it (a task handed over
+ * by vTaskCoreAffinitySet(), a buffer passed through a core channel, ...) is
+ * put on the deferred list of its arena and given back by the owner core the
+ * next time it allocates or frees.  Only that list is shared, under the SEMA42
+ * gate configHEAP_SEMA42_GATE.
+ *
+ * configHEAP_ARENA_SIZES is the initialiser of the array of the arena sizes,
+ * indexed by core.  When it is not defined configTOTAL_HEAP_SIZE is split
+ * evenly.
+ *
+ * See heap_4.c for the single list implementation, and the memory management
+ * pages of http://www.FreeRTOS.org for more information.
+ */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+#if ( configSMP_CORE_NUMBER > 1 )
+	#include "sema42_driver.h"
+
+	#ifndef configHEAP_SEMA42_GATE
+		#error configHEAP_SEMA42_GATE must be defined to the SEMA42 gate guarding the blocks freed across cores.
+	#endif
+
+	#define heapDEFERRED_LOCK()		{ while( SEMA42_DRV_LockGate( 0U, configHEAP_SEMA42_GATE ) != STATUS_SUCCESS ) {} }
+	#define heapDEFERRED_UNLOCK()	{ portMEMORY_BARRIER(); ( void ) SEMA42_DRV_UnlockGate( 0U, configHEAP_SEMA42_GATE ); }
+#else
+	#define heapDEFERRED_LOCK()
+	#define heapDEFERRED_UNLOCK()
+#endif
+
+#ifndef portMEMORY_BARRIER
+	#define portMEMORY_BARRIER()
+#endif
+
+/* All the block sizes are a multiple of the granule, which is also the step
+between the size classes of the small blocks. */
+#define heapGRANULE_LOG2			( 5U )
+#define heapGRANULE					( ( size_t ) 1 << heapGRANULE_LOG2 )
+
+#if( portBYTE_ALIGNMENT > 32 )
+	#error heap_tlsf.c does not support an alignment above its 32 byte granule.
+#endif
+
+/* Each power of two range of sizes (first level) is split into
+heapSL_INDEX_COUNT size classes (second level).  The sizes below
+heapSMALL_BLOCK_SIZE are all in the first level 0. */
+#define heapSL_INDEX_COUNT_LOG2		( 3U )
+#define heapSL_INDEX_COUNT			( 1U << heapSL_INDEX_COUNT_LOG2 )
+#define heapFL_INDEX_SHIFT			( heapSL_INDEX_COUNT_LOG2 + heapGRANULE_LOG2 )
+#define heapSMALL_BLOCK_SIZE		( ( size_t ) 1 << heapFL_INDEX_SHIFT )
+
+/* Arenas up to 1 MB. */
+#define heapFL_INDEX_MAX			( 20U )
+#define heapFL_INDEX_COUNT			( heapFL_INDEX_MAX - heapFL_INDEX_SHIFT + 2U )
+
+/* Set in xBlockSize while the block is free, or while it waits on the
+deferred list of its arena.  The sizes are multiples of the granule so the low
+bits are not used. */
+#define heapBLOCK_FREE_BIT			( ( size_t ) 1 )
+#define heapBLOCK_DEFERRED_BIT		( ( size_t ) 2 )
+#define heapBLOCK_FLAGS				( heapBLOCK_FREE_BIT | heapBLOCK_DEFERRED_BIT )
+#define heapBLOCK_SIZE( pxBlock )	( ( pxBlock )->xBlockSize & ~heapBLOCK_FLAGS )
+#define heapBLOCK_IS_FREE( pxBlock )	( ( ( pxBlock )->xBlockSize & heapBLOCK_FREE_BIT ) != 0 )
+#define heapBLOCK_IS_ALLOCATED( pxBlock )	( ( ( pxBlock )->xBlockSize & heapBLOCK_FLAGS ) == 0 )
+#define heapNEXT_PHYS_BLOCK( pxBlock )	( ( TLSFBlock_t * ) ( ( ( uint8_t * ) ( pxBlock ) ) + heapBLOCK_SIZE( pxBlock ) ) )
+
+/* Block sizes must not get too small. */
+#define heapMINIMUM_BLOCK_SIZE		( xHeapStructSize + heapGRANULE )
+
+/* Index of the most significant bit set, x must not be 0. */
+#define heapFLS( x )				( 31U - ( UBaseType_t ) __builtin_clz( ( unsigned int ) ( x ) ) )
+/* Index of the least significant bit set, x must not be 0. */
+#define heapFFS( x )				( ( UBaseType_t ) __builtin_ctz( ( unsigned int ) ( x ) ) )
+
+/* Allocate the memory for the heap. */
+#if( configAPPLICATION_ALLOCATED_HEAP == 1 )
+	/* The application writer has already defined the array used for the RTOS
+	heap - probably so it can be placed in a special segment or address. */
+	extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+	NOINIT_DATA_SECTION static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+#ifdef configHEAP_ARENA_SIZES
+	static const size_t xArenaSizes[ configSMP_CORE_NUMBER ] = configHEAP_ARENA_SIZES;
+	#define heapARENA_SIZE( uxCoreID )	( xArenaSizes[ uxCoreID ] )
+#else
+	#define heapARENA_SIZE( uxCoreID )	( ( size_t ) configTOTAL_HEAP_SIZE / ( size_t ) configSMP_CORE_NUMBER )
+#endif
+
+/* The header at the start of every block.  The free list links are only valid
+while the block is free, the header is padded to portBYTE_ALIGNMENT anyway. */
+typedef struct A_TLSF_BLOCK
+{
+	struct A_TLSF_BLOCK *pxPrevPhysBlock;	/*<< The block in front of this one in memory, NULL for the first block of an arena. */
+	size_t xBlockSize;						/*<< Size including this header and the heapBLOCK_FLAGS. */
+	struct A_TLSF_BLOCK *pxNextFreeBlock;	/*<< Next block of the same size class, or of the deferred list. */
+	struct A_TLSF_BLOCK *pxPrevFreeBlock;	/*<< Previous block of the same size class. */
+} TLSFBlock_t;
+
+typedef struct A_TLSF_ARENA
+{
+	uint32_t ulFLBitmap;											/*<< Bit n is set when the first level n has a free block. */
+	uint32_t ulSLBitmap[ heapFL_INDEX_COUNT ];						/*<< Bit n is set when the size class n of the first level has a free block. */
+	TLSFBlock_t *pxFreeLists[ heapFL_INDEX_COUNT ][ heapSL_INDEX_COUNT ];
+	uint8_t *pucStart;												/*<< First block of the arena, NULL until the arena is initialised. */
+	TLSFBlock_t * volatile pxDeferredFrees;							/*<< Blocks freed by the other cores, under configHEAP_SEMA42_GATE. */
+	size_t xFreeBytesRemaining;
+	size_t xMinimumEverFreeBytesRemaining;
+	size_t xNumberOfSuccessfulAllocations;
+	size_t xNumberOfSuccessfulFrees;
+} TLSFArena_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Called automatically to setup the arena of a core the first time
+ * pvPortMalloc() is called on it.
+ */
+static void prvHeapInit( UBaseType_t uxCoreID );
+
+/*
+ * Returns the core owning the arena pxBlock is in, configSMP_CORE_NUMBER if it
+ * is not in the heap.
+ */
+static UBaseType_t prvArenaOfBlock( const TLSFBlock_t *pxBlock );
+
+/*
+ * First level and second level index of the list a free block of xBlockSize
+ * bytes is kept in.
+ */
+static void prvMappingInsert( size_t xBlockSize, UBaseType_t *puxFL, UBaseType_t *puxSL );
+
+/*
+ * Removes and returns a free block of at least xBlockSize bytes, NULL if
+ * there is none.
+ */
+static TLSFBlock_t *prvSearchFreeBlock( TLSFArena_t *pxArena, size_t xBlockSize );
+
+static void prvInsertFreeBlock( TLSFArena_t *pxArena, TLSFBlock_t *pxBlock );
+static void prvRemoveFreeBlock( TLSFArena_t *pxArena, TLSFBlock_t *pxBlock );
+
+/*
+ * Gives an allocated block back to the arena of the calling core, merging it
+ * with the free blocks around it.
+ */
+static void prvFreeBlock( TLSFArena_t *pxArena, TLSFBlock_t *pxBlock );
+
+/*
+ * Gives back the blocks freed by the other cores.
+ */
+static void prvFreeDeferredBlocks( TLSFArena_t *pxArena );
+
+/*-----------------------------------------------------------*/
+
+/* The size of the structure placed at the beginning of each allocated memory
+block must by correctly byte aligned. */
+static const size_t xHeapStructSize	= ( sizeof( TLSFBlock_t ) + ( heapGRANULE - 1 ) ) & ~( heapGRANULE - 1 );
+
+/* The arenas are read by the other cores to hand blocks over. */
+SHARED_DATA_SECTION static TLSFArena_t xArenas[ configSMP_CORE_NUMBER ];
+
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+TLSFArena_t *pxArena;
+TLSFBlock_t *pxBlock, *pxRemainder;
+void *pvReturn = NULL;
+const UBaseType_t uxCoreID = ( UBaseType_t ) ucPortGetCoreId();
+
+	pxArena = &( xArenas[ uxCoreID ] );
+
+	vTaskSuspendAll();
+	{
+		/* If this is the first call to malloc on this core then its arena
+		will require initialisation to setup the free blocks. */
+		if( pxArena->pucStart == NULL )
+		{
+			prvHeapInit( uxCoreID );
+		}
+		else
+		{
+			prvFreeDeferredBlocks( pxArena );
+		}
+
+		/* The wanted size is increased so it can contain a TLSFBlock_t
+		structure in addition to the requested amount of bytes, then rounded
+		up to the granule.  Larger requests than the arena would overflow. */
+		if( ( xWantedSize > 0 ) && ( xWantedSize <= heapARENA_SIZE( uxCoreID ) ) )
+		{
+			xWantedSize += xHeapStructSize + ( heapGRANULE - 1 );
+			xWantedSize &= ~( heapGRANULE - 1 );
+
+			pxBlock = prvSearchFreeBlock( pxArena, xWantedSize );
+
+			if( pxBlock != NULL )
+			{
+				/* If the block is larger than required it can be split into
+				two. */
+				if( ( heapBLOCK_SIZE( pxBlock ) - xWantedSize ) >= heapMINIMUM_BLOCK_SIZE )
+				{
+					pxRemainder = ( TLSFBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+					pxRemainder->xBlockSize = heapBLOCK_SIZE( pxBlock ) - xWantedSize;
+					pxRemainder->pxPrevPhysBlock = pxBlock;
+					heapNEXT_PHYS_BLOCK( pxRemainder )->pxPrevPhysBlock = pxRemainder;
+					pxBlock->xBlockSize = xWantedSize;
+					prvInsertFreeBlock( pxArena, pxRemainder );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				pxArena->xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+				if( pxArena->xFreeBytesRemaining < pxArena->xMinimumEverFreeBytesRemaining )
+				{
+					pxArena->xMinimumEverFreeBytesRemaining = pxArena->xFreeBytesRemaining;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				pxArena->xNumberOfSuccessfulAllocations++;
+
+				/* Return the memory space pointed to - jumping over the
+				TLSFBlock_t structure at its start. */
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif
+
+	configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+TLSFBlock_t *pxBlock;
+TLSFArena_t *pxArena;
+UBaseType_t uxOwner;
+
+	if( pv != NULL )
+	{
+		/* The memory being freed will have an TLSFBlock_t structure
+		immediately before it. */
+		pxBlock = ( TLSFBlock_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+		uxOwner = prvArenaOfBlock( pxBlock );
+
+		/* Check the block is actually allocated, neither free nor waiting on
+		a deferred list. */
+		configASSERT( uxOwner < configSMP_CORE_NUMBER );
+		configASSERT( heapBLOCK_IS_ALLOCATED( pxBlock ) );
+
+		if( ( uxOwner < configSMP_CORE_NUMBER ) && heapBLOCK_IS_ALLOCATED( pxBlock ) )
+		{
+			pxArena = &( xArenas[ uxOwner ] );
+			traceFREE( pv, pxBlock->xBlockSize );
+
+			if( uxOwner == ( UBaseType_t ) ucPortGetCoreId() )
+			{
+				vTaskSuspendAll();
+				{
+					prvFreeDeferredBlocks( pxArena );
+					prvFreeBlock( pxArena, pxBlock );
+				}
+				( void ) xTaskResumeAll();
+			}
+			else
+			{
+				/* Only the owner core changes its arena, the block is handed
+				over to it.  The flag is checked again under the gate, the same
+				block may be freed by two cores at once. */
+				taskENTER_CRITICAL();
+				heapDEFERRED_LOCK();
+				{
+					configASSERT( heapBLOCK_IS_ALLOCATED( pxBlock ) );
+
+					if( heapBLOCK_IS_ALLOCATED( pxBlock ) )
+					{
+						pxBlock->xBlockSize |= heapBLOCK_DEFERRED_BIT;
+						pxBlock->pxNextFreeBlock = pxArena->pxDeferredFrees;
+						pxArena->pxDeferredFrees = pxBlock;
+					}
+				}
+				heapDEFERRED_UNLOCK();
+				taskEXIT_CRITICAL();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+size_t xFreeBytes = 0;
+UBaseType_t uxCoreID;
+
+	/* The blocks waiting on a deferred list are counted as allocated. */
+	for( uxCoreID = 0; uxCoreID < configSMP_CORE_NUMBER; uxCoreID++ )
+	{
+		xFreeBytes += xArenas[ uxCoreID ].xFreeBytesRemaining;
+	}
+
+	return xFreeBytes;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+size_t xFreeBytes = 0;
+UBaseType_t uxCoreID;
+
+	/* The sum of the low water marks of the arenas, which were not
+	necessarily reached at the same time. */
+	for( uxCoreID = 0; uxCoreID < configSMP_CORE_NUMBER; uxCoreID++ )
+	{
+		xFreeBytes += xArenas[ uxCoreID ].xMinimumEverFreeBytesRemaining;
+	}
+
+	return xFreeBytes;
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t *pxHeapStats )
+{
+TLSFArena_t * const pxArena = &( xArenas[ ucPortGetCoreId() ] );
+TLSFBlock_t *pxBlock;
+UBaseType_t uxFL, uxSL;
+size_t xBlocks = 0, xMaxSize = 0, xMinSize = 0;
+
+	vTaskSuspendAll();
+	{
+		prvFreeDeferredBlocks( pxArena );
+
+		/* Diagnostics only, all the free blocks are walked. */
+		for( uxFL = 0; uxFL < heapFL_INDEX_COUNT; uxFL++ )
+		{
+			for( uxSL = 0; uxSL < heapSL_INDEX_COUNT; uxSL++ )
+			{
+				for( pxBlock = pxArena->pxFreeLists[ uxFL ][ uxSL ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+				{
+					xBlocks++;
+
+					if( heapBLOCK_SIZE( pxBlock ) > xMaxSize )
+					{
+						xMaxSize = heapBLOCK_SIZE( pxBlock );
+					}
+
+					if( ( xMinSize == 0 ) || ( heapBLOCK_SIZE( pxBlock ) < xMinSize ) )
+					{
+						xMinSize = heapBLOCK_SIZE( pxBlock );
+					}
+				}
+			}
+		}
+
+		pxHeapStats->xAvailableHeapSpaceInBytes = pxArena->xFreeBytesRemaining;
+		pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+		pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+		pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+		pxHeapStats->xMinimumEverFreeBytesRemaining = pxArena->xMinimumEverFreeBytesRemaining;
+		pxHeapStats->xNumberOfSuccessfulAllocations = pxArena->xNumberOfSuccessfulAllocations;
+		pxHeapStats->xNumberOfSuccessfulFrees = pxArena->xNumberOfSuccessfulFrees;
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( UBaseType_t uxCoreID )
+{
+TLSFArena_t * const pxArena = &( xArenas[ uxCoreID ] );
+TLSFBlock_t *pxFirstFreeBlock, *pxEnd;
+size_t uxAddress, uxEndAddress;
+UBaseType_t uxCore;
+
+	/* The arenas follow each other in ucHeap in the order of the cores. */
+	uxAddress = ( size_t ) ucHeap;
+	for( uxCore = 0; uxCore < uxCoreID; uxCore++ )
+	{
+		uxAddress += heapARENA_SIZE( uxCore );
+	}
+	uxEndAddress = uxAddress + heapARENA_SIZE( uxCoreID );
+	configASSERT( uxEndAddress <= ( ( size_t ) ucHeap ) + configTOTAL_HEAP_SIZE );
+	configASSERT( heapARENA_SIZE( uxCoreID ) < ( ( size_t ) 1 << heapFL_INDEX_MAX ) );
+
+	/* Ensure the arena starts on a correctly aligned boundary. */
+	uxAddress += ( heapGRANULE - 1 );
+	uxAddress &= ~( heapGRANULE - 1 );
+
+	/* The end marker is a block that is never free, so a block is never
+	merged past the end of the arena. */
+	uxEndAddress -= xHeapStructSize;
+	uxEndAddress &= ~( heapGRANULE - 1 );
+	configASSERT( uxEndAddress >= uxAddress + heapMINIMUM_BLOCK_SIZE );
+
+	/* To start with there is a single free block that is sized to take up the
+	entire arena, minus the space taken by the end marker. */
+	pxFirstFreeBlock = ( TLSFBlock_t * ) uxAddress;
+	pxFirstFreeBlock->pxPrevPhysBlock = NULL;
+	pxFirstFreeBlock->xBlockSize = uxEndAddress - uxAddress;
+
+	pxEnd = ( TLSFBlock_t * ) uxEndAddress;
+	pxEnd->pxPrevPhysBlock = pxFirstFreeBlock;
+	pxEnd->xBlockSize = 0;
+	pxEnd->pxNextFreeBlock = NULL;
+
+	prvInsertFreeBlock( pxArena, pxFirstFreeBlock );
+
+	pxArena->xFreeBytesRemaining = heapBLOCK_SIZE( pxFirstFreeBlock );
+	pxArena->xMinimumEverFreeBytesRemaining = pxArena->xFreeBytesRemaining;
+	pxArena->pucStart = ( uint8_t * ) uxAddress;
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvArenaOfBlock( const TLSFBlock_t *pxBlock )
+{
+UBaseType_t uxCoreID;
+size_t uxAddress = ( size_t ) ucHeap;
+
+	for( uxCoreID = 0; uxCoreID < configSMP_CORE_NUMBER; uxCoreID++ )
+	{
+		if( ( ( size_t ) pxBlock >= uxAddress ) && ( ( size_t ) pxBlock < uxAddress + heapARENA_SIZE( uxCoreID ) ) )
+		{
+			break;
+		}
+		uxAddress += heapARENA_SIZE( uxCoreID );
+	}
+
+	return uxCoreID;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingInsert( size_t xBlockSize, UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+UBaseType_t uxFLS;
+
+	if( xBlockSize < heapSMALL_BLOCK_SIZE )
+	{
+		/* The small blocks are in classes one granule apart. */
+		*puxFL = 0;
+		*puxSL = ( UBaseType_t ) ( xBlockSize >> heapGRANULE_LOG2 );
+	}
+	else
+	{
+		uxFLS = heapFLS( xBlockSize );
+		*puxSL = ( UBaseType_t ) ( xBlockSize >> ( uxFLS - heapSL_INDEX_COUNT_LOG2 ) ) ^ heapSL_INDEX_COUNT;
+		*puxFL = uxFLS - ( heapFL_INDEX_SHIFT - 1U );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static TLSFBlock_t *prvSearchFreeBlock( TLSFArena_t *pxArena, size_t xBlockSize )
+{
+TLSFBlock_t *pxBlock = NULL;
+UBaseType_t uxFL, uxSL;
+uint32_t ulMap;
+
+	/* Round up to the next size class, so that any block of the class found
+	is large enough. */
+	if( xBlockSize >= heapSMALL_BLOCK_SIZE )
+	{
+		xBlockSize += ( ( size_t ) 1 << ( heapFLS( xBlockSize ) - heapSL_INDEX_COUNT_LOG2 ) ) - 1U;
+	}
+	prvMappingInsert( xBlockSize, &uxFL, &uxSL );
+
+	if( uxFL < heapFL_INDEX_COUNT )
+	{
+		/* A class of the same first level at least as large, else the
+		smallest class of a larger first level. */
+		ulMap = pxArena->ulSLBitmap[ uxFL ] & ( ~( uint32_t ) 0 << uxSL );
+
+		if( ulMap == 0UL )
+		{
+			ulMap = pxArena->ulFLBitmap & ( ~( uint32_t ) 0 << ( uxFL + 1U ) );
+
+			if( ulMap != 0UL )
+			{
+				uxFL = heapFFS( ulMap );
+				ulMap = pxArena->ulSLBitmap[ uxFL ];
+			}
+		}
+
+		if( ulMap != 0UL )
+		{
+			uxSL = heapFFS( ulMap );
+			pxBlock = pxArena->pxFreeLists[ uxFL ][ uxSL ];
+			prvRemoveFreeBlock( pxArena, pxBlock );
+		}
+	}
+
+	return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( TLSFArena_t *pxArena, TLSFBlock_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+
+	prvMappingInsert( heapBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+	pxBlock->xBlockSize |= heapBLOCK_FREE_BIT;
+	pxBlock->pxPrevFreeBlock = NULL;
+	pxBlock->pxNextFreeBlock = pxArena->pxFreeLists[ uxFL ][ uxSL ];
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock;
+	}
+
+	pxArena->pxFreeLists[ uxFL ][ uxSL ] = pxBlock;
+	pxArena->ulFLBitmap |= ( uint32_t ) 1 << uxFL;
+	pxArena->ulSLBitmap[ uxFL ] |= ( uint32_t ) 1 << uxSL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( TLSFArena_t *pxArena, TLSFBlock_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+
+	prvMappingInsert( heapBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock->pxPrevFreeBlock;
+	}
+
+	if( pxBlock->pxPrevFreeBlock != NULL )
+	{
+		pxBlock->pxPrevFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+	}
+	else
+	{
+		pxArena->pxFreeLists[ uxFL ][ uxSL ] = pxBlock->pxNextFreeBlock;
+
+		if( pxBlock->pxNextFreeBlock == NULL )
+		{
+			pxArena->ulSLBitmap[ uxFL ] &= ~( ( uint32_t ) 1 << uxSL );
+
+			if( pxArena->ulSLBitmap[ uxFL ] == 0UL )
+			{
+				pxArena->ulFLBitmap &= ~( ( uint32_t ) 1 << uxFL );
+			}
+		}
+	}
+
+	/* The caller owns the block now, it is no longer marked free. */
+	pxBlock->xBlockSize &= ~heapBLOCK_FREE_BIT;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFreeBlock( TLSFArena_t *pxArena, TLSFBlock_t *pxBlock )
+{
+TLSFBlock_t *pxNeighbour;
+
+	pxArena->xFreeBytesRemaining += pxBlock->xBlockSize;
+	pxArena->xNumberOfSuccessfulFrees++;
+
+	/* Merge with the block in front of it... */
+	pxNeighbour = pxBlock->pxPrevPhysBlock;
+	if( ( pxNeighbour != NULL ) && heapBLOCK_IS_FREE( pxNeighbour ) )
+	{
+		prvRemoveFreeBlock( pxArena, pxNeighbour );
+		pxNeighbour->xBlockSize += pxBlock->xBlockSize;
+		pxBlock = pxNeighbour;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	/* ...and with the block behind it.  The end marker is never free. */
+	pxNeighbour = heapNEXT_PHYS_BLOCK( pxBlock );
+	if( heapBLOCK_IS_FREE( pxNeighbour ) )
+	{
+		prvRemoveFreeBlock( pxArena, pxNeighbour );
+		pxBlock->xBlockSize += pxNeighbour->xBlockSize;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	heapNEXT_PHYS_BLOCK( pxBlock )->pxPrevPhysBlock = pxBlock;
+	prvInsertFreeBlock( pxArena, pxBlock );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFreeDeferredBlocks( TLSFArena_t *pxArena )
+{
+TLSFBlock_t *pxBlock, *pxNext;
+
+	/* Read without the gate first, the list is nearly always empty. */
+	if( pxArena->pxDeferredFrees != NULL )
+	{
+		taskENTER_CRITICAL();
+		heapDEFERRED_LOCK();
+		{
+			pxBlock = pxArena->pxDeferredFrees;
+			pxArena->pxDeferredFrees = NULL;
+		}
+		heapDEFERRED_UNLOCK();
+		taskEXIT_CRITICAL();
+
+		while( pxBlock != NULL )
+		{
+			pxNext = pxBlock->pxNextFreeBlock;
+			pxBlock->xBlockSize &= ~heapBLOCK_DEFERRED_BIT;
+			prvFreeBlock( pxArena, pxBlock );
+			pxBlock = pxNext;
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+}
+/*-----------------------------------------------------------*/
@@ -135,6 +135,12 @@ that uses task notifications. */
 #define sbFLAGS_IS_MESSAGE_BUFFER		( ( uint8_t ) 1 ) /* Set if the stream buffer was created as a message buffer, in which case it holds discrete messages rather than a stream. */
 #define sbFLAGS_IS_STATICALLY_ALLOCATED ( ( uint8_t ) 2 ) /* Set if the stream buffer was created using statically allocated memory. */
 
+/* Orders the accesses made through the spans of the zero copy functions with
+the update of the head or the tail, the other side may run on another core. */
+#ifndef portMEMORY_BARRIER
+	#define portMEMORY_BARRIER()
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* Structure that hold state information on the buffer. */
@@ -202,6 +208,48 @@ static size_t prvReadBytesFromBuffer( StreamBuffer_t *pxStreamBuffer,
 									  size_t xMaxCount,
 									  size_t xBytesAvailable ) PRIVILEGED_FUNCTION;
 
+/*
+ * Describes the xCount bytes of the storage area that start at xIndex in
+ * pxSpans[ 0 ], and in pxSpans[ 1 ] the part that wraps back to the start of
+ * the storage area (zero bytes if they do not wrap).
+ */
+static void prvGetSpans( const StreamBuffer_t * const pxStreamBuffer,
+						 size_t xIndex,
+						 size_t xCount,
+						 StreamBufferSpan_t * const pxSpans ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns the head or tail index xIndex moved on by xCount bytes.
+ */
+static size_t prvAdvanceIndex( const StreamBuffer_t * const pxStreamBuffer, size_t xIndex, size_t xCount ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns the length of the message at the tail of a message buffer without
+ * moving the tail.
+ */
+static size_t prvPeekMessageLength( const StreamBuffer_t * const pxStreamBuffer ) PRIVILEGED_FUNCTION;
+
+/*
+ * Block for up to xTicksToWait ticks until xRequiredSpace bytes are free, or
+ * until more than xBytesToStoreMessageLength bytes are available.  Return the
+ * free space and the available bytes respectively.
+ */
+static size_t prvWaitForSpace( StreamBuffer_t * const pxStreamBuffer, size_t xRequiredSpace, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+static size_t prvWaitForData( StreamBuffer_t * const pxStreamBuffer, size_t xBytesToStoreMessageLength, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/*
+ * The non blocking parts of xStreamBufferReserve(), xStreamBufferCommit(),
+ * xStreamBufferPeekContiguous() and xStreamBufferConsume(), shared with their
+ * FromISR versions.
+ */
+static size_t prvReserveSpans( const StreamBuffer_t * const pxStreamBuffer,
+							   size_t xDataLengthBytes,
+							   size_t xSpace,
+							   StreamBufferSpan_t * const pxSpans ) PRIVILEGED_FUNCTION;
+static size_t prvCommitBytes( StreamBuffer_t * const pxStreamBuffer, size_t xDataLengthBytes ) PRIVILEGED_FUNCTION;
+static size_t prvPeekSpans( const StreamBuffer_t * const pxStreamBuffer, StreamBufferSpan_t * const pxSpans ) PRIVILEGED_FUNCTION;
+static size_t prvConsumeBytes( StreamBuffer_t * const pxStreamBuffer, size_t xDataLengthBytes ) PRIVILEGED_FUNCTION;
+
 /*
  * Called by both pxStreamBufferCreate() and pxStreamBufferCreateStatic() to
  * initialise the members of the newly created stream buffer structure.
@@ -1085,6 +1133,506 @@ UBaseType_t uxSavedInterruptStatus;
 }
 /*-----------------------------------------------------------*/
 
+size_t xStreamBufferReserve( StreamBufferHandle_t xStreamBuffer,
+							 size_t xDataLengthBytes,
+							 StreamBufferSpan_t * const pxSpans,
+							 TickType_t xTicksToWait )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+size_t xSpace;
+size_t xRequiredSpace = xDataLengthBytes;
+
+	configASSERT( pxSpans );
+	configASSERT( pxStreamBuffer );
+
+	/* As in xStreamBufferSend(), a message also needs the bytes that hold its
+	length. */
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xRequiredSpace += sbBYTES_TO_STORE_MESSAGE_LENGTH;
+
+		/* Overflow? */
+		configASSERT( xRequiredSpace > xDataLengthBytes );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	xSpace = prvWaitForSpace( pxStreamBuffer, xRequiredSpace, xTicksToWait );
+
+	return prvReserveSpans( pxStreamBuffer, xDataLengthBytes, xSpace, pxSpans );
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferReserveFromISR( StreamBufferHandle_t xStreamBuffer,
+									size_t xDataLengthBytes,
+									StreamBufferSpan_t * const pxSpans )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+
+	configASSERT( pxSpans );
+	configASSERT( pxStreamBuffer );
+
+	return prvReserveSpans( pxStreamBuffer, xDataLengthBytes, xStreamBufferSpacesAvailable( pxStreamBuffer ), pxSpans );
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferCommit( StreamBufferHandle_t xStreamBuffer, size_t xDataLengthBytes )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+size_t xReturn;
+
+	configASSERT( pxStreamBuffer );
+
+	xReturn = prvCommitBytes( pxStreamBuffer, xDataLengthBytes );
+
+	if( xReturn > ( size_t ) 0 )
+	{
+		traceSTREAM_BUFFER_SEND( xStreamBuffer, xReturn );
+
+		/* Was a task waiting for the data? */
+		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+		{
+			sbSEND_COMPLETED( pxStreamBuffer );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		/* Nothing committed, the reservation is dropped. */
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferCommitFromISR( StreamBufferHandle_t xStreamBuffer,
+								   size_t xDataLengthBytes,
+								   BaseType_t * const pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+size_t xReturn;
+
+	configASSERT( pxStreamBuffer );
+
+	xReturn = prvCommitBytes( pxStreamBuffer, xDataLengthBytes );
+
+	if( xReturn > ( size_t ) 0 )
+	{
+		/* Was a task waiting for the data? */
+		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+		{
+			sbSEND_COMPLETE_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	traceSTREAM_BUFFER_SEND_FROM_ISR( xStreamBuffer, xReturn );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferPeekContiguous( StreamBufferHandle_t xStreamBuffer,
+									StreamBufferSpan_t * const pxSpans,
+									TickType_t xTicksToWait )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+size_t xReturn, xBytesToStoreMessageLength;
+
+	configASSERT( pxSpans );
+	configASSERT( pxStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xBytesToStoreMessageLength = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xBytesToStoreMessageLength = 0;
+	}
+
+	( void ) prvWaitForData( pxStreamBuffer, xBytesToStoreMessageLength, xTicksToWait );
+
+	xReturn = prvPeekSpans( pxStreamBuffer, pxSpans );
+
+	if( xReturn == ( size_t ) 0 )
+	{
+		traceSTREAM_BUFFER_RECEIVE_FAILED( xStreamBuffer );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferPeekContiguousFromISR( StreamBufferHandle_t xStreamBuffer,
+										   StreamBufferSpan_t * const pxSpans )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+
+	configASSERT( pxSpans );
+	configASSERT( pxStreamBuffer );
+
+	return prvPeekSpans( pxStreamBuffer, pxSpans );
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferConsume( StreamBufferHandle_t xStreamBuffer, size_t xDataLengthBytes )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+size_t xReturn;
+
+	configASSERT( pxStreamBuffer );
+
+	xReturn = prvConsumeBytes( pxStreamBuffer, xDataLengthBytes );
+
+	/* Was a task waiting for space in the buffer? */
+	if( xReturn != ( size_t ) 0 )
+	{
+		traceSTREAM_BUFFER_RECEIVE( xStreamBuffer, xReturn );
+		sbRECEIVE_COMPLETED( pxStreamBuffer );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferConsumeFromISR( StreamBufferHandle_t xStreamBuffer,
+									size_t xDataLengthBytes,
+									BaseType_t * const pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+size_t xReturn;
+
+	configASSERT( pxStreamBuffer );
+
+	xReturn = prvConsumeBytes( pxStreamBuffer, xDataLengthBytes );
+
+	/* Was a task waiting for space in the buffer? */
+	if( xReturn != ( size_t ) 0 )
+	{
+		sbRECEIVE_COMPLETED_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	traceSTREAM_BUFFER_RECEIVE_FROM_ISR( xStreamBuffer, xReturn );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvWaitForSpace( StreamBuffer_t * const pxStreamBuffer, size_t xRequiredSpace, TickType_t xTicksToWait )
+{
+TimeOut_t xTimeOut;
+
+	/* Same wait as in xStreamBufferSend(). */
+	if( xTicksToWait != ( TickType_t ) 0 )
+	{
+		vTaskSetTimeOutState( &xTimeOut );
+
+		do
+		{
+			taskENTER_CRITICAL();
+			{
+				if( xStreamBufferSpacesAvailable( pxStreamBuffer ) < xRequiredSpace )
+				{
+					/* Clear notification state as going to wait for space. */
+					( void ) xTaskNotifyStateClear( NULL );
+
+					/* Should only be one writer. */
+					configASSERT( pxStreamBuffer->xTaskWaitingToSend == NULL );
+					pxStreamBuffer->xTaskWaitingToSend = xTaskGetCurrentTaskHandle();
+				}
+				else
+				{
+					taskEXIT_CRITICAL();
+					break;
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			traceBLOCKING_ON_STREAM_BUFFER_SEND( pxStreamBuffer );
+			( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+			pxStreamBuffer->xTaskWaitingToSend = NULL;
+
+		} while( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xStreamBufferSpacesAvailable( pxStreamBuffer );
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvWaitForData( StreamBuffer_t * const pxStreamBuffer, size_t xBytesToStoreMessageLength, TickType_t xTicksToWait )
+{
+size_t xBytesAvailable;
+
+	/* Same wait as in xStreamBufferReceive(). */
+	if( xTicksToWait != ( TickType_t ) 0 )
+	{
+		/* Checking if there is data and clearing the notification state must be
+		performed atomically. */
+		taskENTER_CRITICAL();
+		{
+			xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+			if( xBytesAvailable <= xBytesToStoreMessageLength )
+			{
+				/* Clear notification state as going to wait for data. */
+				( void ) xTaskNotifyStateClear( NULL );
+
+				/* Should only be one reader. */
+				configASSERT( pxStreamBuffer->xTaskWaitingToReceive == NULL );
+				pxStreamBuffer->xTaskWaitingToReceive = xTaskGetCurrentTaskHandle();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( xBytesAvailable <= xBytesToStoreMessageLength )
+		{
+			/* Wait for data to be available. */
+			traceBLOCKING_ON_STREAM_BUFFER_RECEIVE( pxStreamBuffer );
+			( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+			pxStreamBuffer->xTaskWaitingToReceive = NULL;
+
+			/* Recheck the data available after blocking. */
+			xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+	}
+
+	return xBytesAvailable;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvReserveSpans( const StreamBuffer_t * const pxStreamBuffer,
+							   size_t xDataLengthBytes,
+							   size_t xSpace,
+							   StreamBufferSpan_t * const pxSpans )
+{
+size_t xOffset = 0;
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) == ( uint8_t ) 0 )
+	{
+		/* A stream takes as many bytes as there is space for. */
+		xDataLengthBytes = configMIN( xDataLengthBytes, xSpace );
+	}
+	else if( ( xDataLengthBytes > ( size_t ) 0 ) && ( xSpace >= ( xDataLengthBytes + sbBYTES_TO_STORE_MESSAGE_LENGTH ) ) )
+	{
+		/* A message is reserved whole.  Its length is written in front of it
+		by the commit, the spans start after the bytes that will hold it. */
+		xOffset = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xDataLengthBytes = 0;
+	}
+
+	prvGetSpans( pxStreamBuffer, prvAdvanceIndex( pxStreamBuffer, pxStreamBuffer->xHead, xOffset ), xDataLengthBytes, pxSpans );
+
+	return xDataLengthBytes;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvCommitBytes( StreamBuffer_t * const pxStreamBuffer, size_t xDataLengthBytes )
+{
+size_t xNextHead;
+StreamBufferSpan_t xSpans[ 2 ];
+configMESSAGE_BUFFER_LENGTH_TYPE xTempLength;
+
+	if( xDataLengthBytes > ( size_t ) 0 )
+	{
+		xNextHead = pxStreamBuffer->xHead;
+
+		if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+		{
+			/* Can only commit what a reservation could have handed out. */
+			configASSERT( xStreamBufferSpacesAvailable( pxStreamBuffer ) >= ( xDataLengthBytes + sbBYTES_TO_STORE_MESSAGE_LENGTH ) );
+
+			/* Write the length in front of the message, it can wrap. */
+			xTempLength = ( configMESSAGE_BUFFER_LENGTH_TYPE ) xDataLengthBytes;
+			prvGetSpans( pxStreamBuffer, xNextHead, sbBYTES_TO_STORE_MESSAGE_LENGTH, xSpans );
+			( void ) memcpy( ( void * ) xSpans[ 0 ].pucData, ( const void * ) &xTempLength, xSpans[ 0 ].xLength ); /*lint !e9087 memcpy() requires void *. */
+			( void ) memcpy( ( void * ) xSpans[ 1 ].pucData, ( const void * ) &( ( ( const uint8_t * ) &xTempLength )[ xSpans[ 0 ].xLength ] ), xSpans[ 1 ].xLength ); /*lint !e9087 memcpy() requires void *. */
+			xNextHead = prvAdvanceIndex( pxStreamBuffer, xNextHead, sbBYTES_TO_STORE_MESSAGE_LENGTH );
+		}
+		else
+		{
+			configASSERT( xStreamBufferSpacesAvailable( pxStreamBuffer ) >= xDataLengthBytes );
+		}
+
+		/* The bytes written through the spans are published by a single
+		update of the head. */
+		portMEMORY_BARRIER();
+		pxStreamBuffer->xHead = prvAdvanceIndex( pxStreamBuffer, xNextHead, xDataLengthBytes );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xDataLengthBytes;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvPeekSpans( const StreamBuffer_t * const pxStreamBuffer, StreamBufferSpan_t * const pxSpans )
+{
+size_t xCount, xBytesAvailable, xOffset = 0;
+
+	xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+	/* Pairs with the barrier in prvCommitBytes(), the bytes behind the head
+	just read are not read before it. */
+	portMEMORY_BARRIER();
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) == ( uint8_t ) 0 )
+	{
+		xCount = xBytesAvailable;
+	}
+	else if( xBytesAvailable > sbBYTES_TO_STORE_MESSAGE_LENGTH )
+	{
+		/* Only the message at the tail is handed out, without its length. */
+		xCount = prvPeekMessageLength( pxStreamBuffer );
+		configASSERT( xCount <= ( xBytesAvailable - sbBYTES_TO_STORE_MESSAGE_LENGTH ) );
+		xOffset = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xCount = 0;
+	}
+
+	prvGetSpans( pxStreamBuffer, prvAdvanceIndex( pxStreamBuffer, pxStreamBuffer->xTail, xOffset ), xCount, pxSpans );
+
+	return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvConsumeBytes( StreamBuffer_t * const pxStreamBuffer, size_t xDataLengthBytes )
+{
+size_t xCount, xBytesAvailable;
+
+	xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) == ( uint8_t ) 0 )
+	{
+		xDataLengthBytes = configMIN( xDataLengthBytes, xBytesAvailable );
+		xCount = xDataLengthBytes;
+	}
+	else if( xBytesAvailable > sbBYTES_TO_STORE_MESSAGE_LENGTH )
+	{
+		/* A message is removed whole, together with its length. */
+		configASSERT( xDataLengthBytes == prvPeekMessageLength( pxStreamBuffer ) );
+		xDataLengthBytes = prvPeekMessageLength( pxStreamBuffer );
+		xCount = xDataLengthBytes + sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xDataLengthBytes = 0;
+		xCount = 0;
+	}
+
+	if( xCount > ( size_t ) 0 )
+	{
+		/* The bytes read through the spans are done with before the tail hands
+		them back to the writer. */
+		portMEMORY_BARRIER();
+		pxStreamBuffer->xTail = prvAdvanceIndex( pxStreamBuffer, pxStreamBuffer->xTail, xCount );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xDataLengthBytes;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvPeekMessageLength( const StreamBuffer_t * const pxStreamBuffer )
+{
+StreamBufferSpan_t xSpans[ 2 ];
+configMESSAGE_BUFFER_LENGTH_TYPE xTempLength;
+
+	prvGetSpans( pxStreamBuffer, pxStreamBuffer->xTail, sbBYTES_TO_STORE_MESSAGE_LENGTH, xSpans );
+	( void ) memcpy( ( void * ) &xTempLength, ( const void * ) xSpans[ 0 ].pucData, xSpans[ 0 ].xLength ); /*lint !e9087 memcpy() requires void *. */
+	( void ) memcpy( ( void * ) &( ( ( uint8_t * ) &xTempLength )[ xSpans[ 0 ].xLength ] ), ( const void * ) xSpans[ 1 ].pucData, xSpans[ 1 ].xLength ); /*lint !e9087 memcpy() requires void *. */
+
+	return ( size_t ) xTempLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvGetSpans( const StreamBuffer_t * const pxStreamBuffer,
+						 size_t xIndex,
+						 size_t xCount,
+						 StreamBufferSpan_t * const pxSpans )
+{
+size_t xFirstLength;
+
+	configASSERT( xIndex < pxStreamBuffer->xLength );
+	configASSERT( xCount < pxStreamBuffer->xLength );
+
+	xFirstLength = configMIN( pxStreamBuffer->xLength - xIndex, xCount );
+
+	pxSpans[ 0 ].pucData = &( pxStreamBuffer->pucBuffer[ xIndex ] );
+	pxSpans[ 0 ].xLength = xFirstLength;
+	pxSpans[ 1 ].pucData = pxStreamBuffer->pucBuffer;
+	pxSpans[ 1 ].xLength = xCount - xFirstLength;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvAdvanceIndex( const StreamBuffer_t * const pxStreamBuffer, size_t xIndex, size_t xCount )
+{
+	xIndex += xCount;
+
+	if( xIndex >= pxStreamBuffer->xLength )
+	{
+		xIndex -= pxStreamBuffer->xLength;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xIndex;
+}
+/*-----------------------------------------------------------*/
+
 static size_t prvWriteBytesToBuffer( StreamBuffer_t * const pxStreamBuffer, const uint8_t *pucData, size_t xCount )
 {
 size_t xNextHead, xFirstLength;
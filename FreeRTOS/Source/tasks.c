@@ -230,6 +230,23 @@ count overflows. */
  */
 #define prvGetTCBFromHandle( pxHandle ) ( ( ( pxHandle ) == NULL ) ? pxCurrentTCB : ( pxHandle ) )
 
+#if ( configUSE_CORE_AFFINITY == 1 )
+
+	#define taskALL_CORES_MASK		( ( ( UBaseType_t ) 1UL << configSMP_CORE_NUMBER ) - ( UBaseType_t ) 1UL )
+	#define taskCURRENT_CORE_MASK	( ( UBaseType_t ) 1UL << ucPortGetCoreId() )
+
+	/* Returned by prvSelectMigrationCore() when no core can take the task. */
+	#define taskNO_MIGRATION_CORE	( ( UBaseType_t ) configSMP_CORE_NUMBER )
+
+	/* A mutex lives on the core of its holder, so a task holding one stays. */
+	#if ( configUSE_MUTEXES == 1 )
+		#define taskCAN_MIGRATE( pxTCB ) ( ( pxTCB )->uxMutexesHeld == ( UBaseType_t ) 0U )
+	#else
+		#define taskCAN_MIGRATE( pxTCB ) ( pdTRUE )
+	#endif
+
+#endif /* configUSE_CORE_AFFINITY */
+
 /* The item value of the event list item is normally used to hold the priority
 of the task to which it belongs (coded to allow it to be held in reverse
 priority order).  However, it is occasionally borrowed for other purposes.  It
@@ -281,6 +298,14 @@ typedef struct tskTaskControlBlock 			/* The old naming convention is used to pr
 		UBaseType_t		uxMutexesHeld;
 	#endif
 
+	#if ( configUSE_CORE_AFFINITY == 1 )
+		UBaseType_t		uxCoreAffinityMask;	/*< The cores the task may run on, bit n stands for core n. */
+	#endif
+
+	#ifdef portFPU_CORE_MASK
+		uint8_t			ucUsesFPU;			/*< Set by vTaskUsesFPU(), the task may only run on the cores of portFPU_CORE_MASK. */
+	#endif
+
 	#if ( configUSE_APPLICATION_TASK_TAG == 1 )
 		TaskHookFunction_t pxTaskTag;
 	#endif
@@ -364,6 +389,16 @@ PRIVILEGED_DATA static List_t * volatile pxOverflowDelayedTaskList_SMP[configSMP
 PRIVILEGED_DATA static List_t xPendingReadyList_SMP[configSMP_CORE_NUMBER];						/*< Tasks that have been readied while the scheduler was suspended.  They will be moved to the ready list when the scheduler is resumed. */
 #define xPendingReadyList xPendingReadyList_SMP[ucPortGetCoreId()]
 
+#if ( configUSE_CORE_AFFINITY == 1 )
+
+	/* Tasks handed over by another core.  Unlike the lists above it is written
+	by the other cores, so it is only accessed with portGET_MIGRATION_LOCK()
+	held. */
+	PRIVILEGED_DATA static List_t xMigratedTasksList_SMP[configSMP_CORE_NUMBER];
+	#define xMigratedTasksList xMigratedTasksList_SMP[ucPortGetCoreId()]
+
+#endif
+
 #if( INCLUDE_vTaskDelete == 1 )
 
 	//PRIVILEGED_DATA static List_t xTasksWaitingTermination;				/*< Tasks that have been deleted - but their memory not yet freed. */
@@ -587,6 +622,32 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait, const BaseT
  */
 static void prvResetNextTaskUnblockTime( void );
 
+#if ( configUSE_CORE_AFFINITY == 1 )
+
+	/*
+	 * Returns a core other than the calling one that is in uxCoreAffinityMask
+	 * and runs its scheduler, or taskNO_MIGRATION_CORE.  With xIdleOnly set
+	 * the core must also be running its idle task with no hand over pending.
+	 */
+	static UBaseType_t prvSelectMigrationCore( UBaseType_t uxCoreAffinityMask, BaseType_t xIdleOnly ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Removes a ready task whose context is saved from the ready lists of the
+	 * calling core and hands it over to core uxCoreID.  Must be called with
+	 * interrupts disabled.
+	 */
+	static void prvMigrateTask( TCB_t *pxTCB, UBaseType_t uxCoreID ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Called from the tick every configTASK_MIGRATION_PERIOD ticks.  Hands
+	 * over at most one ready task that waits for the processor to an idle
+	 * core of its affinity mask, or a task whose mask no longer holds the
+	 * calling core to any core of its mask.
+	 */
+	static void prvBalanceReadyTasks( void ) PRIVILEGED_FUNCTION;
+
+#endif
+
 #if ( ( configUSE_TRACE_FACILITY == 1 ) && ( configUSE_STATS_FORMATTING_FUNCTIONS > 0 ) )
 
 	/*
@@ -991,6 +1052,20 @@ UBaseType_t x;
 	}
 	#endif /* configUSE_MUTEXES */
 
+	#if ( configUSE_CORE_AFFINITY == 1 )
+	{
+		/* Bound to the creating core until vTaskCoreAffinitySet() says
+		otherwise. */
+		pxNewTCB->uxCoreAffinityMask = taskCURRENT_CORE_MASK;
+	}
+	#endif /* configUSE_CORE_AFFINITY */
+
+	#ifdef portFPU_CORE_MASK
+	{
+		pxNewTCB->ucUsesFPU = pdFALSE;
+	}
+	#endif /* portFPU_CORE_MASK */
+
 	vListInitialiseItem( &( pxNewTCB->xStateListItem ) );
 	vListInitialiseItem( &( pxNewTCB->xEventListItem ) );
 
@@ -1747,6 +1822,97 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 #endif /* INCLUDE_vTaskPrioritySet */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_CORE_AFFINITY == 1 )
+
+	void vTaskCoreAffinitySet( TaskHandle_t xTask, UBaseType_t uxCoreAffinityMask )
+	{
+	TCB_t *pxTCB;
+
+		uxCoreAffinityMask &= taskALL_CORES_MASK;
+		configASSERT( uxCoreAffinityMask != 0U );
+
+		taskENTER_CRITICAL();
+		{
+			pxTCB = prvGetTCBFromHandle( xTask );
+
+			#ifdef portFPU_CORE_MASK
+			{
+				/* A floating point task never runs on a core without the FPU. */
+				if( pxTCB->ucUsesFPU != ( uint8_t ) pdFALSE )
+				{
+					uxCoreAffinityMask &= portFPU_CORE_MASK;
+					configASSERT( uxCoreAffinityMask != 0U );
+				}
+			}
+			#endif /* portFPU_CORE_MASK */
+
+			pxTCB->uxCoreAffinityMask = uxCoreAffinityMask;
+
+			/* The calling task can only be handed over from a context switch,
+			any other task is handed over by the next balancing tick. */
+			if( ( pxTCB == pxCurrentTCB ) &&
+				( xSchedulerRunning != pdFALSE ) &&
+				( ( uxCoreAffinityMask & taskCURRENT_CORE_MASK ) == 0U ) )
+			{
+				portYIELD_WITHIN_API();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_CORE_AFFINITY */
+/*-----------------------------------------------------------*/
+
+#ifdef portFPU_CORE_MASK
+
+	void vTaskUsesFPU( void )
+	{
+		/* Only the cores of portFPU_CORE_MASK have a floating point context. */
+		configASSERT( ( ( ( UBaseType_t ) 1UL << ucPortGetCoreId() ) & portFPU_CORE_MASK ) != 0U );
+
+		taskENTER_CRITICAL();
+		{
+			pxCurrentTCB->ucUsesFPU = ( uint8_t ) pdTRUE;
+
+			#if ( configUSE_CORE_AFFINITY == 1 )
+			{
+				/* The calling core stays in the mask, no need to move. */
+				pxCurrentTCB->uxCoreAffinityMask &= portFPU_CORE_MASK;
+			}
+			#endif /* configUSE_CORE_AFFINITY */
+		}
+		taskEXIT_CRITICAL();
+
+		vPortTaskUsesFPU();
+	}
+
+#endif /* portFPU_CORE_MASK */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_CORE_AFFINITY == 1 )
+
+	UBaseType_t vTaskCoreAffinityGet( TaskHandle_t xTask )
+	{
+	TCB_t *pxTCB;
+	UBaseType_t uxReturn;
+
+		taskENTER_CRITICAL();
+		{
+			pxTCB = prvGetTCBFromHandle( xTask );
+			uxReturn = pxTCB->uxCoreAffinityMask;
+		}
+		taskEXIT_CRITICAL();
+
+		return uxReturn;
+	}
+
+#endif /* configUSE_CORE_AFFINITY */
+/*-----------------------------------------------------------*/
+
 #if ( INCLUDE_vTaskSuspend == 1 )
 
 	void vTaskSuspend( TaskHandle_t xTaskToSuspend )
@@ -2106,6 +2272,23 @@ BaseType_t xReturn;
 		xSchedulerRunning = pdTRUE;
 		xTickCount = ( TickType_t ) configINITIAL_TICK_COUNT;
 
+		#if ( configUSE_CORE_AFFINITY == 1 )
+		{
+			/* The secondary cores are ticked from the tick of core 0.  Start
+			from its count so that the time outs of a task stay valid when it
+			moves to another core. */
+			if( ( ucPortGetCoreId() != 0U ) && ( xSchedulerRunning_SMP[ 0 ] != pdFALSE ) )
+			{
+				xNumOfOverflows = xNumOfOverflows_SMP[ 0 ];
+				xTickCount = xTickCount_SMP[ 0 ];
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif /* configUSE_CORE_AFFINITY */
+
 		/* If configGENERATE_RUN_TIME_STATS is defined then the following
 		macro must be defined to configure the timer/counter used to generate
 		the run time counter time base.   NOTE:  If configGENERATE_RUN_TIME_STATS
@@ -2272,6 +2455,21 @@ BaseType_t xAlreadyYielded = pdFALSE;
 					}
 				}
 
+				#if ( configUSE_CORE_AFFINITY == 1 )
+				{
+					/* Tasks handed over by another core while the scheduler
+					was suspended. */
+					if( xTaskReceiveMigratedTasks() != pdFALSE )
+					{
+						xYieldPending = pdTRUE;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				#endif /* configUSE_CORE_AFFINITY */
+
 				if( pxTCB != NULL )
 				{
 					/* A task was unblocked while the scheduler was suspended,
@@ -2625,6 +2823,18 @@ TCB_t *pxTCB;
 #endif /* INCLUDE_xTaskGetIdleTaskHandle */
 /*----------------------------------------------------------*/
 
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+	uint32_t ulTaskGetIdleRunTimeCounter( void )
+	{
+		/* The idle task of the calling core. */
+		configASSERT( ( xIdleTaskHandle != NULL ) );
+		return ( ( TCB_t * ) xIdleTaskHandle )->ulRunTimeCounter;
+	}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
+/*----------------------------------------------------------*/
+
 /* This conditional compilation should use inequality to 0, not equality to 1.
 This is to ensure vTaskStepTick() is available when user defined low power mode
 implementations require configUSE_TICKLESS_IDLE to be set to a value other than
@@ -2831,6 +3041,19 @@ BaseType_t xSwitchRequired = pdFALSE;
 			}
 		}
 
+		#if ( configUSE_CORE_AFFINITY == 1 )
+		{
+			if( ( xConstTickCount % ( TickType_t ) configTASK_MIGRATION_PERIOD ) == ( TickType_t ) 0U )
+			{
+				prvBalanceReadyTasks();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif /* configUSE_CORE_AFFINITY */
+
 		/* Tasks of equal priority to the currently running task will share
 		processing time (time slice) if preemption is on, and the application
 		writer has not explicitly turned time slicing off. */
@@ -3052,6 +3275,35 @@ void vTaskSwitchContext( void )
 		}
 		#endif
 
+		#if ( configUSE_CORE_AFFINITY == 1 )
+		{
+			UBaseType_t uxCoreID;
+
+			/* The context of the running task has been saved by now, so a
+			task that may no longer run on this core can be handed over
+			before the next one is selected. */
+			if( ( ( pxCurrentTCB->uxCoreAffinityMask & taskCURRENT_CORE_MASK ) == 0U ) &&
+				( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ), &( pxCurrentTCB->xStateListItem ) ) != pdFALSE ) &&
+				taskCAN_MIGRATE( pxCurrentTCB ) )
+			{
+				uxCoreID = prvSelectMigrationCore( pxCurrentTCB->uxCoreAffinityMask, pdFALSE );
+
+				if( uxCoreID != taskNO_MIGRATION_CORE )
+				{
+					prvMigrateTask( pxCurrentTCB, uxCoreID );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif /* configUSE_CORE_AFFINITY */
+
 		/* Select a new task to run using either the generic C or port
 		optimised asm code. */
 		taskSELECT_HIGHEST_PRIORITY_TASK(); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
@@ -3075,6 +3327,169 @@ void vTaskSwitchContext( void )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_CORE_AFFINITY == 1 )
+
+	static UBaseType_t prvSelectMigrationCore( UBaseType_t uxCoreAffinityMask, BaseType_t xIdleOnly )
+	{
+	UBaseType_t uxCoreID;
+
+		/* The state of the other cores is read without a lock.  It is only a
+		hint, a core that got busy meanwhile simply runs the task later. */
+		for( uxCoreID = ( UBaseType_t ) 0U; uxCoreID < ( UBaseType_t ) configSMP_CORE_NUMBER; uxCoreID++ )
+		{
+			if( ( uxCoreID != ( UBaseType_t ) ucPortGetCoreId() ) &&
+				( ( uxCoreAffinityMask & ( ( UBaseType_t ) 1UL << uxCoreID ) ) != 0U ) &&
+				( xSchedulerRunning_SMP[ uxCoreID ] != pdFALSE ) )
+			{
+				if( xIdleOnly == pdFALSE )
+				{
+					break;
+				}
+				else if( ( pxCurrentTCB_SMP[ uxCoreID ] == xIdleTaskHandle_SMP[ uxCoreID ] ) &&
+						 ( listLIST_IS_EMPTY( &( xMigratedTasksList_SMP[ uxCoreID ] ) ) != pdFALSE ) )
+				{
+					break;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+
+		return uxCoreID;
+	}
+
+#endif /* configUSE_CORE_AFFINITY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_CORE_AFFINITY == 1 )
+
+	static void prvMigrateTask( TCB_t *pxTCB, UBaseType_t uxCoreID )
+	{
+		if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+		{
+			taskRESET_READY_PRIORITY( pxTCB->uxPriority );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		/* From here on the task belongs to the other core, which counts it
+		once it has taken it from its list. */
+		--uxCurrentNumberOfTasks;
+
+		portGET_MIGRATION_LOCK();
+		{
+			vListInsertEnd( &( xMigratedTasksList_SMP[ uxCoreID ] ), &( pxTCB->xStateListItem ) );
+		}
+		portRELEASE_MIGRATION_LOCK();
+
+		portYIELD_CORE( uxCoreID );
+	}
+
+#endif /* configUSE_CORE_AFFINITY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_CORE_AFFINITY == 1 )
+
+	static void prvBalanceReadyTasks( void )
+	{
+	UBaseType_t uxPriority, uxCoreID = taskNO_MIGRATION_CORE;
+	ListItem_t *pxIterator;
+	ListItem_t const *pxEndMarker;
+	TCB_t *pxTCB = NULL;
+
+		/* Every task in a ready list other than the running one is waiting
+		for the processor, the highest priority one is handed over first.  One
+		task per check, the next check sees the receiving core busy. */
+		for( uxPriority = ( UBaseType_t ) configMAX_PRIORITIES; ( uxPriority > ( UBaseType_t ) 0U ) && ( uxCoreID == taskNO_MIGRATION_CORE ); )
+		{
+			--uxPriority;
+			pxEndMarker = listGET_END_MARKER( &( pxReadyTasksLists[ uxPriority ] ) );
+
+			for( pxIterator = listGET_HEAD_ENTRY( &( pxReadyTasksLists[ uxPriority ] ) ); ( pxIterator != pxEndMarker ) && ( uxCoreID == taskNO_MIGRATION_CORE ); pxIterator = listGET_NEXT( pxIterator ) )
+			{
+				pxTCB = ( TCB_t * ) listGET_LIST_ITEM_OWNER( pxIterator ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+
+				if( ( pxTCB != pxCurrentTCB ) && ( pxTCB->uxCoreAffinityMask != taskCURRENT_CORE_MASK ) && taskCAN_MIGRATE( pxTCB ) )
+				{
+					/* A task that may no longer run here goes to any core of
+					its mask, otherwise only to an idle one. */
+					if( ( pxTCB->uxCoreAffinityMask & taskCURRENT_CORE_MASK ) == 0U )
+					{
+						uxCoreID = prvSelectMigrationCore( pxTCB->uxCoreAffinityMask, pdFALSE );
+					}
+					else
+					{
+						uxCoreID = prvSelectMigrationCore( pxTCB->uxCoreAffinityMask, pdTRUE );
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+
+		if( uxCoreID != taskNO_MIGRATION_CORE )
+		{
+			prvMigrateTask( pxTCB, uxCoreID );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* configUSE_CORE_AFFINITY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_CORE_AFFINITY == 1 )
+
+	BaseType_t xTaskReceiveMigratedTasks( void )
+	{
+	TCB_t *pxTCB;
+	BaseType_t xSwitchRequired = pdFALSE;
+
+		/* While the scheduler is suspended the tasks wait in the list, the
+		list is emptied by xTaskResumeAll(). */
+		if( ( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE ) &&
+			( listLIST_IS_EMPTY( &xMigratedTasksList ) == pdFALSE ) )
+		{
+			portGET_MIGRATION_LOCK();
+			{
+				while( listLIST_IS_EMPTY( &xMigratedTasksList ) == pdFALSE )
+				{
+					pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xMigratedTasksList ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+					( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+					prvAddTaskToReadyList( pxTCB );
+					++uxCurrentNumberOfTasks;
+
+					if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+					{
+						xSwitchRequired = pdTRUE;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+			}
+			portRELEASE_MIGRATION_LOCK();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return xSwitchRequired;
+	}
+
+#endif /* configUSE_CORE_AFFINITY */
+/*-----------------------------------------------------------*/
+
 void vTaskPlaceOnEventList( List_t * const pxEventList, const TickType_t xTicksToWait )
 {
 	configASSERT( pxEventList );
@@ -3614,6 +4029,13 @@ UBaseType_t uxPriority;
 	vListInitialise( &xDelayedTaskList2 );
 	vListInitialise( &xPendingReadyList );
 
+	#if ( configUSE_CORE_AFFINITY == 1 )
+	{
+		/* The other cores only write to it once this core's scheduler runs. */
+		vListInitialise( &xMigratedTasksList );
+	}
+	#endif /* configUSE_CORE_AFFINITY */
+
 	#if ( INCLUDE_vTaskDelete == 1 )
 	{
 		vListInitialise( &xTasksWaitingTermination );
@@ -137,6 +137,8 @@ static qualifier. */
 //PRIVILEGED_DATA static List_t *pxCurrentTimerList;
 //PRIVILEGED_DATA static List_t *pxOverflowTimerList;
 
+#if ( configUSE_TIMER_WHEEL == 0 )
+
 PRIVILEGED_DATA static List_t xActiveTimerList1_SMP[configSMP_CORE_NUMBER];
 PRIVILEGED_DATA static List_t xActiveTimerList2_SMP[configSMP_CORE_NUMBER];
 PRIVILEGED_DATA static List_t *pxCurrentTimerList_SMP[configSMP_CORE_NUMBER];
@@ -147,6 +149,37 @@ PRIVILEGED_DATA static List_t *pxOverflowTimerList_SMP[configSMP_CORE_NUMBER];
 #define pxCurrentTimerList pxCurrentTimerList_SMP[ucPortGetCoreId()]
 #define pxOverflowTimerList pxOverflowTimerList_SMP[ucPortGetCoreId()]
 
+#else
+
+	/* With the timer wheel the active timers are not sorted.  A timer that
+	expires less than tmrWHEEL_SLOTS ticks after the wheel time is in the slot
+	of its expiry tick in level 0.  A timer further away is in the slot of
+	level n that covers its expiry time, and is placed again in a lower level
+	(cascaded) when the wheel time reaches the start of that slot.  Timers
+	beyond tmrWHEEL_RANGE wait in the top level and are cascaded again.  Start,
+	stop and expiry are therefore constant time, whatever the number of active
+	timers. */
+	#define tmrWHEEL_SLOT_BITS		( 5U )
+	#define tmrWHEEL_SLOTS			( 1U << tmrWHEEL_SLOT_BITS )
+	#define tmrWHEEL_SLOT_MASK		( ( TickType_t ) tmrWHEEL_SLOTS - 1U )
+	#define tmrWHEEL_LEVELS			( 4U )
+	#define tmrWHEEL_RANGE			( ( TickType_t ) 1 << ( tmrWHEEL_SLOT_BITS * tmrWHEEL_LEVELS ) )
+	#define tmrWHEEL_LEVEL_SHIFT( uxLevel )	( tmrWHEEL_SLOT_BITS * ( uxLevel ) )
+
+	/* The slots of each level, and a bitmap of the slots that hold a timer. */
+	PRIVILEGED_DATA static List_t xTimerWheel_SMP[configSMP_CORE_NUMBER][tmrWHEEL_LEVELS][tmrWHEEL_SLOTS];
+	PRIVILEGED_DATA static uint32_t ulTimerWheelBitmap_SMP[configSMP_CORE_NUMBER][tmrWHEEL_LEVELS];
+	/* The next tick the wheel has to process. */
+	PRIVILEGED_DATA static TickType_t xTimerWheelTime_SMP[configSMP_CORE_NUMBER];
+	PRIVILEGED_DATA static UBaseType_t uxTimersInWheel_SMP[configSMP_CORE_NUMBER];
+
+	#define xTimerWheel xTimerWheel_SMP[ucPortGetCoreId()]
+	#define ulTimerWheelBitmap ulTimerWheelBitmap_SMP[ucPortGetCoreId()]
+	#define xTimerWheelTime xTimerWheelTime_SMP[ucPortGetCoreId()]
+	#define uxTimersInWheel uxTimersInWheel_SMP[ucPortGetCoreId()]
+
+#endif /* configUSE_TIMER_WHEEL */
+
 /* A queue that is used to send commands to the timer service task. */
 //PRIVILEGED_DATA static QueueHandle_t xTimerQueue = NULL;
 //PRIVILEGED_DATA static TaskHandle_t xTimerTaskHandle = NULL;
@@ -195,17 +228,21 @@ static void prvProcessReceivedCommands( void ) PRIVILEGED_FUNCTION;
  */
 static BaseType_t prvInsertTimerInActiveList( Timer_t * const pxTimer, const TickType_t xNextExpiryTime, const TickType_t xTimeNow, const TickType_t xCommandTime ) PRIVILEGED_FUNCTION;
 
-/*
- * An active timer has reached its expire time.  Reload the timer if it is an
- * auto reload timer, then call its callback.
- */
-static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow ) PRIVILEGED_FUNCTION;
+#if ( configUSE_TIMER_WHEEL == 0 )
 
-/*
- * The tick count has overflowed.  Switch the timer lists after ensuring the
- * current timer list does not still reference some timers.
- */
-static void prvSwitchTimerLists( void ) PRIVILEGED_FUNCTION;
+	/*
+	 * An active timer has reached its expire time.  Reload the timer if it is an
+	 * auto reload timer, then call its callback.
+	 */
+	static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * The tick count has overflowed.  Switch the timer lists after ensuring the
+	 * current timer list does not still reference some timers.
+	 */
+	static void prvSwitchTimerLists( void ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TIMER_WHEEL */
 
 /*
  * Obtain the current tick count, setting *pxTimerListsWereSwitched to pdTRUE
@@ -213,19 +250,57 @@ static void prvSwitchTimerLists( void ) PRIVILEGED_FUNCTION;
  */
 static TickType_t prvSampleTimeNow( BaseType_t * const pxTimerListsWereSwitched ) PRIVILEGED_FUNCTION;
 
-/*
- * If the timer list contains any active timers then return the expire time of
- * the timer that will expire first and set *pxListWasEmpty to false.  If the
- * timer list does not contain any timers then return 0 and set *pxListWasEmpty
- * to pdTRUE.
- */
-static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty ) PRIVILEGED_FUNCTION;
+#if ( configUSE_TIMER_WHEEL == 0 )
+
+	/*
+	 * If the timer list contains any active timers then return the expire time of
+	 * the timer that will expire first and set *pxListWasEmpty to false.  If the
+	 * timer list does not contain any timers then return 0 and set *pxListWasEmpty
+	 * to pdTRUE.
+	 */
+	static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * If a timer has expired, process it.  Otherwise, block the timer service task
+	 * until either a timer does expire or a command is received.
+	 */
+	static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseType_t xListWasEmpty ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TIMER_WHEEL */
 
 /*
- * If a timer has expired, process it.  Otherwise, block the timer service task
- * until either a timer does expire or a command is received.
+ * Removes an active timer from the list or wheel slot it is in.
  */
-static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseType_t xListWasEmpty ) PRIVILEGED_FUNCTION;
+static void prvRemoveTimerFromActiveList( Timer_t * const pxTimer ) PRIVILEGED_FUNCTION;
+
+#if ( configUSE_TIMER_WHEEL == 1 )
+
+	/*
+	 * Places the timer in the slot of the wheel that covers xNextExpiryTime,
+	 * relative to the current wheel time.
+	 */
+	static void prvInsertTimerInWheel( Timer_t * const pxTimer, const TickType_t xNextExpiryTime ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Returns the number of ticks from the wheel time to the next tick at
+	 * which a timer expires or a slot has to be cascaded.  The wheel must not
+	 * be empty.
+	 */
+	static TickType_t prvGetTimerWheelNextEvent( void ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Processes the ticks of the wheel up to xTimeNow: cascades the slots
+	 * reached and calls the callbacks of all the timers of each expired slot.
+	 */
+	static void prvAdvanceTimerWheel( const TickType_t xTimeNow ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Processes the expired timers, then blocks the timer service task until
+	 * the next event of the wheel or until a command is received.
+	 */
+	static void prvProcessTimerWheelOrBlockTask( void ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TIMER_WHEEL */
 
 /*
  * Called after a Timer_t structure has been allocated either statically or
@@ -494,6 +569,8 @@ Timer_t *pxTimer = xTimer;
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TIMER_WHEEL == 0 )
+
 static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow )
 {
 BaseType_t xResult;
@@ -533,12 +610,16 @@ Timer_t * const pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTi
 	/* Call the timer callback. */
 	pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
 }
+
+#endif /* configUSE_TIMER_WHEEL */
 /*-----------------------------------------------------------*/
 
 static portTASK_FUNCTION( prvTimerTask, pvParameters )
 {
-TickType_t xNextExpireTime;
-BaseType_t xListWasEmpty;
+#if ( configUSE_TIMER_WHEEL == 0 )
+	TickType_t xNextExpireTime;
+	BaseType_t xListWasEmpty;
+#endif
 
 	/* Just to avoid compiler warnings. */
 	( void ) pvParameters;
@@ -557,13 +638,23 @@ BaseType_t xListWasEmpty;
 
 	for( ;; )
 	{
-		/* Query the timers list to see if it contains any timers, and if so,
-		obtain the time at which the next timer will expire. */
-		xNextExpireTime = prvGetNextExpireTime( &xListWasEmpty );
+		#if ( configUSE_TIMER_WHEEL == 1 )
+		{
+			/* Process the timers that expired, in batches of one wheel slot,
+			then block until the next event of the wheel or a command. */
+			prvProcessTimerWheelOrBlockTask();
+		}
+		#else
+		{
+			/* Query the timers list to see if it contains any timers, and if so,
+			obtain the time at which the next timer will expire. */
+			xNextExpireTime = prvGetNextExpireTime( &xListWasEmpty );
 
-		/* If a timer has expired, process it.  Otherwise, block this task
-		until either a timer does expire, or a command is received. */
-		prvProcessTimerOrBlockTask( xNextExpireTime, xListWasEmpty );
+			/* If a timer has expired, process it.  Otherwise, block this task
+			until either a timer does expire, or a command is received. */
+			prvProcessTimerOrBlockTask( xNextExpireTime, xListWasEmpty );
+		}
+		#endif /* configUSE_TIMER_WHEEL */
 
 		/* Empty the command queue. */
 		prvProcessReceivedCommands();
@@ -571,6 +662,8 @@ BaseType_t xListWasEmpty;
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TIMER_WHEEL == 0 )
+
 static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseType_t xListWasEmpty )
 {
 TickType_t xTimeNow;
@@ -655,27 +748,41 @@ TickType_t xNextExpireTime;
 
 	return xNextExpireTime;
 }
+
+#endif /* configUSE_TIMER_WHEEL */
 /*-----------------------------------------------------------*/
 
 static TickType_t prvSampleTimeNow( BaseType_t * const pxTimerListsWereSwitched )
 {
 TickType_t xTimeNow;
+#if ( configUSE_TIMER_WHEEL == 0 )
 //PRIVILEGED_DATA static TickType_t xLastTime = ( TickType_t ) 0U; /*lint !e956 Variable is only accessible to one task. */
 PRIVILEGED_DATA static TickType_t xLastTime_SMP[configSMP_CORE_NUMBER] = {( TickType_t ) 0U}; /*lint !e956 Variable is only accessible to one task. */
+#endif
 
 	xTimeNow = xTaskGetTickCount();
 
-	if( xTimeNow < xLastTime_SMP[ucPortGetCoreId()] )
-	{
-		prvSwitchTimerLists();
-		*pxTimerListsWereSwitched = pdTRUE;
-	}
-	else
+	#if ( configUSE_TIMER_WHEEL == 1 )
 	{
+		/* The wheel is indexed by the low bits of the expiry time, the tick
+		count overflow needs no special handling. */
 		*pxTimerListsWereSwitched = pdFALSE;
 	}
+	#else
+	{
+		if( xTimeNow < xLastTime_SMP[ucPortGetCoreId()] )
+		{
+			prvSwitchTimerLists();
+			*pxTimerListsWereSwitched = pdTRUE;
+		}
+		else
+		{
+			*pxTimerListsWereSwitched = pdFALSE;
+		}
 
-	xLastTime_SMP[ucPortGetCoreId()] = xTimeNow;
+		xLastTime_SMP[ucPortGetCoreId()] = xTimeNow;
+	}
+	#endif /* configUSE_TIMER_WHEEL */
 
 	return xTimeNow;
 }
@@ -688,6 +795,32 @@ BaseType_t xProcessTimerNow = pdFALSE;
 	listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xNextExpiryTime );
 	listSET_LIST_ITEM_OWNER( &( pxTimer->xTimerListItem ), pxTimer );
 
+	#if ( configUSE_TIMER_WHEEL == 1 )
+	{
+		/* Same test as below, without the two lists: the expiry time has
+		been reached if the period elapsed since the command time. */
+		if( ( ( TickType_t ) ( xTimeNow - xCommandTime ) ) >= pxTimer->xTimerPeriodInTicks ) /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+		{
+			xProcessTimerNow = pdTRUE;
+		}
+		else
+		{
+			/* The wheel time is not advanced while the wheel is empty.  Not
+			done by prvInsertTimerInWheel() as a cascade empties the wheel for
+			a moment while the wheel time is in use. */
+			if( uxTimersInWheel == ( UBaseType_t ) 0U )
+			{
+				xTimerWheelTime = xTimeNow + ( TickType_t ) 1U;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			prvInsertTimerInWheel( pxTimer, xNextExpiryTime );
+		}
+	}
+	#else
 	if( xNextExpiryTime <= xTimeNow )
 	{
 		/* Has the expiry time elapsed between the command to start/reset a
@@ -717,11 +850,260 @@ BaseType_t xProcessTimerNow = pdFALSE;
 			vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
 		}
 	}
+	#endif /* configUSE_TIMER_WHEEL */
 
 	return xProcessTimerNow;
 }
 /*-----------------------------------------------------------*/
 
+static void prvRemoveTimerFromActiveList( Timer_t * const pxTimer )
+{
+	#if ( configUSE_TIMER_WHEEL == 1 )
+	{
+	const List_t * const pxSlot = ( const List_t * ) listLIST_ITEM_CONTAINER( &( pxTimer->xTimerListItem ) );
+	const UBaseType_t uxIndex = ( UBaseType_t ) ( pxSlot - &( xTimerWheel[ 0 ][ 0 ] ) );
+
+		/* The timer must be in the wheel of this core. */
+		configASSERT( uxIndex < ( tmrWHEEL_LEVELS * tmrWHEEL_SLOTS ) );
+
+		( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+		uxTimersInWheel--;
+
+		if( listLIST_IS_EMPTY( pxSlot ) != pdFALSE )
+		{
+			ulTimerWheelBitmap[ uxIndex / tmrWHEEL_SLOTS ] &= ~( ( uint32_t ) 1 << ( uxIndex % tmrWHEEL_SLOTS ) );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#else
+	{
+		( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+	}
+	#endif /* configUSE_TIMER_WHEEL */
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TIMER_WHEEL == 1 )
+
+static void prvInsertTimerInWheel( Timer_t * const pxTimer, const TickType_t xNextExpiryTime )
+{
+TickType_t xSlotTime = xNextExpiryTime, xDelta;
+UBaseType_t uxLevel = 0U, uxSlot;
+
+	xDelta = xNextExpiryTime - xTimerWheelTime;
+
+	if( xDelta > ( portMAX_DELAY >> 1 ) )
+	{
+		/* Already due, processed with the next tick of the wheel. */
+		xSlotTime = xTimerWheelTime;
+		xDelta = ( TickType_t ) 0U;
+	}
+	else if( xDelta >= tmrWHEEL_RANGE )
+	{
+		/* Beyond the wheel, parked in the last slot of the top level. */
+		xSlotTime = xTimerWheelTime + ( tmrWHEEL_RANGE - ( TickType_t ) 1U );
+		xDelta = tmrWHEEL_RANGE - ( TickType_t ) 1U;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	while( xDelta >= ( ( TickType_t ) 1 << tmrWHEEL_LEVEL_SHIFT( uxLevel + 1U ) ) )
+	{
+		uxLevel++;
+	}
+
+	uxSlot = ( UBaseType_t ) ( ( xSlotTime >> tmrWHEEL_LEVEL_SHIFT( uxLevel ) ) & tmrWHEEL_SLOT_MASK );
+
+	vListInsertEnd( &( xTimerWheel[ uxLevel ][ uxSlot ] ), &( pxTimer->xTimerListItem ) );
+	ulTimerWheelBitmap[ uxLevel ] |= ( uint32_t ) 1 << uxSlot;
+	uxTimersInWheel++;
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvGetTimerWheelNextEvent( void )
+{
+TickType_t xNextEvent = portMAX_DELAY, xLevelEvent, xBoundary;
+UBaseType_t uxLevel, uxIndex;
+uint32_t ulBitmap;
+
+	for( uxLevel = 0U; uxLevel < tmrWHEEL_LEVELS; uxLevel++ )
+	{
+		ulBitmap = ulTimerWheelBitmap[ uxLevel ];
+
+		if( ulBitmap != 0UL )
+		{
+			/* A slot of level n is reached at the first tick, from the wheel
+			time on, whose low n * tmrWHEEL_SLOT_BITS bits are zero. */
+			xBoundary = ( ( TickType_t ) 1 << tmrWHEEL_LEVEL_SHIFT( uxLevel ) ) - ( TickType_t ) 1U;
+			xBoundary = ( xTimerWheelTime + xBoundary ) & ~xBoundary;
+			uxIndex = ( UBaseType_t ) ( ( xBoundary >> tmrWHEEL_LEVEL_SHIFT( uxLevel ) ) & tmrWHEEL_SLOT_MASK );
+
+			/* Rotate the bitmap so that bit 0 is the slot reached first. */
+			ulBitmap = ( ulBitmap >> uxIndex ) | ( ulBitmap << ( ( tmrWHEEL_SLOTS - uxIndex ) % tmrWHEEL_SLOTS ) );
+			xLevelEvent = ( xBoundary - xTimerWheelTime ) + ( ( TickType_t ) __builtin_ctz( ulBitmap ) << tmrWHEEL_LEVEL_SHIFT( uxLevel ) );
+
+			if( xLevelEvent < xNextEvent )
+			{
+				xNextEvent = xLevelEvent;
+			}
+		}
+	}
+
+	return xNextEvent;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAdvanceTimerWheel( const TickType_t xTimeNow )
+{
+TickType_t xNextEvent, xTicksDue, xExpiryTime;
+UBaseType_t uxLevel, uxSlot, uxExpired;
+List_t *pxSlot;
+Timer_t *pxTimer;
+BaseType_t xResult;
+
+	for( ;; )
+	{
+		/* The ticks from the wheel time up to xTimeNow are due. */
+		xTicksDue = ( xTimeNow - xTimerWheelTime ) + ( TickType_t ) 1U;
+
+		if( ( uxTimersInWheel == ( UBaseType_t ) 0U ) || ( xTicksDue > ( portMAX_DELAY >> 1 ) ) )
+		{
+			break;
+		}
+
+		/* The ticks without an event are skipped. */
+		xNextEvent = prvGetTimerWheelNextEvent();
+		if( xNextEvent >= xTicksDue )
+		{
+			xTimerWheelTime = xTimeNow + ( TickType_t ) 1U;
+			break;
+		}
+
+		xTimerWheelTime += xNextEvent;
+
+		/* Cascade the slots of the higher levels reached at this tick, the
+		lower level first. */
+		for( uxLevel = 1U; uxLevel < tmrWHEEL_LEVELS; uxLevel++ )
+		{
+			if( ( xTimerWheelTime & ( ( ( TickType_t ) 1 << tmrWHEEL_LEVEL_SHIFT( uxLevel ) ) - ( TickType_t ) 1U ) ) != ( TickType_t ) 0U )
+			{
+				break;
+			}
+
+			pxSlot = &( xTimerWheel[ uxLevel ][ ( xTimerWheelTime >> tmrWHEEL_LEVEL_SHIFT( uxLevel ) ) & tmrWHEEL_SLOT_MASK ] );
+
+			while( listLIST_IS_EMPTY( pxSlot ) == pdFALSE )
+			{
+				pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxSlot ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+				prvRemoveTimerFromActiveList( pxTimer );
+				prvInsertTimerInWheel( pxTimer, listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) ) );
+			}
+		}
+
+		/* An auto reload timer whose period is a multiple of tmrWHEEL_SLOTS
+		goes back to the end of the slot being processed, only the timers that
+		are in the slot now have expired. */
+		uxSlot = ( UBaseType_t ) ( xTimerWheelTime & tmrWHEEL_SLOT_MASK );
+		xTimerWheelTime++;
+		pxSlot = &( xTimerWheel[ 0 ][ uxSlot ] );
+
+		for( uxExpired = listCURRENT_LIST_LENGTH( pxSlot ); uxExpired > ( UBaseType_t ) 0U; uxExpired-- )
+		{
+			pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxSlot ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+			xExpiryTime = listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) );
+			prvRemoveTimerFromActiveList( pxTimer );
+			traceTIMER_EXPIRED( pxTimer );
+
+			/* As prvProcessExpiredTimer(), relative to the tick processed. */
+			if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+			{
+				if( prvInsertTimerInActiveList( pxTimer, ( xExpiryTime + pxTimer->xTimerPeriodInTicks ), ( xTimerWheelTime - ( TickType_t ) 1U ), xExpiryTime ) != pdFALSE )
+				{
+					xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xExpiryTime, NULL, tmrNO_DELAY );
+					configASSERT( xResult );
+					( void ) xResult;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+			}
+
+			pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvProcessTimerWheelOrBlockTask( void )
+{
+TickType_t xTimeNow, xNextEvent, xTicksDue, xTicksToWait = portMAX_DELAY;
+BaseType_t xWaitIndefinitely = pdTRUE;
+
+	prvAdvanceTimerWheel( xTaskGetTickCount() );
+
+	vTaskSuspendAll();
+	{
+		/* The callbacks may have taken some ticks. */
+		xTimeNow = xTaskGetTickCount();
+
+		if( uxTimersInWheel != ( UBaseType_t ) 0U )
+		{
+			xWaitIndefinitely = pdFALSE;
+			xTicksDue = ( xTimeNow - xTimerWheelTime ) + ( TickType_t ) 1U;
+			xNextEvent = prvGetTimerWheelNextEvent();
+
+			if( ( xTicksDue > ( portMAX_DELAY >> 1 ) ) || ( xNextEvent >= xTicksDue ) )
+			{
+				/* Block until the tick of the next event. */
+				xTicksToWait = ( xTimerWheelTime + xNextEvent ) - xTimeNow;
+			}
+			else
+			{
+				xTicksToWait = ( TickType_t ) 0U;
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		if( xTicksToWait != ( TickType_t ) 0U )
+		{
+			vQueueWaitForMessageRestricted( xTimerQueue, xTicksToWait, xWaitIndefinitely );
+
+			if( xTaskResumeAll() == pdFALSE )
+			{
+				/* Yield to wait for either a command to arrive, or the
+				block time to expire.  If a command arrived between the
+				critical section being exited and this yield then the yield
+				will not cause the task to block. */
+				portYIELD_WITHIN_API();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			( void ) xTaskResumeAll();
+		}
+	}
+}
+
+#endif /* configUSE_TIMER_WHEEL */
+/*-----------------------------------------------------------*/
+
 static void	prvProcessReceivedCommands( void )
 {
 DaemonTaskMessage_t xMessage;
@@ -764,7 +1146,7 @@ TickType_t xTimeNow;
 			if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE ) /*lint !e961. The cast is only redundant when NULL is passed into the macro. */
 			{
 				/* The timer is in a list, remove it. */
-				( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+				prvRemoveTimerFromActiveList( pxTimer );
 			}
 			else
 			{
@@ -870,6 +1252,8 @@ TickType_t xTimeNow;
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TIMER_WHEEL == 0 )
+
 static void prvSwitchTimerLists( void )
 {
 TickType_t xNextExpireTime, xReloadTime;
@@ -927,10 +1311,16 @@ BaseType_t xResult;
 	pxCurrentTimerList = pxOverflowTimerList;
 	pxOverflowTimerList = pxTemp;
 }
+
+#endif /* configUSE_TIMER_WHEEL */
 /*-----------------------------------------------------------*/
 
 static void prvCheckForValidListAndQueue( void )
 {
+#if ( configUSE_TIMER_WHEEL == 1 )
+	UBaseType_t uxLevel, uxSlot;
+#endif
+
 	/* Check that the list from which active timers are referenced, and the
 	queue used to communicate with the timer service, have been
 	initialised. */
@@ -938,10 +1328,26 @@ static void prvCheckForValidListAndQueue( void )
 	{
 		if( xTimerQueue == NULL )
 		{
-			vListInitialise( &xActiveTimerList1 );
-			vListInitialise( &xActiveTimerList2 );
-			pxCurrentTimerList = &xActiveTimerList1;
-			pxOverflowTimerList = &xActiveTimerList2;
+			#if ( configUSE_TIMER_WHEEL == 1 )
+			{
+				for( uxLevel = 0U; uxLevel < tmrWHEEL_LEVELS; uxLevel++ )
+				{
+					for( uxSlot = 0U; uxSlot < tmrWHEEL_SLOTS; uxSlot++ )
+					{
+						vListInitialise( &( xTimerWheel[ uxLevel ][ uxSlot ] ) );
+					}
+					ulTimerWheelBitmap[ uxLevel ] = 0UL;
+				}
+				uxTimersInWheel = ( UBaseType_t ) 0U;
+			}
+			#else
+			{
+				vListInitialise( &xActiveTimerList1 );
+				vListInitialise( &xActiveTimerList2 );
+				pxCurrentTimerList = &xActiveTimerList1;
+				pxOverflowTimerList = &xActiveTimerList2;
+			}
+			#endif /* configUSE_TIMER_WHEEL */
 
 			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
 			{
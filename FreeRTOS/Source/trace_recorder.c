@@ -0,0 +1,251 @@
+/*
+ * FreeRTOS Kernel V10.0.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if ( configUSE_TRACE_RECORDER == 1 )
+
+#define traceRING_INDEX_MASK	( ( uint32_t ) configTRACE_RING_LENGTH - 1U )
+
+/* The ring and the name table of one core. */
+typedef struct xTRACE_RING
+{
+	volatile uint32_t ulHead;		/*< Number of events written, only updated by the core of the ring. */
+	volatile uint32_t ulTail;		/*< Number of events read, only updated by the stream task. */
+	volatile uint32_t ulDropped;	/*< Events lost on a full ring. */
+	volatile uint32_t ulNameCount;	/*< Entries of xNames, only updated by the core of the ring. */
+	TraceName_t xNames[ configTRACE_MAX_NAMES ];
+	TraceEvent_t xEvents[ configTRACE_RING_LENGTH ];
+} TraceRing_t;
+
+/* Read by the stream task of core 0, so in the memory shared by the cores. */
+SHARED_DATA_SECTION static TraceRing_t xTraceRings[ configSMP_CORE_NUMBER ];
+
+SHARED_DATA_SECTION volatile uint32_t ulTraceRecorderEnabled;
+
+SHARED_DATA_SECTION void * volatile pvTraceRecorderStreamTask;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The rings are written from the interrupts above the API ceiling as well,
+ * so MSR[EE] is cleared instead of raising INTC_CPR.  The core ID is read
+ * with EE cleared, a task must not migrate between the read and the write.
+ */
+static portFORCE_INLINE uint32_t prvDisableInterrupts( void )
+{
+uint32_t ulMSR;
+
+	__asm__ volatile
+	(
+		"mfmsr  %0 \n\t"
+		"wrteei  0 \n\t"
+		: "=r" ( ulMSR ) : : "memory"
+	);
+
+	return ulMSR;
+}
+
+static portFORCE_INLINE void prvRestoreInterrupts( uint32_t ulMSR )
+{
+	__asm__ volatile ( "wrtee %0" : : "r" ( ulMSR ) : "memory" );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRecordEvent( uint8_t ucType, uint8_t ucArg, uint16_t usArg, uint32_t ulObject, uint32_t ulData )
+{
+TraceRing_t *pxRing;
+TraceEvent_t *pxEvent;
+uint32_t ulMSR, ulHead;
+
+	ulMSR = prvDisableInterrupts();
+	pxRing = &( xTraceRings[ ucPortGetCoreId() ] );
+	ulHead = pxRing->ulHead;
+
+	if( ( ulHead - pxRing->ulTail ) < ( uint32_t ) configTRACE_RING_LENGTH )
+	{
+		pxEvent = &( pxRing->xEvents[ ulHead & traceRING_INDEX_MASK ] );
+		pxEvent->ulTimeStamp = STM_0->CNT;
+		pxEvent->ucType = ucType;
+		pxEvent->ucArg = ucArg;
+		pxEvent->usArg = usArg;
+		pxEvent->ulObject = ulObject;
+		pxEvent->ulData = ulData;
+
+		/* The event must be complete before the stream task sees the new
+		head. */
+		portMEMORY_BARRIER();
+		pxRing->ulHead = ulHead + 1U;
+	}
+	else
+	{
+		pxRing->ulDropped++;
+	}
+
+	prvRestoreInterrupts( ulMSR );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceSetObjectName( const void *pvObject, const char *pcName )
+{
+TraceRing_t *pxRing;
+TraceName_t *pxName;
+uint32_t ulMSR, ulCount, x;
+
+	ulMSR = prvDisableInterrupts();
+	pxRing = &( xTraceRings[ ucPortGetCoreId() ] );
+	ulCount = pxRing->ulNameCount;
+
+	if( ulCount < ( uint32_t ) configTRACE_MAX_NAMES )
+	{
+		pxName = &( pxRing->xNames[ ulCount ] );
+		pxName->ulObject = ( uint32_t ) pvObject;
+
+		for( x = 0U; x < traceNAME_LENGTH; x++ )
+		{
+			pxName->pcName[ x ] = pcName[ x ];
+
+			if( pcName[ x ] == '\0' )
+			{
+				break;
+			}
+		}
+
+		portMEMORY_BARRIER();
+		pxRing->ulNameCount = ulCount + 1U;
+	}
+
+	prvRestoreInterrupts( ulMSR );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRecorderStart( void )
+{
+	if( ( STM_0->CR & STM_CR_TEN_MASK ) == 0U )
+	{
+		/* No prescaler, the events are timestamped at the STM clock. */
+		STM_0->CR = STM_CR_TEN( 1U );
+	}
+
+	ulTraceRecorderEnabled = 1U;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRecorderStop( void )
+{
+	ulTraceRecorderEnabled = 0U;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRecorderSetStreamTask( void *pvTask )
+{
+	pvTraceRecorderStreamTask = pvTask;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceISREnter( uint32_t ulVector )
+{
+	traceRECORD( traceREC_ISR_ENTER, 0, ulVector, 0, 0 );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceISRExit( uint32_t ulVector )
+{
+	traceRECORD( traceREC_ISR_EXIT, 0, ulVector, 0, 0 );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTraceRecorderRead( uint32_t ulCore, TraceEvent_t *pxEvents, uint32_t ulMaxEvents, uint32_t *pulDropped )
+{
+TraceRing_t *pxRing;
+uint32_t ulTail, ulCount, ulFirst;
+
+	configASSERT( ulCore < ( uint32_t ) configSMP_CORE_NUMBER );
+
+	pxRing = &( xTraceRings[ ulCore ] );
+	ulTail = pxRing->ulTail;
+	ulCount = pxRing->ulHead - ulTail;
+
+	/* The head is read before the events it covers, pairs with the barrier of
+	vTraceRecordEvent() on the recording core. */
+	portMEMORY_BARRIER();
+
+	if( ulCount > ulMaxEvents )
+	{
+		ulCount = ulMaxEvents;
+	}
+
+	/* Up to the end of the ring, then from its start. */
+	ulFirst = ( uint32_t ) configTRACE_RING_LENGTH - ( ulTail & traceRING_INDEX_MASK );
+
+	if( ulFirst > ulCount )
+	{
+		ulFirst = ulCount;
+	}
+
+	( void ) memcpy( ( void * ) pxEvents, ( const void * ) &( pxRing->xEvents[ ulTail & traceRING_INDEX_MASK ] ), ulFirst * sizeof( TraceEvent_t ) );
+	( void ) memcpy( ( void * ) &( pxEvents[ ulFirst ] ), ( const void * ) pxRing->xEvents, ( ulCount - ulFirst ) * sizeof( TraceEvent_t ) );
+
+	/* The events must be copied before their slots are handed back. */
+	portMEMORY_BARRIER();
+	pxRing->ulTail = ulTail + ulCount;
+	*pulDropped = pxRing->ulDropped;
+
+	return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+const TraceName_t *pxTraceRecorderGetNames( uint32_t ulCore, uint32_t *pulCount )
+{
+	configASSERT( ulCore < ( uint32_t ) configSMP_CORE_NUMBER );
+
+	*pulCount = xTraceRings[ ulCore ].ulNameCount;
+	portMEMORY_BARRIER();
+
+	return xTraceRings[ ulCore ].xNames;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTraceRecorderGetTimeStamp( void )
+{
+	return STM_0->CNT;
+}
+
+#endif /* configUSE_TRACE_RECORDER */
@@ -20,7 +20,8 @@ PPCASMF( .extern     vPortISRHandler);
 PPCASMF( .extern     xPortSyscall);
 PPCASMF2( .section    .core_exceptions_table, "ax" );
 
-PPCASMF(.align 4);
+/* IVPR must be 4 KB aligned, this table follows the core 0 one in the same section */
+PPCASMF(.align 12);
 PPCASMF( VTABLE1: );
 PPCASMF( IVOR0_Vector: );
 PPCASMF( e_b   IVOR0_Vector );
@@ -34,6 +34,11 @@ extern void _startcore2(void);
 #else
 #error "Neither core is selected"
 #endif /* defined(CPU0) && defined(CPU1) && defined(CPU2) */
+#if defined(SECONDARY_CORES_SW_START)
+/* Only core 0 boots from reset, the others are started by software through MC_ME. */
+#undef TARGET_CORES
+#define TARGET_CORES (CPU0_ENABLED)
+#endif
 #define RCHW_VAL (MPC57xx_ID | TARGET_CORES)
 #endif
 
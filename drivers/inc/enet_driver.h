@@ -76,6 +76,9 @@
 #define ENET_TX_WATERMARK_SHIFT       (6U)
 #define ENET_TX_WATERMARK_MASK        (0x3FU)
 
+/*! @brief Maximum number of buffers of a frame sent by ENET_DRV_SendMultiBufferFrame */
+#define ENET_TX_MAX_FRAGMENTS         (4U)
+
 /*!
  * @brief Media Independent Interface mode selection
  * Implements : enet_mii_mode_t_Class
@@ -372,6 +375,9 @@ typedef struct
     enet_timer_callback_t timerCallback;   /*!< Timer callback function. */
 #endif /* FEATURE_ENET_HAS_ADJUSTABLE_TIMER */
     uint8_t ringCount;                     /*!< The number of rings used by the driver. */
+#if FEATURE_ENET_HAS_ENHANCED_BD
+    uint32_t txChecksumInsert;             /*!< Checksum insertion bits of the transmit buffer descriptors, from txAccelerConfig. */
+#endif /* FEATURE_ENET_HAS_ENHANCED_BD */
 } enet_state_t;
 
 /*!
@@ -541,6 +547,10 @@ typedef struct {
 typedef struct {
     bool noCRC;    /*!< Do not append CRC. It will be provided by the application. */
     bool noInt;    /*!< Do not generate a transmit interrupt. */
+#if FEATURE_ENET_HAS_ENHANCED_BD
+    bool noIpChecksum;    /*!< Do not insert the IP header checksum, even if enabled in txAccelerConfig. */
+    bool noProtoChecksum; /*!< Do not insert the protocol checksum, even if enabled in txAccelerConfig. */
+#endif /* FEATURE_ENET_HAS_ENHANCED_BD */
 #if FEATURE_ENET_HAS_TBS
     bool useTLT;   /*!< If true, use transmit launch time. */
     uint32_t TLT;  /*!< The value of the transmit launch time. */
@@ -811,6 +821,27 @@ status_t ENET_DRV_SendFrame(uint8_t instance,
                             const enet_buffer_t * buff,
                             enet_tx_options_t * options);
 
+/*!
+ * @brief Sends an Ethernet frame scattered over several buffers
+ *
+ * Each buffer takes one transmit buffer descriptor, in order, the frame is sent
+ * only if all of them are free. The same buffer ownership rules as for
+ * ENET_DRV_SendFrame apply to every buffer.
+ *
+ * @param[in] instance Instance number
+ * @param[in] queue The queue number
+ * @param[in] buffs The buffers making up the frame, header first
+ * @param[in] buffCount The number of buffers, at most ENET_TX_MAX_FRAGMENTS
+ * @param[in] options Transmit options for this frame. Can be NULL, if no special option is required.
+ * @return STATUS_SUCCESS if the frame was successfully enqueued for transmission,
+ * STATUS_ENET_TX_QUEUE_FULL if there are not enough free descriptors in the queue.
+ */
+status_t ENET_DRV_SendMultiBufferFrame(uint8_t instance,
+                                       uint8_t queue,
+                                       const enet_buffer_t * buffs,
+                                       uint8_t buffCount,
+                                       enet_tx_options_t * options);
+
 enet_buffer_descriptor_t *ENET_DRV_GetCurrentTxBuffDesc(uint8_t instance, uint8_t queue);
 
 status_t ENET_DRV_GetTxBuffDescStatus(enet_buffer_descriptor_t *bd);
@@ -1330,6 +1361,9 @@ void ENET_DRV_EnableTxStoreAndForward(uint8_t instance);
 /*!
  * @brief Configures and enables the receive parser.
  *
+ * The rules added since the last ENET_DRV_RxParserDeinit call are kept, so the
+ * table can be written while the parser is off and enabled complete.
+ *
  * @param[in] instance Instance number
  * @param[in] config Receive parser configuration
  */
@@ -548,6 +548,17 @@ void ENET_DRV_Init(uint8_t instance,
     }
     state->callback = config->callback;
     state->ringCount = config->ringCount;
+#if FEATURE_ENET_HAS_ENHANCED_BD
+    state->txChecksumInsert = 0UL;
+    if ((config->txAccelerConfig & ENET_TACC_IPCHK_MASK) != 0U)
+    {
+        state->txChecksumInsert |= ENET_TX_ENH1_IINS_MASK;
+    }
+    if ((config->txAccelerConfig & ENET_TACC_PROCHK_MASK) != 0U)
+    {
+        state->txChecksumInsert |= ENET_TX_ENH1_PINS_MASK;
+    }
+#endif /* FEATURE_ENET_HAS_ENHANCED_BD */
 
     g_enetState[instance] = state;
 
@@ -722,6 +733,35 @@ status_t ENET_DRV_ReadFrame(uint8_t instance,
     return status;
 }
 
+#if FEATURE_ENET_HAS_ENHANCED_BD
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : ENET_SetTxChecksumInsert
+ * Description   : Sets the checksum insertion bits of a transmit buffer descriptor
+ *
+ * The bits enabled in txAccelerConfig are set, unless the options of the frame
+ * turn them off.
+ *
+ *END**************************************************************************/
+static void ENET_SetTxChecksumInsert(enet_buffer_descriptor_t *bd,
+                                     uint32_t insert,
+                                     const enet_tx_options_t * options)
+{
+    if (options != NULL)
+    {
+        if (options->noIpChecksum)
+        {
+            insert &= ~ENET_TX_ENH1_IINS_MASK;
+        }
+        if (options->noProtoChecksum)
+        {
+            insert &= ~ENET_TX_ENH1_PINS_MASK;
+        }
+    }
+    bd->enh1 = (bd->enh1 & ~(ENET_TX_ENH1_IINS_MASK | ENET_TX_ENH1_PINS_MASK)) | insert;
+}
+#endif /* FEATURE_ENET_HAS_ENHANCED_BD */
+
 /*FUNCTION**********************************************************************
  *
  * Function Name : ENET_DRV_SendFrame
@@ -762,6 +802,7 @@ status_t ENET_DRV_SendFrame(uint8_t instance,
         bd->control |= (uint16_t)(ENET_BUFFDESCR_TX_READY_MASK | ENET_BUFFDESCR_TX_LAST_MASK | ENET_BUFFDESCR_TX_TRANSMITCRC_MASK);
 #if FEATURE_ENET_HAS_ENHANCED_BD
         bd->enh1 |= ENET_TX_ENH1_INT_MASK;
+        ENET_SetTxChecksumInsert(bd, g_enetState[instance]->txChecksumInsert, options);
 #endif /* FEATURE_ENET_HAS_ENHANCED_BD */
 
         if (options != NULL)
@@ -801,6 +842,101 @@ status_t ENET_DRV_SendFrame(uint8_t instance,
     return status;
 }
 
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : ENET_DRV_SendMultiBufferFrame
+ * Description   : Sends an Ethernet frame scattered over several buffers
+ *
+ * This function places each buffer in a consecutive transmit buffer descriptor,
+ * marks the last one and hands the descriptors to the MAC starting from the
+ * last, so the MAC never sees a partially built frame.
+ *
+ *END**************************************************************************/
+status_t ENET_DRV_SendMultiBufferFrame(uint8_t instance,
+                                       uint8_t queue,
+                                       const enet_buffer_t * buffs,
+                                       uint8_t buffCount,
+                                       enet_tx_options_t * options)
+{
+    ENET_Type *base;
+    enet_buffer_descriptor_t *bd[ENET_TX_MAX_FRAGMENTS];
+    enet_buffer_descriptor_t *next;
+    uint16_t control;
+    uint8_t i;
+    status_t status = STATUS_SUCCESS;
+
+    DEV_ASSERT(instance <  ENET_INSTANCE_COUNT);
+    DEV_ASSERT(g_enetState[instance] != NULL);
+    DEV_ASSERT(queue < g_enetState[instance]->ringCount);
+    DEV_ASSERT(buffs != NULL);
+    DEV_ASSERT((buffCount > 0U) && (buffCount <= ENET_TX_MAX_FRAGMENTS));
+
+    base = s_enetBases[instance];
+
+    /* All descriptors must be free before any of them is touched. */
+    next = g_enetState[instance]->txBdCurrent[queue];
+    for (i = 0U; i < buffCount; i++)
+    {
+        if ((next->control & ENET_BUFFDESCR_TX_READY_MASK) != 0U)
+        {
+            status = STATUS_ENET_TX_QUEUE_FULL;
+            break;
+        }
+        bd[i] = next;
+        if ((next->control & ENET_BUFFDESCR_TX_WRAP_MASK) != 0U)
+        {
+            next = g_enetState[instance]->txBdBase[queue];
+        }
+        else
+        {
+            next++;
+        }
+    }
+
+    if (status == STATUS_SUCCESS)
+    {
+        for (i = buffCount; i > 0U; i--)
+        {
+            control = (uint16_t)(bd[i - 1U]->control & ENET_BUFFDESCR_TX_WRAP_MASK);
+            control |= (uint16_t)(ENET_BUFFDESCR_TX_READY_MASK | ENET_BUFFDESCR_TX_TRANSMITCRC_MASK);
+            if (i == buffCount)
+            {
+                control |= (uint16_t)ENET_BUFFDESCR_TX_LAST_MASK;
+            }
+            if ((options != NULL) && options->noCRC)
+            {
+                control &= (uint16_t)(~ENET_BUFFDESCR_TX_TRANSMITCRC_MASK);
+            }
+            bd[i - 1U]->length = buffs[i - 1U].length;
+            bd[i - 1U]->buffer = buffs[i - 1U].data;
+#if FEATURE_ENET_HAS_ENHANCED_BD
+            /* Only the last descriptor of the frame raises the interrupt. */
+            bd[i - 1U]->enh1 &= ~ENET_TX_ENH1_INT_MASK;
+            if ((i == buffCount) && ((options == NULL) || !options->noInt))
+            {
+                bd[i - 1U]->enh1 |= ENET_TX_ENH1_INT_MASK;
+            }
+            ENET_SetTxChecksumInsert(bd[i - 1U], g_enetState[instance]->txChecksumInsert, options);
+#if FEATURE_ENET_HAS_TBS
+            if ((i == 1U) && (options != NULL) && options->useTLT)
+            {
+                bd[i - 1U]->enh1 |= ENET_TX_ENH1_UTLT_MASK;
+                bd[i - 1U]->enh2 = options->TLT;
+            }
+#endif /* FEATURE_ENET_HAS_TBS */
+#endif /* FEATURE_ENET_HAS_ENHANCED_BD */
+            bd[i - 1U]->control = control;
+        }
+
+        /* Activate the transmit buffer descriptors. */
+        ENET_ActivateTransmit(base, queue);
+
+        g_enetState[instance]->txBdCurrent[queue] = next;
+    }
+
+    return status;
+}
+
 /*FUNCTION**********************************************************************
  *
  * Function Name : ENET_DRV_GetTransmitStatus
@@ -1950,7 +2086,8 @@ void ENET_DRV_EnableTxStoreAndForward(uint8_t instance)
 /*FUNCTION**********************************************************************
  *
  * Function Name : ENET_DRV_RxParserInit
- * Description   : Configures and enables the receive parser.
+ * Description   : Configures and enables the receive parser, the rules
+ * added since the last ENET_DRV_RxParserDeinit call are kept.
  *
  * Implements    : ENET_DRV_RxParserInit_Activity
  *END**************************************************************************/
@@ -1968,11 +2105,11 @@ void ENET_DRV_RxParserInit(uint8_t instance,
     /* Set maximum frame offset */
     base->MAXFRMOFF = ENET_MAXFRMOFF_MXFRMOFF_MASK;
 
-    /* Configure and enable parser */
+    /* Configure and enable parser, MAXINDEX covers the rules already written */
     reg = base->RXPCTL;
 
     reg &= ~(ENET_RXPCTL_ACPTEERR_MASK | ENET_RXPCTL_ENDERRQ_MASK | ENET_RXPCTL_PRSRSCLR_MASK |
-             ENET_RXPCTL_INVBYTORD_MASK | ENET_RXPCTL_MAXINDEX_MASK);
+             ENET_RXPCTL_INVBYTORD_MASK);
     reg |= ENET_RXPCTL_ACPTEERR(config->acceptEndError ? 1UL : 0UL);
     reg |= ENET_RXPCTL_ENDERRQ(config->endErrorQueue);
     reg |= ENET_RXPCTL_INVBYTORD(config->inverseByteOrder ? 1UL : 0UL);
@@ -10,21 +10,30 @@
 #include "tcpip.h"
 #include "boot_board.h"
 #include "boot_app.h"
+#include "boot_routine.h"
+#include "boot_lease.h"
+#include "boot_trace.h"
+#include "boot_net_bench.h"
+#include "boot_rtos_bench.h"
 #include "flash_drv.h"
 #include "crc32.h"
 #include "rnd.h"
 #include "rc4.h"
 
-#define ROUTINE_ID_ERASE_MEMORY (0xFF00)
-#define ROUTINE_ID_CHECKSUM (0xFF01)
+#if (BOOT_MAX_DATAGRAM_SIZE > ipconfigIP_MAX_DATAGRAM_SIZE)
+#error "BOOT_MAX_DATAGRAM_SIZE must fit in ipconfigIP_MAX_DATAGRAM_SIZE."
+#endif
 
 #define CPYPT_MASK (0x55)
+#define BOOT_RX_BATCH (4) // requests taken per FreeRTOS_recvmmsg()
+#define BOOT_TX_BATCH (8) // upload blocks per FreeRTOS_sendmmsg(), the rest of the pool stays free for RX
 
 static int session_ctrl_svc(boot_service_data_t*state, unsigned char *req, int len);
 static int reset_svc(boot_service_data_t*state, unsigned char *req, int len);
 static int tester_present_svc(boot_service_data_t*state, unsigned char *req, int len);
 static int routine_ctrl_svc(boot_service_data_t*state, unsigned char *req, int len);
 static int download_req_svc(boot_service_data_t*state, unsigned char *req, int len);
+static int upload_req_svc(boot_service_data_t*state, unsigned char *req, int len);
 static int xfer_data_svc(boot_service_data_t*state, unsigned char *req, int len);
 static int exit_xfer_svc(boot_service_data_t*state, unsigned char *req, int len);
 static int sec_access_svc(boot_service_data_t*state, unsigned char *req, int len);
@@ -39,13 +48,16 @@ static const uint32_t svn_rev = SVN_REV;
 static const boot_data_identifier_desc_t boot_data_table[] = 
 {
 	{enc_header, sizeof(enc_header), 0x03},
-	{&svn_rev, sizeof(svn_rev), 0x01}
+	{&svn_rev, sizeof(svn_rev), 0x01},
+	{&flash_drv_stats, sizeof(flash_drv_stats), 0x03} // write to clear
 };
 
 rc4_key rc4_ctx;
 
-boot_erase_flash_routine_t erase_routine_data;
-boot_checksum_routine_t checksum_routine_data;
+// host that unlocked the active session, see boot_app_session_host()
+static uint32_t session_host_addr;
+static uint8_t session_host_valid;
+
 
 const boot_service_handle_t boot_service_table[] =
 {
@@ -53,12 +65,13 @@ const boot_service_handle_t boot_service_table[] =
 	{0x10, 0, 0x03, 2, 2, session_ctrl_svc},
 	{0x11, 0, 0x03, 2, 2, reset_svc},
 	{0x3E, 0, 0x03, 2, 2, tester_present_svc},
-	{0x31, 1, 0x02, 4, 12, routine_ctrl_svc},
+	{0x31, 1, 0x02, 4, 16, routine_ctrl_svc},
 	{0x34, 1, 0x02, 4, 10, download_req_svc},
-	{0x36, 1, 0x02, 3, 1500, xfer_data_svc},
+	{0x35, 1, 0x02, 4, 10, upload_req_svc},
+	{0x36, 1, 0x02, 2, BOOT_MAX_MSG_LEN, xfer_data_svc},
 	{0x37, 1, 0x02, 1, 1, exit_xfer_svc},
 	{0x27, 0, 0x03, 2, 6, sec_access_svc},
-	{0x2E, 1, 0x02, 4, 1500, write_data_by_id_svc},
+	{0x2E, 1, 0x02, 4, BOOT_MAX_MSG_LEN, write_data_by_id_svc},
 	{0x22, 0, 0x03, 3, 3, read_data_by_id_svc},
 };
 
@@ -104,14 +117,49 @@ void build_crypt_msg(uint8_t *src, uint32_t src_len, uint8_t *dest, uint32_t *de
 	*dest_len = src_len + 5;
 }
 
-void decrypt_msg(uint8_t *src, uint32_t src_len, uint8_t *dest, int *dest_len, uint8_t mask)
+// Same framing as build_crypt_msg() for a 0x76 upload block, masked straight from the
+// (read only) memory into the network buffer. Returns the frame length.
+static uint32_t build_upload_msg(uint8_t sn, const uint8_t *data, uint32_t data_len, uint8_t *dest, uint8_t mask)
+{
+	uint32_t i;
+	uint32_t src_len = data_len + 2;
+	uint8_t check;
+
+	dest[0] = 0x7E;
+	dest[1] = (0x76 ^ mask);
+	dest[2] = (uint8_t)(src_len >> 8);
+	dest[3] = (uint8_t)(src_len);
+	dest[4] = (sn ^ mask);
+	check = dest[1] + dest[4];
+	for (i = 0; i < data_len; i++)
+	{
+		dest[5 + i] = (data[i] ^ mask);
+		check += dest[5 + i];
+	}
+	dest[3 + src_len] = check;
+	dest[4 + src_len] = 0x7E;
+	return src_len + 5;
+}
+
+// *dest_len is 0 when the length field runs past the frame or the message does not fit in dest_size bytes.
+void decrypt_msg(uint8_t *src, uint32_t src_len, uint8_t *dest, uint32_t dest_size, int *dest_len, uint8_t mask)
 {
 	uint32_t i;
 	int len = 1;
 	
+	if (src_len < 2)
+	{
+		*dest_len = 0;
+		return;
+	}
 	dest[0] = src[1];
 	if(src_len > 6){
 		len = ((src[2]<<8)&0xFF00) + src[3];
+		if ((len == 0) || ((uint32_t)len + 5 > src_len) || ((uint32_t)len > dest_size))
+		{
+			*dest_len = 0;
+			return;
+		}
 		memcpy(&dest[1], &src[4], len-1);
 	}
 	
@@ -138,6 +186,8 @@ static void boot_service_data_init(boot_service_data_t *data)
 	data->total_xfer_data_cnt = 0;
 	data->encrypt_flag = 0;
 	data->compress_flag = 0;
+	data->upload_state = 0;
+	data->upload_tx_req = 0;
 }
 
 static int write_data_by_id_svc(boot_service_data_t*state, unsigned char *req, int len)
@@ -249,309 +299,357 @@ static int tester_present_svc(boot_service_data_t *state, unsigned char *req, in
 
 static int routine_ctrl_svc(boot_service_data_t *state, unsigned char *req, int len)
 {
+#if defined(BOOT_CHANNEL_BENCH)
+	static const uint8_t routine_arg_num[BOOT_ROUTINE_NUM] = {2, 1, 2, 3, 3, 1};
+	boot_routine_bench_t bench;
+#else
+	static const uint8_t routine_arg_num[BOOT_ROUTINE_NUM] = {2, 1, 2, 3, 3};
+#endif
 	int ret = 0;
 	uint8_t cmd = req[1];
 	uint16_t id = (((uint16_t)req[2] << 8) | (req[3]));
-	uint32_t tmp_u32[4];
-	switch (cmd)
+	uint8_t routine = (uint8_t)(id - BOOT_ROUTINE_ID_BASE);
+	uint8_t nrc = 0;
+	uint8_t result;
+	uint32_t tmp_u32[3] = {0};
+	uint32_t crc;
+	int i;
+
+	if ((id < BOOT_ROUTINE_ID_BASE) || (routine >= BOOT_ROUTINE_NUM))
 	{
-		case 0x01:
-			// start routine
-			switch (id)
-			{
-				case ROUTINE_ID_ERASE_MEMORY:
-					if (len == 12)
-					{
-						tmp_u32[0] = (((uint32_t)req[4] << 24) | ((uint32_t)req[5] << 16) | ((uint32_t)req[6] << 8) | ((uint32_t)req[7]));
-						tmp_u32[1] = (((uint32_t)req[8] << 24) | ((uint32_t)req[9] << 16) | ((uint32_t)req[10] << 8) | ((uint32_t)req[11]));
-						if (check_flash_address_valid(tmp_u32[0], tmp_u32[1]))
+		nrc = 0x31;
+	}
+	else
+	{
+		switch (cmd)
+		{
+			case 0x01:
+				// start routine
+				if (len != 4 + 4 * routine_arg_num[routine])
+				{
+					// incorrect message length
+					nrc = 0x13;
+					break;
+				}
+				for (i = 0; i < routine_arg_num[routine]; i++)
+				{
+					tmp_u32[i] = (((uint32_t)req[4 + 4 * i] << 24) | ((uint32_t)req[5 + 4 * i] << 16) | ((uint32_t)req[6 + 4 * i] << 8) | ((uint32_t)req[7 + 4 * i]));
+				}
+				switch (routine)
+				{
+					case BOOT_ROUTINE_ERASE:
+					case BOOT_ROUTINE_CRC:
+					case BOOT_ROUTINE_VERIFY:
+						if (!check_flash_address_valid(tmp_u32[0], tmp_u32[1]))
 						{
-							if ((erase_routine_data.state != 1) && (erase_routine_data.req == 0))
-							{
-								erase_routine_data.result = 0;
-								erase_routine_data.address = tmp_u32[0];
-								erase_routine_data.size = tmp_u32[1];
-								erase_routine_data.req = 1;
-								req[0] += 0x40;
-								ret = 4;
-							}
-							else
-							{
-								req[1] = req[0];
-								req[0] = 0x7F;
-								req[2] = 0x22;
-								ret = 3;
-							}
+							nrc = 0x31;
 						}
-						else
+						break;
+					case BOOT_ROUTINE_CHECKSUM:
+						if (state->total_xfer_data_cnt == 0)
 						{
-							req[1] = req[0];
-							req[0] = 0x7F;
-							req[2] = 0x31;
-							ret = 3;
+							nrc = 0x22;
 						}
-					}
-					else
-					{
-						// incorrect message length
-						req[1] = req[0];
-						req[0] = 0x7F;
-						req[2] = 0x13;
-						ret = 3;
-					}
-					break;
-				case ROUTINE_ID_CHECKSUM:
-					if (len == 8)
-					{
-						tmp_u32[0] = (((uint32_t)req[4] << 24) | ((uint32_t)req[5] << 16) | ((uint32_t)req[6] << 8) | ((uint32_t)req[7]));
-						if (state->total_xfer_data_cnt != 0)
-						{		
-							if (tmp_u32[0] == state->checksum)
-							{
-								tmp_u32[0] = APP_VALID_PATTERN;
-								tmp_u32[1] = (~APP_VALID_PATTERN);
-								tmp_u32[2] = state->total_xfer_data_cnt;
-								tmp_u32[3] = state->checksum;
-								if (STATUS_SUCCESS == flash_write(APP_VALID_FLAG_ADDR, tmp_u32, 16))
-								{
-									checksum_routine_data.result = 1;
-								}
-								else
-								{
-									// program fail.
-									checksum_routine_data.result = 2;
-								}
-							}
-							else
-							{
-								checksum_routine_data.result = 0;
-							}
-							checksum_routine_data.state = 2;
-							req[0] += 0x40;
-							ret = 4;
+						tmp_u32[1] = state->checksum;
+						tmp_u32[2] = state->total_xfer_data_cnt;
+						break;
+					case BOOT_ROUTINE_COPY:
+						if (!check_flash_address_valid(tmp_u32[0], tmp_u32[2]) || !check_flash_address_valid(tmp_u32[1], tmp_u32[2]))
+						{
+							nrc = 0x31;
 						}
-						else
+						break;
+#if defined(BOOT_CHANNEL_BENCH)
+					case BOOT_ROUTINE_BENCH:
+						if (tmp_u32[0] == 0)
 						{
-							req[1] = req[0];
-							req[0] = 0x7F;
-							req[2] = 0x22;
-							ret = 3;
+							nrc = 0x31;
 						}
-					}
-					else
-					{
-						// incorrect message length
-						req[1] = req[0];
-						req[0] = 0x7F;
-						req[2] = 0x13;
-						ret = 3;
-					}
-					break;
-				default:
-					req[1] = req[0];
-					req[0] = 0x7F;
-					req[2] = 0x31;
-					ret = 3;
-					break;
-			}
-			break;
-		case 0x03:
-			// request routine result
-			if (len == 4)
-			{
-				switch (id)
+						break;
+#endif
+					default:
+						break;
+				}
+				if (nrc == 0)
 				{
-				case ROUTINE_ID_ERASE_MEMORY:
-					if (2 == erase_routine_data.state)
-					{
-						erase_routine_data.state = 0;
-						req[0] += 0x40;
-						req[4] = erase_routine_data.result;
-						ret = 5;
-					}
-					else if ((1 == erase_routine_data.state) || (1 == erase_routine_data.req))
+					if (STATUS_SUCCESS == boot_routine_start(routine, tmp_u32, 3))
 					{
 						req[0] += 0x40;
-						req[4] = 0x00;
-						ret = 5;
+						ret = 4;
 					}
 					else
 					{
-						req[1] = req[0];
-						req[0] = 0x7F;
-						req[2] = 0x24;
-						ret = 3;
+						// busy, queue full or no worker running
+						nrc = 0x22;
 					}
-					break;
-				case ROUTINE_ID_CHECKSUM:
-					if (2 == checksum_routine_data.state)
-					{
-						checksum_routine_data.state = 0;
-						req[0] += 0x40;
-						req[4] = checksum_routine_data.result;
-						ret = 5;
-					}
-					else if (1 == checksum_routine_data.state)
-					{
-						checksum_routine_data.state = 0;
-						req[0] += 0x40;
-						req[4] = 0x00;
-						ret = 5;
-					}
-					else
+				}
+				break;
+			case 0x02:
+				// stop routine
+				if (len == 4)
+				{
+					boot_routine_stop(routine);
+					req[0] += 0x40;
+					ret = 4;
+				}
+				else
+				{
+					nrc = 0x13;
+				}
+				break;
+			case 0x03:
+				// request routine result
+				if (len == 4)
+				{
+					switch (boot_routine_get_result(routine, &result, &crc))
 					{
-						req[1] = req[0];
-						req[0] = 0x7F;
-						req[2] = 0x24;
-						ret = 3;
+						case BOOT_ROUTINE_STATE_COMPLETE:
+							req[0] += 0x40;
+							req[4] = result;
+							ret = 5;
+							if (BOOT_ROUTINE_CRC == routine)
+							{
+								req[5] = (uint8_t)(crc >> 24);
+								req[6] = (uint8_t)(crc >> 16);
+								req[7] = (uint8_t)(crc >> 8);
+								req[8] = (uint8_t)(crc);
+								ret = 9;
+							}
+#if defined(BOOT_CHANNEL_BENCH)
+							if ((BOOT_ROUTINE_BENCH == routine) && (BOOT_ROUTINE_RESULT_OK == result))
+							{
+								// min, avg, max round trip in ns and round trips per second
+								boot_routine_get_bench(&bench);
+								tmp_u32[0] = bench.rtt_min_ns;
+								tmp_u32[1] = bench.rtt_avg_ns;
+								tmp_u32[2] = bench.rtt_max_ns;
+								for (i = 0; i < 3; i++)
+								{
+									req[5 + 4 * i] = (uint8_t)(tmp_u32[i] >> 24);
+									req[6 + 4 * i] = (uint8_t)(tmp_u32[i] >> 16);
+									req[7 + 4 * i] = (uint8_t)(tmp_u32[i] >> 8);
+									req[8 + 4 * i] = (uint8_t)(tmp_u32[i]);
+								}
+								req[17] = (uint8_t)(bench.items_per_s >> 24);
+								req[18] = (uint8_t)(bench.items_per_s >> 16);
+								req[19] = (uint8_t)(bench.items_per_s >> 8);
+								req[20] = (uint8_t)(bench.items_per_s);
+								ret = 21;
+							}
+#endif
+							break;
+						case BOOT_ROUTINE_STATE_PENDING:
+						case BOOT_ROUTINE_STATE_RUNNING:
+							req[0] += 0x40;
+							req[4] = 0x00;
+							ret = 5;
+							break;
+						default:
+							nrc = 0x24;
+							break;
 					}
-					break;
-				default:
-					req[1] = req[0];
-					req[0] = 0x7F;
-					req[2] = 0x31;
-					ret = 3;
-					break;
 				}
-			}
-			else
-			{
-				// incorrect message length
-				req[1] = req[0];
-				req[0] = 0x7F;
-				req[2] = 0x13;
-				ret = 3;
-			}
-			break;
-		case 0x02:
-			//stop routine
-			//break;
-		default:
-			req[1] = req[0];
-			req[0] = 0x7F;
-			req[2] = 0x12;
-			ret = 3;
-			break;
+				else
+				{
+					// incorrect message length
+					nrc = 0x13;
+				}
+				break;
+			default:
+				nrc = 0x12;
+				break;
+		}
+	}
+	if (nrc != 0)
+	{
+		req[1] = req[0];
+		req[0] = 0x7F;
+		req[2] = nrc;
+		ret = 3;
 	}
 	return ret;
 }
-static int download_req_svc(boot_service_data_t *state, unsigned char *req, int len)
+// Parses the address/size of 0x34 and 0x35: req[1] bit 6..4 - address bytes, bit 2..0 - size bytes.
+// Returns the NRC, 0 if OK.
+static uint8_t parse_mem_req(const unsigned char *req, int len, uint32_t *addr, uint32_t *size)
 {
-	int ret = 0;
 	uint8_t fmt_len1 = ((req[1] >> 4) & 0x07);
 	uint8_t fmt_len2 = (req[1] & 0x07);
+	uint8_t i;
+	if ((fmt_len1 == 0) || (fmt_len1 > 4) || (fmt_len2 == 0) || (fmt_len2 > 4))
+	{
+		return 0x12;
+	}
+	if (len < 2 + fmt_len1 + fmt_len2)
+	{
+		// incorrect message length
+		return 0x13;
+	}
+	*addr = 0;
+	*size = 0;
+	for (i = 0; i < fmt_len1; i++)
+	{
+		*addr = ((*addr << 8) | (uint32_t)req[2 + i]);
+	}
+	for (i = 0; i < fmt_len2; i++)
+	{
+		*size = ((*size << 8) | (uint32_t)req[2 + fmt_len1 + i]);
+	}
+	return 0;
+}
+
+static int download_req_svc(boot_service_data_t *state, unsigned char *req, int len)
+{
+	int ret = 0;
 	uint8_t encrypt_flag = (req[1] & 0x80) ? 1 : 0;
 	uint8_t compress_flag = (req[1] & 0x08) ? 1 : 0;
 	uint32_t addr;
 	uint32_t data_size;
 	uint8_t tmp_key[16];
 	uint8_t i;
-	//state->flash_prog_state = 0;
-	if ((fmt_len1 != 0) && (fmt_len1 <= 4) && (fmt_len2 != 0) && (fmt_len2 <= 4))
+	uint8_t nrc = parse_mem_req(req, len, &addr, &data_size);
+	state->upload_state = 0;
+	if ((nrc == 0) && !check_flash_address_valid(addr, data_size))
+	{
+		nrc = 0x31;
+	}
+	if (nrc == 0)
 	{
-		if (len >= 2 + fmt_len1 + fmt_len2)
+		if (0 == state->flash_prog_state)
 		{
-			switch (fmt_len1)
-			{
-			case 1:
-				addr = (unsigned int)req[2];
-				break;
-			case 2:
-				addr = (((unsigned int)req[2] << 8) | (unsigned int)req[3]);
-				break;
-			case 3:
-				addr = (((unsigned int)req[2] << 16) | ((unsigned int)req[3] << 8) | (unsigned int)req[4]);
-				break;
-			case 4:
-				addr = (((unsigned int)req[2] << 24) | ((unsigned int)req[3] << 16) | ((unsigned int)req[4] << 8) | (unsigned int)req[5]);
-				break;
-			default:
-				addr = 0;
-				break;
-			}
-			switch (fmt_len2)
-			{
-			case 1:
-				data_size = (unsigned int)req[2 + fmt_len1];
-				break;
-			case 2:
-				data_size = (((unsigned int)req[2 + fmt_len1] << 8) | (unsigned int)req[3 + fmt_len1]);
-				break;
-			case 3:
-				data_size = (((unsigned int)req[2 + fmt_len1] << 16) | ((unsigned int)req[3 + fmt_len1] << 8) | (unsigned int)req[4 + fmt_len1]);
-				break;
-			case 4:
-				data_size = (((unsigned int)req[2 + fmt_len1] << 24) | ((unsigned int)req[3 + fmt_len1] << 16) | ((unsigned int)req[4 + fmt_len1] << 8) | (unsigned int)req[5 + fmt_len1]);
-				break;
-			default:
-				data_size = 0;
-				break;
-			}
-			if (check_flash_address_valid(addr, data_size))
+			for (i=0; i<sizeof(tmp_key); i++)
 			{
-				if (0 == state->flash_prog_state)
-				{
-					for (i=0; i<sizeof(tmp_key); i++)
-					{
-						tmp_key[i] = (enc_key[i] ^ enc_header[(i & 7)]);
-					}
-					rc4_init_key(tmp_key, &rc4_ctx);
-				}
-				state->expected_xfer_block_sn = 1;
-				state->flash_prog_state = 1;
-				state->xfer_data_rcvd_cnt = 0;
-				state->download_req_addr = addr;
-				state->download_req_size = data_size;
-				state->encrypt_flag = encrypt_flag;
-				state->compress_flag = compress_flag;
-				req[0] += 0x40;
-				ret = 1;
-			}
-			else
-			{
-				state->flash_prog_state = 0;
-				req[1] = req[0];
-				req[0] = 0x7F;
-				req[2] = 0x31;
-				ret = 3;
+				tmp_key[i] = (enc_key[i] ^ enc_header[(i & 7)]);
 			}
+			rc4_init_key(tmp_key, &rc4_ctx);
 		}
-		else
-		{
-			// incorrect message length
-			state->flash_prog_state = 0;
-			req[1] = req[0];
-			req[0] = 0x7F;
-			req[2] = 0x13;
-			ret = 3;
-		}
+		state->expected_xfer_block_sn = 1;
+		state->flash_prog_state = 1;
+		state->xfer_data_rcvd_cnt = 0;
+		state->download_req_addr = addr;
+		state->download_req_size = data_size;
+		state->encrypt_flag = encrypt_flag;
+		state->compress_flag = compress_flag;
+		// lengthFormatIdentifier, maxNumberOfBlockLength (SID + SN + data)
+		req[0] += 0x40;
+		req[1] = 0x20;
+		req[2] = (uint8_t)(BOOT_MAX_MSG_LEN >> 8);
+		req[3] = (uint8_t)BOOT_MAX_MSG_LEN;
+		ret = 4;
 	}
 	else
 	{
 		state->flash_prog_state = 0;
 		req[1] = req[0];
 		req[0] = 0x7F;
-		req[2] = 0x12;
+		req[2] = nrc;
+		ret = 3;
+	}
+	return ret;
+}
+
+static int upload_req_svc(boot_service_data_t *state, unsigned char *req, int len)
+{
+	int ret = 0;
+	uint32_t addr;
+	uint32_t data_size;
+	uint8_t nrc = parse_mem_req(req, len, &addr, &data_size);
+	state->flash_prog_state = 0;
+	if ((nrc == 0) && ((req[1] & 0x88) || !check_flash_address_valid(addr, data_size)))
+	{
+		// no encrypted/compressed upload
+		nrc = 0x31;
+	}
+	if (nrc == 0)
+	{
+		state->upload_state = 1;
+		state->upload_window_sn = 1;
+		state->upload_window = 0;
+		state->upload_tx_req = 0;
+		state->upload_req_addr = addr;
+		state->upload_req_size = data_size;
+		state->upload_window_offset = 0;
+		// lengthFormatIdentifier, maxNumberOfBlockLength (SID + SN + data)
+		req[0] += 0x40;
+		req[1] = 0x20;
+		req[2] = (uint8_t)((BOOT_UPLOAD_BLOCK_SIZE + 2) >> 8);
+		req[3] = (uint8_t)(BOOT_UPLOAD_BLOCK_SIZE + 2);
+		ret = 4;
+	}
+	else
+	{
+		state->upload_state = 0;
+		req[1] = req[0];
+		req[0] = 0x7F;
+		req[2] = nrc;
 		ret = 3;
 	}
 	return ret;
 }
+
+// 0x36 in upload direction: req[1] - SN of the first block wanted, req[2] - number of blocks (optional).
+// The host requests the SN after the last block it got in order, so a lost frame is re-sent from there.
+// The blocks are not answered here but streamed by upload_stream() from the main task.
+static uint8_t upload_xfer_data(boot_service_data_t *state, unsigned char *req, int len)
+{
+	uint8_t delta = (uint8_t)(req[1] - state->upload_window_sn);
+	uint32_t offset;
+	if (delta > state->upload_window)
+	{
+		return 0x24;
+	}
+	offset = state->upload_window_offset + (uint32_t)delta * BOOT_UPLOAD_BLOCK_SIZE;
+	if (offset >= state->upload_req_size)
+	{
+		return 0x24;
+	}
+	state->upload_window_sn = req[1];
+	state->upload_window_offset = offset;
+	state->upload_window = 0;
+	state->upload_tx_req = (len > 2) ? req[2] : 1;
+	if ((state->upload_tx_req == 0) || (state->upload_tx_req > BOOT_UPLOAD_MAX_WINDOW))
+	{
+		state->upload_tx_req = BOOT_UPLOAD_MAX_WINDOW;
+	}
+	return 0;
+}
+
 static int xfer_data_svc(boot_service_data_t *state, unsigned char *req, int len)
 {
 	int ret = 0;
 	uint8_t nrc = 0;
-	len -=2;
-	if ((state->flash_prog_state == 1) && (state->download_req_size >= state->xfer_data_rcvd_cnt + len))
+#if defined(BOOT_XFER_SW_READBACK)
+	uint32_t t0;
+#else
+	uint32_t crc;
+#endif
+	if (state->upload_state == 1)
 	{
+		nrc = upload_xfer_data(state, req, len);
+	}
+	else if ((state->flash_prog_state == 1) && (len > 2) && (state->download_req_size >= state->xfer_data_rcvd_cnt + len - 2))
+	{
+		len -= 2;
 		if (state->expected_xfer_block_sn == req[1])
 		{
 			if (state->encrypt_flag)
 			{
 				rc4(&req[2], &req[2], len, &rc4_ctx);
 			}
+#if defined(BOOT_XFER_SW_READBACK)
+			// reference path for the benchmark: CRC read back from flash after programming
 			if (STATUS_SUCCESS == flash_write(state->download_req_addr + state->xfer_data_rcvd_cnt, &req[2], len))
 			{
+				t0 = flash_drv_get_ticks();
 				state->checksum = crc32(state->checksum, (void *)(state->download_req_addr + state->xfer_data_rcvd_cnt), len);
+				flash_drv_stats.crc_ticks += (flash_drv_get_ticks() - t0);
+#else
+			// CRC of the RAM block is computed while it is programmed, the flash is read once by the verify
+			crc = state->checksum;
+			if (STATUS_SUCCESS == flash_write_crc(state->download_req_addr + state->xfer_data_rcvd_cnt, &req[2], len, &crc))
+			{
+				state->checksum = crc;
+#endif
 				++state->expected_xfer_block_sn;
 				state->xfer_data_rcvd_cnt += len;
 				state->total_xfer_data_cnt += len;
@@ -585,7 +683,7 @@ static int xfer_data_svc(boot_service_data_t *state, unsigned char *req, int len
 static int exit_xfer_svc(boot_service_data_t *state, unsigned char *req, int len)
 {
 	int ret = 0;
-	if (state->flash_prog_state == 1)
+	if ((state->flash_prog_state == 1) || (state->upload_state == 1))
 	{
 		req[0] += 0x40;
 		ret = 1;
@@ -598,6 +696,7 @@ static int exit_xfer_svc(boot_service_data_t *state, unsigned char *req, int len
 		ret = 3;
 	}
 	state->flash_prog_state = 0;
+	state->upload_state = 0;
 	return ret;
 }
 
@@ -677,27 +776,177 @@ static int sec_access_svc(boot_service_data_t *state, unsigned char *req, int le
 	return ret;
 }
 
-void erase_routine_task(void *param)
+// Sends the queued frames to the address of the first one, the frames the stack did not take are released.
+static uint32_t send_batch(Socket_t sock, struct freertos_mmsghdr *msgs, uint32_t *cnt)
 {
-	while(1)
+	uint32_t sent = *cnt;
+	uint32_t i;
+	if ((sent > 0) && (FreeRTOS_sendmmsg(sock, msgs, sent, 0, &msgs[0].xAddress) <= 0))
 	{
-		if (erase_routine_data.req)
+		for (i = 0; i < sent; i++)
 		{
-			erase_routine_data.state = 1;
-			erase_routine_data.req = 0;
-			erase_routine_data.error_code = flash_erase(erase_routine_data.address, erase_routine_data.size);
-			if (STATUS_SUCCESS == erase_routine_data.error_code)
+			FreeRTOS_ReleaseUDPPayloadBuffer(msgs[i].pvData);
+		}
+		sent = 0;
+	}
+	*cnt = 0;
+	return sent;
+}
+
+// Sends the blocks requested by the last 0x36 of an upload, one zero-copy UDP datagram per block,
+// up to BOOT_TX_BATCH datagrams per call into the stack.
+// Stops early when the network buffers run out, the host re-requests from the first missing SN.
+static void upload_stream(Socket_t sock, struct freertos_sockaddr *remote, boot_service_data_t *state)
+{
+	struct freertos_mmsghdr msgs[BOOT_TX_BATCH];
+	uint32_t cnt = 0;
+	uint32_t offset = state->upload_window_offset;
+	uint32_t len;
+	uint8_t *p_tx_data;
+	uint32_t batch_sent;
+	uint8_t i;
+	uint8_t sent = 0;
+
+	for (i = 0; (i < state->upload_tx_req) && (offset < state->upload_req_size); i++)
+	{
+		len = state->upload_req_size - offset;
+		if (len > BOOT_UPLOAD_BLOCK_SIZE)
+		{
+			len = BOOT_UPLOAD_BLOCK_SIZE;
+		}
+		p_tx_data = FreeRTOS_GetUDPPayloadBuffer(len + 7, 0);
+		if ((p_tx_data == NULL) && (cnt > 0))
+		{
+			// a full block takes a jumbo buffer and there are fewer of them than BOOT_TX_BATCH,
+			// send the batch so that its buffers come back
+			batch_sent = send_batch(sock, msgs, &cnt);
+			if (batch_sent == 0)
 			{
-				erase_routine_data.result = 1;
+				break;
+			}
+			sent += (uint8_t)batch_sent;
+		}
+		if (p_tx_data == NULL)
+		{
+			p_tx_data = FreeRTOS_GetUDPPayloadBuffer(len + 7, pdMS_TO_TICKS(20));
+		}
+		if (p_tx_data == NULL)
+		{
+			break;
+		}
+		msgs[cnt].pvData = p_tx_data;
+		msgs[cnt].xLength = build_upload_msg((uint8_t)(state->upload_window_sn + i), (const uint8_t *)(state->upload_req_addr + offset), len, p_tx_data, CPYPT_MASK);
+		msgs[cnt].xAddress = *remote;
+		cnt++;
+		offset += len;
+		if (cnt == BOOT_TX_BATCH)
+		{
+			if (0 == send_batch(sock, msgs, &cnt))
+			{
+				break;
+			}
+			sent += BOOT_TX_BATCH;
+		}
+	}
+	sent += (uint8_t)send_batch(sock, msgs, &cnt);
+	state->upload_window = sent;
+	state->upload_tx_req = 0;
+}
+
+// Follows the unlocked state of the active session after a request from host, the host of the request that unlocked it owns it.
+static void boot_session_update(const boot_service_data_t *state, uint8_t was_unlocked, const struct freertos_sockaddr *host)
+{
+	uint8_t unlocked = ((state->unlocked & state->session) != 0);
+	taskENTER_CRITICAL();
+	if (!unlocked)
+	{
+		session_host_valid = 0;
+	}
+	else if (!was_unlocked)
+	{
+		session_host_addr = host->sin_addr;
+		session_host_valid = 1;
+	}
+	taskEXIT_CRITICAL();
+}
+
+uint8_t boot_app_session_host(uint32_t *addr)
+{
+	uint8_t ret;
+	taskENTER_CRITICAL();
+	ret = session_host_valid;
+	*addr = session_host_addr;
+	taskEXIT_CRITICAL();
+	return ret;
+}
+
+// Runs the service of a decrypted request, the response is built in req. Returns the response length.
+static int32_t boot_dispatch(boot_service_data_t *state, uint8_t *req, uint32_t len)
+{
+	int32_t ret = 0;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(boot_service_table) / sizeof(boot_service_table[0]); i++)
+	{
+		if (req[0] == boot_service_table[i].sid)
+		{
+			if ((len >= boot_service_table[i].min_len) && (len <= boot_service_table[i].max_len))
+			{
+				if (state->session & boot_service_table[i].supported_session_mask)
+				{
+					if ((boot_service_table[i].unlock_required == 0) || (state->unlocked & state->session))
+					{
+						if (boot_service_table[i].fn != NULL)
+						{
+							ret = boot_service_table[i].fn(state, req, len);
+						}
+						else
+						{
+							// general reject
+							req[1] = req[0];
+							req[0] = 0x7F;
+							req[2] = 0x10;
+							ret = 3;
+						}
+					}
+					else
+					{
+						// security access required
+						req[1] = req[0];
+						req[0] = 0x7F;
+						req[2] = 0x33;
+						ret = 3;
+					}
+				}
+				else
+				{
+					// session not support
+					req[1] = req[0];
+					req[0] = 0x7F;
+					req[2] = 0x7F;
+					ret = 3;
+				}
 			}
 			else
 			{
-				erase_routine_data.result = 2;
+				// incorrect message length
+				req[1] = req[0];
+				req[0] = 0x7F;
+				req[2] = 0x13;
+				ret = 3;
 			}
-			erase_routine_data.state = 2;
+			break;
 		}
-		vTaskDelay(100);
 	}
+	if (i >= sizeof(boot_service_table) / sizeof(boot_service_table[0]))
+	{
+		// service not supported
+		req[1] = req[0];
+		req[0] = 0x7F;
+		req[2] = 0x11;
+		ret = 3;
+	}
+	return ret;
 }
 
 void boot_main_task(void *param)
@@ -709,131 +958,109 @@ void boot_main_task(void *param)
 	unsigned char gateway[4] = {192, 168, 1, 187};
 	unsigned char dns[4] = {114,114,114,114};
 
-	uint8_t buf_crypt[16] = {0};
+	uint8_t buf_crypt[32] = {0};
 	uint32_t cryptLen = 0;
-	uint8_t buf_decrypt[1280] = {0};
-	uint32_t decryptLen = 0;
+	// a request of BOOT_MAX_MSG_LEN bytes does not fit on the task stack
+	static uint8_t buf_decrypt[BOOT_MAX_MSG_LEN];
+	int decryptLen = 0;
 
 	Socket_t sock;
 	struct freertos_sockaddr local_addr;
 	int rx_timeout = 3000; // 3 sec timeout
+#if (ipconfigUDP_FAST_PATH == 1)
+	BaseType_t fast_path = pdTRUE;
+#endif
+	struct freertos_mmsghdr rx_msgs[BOOT_RX_BATCH];
+	struct freertos_mmsghdr tx_msgs[BOOT_RX_BATCH];
+	int32_t rx_cnt;
+	int32_t n;
+	uint32_t tx_cnt = 0;
 	int32_t rx_size;
 	int32_t tx_size;
 	uint8_t *p_rx_data;
-	unsigned int i;
-	struct freertos_sockaddr addr_remote;
+	uint8_t was_unlocked;
 	boot_service_data_t svc_state;
 
 	boot_service_data_init(&svc_state);
-	erase_routine_data.state = 0;
-	erase_routine_data.req = 0;
-	erase_routine_data.result = 0;
-	erase_routine_data.error_code = 0;
-	erase_routine_data.address = 0;
-	erase_routine_data.size = 0;
-
-	checksum_routine_data.state = 0;
-	checksum_routine_data.result = 0;
+	flash_drv_init();
+	// bring up the routine workers before the IP stack is started
+	boot_routine_init();
+	boot_routine_start_cores();
 
 	ip_addr[3] += dev_id;
 	mac_addr[5] += dev_id;
 	param;
+	// DHCP confirms the cached lease first, ip_addr is the fallback
+	boot_lease_init(mac_addr);
 	FreeRTOS_IPInit(ip_addr, net_mask, gateway, dns, mac_addr);
+	boot_trace_init();
+	boot_net_bench_init();
+	boot_rtos_bench_init();
 	sock = FreeRTOS_socket(FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP);
 	FreeRTOS_setsockopt(sock, 0, FREERTOS_SO_RCVTIMEO, &rx_timeout, 0);
 	FreeRTOS_GetAddressConfiguration(&local_addr.sin_addr, NULL, NULL, NULL);
 	local_addr.sin_port = FreeRTOS_htons( 14229 );
 	FreeRTOS_bind(sock, &local_addr, sizeof(local_addr));
-	flash_drv_init();
+#if (ipconfigUDP_FAST_PATH == 1)
+	// requests are taken straight from the ENET handler task
+	FreeRTOS_setsockopt(sock, 0, FREERTOS_SO_UDP_FAST_PATH, &fast_path, 0);
+#endif
 	while (1)
 	{
-		rx_size = FreeRTOS_recvfrom(sock, (void *)&p_rx_data, 0, FREERTOS_ZERO_COPY, &addr_remote, NULL, NULL);
+		rx_cnt = FreeRTOS_recvmmsg(sock, rx_msgs, BOOT_RX_BATCH, 0, NULL, NULL);
 		Srnd(xTaskGetTickCount());
-		if (rx_size > 0)
+		if (rx_cnt > 0)
 		{
-			//TODO: serve command.
-			decrypt_msg(p_rx_data, rx_size, buf_decrypt, &decryptLen, CPYPT_MASK);
-			//memcpy(p_rx_data, buf_decrypt, decryptLen);
-			//FreeRTOS_sendto(sock, p_rx_data, decryptLen, FREERTOS_ZERO_COPY, &addr_remote, NULL, NULL);
-			
-			tx_size = 0;
-			for (i = 0; i < sizeof(boot_service_table) / sizeof(boot_service_table[0]); i++)
+			for (n = 0; n < rx_cnt; n++)
 			{
-				if (buf_decrypt[0] == boot_service_table[i].sid)
+				p_rx_data = (uint8_t *)rx_msgs[n].pvData;
+				rx_size = (int32_t)rx_msgs[n].xLength;
+				if (rx_size > 0)
 				{
-					if ((decryptLen >= boot_service_table[i].min_len) && (decryptLen <= boot_service_table[i].max_len))
+					decrypt_msg(p_rx_data, rx_size, buf_decrypt, sizeof(buf_decrypt), &decryptLen, CPYPT_MASK);
+					was_unlocked = ((svc_state.unlocked & svc_state.session) != 0);
+					// a malformed frame gets no response
+					tx_size = (decryptLen > 0) ? boot_dispatch(&svc_state, buf_decrypt, decryptLen) : 0;
+					boot_session_update(&svc_state, was_unlocked, &rx_msgs[n].xAddress);
+					if (tx_size > 0)
 					{
-						if (svc_state.session & boot_service_table[i].supported_session_mask)
+						build_crypt_msg(buf_decrypt, tx_size, buf_crypt, &cryptLen, CPYPT_MASK);
+						memcpy(p_rx_data, buf_crypt, cryptLen);
+						// the responses of a batch go out together while they are for the same host
+						if ((tx_cnt > 0) && ((tx_msgs[0].xAddress.sin_addr != rx_msgs[n].xAddress.sin_addr) ||
+											 (tx_msgs[0].xAddress.sin_port != rx_msgs[n].xAddress.sin_port)))
 						{
-							if ((boot_service_table[i].unlock_required == 0) || (svc_state.unlocked & svc_state.session))
-							{
-								if (boot_service_table[i].fn != NULL)
-								{
-									tx_size = boot_service_table[i].fn(&svc_state, buf_decrypt, decryptLen);
-								}
-								else
-								{
-									// general reject
-									buf_decrypt[1] = buf_decrypt[0];
-									buf_decrypt[0] = 0x7F;
-									buf_decrypt[2] = 0x10;
-									tx_size = 3;
-								}
-							}
-							else
-							{
-								// security access required
-								buf_decrypt[1] = buf_decrypt[0];
-								buf_decrypt[0] = 0x7F;
-								buf_decrypt[2] = 0x33;
-								tx_size = 3;
-							}
-						}
-						else
-						{
-							// session not support
-							buf_decrypt[1] = buf_decrypt[0];
-							buf_decrypt[0] = 0x7F;
-							buf_decrypt[2] = 0x7F;
-							tx_size = 3;
+							send_batch(sock, tx_msgs, &tx_cnt);
 						}
+						tx_msgs[tx_cnt].pvData = p_rx_data;
+						tx_msgs[tx_cnt].xLength = cryptLen;
+						tx_msgs[tx_cnt].xAddress = rx_msgs[n].xAddress;
+						tx_cnt++;
+						// the buffer is sent or released by send_batch()
+						p_rx_data = NULL;
 					}
-					else
+					if (svc_state.upload_tx_req)
 					{
-						// incorrect message length
-						buf_decrypt[1] = buf_decrypt[0];
-						buf_decrypt[0] = 0x7F;
-						buf_decrypt[2] = 0x13;
-						tx_size = 3;
+						// the 0x36 response goes before the blocks
+						send_batch(sock, tx_msgs, &tx_cnt);
+						upload_stream(sock, &rx_msgs[n].xAddress, &svc_state);
 					}
-					break;
+				}
+				if (p_rx_data != NULL)
+				{
+					/* The buffer *must* be freed once it is no longer needed. */
+					FreeRTOS_ReleaseUDPPayloadBuffer(p_rx_data);
 				}
 			}
-			if (i >= sizeof(boot_service_table) / sizeof(boot_service_table[0]))
-			{
-				// service not supported
-				buf_decrypt[1] = buf_decrypt[0];
-				buf_decrypt[0] = 0x7F;
-				buf_decrypt[2] = 0x11;
-				tx_size = 3;
-			}
-			if (tx_size > 0)
-			{
-				build_crypt_msg(buf_decrypt, tx_size, buf_crypt, &cryptLen, CPYPT_MASK);
-				memcpy(p_rx_data, buf_crypt, cryptLen);
-				FreeRTOS_sendto(sock, p_rx_data, cryptLen, FREERTOS_ZERO_COPY, &addr_remote, NULL, NULL);
-			}
+			send_batch(sock, tx_msgs, &tx_cnt);
 		}
 		else
 		{
 			// nothing recved
 			boot_service_data_init(&svc_state);
+			boot_session_update(&svc_state, 0, NULL);
 		}
-		if (rx_size >= 0)
-		{
-			/* The buffer *must* be freed once it is no longer needed. */
-			FreeRTOS_ReleaseUDPPayloadBuffer(p_rx_data);
-		}
+		boot_lease_commit();
 		if (svc_state.reset_req)
 		{
 			svc_state.reset_req = 0;
@@ -846,6 +1073,5 @@ void boot_main_task(void *param)
 void app_init(void)
 {
 	xTaskCreate( boot_main_task, "boot_main", 4096, NULL, 4, NULL );
-	xTaskCreate( erase_routine_task, "boot_routine", 2048, NULL, 3, NULL );
 	vTaskStartScheduler();
 }
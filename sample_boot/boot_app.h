@@ -33,12 +33,28 @@ typedef struct
 	uint32_t download_req_size;
 	uint8_t encrypt_flag;
 	uint8_t compress_flag;
-
+	uint8_t upload_state; // 0 - init, 1 - upload req rcvd
+	uint8_t upload_window_sn; // sn of the first block of the last window
+	uint8_t upload_window; // blocks sent in the last window
+	uint8_t upload_tx_req; // blocks requested by the host, streamed by the main task
+	uint32_t upload_req_addr;
+	uint32_t upload_req_size;
+	uint32_t upload_window_offset;
 } boot_service_data_t;
 
 typedef int (*boot_service_fn_t)(boot_service_data_t*state, unsigned char *data, int len);
 typedef void (*function_entry_t)(void);
 
+// Longest message (SID + parameters) in one UDP datagram after the framing of build_crypt_msg():
+// BOOT_MAX_DATAGRAM_SIZE is ipconfigIP_MAX_DATAGRAM_SIZE, less the IP and UDP headers and 5 bytes of framing.
+// Advertised as maxNumberOfBlockLength by 0x34 and 0x35.
+#define BOOT_MAX_DATAGRAM_SIZE (16384)
+#define BOOT_MAX_MSG_LEN (BOOT_MAX_DATAGRAM_SIZE - 20 - 8 - 5)
+
+// RequestUpload: data bytes per 0x76 block (SID + SN + data fill a message) and blocks per 0x36 request
+#define BOOT_UPLOAD_BLOCK_SIZE (BOOT_MAX_MSG_LEN - 2)
+#define BOOT_UPLOAD_MAX_WINDOW (32)
+
 #define APP_FLASH_ADDR_START (0x01001000)
 #define APP_FLASH_SIZE (5564 * 1024)
 
@@ -62,25 +78,11 @@ typedef struct
 	boot_service_fn_t fn;
 } boot_service_handle_t;
 
-typedef struct 
-{
-	uint8_t state; // 0 - idle, 1 - on processing, 2 - complete
-	uint8_t result; // 0 - no req, 1 - start req, 2 - stop req
-} boot_checksum_routine_t;
-
-typedef struct
-{
-	uint8_t state;	// 0 - idle, 1 - on processing, 2 - complete
-	uint8_t req;	// 0 - no req, 1 - start req, 2 - stop req
-	uint8_t result; // 0 - no result, 1 - OK, 2 - fail
-	uint32_t address;
-	uint32_t size;
-	int error_code;
-} boot_erase_flash_routine_t;
-
 //extern APP_BOOT_SHARE_DATA_SECTION uint32_t AppBootShareData[];
 
 void app_init(void);
+// IPv4 address (network order) of the host that unlocked the active session. Returns 0 without an unlocked session.
+uint8_t boot_app_session_host(uint32_t *addr);
 
 
 #endif /* APP_H_ */
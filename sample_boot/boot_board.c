@@ -17,7 +17,7 @@ void board_hw_init(void)
 	//1. Clock
 	CLOCK_SYS_Init(g_clockManConfigsArr, CLOCK_MANAGER_CONFIG_CNT, g_clockManCallbacksArr, CLOCK_MANAGER_CALLBACK_CNT);
 	CLOCK_SYS_UpdateConfiguration(0U, CLOCK_MANAGER_POLICY_AGREEMENT);
-	//SEMA42_DRV_Init(0);
+	SEMA42_DRV_Init(0);
 	//2. Pin Mux
 	PINS_DRV_Init(NUM_OF_CONFIGURED_PINS, g_pin_mux_InitConfigArr);
 	//3. CAN - be initialized by can.c
@@ -27,6 +27,32 @@ void board_hw_init(void)
 	//7. EEE
 }
 
+// Release a secondary core (1 - e200z4b, 2 - e200z2) at entry through MC_ME.
+// The core is reset on the next mode change, so re-enter the current mode.
+void board_start_core(uint8_t core, void (*entry)(void))
+{
+	uint32_t mode;
+	switch (core)
+	{
+	case 1:
+		MC_ME->CCTL2 = 0x00FE; // active in all RUN/DRUN/SAFE modes
+		MC_ME->CADDR2 = ((uint32_t)entry | 0x01); // RMC: reset on mode change
+		break;
+	case 2:
+		MC_ME->CCTL3 = 0x00FE;
+		MC_ME->CADDR3 = ((uint32_t)entry | 0x01);
+		break;
+	default:
+		return;
+	}
+	mode = ((MC_ME->GS & MC_ME_GS_S_CURRENT_MODE_MASK) >> MC_ME_GS_S_CURRENT_MODE_SHIFT);
+	MC_ME->MCTL = MC_ME_MCTL_TARGET_MODE(mode) | FEATURE_MC_ME_KEY;
+	MC_ME->MCTL = MC_ME_MCTL_TARGET_MODE(mode) | FEATURE_MC_ME_KEY_INV;
+	while (MC_ME->GS & MC_ME_GS_S_MTRANS_MASK)
+	{
+	}
+}
+
 void can_set_transciever_mode(unsigned char channel, bool power_enable, bool trans_enable, bool stbn_enable)
 {
 	static const DioIdxType pwr_en[8] = {PM_EN0, PM_EN1, PM_EN2, PM_EN3, PM_EN4, PM_EN5, PM_EN6, PM_EN7};
@@ -8,8 +8,16 @@
 #ifndef BOARD_H_
 #define BOARD_H_
 #include <stdbool.h>
+#include <stdint.h>
+
+// SEMA42 gates shared by the cores
+#define BOARD_SEMA42_GATE_FLASH (0U)   // flash controller program/erase
+#define BOARD_SEMA42_GATE_ROUTINE (1U) // routine job queue
+// gate 14 is configHEAP_SEMA42_GATE, taken by heap_tlsf.c for blocks freed across cores
+// gate 15 is configKERNEL_SEMA42_GATE, taken by the kernel for task migration
 
 void board_hw_init(void);
+void board_start_core(uint8_t core, void (*entry)(void));
 unsigned char id_pin_read(void);
 void can_set_transciever_mode(unsigned char channel, bool power_enable, bool trans_enable, bool stbn_enable);
 unsigned char hw_rev_pin_read(void);
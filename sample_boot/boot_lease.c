@@ -0,0 +1,201 @@
+/*
+ * boot_lease.c
+ *
+ *  DHCP lease cache in emulated EEPROM. The IP task only sees a RAM copy: the
+ *  lease is read once before the stack starts, and a change is handed over to
+ *  boot_main_task, which is the flash user of core 0 (see flash_lock()).
+ */
+#include <string.h>
+#include "drivers.h"
+#include "rtos.h"
+#include "tcpip.h"
+#include "flash_drv.h"
+#include "boot_lease.h"
+
+#if (ipconfigDHCP_USE_LEASE_CACHE != 0)
+
+#define BOOT_LEASE_MAGIC (0x44484350) // "DHCP"
+
+typedef enum
+{
+	BOOT_LEASE_OP_NONE = 0,
+	BOOT_LEASE_OP_WRITE = 1,
+	BOOT_LEASE_OP_DELETE = 2,
+} boot_lease_op_t;
+
+// Fixed length EEE record, a multiple of the 8 byte ECC unit
+typedef struct
+{
+	uint32_t magic;
+	uint8_t mac[6];
+	uint8_t reserved[2];
+	DHCPLease_t lease;
+} boot_lease_record_t;
+
+static eee_block_config_t lease_eee_block0 =
+{
+	0x1, BOOT_LEASE_EEE_BLOCK0_ADDR, BOOT_LEASE_EEE_BLOCK_SIZE, 0, C55_BLOCK_HIGH, 0
+};
+static eee_block_config_t lease_eee_block1 =
+{
+	0x2, BOOT_LEASE_EEE_BLOCK1_ADDR, BOOT_LEASE_EEE_BLOCK_SIZE, 0, C55_BLOCK_HIGH, 0
+};
+static eee_block_config_t *lease_eee_blocks[] = {&lease_eee_block0, &lease_eee_block1};
+
+static const eee_user_config_t lease_eee_config =
+{
+	.numberOfBlock = sizeof(lease_eee_blocks) / sizeof(lease_eee_blocks[0]),
+	.numberOfActBlock = 1,
+	.numOfByteRead = 64,
+	.numOfCycleSearch = 64,
+	.numOfRecordSearch = BOOT_LEASE_EEE_BLOCK_SIZE / 16, // more than the records a block can hold
+	.callback = NULL,
+	.callbackParam = NULL,
+	.cTable = NULL,
+	.flashBlocks = lease_eee_blocks,
+	.schemeSelection = EEE_FIXLENGTH,
+	.dataSize = sizeof(boot_lease_record_t),
+	.maxReEraseEeeBlock = 2,
+	.maxReProgram = 2,
+	.cacheEnable = false,
+	.maxRecordId = BOOT_LEASE_RECORD_ID + 1, // the swap copies the IDs below
+};
+
+static eee_state_t lease_eee_state;
+static uint8_t lease_eee_ready;
+static boot_lease_record_t lease_record; // owned by boot_main_task
+// RAM copy shared with the IP task, under a critical section
+static DHCPLease_t lease_cached;
+static uint8_t lease_valid;
+static volatile uint8_t lease_pending_op;
+
+static status_t lease_eee_init(void)
+{
+	status_t ret;
+	flash_drv_lock();
+	ret = EEE_DRV_InitEeprom(&lease_eee_config, &lease_eee_state);
+	flash_drv_unlock();
+	return ret;
+}
+
+// Finishes the erase of a block swap, the gate stays taken so the workers can not start a job meanwhile.
+static status_t lease_eee_finish_swap(void)
+{
+	status_t ret = STATUS_SUCCESS;
+	while ((g_eraseStatusFlag == EEE_ERASE_IN_PROGRESS) && (ret == STATUS_SUCCESS))
+	{
+		ret = EEE_DRV_MainFunction();
+		vTaskDelay(BOOT_LEASE_ERASE_POLL_TICKS);
+	}
+	if (g_eraseStatusFlag == EEE_ERASE_SWAP_ERROR)
+	{
+		ret = STATUS_ERROR;
+	}
+	return ret;
+}
+
+void boot_lease_init(const uint8_t *mac)
+{
+	uint32_t record_addr;
+	status_t ret;
+	lease_valid = 0;
+	lease_pending_op = BOOT_LEASE_OP_NONE;
+	memset(&lease_record, 0, sizeof(lease_record));
+	lease_eee_ready = (lease_eee_init() == STATUS_SUCCESS);
+	if (lease_eee_ready)
+	{
+		flash_drv_lock();
+		ret = EEE_DRV_ReadEeprom(BOOT_LEASE_RECORD_ID, sizeof(lease_record), (uint32_t)&lease_record, &record_addr, EEE_IMMEDIATE_NONE);
+		flash_drv_unlock();
+		// the lease belongs to the client ID, which follows the ID pins
+		if ((ret == STATUS_SUCCESS) && (lease_record.magic == BOOT_LEASE_MAGIC) && (memcmp(lease_record.mac, mac, sizeof(lease_record.mac)) == 0))
+		{
+			lease_cached = lease_record.lease;
+			lease_valid = 1;
+		}
+	}
+	memcpy(lease_record.mac, mac, sizeof(lease_record.mac));
+	lease_record.magic = BOOT_LEASE_MAGIC;
+}
+
+void boot_lease_commit(void)
+{
+	uint8_t op;
+	status_t ret;
+	if ((lease_pending_op == BOOT_LEASE_OP_NONE) || !lease_eee_ready)
+	{
+		return;
+	}
+	taskENTER_CRITICAL();
+	op = lease_pending_op;
+	lease_record.lease = lease_cached;
+	lease_pending_op = BOOT_LEASE_OP_NONE;
+	taskEXIT_CRITICAL();
+
+	flash_drv_lock();
+	if (op == BOOT_LEASE_OP_WRITE)
+	{
+		ret = EEE_DRV_WriteEeprom(BOOT_LEASE_RECORD_ID, sizeof(lease_record), (uint32_t)&lease_record, EEE_IMMEDIATE_NONE);
+	}
+	else
+	{
+		ret = EEE_DRV_DeleteRecord(BOOT_LEASE_RECORD_ID, EEE_IMMEDIATE_NONE);
+		if (ret == STATUS_EEE_ERROR_DATA_NOT_FOUND)
+		{
+			ret = STATUS_SUCCESS;
+		}
+	}
+	if (ret == STATUS_SUCCESS)
+	{
+		ret = lease_eee_finish_swap();
+	}
+	flash_drv_unlock();
+	if (ret != STATUS_SUCCESS)
+	{
+		// recovers the blocks, the lease is written again on the next change
+		lease_eee_ready = (lease_eee_init() == STATUS_SUCCESS);
+	}
+}
+
+BaseType_t xApplicationDHCPLeaseLoad(DHCPLease_t *pxLease)
+{
+	BaseType_t ret = pdFALSE;
+	taskENTER_CRITICAL();
+	if (lease_valid)
+	{
+		*pxLease = lease_cached;
+		ret = pdTRUE;
+	}
+	taskEXIT_CRITICAL();
+	return ret;
+}
+
+void vApplicationDHCPLeaseStore(const DHCPLease_t *pxLease)
+{
+	taskENTER_CRITICAL();
+	if (pxLease != NULL)
+	{
+		lease_cached = *pxLease;
+		lease_valid = 1;
+		lease_pending_op = BOOT_LEASE_OP_WRITE;
+	}
+	else
+	{
+		lease_valid = 0;
+		lease_pending_op = BOOT_LEASE_OP_DELETE;
+	}
+	taskEXIT_CRITICAL();
+}
+
+#else
+
+void boot_lease_init(const uint8_t *mac)
+{
+	(void)mac;
+}
+
+void boot_lease_commit(void)
+{
+}
+
+#endif /* ipconfigDHCP_USE_LEASE_CACHE */
@@ -0,0 +1,25 @@
+/*
+ * boot_lease.h
+ *
+ *  DHCP lease cache. The last acknowledged lease is kept in emulated EEPROM
+ *  so that after a reset the stack can confirm it with one INIT-REBOOT
+ *  request instead of a full discovery.
+ */
+
+#ifndef BOOT_LEASE_H_
+#define BOOT_LEASE_H_
+#include <stdint.h>
+
+// EEPROM emulation on the two 16 KB high blocks, outside of check_flash_address_valid()
+#define BOOT_LEASE_EEE_BLOCK0_ADDR (0x00F80000)
+#define BOOT_LEASE_EEE_BLOCK1_ADDR (0x00F84000)
+#define BOOT_LEASE_EEE_BLOCK_SIZE (0x4000)
+#define BOOT_LEASE_RECORD_ID (1)
+#define BOOT_LEASE_ERASE_POLL_TICKS (1)
+
+// Reads the cached lease, call before FreeRTOS_IPInit() with the MAC passed to it.
+void boot_lease_init(const uint8_t *mac);
+// Writes a lease handed over by the IP task. Only from boot_main_task, the flash user of core 0.
+void boot_lease_commit(void);
+
+#endif /* BOOT_LEASE_H_ */
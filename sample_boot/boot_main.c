@@ -46,9 +46,16 @@ volatile int exit_code = 0;
 /* User includes (#include below this line is not maintained by Processor Expert) */
 #include "boot_board.h"
 #include "boot_app.h"
+#include "boot_routine.h"
 
 extern void xcptn_xmpl(void (*)(void));
 void VTABLE0(void);
+#if defined(TURN_ON_CPU1)
+void VTABLE1(void);
+#endif
+#if defined(TURN_ON_CPU2)
+void VTABLE2(void);
+#endif
 
 /*!
   \brief The main function for the project.
@@ -90,6 +97,32 @@ int main(void)
   /*** Processor Expert end of main routine. DON'T WRITE CODE BELOW!!! ***/
 } /*** End of main routine. DO NOT MODIFY THIS TEXT!!! ***/
 
+#if defined(TURN_ON_CPU1)
+/* Entry of core 1, started by boot_routine_start_cores() from core 0 */
+int main1(void)
+{
+  xcptn_xmpl(VTABLE1);
+  boot_routine_core_main();
+  for (;;)
+  {
+  }
+  return 0;
+}
+#endif
+
+#if defined(TURN_ON_CPU2)
+/* Entry of core 2, started by boot_routine_start_cores() from core 0 */
+int main2(void)
+{
+  xcptn_xmpl(VTABLE2);
+  boot_routine_core_main();
+  for (;;)
+  {
+  }
+  return 0;
+}
+#endif
+
 /* END main */
 /*!
 ** @}
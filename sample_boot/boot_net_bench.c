@@ -0,0 +1,169 @@
+/*
+ * boot_net_bench.c
+ *
+ *  Sink task of the network load benchmark. The load datagrams take the path
+ *  of the bootloader requests (bulk ring, fast path when it is on, batches of
+ *  FreeRTOS_recvmmsg()) and are only counted, so the idle time of core 0 is
+ *  what the driver, the stack and the interrupts leave.
+ */
+#include <string.h>
+#include "drivers.h"
+#include "rtos.h"
+#include "tcpip.h"
+#include "boot_net_bench.h"
+
+#if defined(BOOT_NET_BENCH)
+
+#if (configGENERATE_RUN_TIME_STATS != 1)
+#error "BOOT_NET_BENCH needs configGENERATE_RUN_TIME_STATS."
+#endif
+
+#if (ipconfigMEASURE_RX_LATENCY == 0)
+#error "BOOT_NET_BENCH needs ipconfigMEASURE_RX_LATENCY."
+#endif
+
+#define BOOT_NET_BENCH_BATCH (8) // datagrams taken per FreeRTOS_recvmmsg()
+
+// see NetworkInterface.c
+extern uint32_t ENET_RxFrameCnt;
+extern uint32_t ENET_RxIrqCnt;
+extern uint32_t ENET_CoalLevel;
+extern uint32_t ENET_CoalAdaptive;
+extern uint32_t ENET_TxFrameCnt;
+extern uint32_t ENET_ChecksumOffload;
+extern uint32_t ENET_RxLatencyMaxUs[2];
+extern uint32_t ENET_RxLatencySumUs[2];
+extern uint32_t ENET_RxLatencyCnt[2];
+
+static uint32_t net_bench_sink_frames;
+static uint32_t net_bench_echo_frames;
+static uint8_t net_bench_echo;
+static BaseType_t net_bench_fast_path;
+
+static void net_bench_sample(boot_net_bench_sample_t *sample)
+{
+	uint32_t path;
+	// the idle task of this core is switched out, its counter is up to date
+	taskENTER_CRITICAL();
+	sample->time_ticks = portGET_RUN_TIME_COUNTER_VALUE();
+	sample->idle_ticks = ulTaskGetIdleRunTimeCounter();
+	sample->rx_frames = ENET_RxFrameCnt;
+	sample->rx_irqs = ENET_RxIrqCnt;
+	sample->tx_frames = ENET_TxFrameCnt;
+	for (path = 0; path < 2; path++)
+	{
+		sample->rx_latency_cnt[path] = ENET_RxLatencyCnt[path];
+		sample->rx_latency_sum_us[path] = ENET_RxLatencySumUs[path];
+		sample->rx_latency_max_us[path] = ENET_RxLatencyMaxUs[path];
+		ENET_RxLatencyMaxUs[path] = 0;
+	}
+	taskEXIT_CRITICAL();
+	sample->fast_path = (net_bench_fast_path != pdFALSE);
+	sample->sink_frames = net_bench_sink_frames;
+	sample->coal_level = ENET_CoalLevel;
+	sample->coal_adaptive = ENET_CoalAdaptive;
+	sample->echo_frames = net_bench_echo_frames;
+	sample->checksum_offload = ENET_ChecksumOffload;
+	sample->tick_hz = configCPU_CLOCK_HZ;
+}
+
+static void net_bench_reply(Socket_t sock, const struct freertos_sockaddr *host)
+{
+	uint8_t *p_tx_data;
+	boot_net_bench_sample_t sample;
+	p_tx_data = FreeRTOS_GetUDPPayloadBuffer(sizeof(sample), 0);
+	if (p_tx_data == NULL)
+	{
+		// the host times out and asks again
+		return;
+	}
+	net_bench_sample(&sample);
+	memcpy(p_tx_data, &sample, sizeof(sample));
+	if (FreeRTOS_sendto(sock, p_tx_data, sizeof(sample), FREERTOS_ZERO_COPY, host, NULL, NULL) == 0)
+	{
+		FreeRTOS_ReleaseUDPPayloadBuffer(p_tx_data);
+	}
+}
+
+static void boot_net_bench_task(void *param)
+{
+	Socket_t sock;
+	struct freertos_sockaddr local_addr;
+	struct freertos_mmsghdr rx_msgs[BOOT_NET_BENCH_BATCH];
+	TickType_t rx_timeout = portMAX_DELAY;
+	const uint8_t *p_rx_data;
+	int32_t rx_cnt;
+	int32_t n;
+	(void)param;
+
+	sock = FreeRTOS_socket(FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP);
+	FreeRTOS_setsockopt(sock, 0, FREERTOS_SO_RCVTIMEO, &rx_timeout, 0);
+	memset(&local_addr, 0, sizeof(local_addr));
+	local_addr.sin_port = FreeRTOS_htons(BOOT_NET_BENCH_PORT);
+	FreeRTOS_bind(sock, &local_addr, sizeof(local_addr));
+#if (ipconfigUDP_FAST_PATH == 1)
+	net_bench_fast_path = pdTRUE;
+	FreeRTOS_setsockopt(sock, 0, FREERTOS_SO_UDP_FAST_PATH, &net_bench_fast_path, 0);
+#endif
+	while (1)
+	{
+		rx_cnt = FreeRTOS_recvmmsg(sock, rx_msgs, BOOT_NET_BENCH_BATCH, 0, NULL, NULL);
+		for (n = 0; n < rx_cnt; n++)
+		{
+			p_rx_data = (const uint8_t *)rx_msgs[n].pvData;
+			if ((rx_msgs[n].xLength >= 1) && (p_rx_data[0] == BOOT_NET_BENCH_CMD_SAMPLE))
+			{
+				net_bench_reply(sock, &rx_msgs[n].xAddress);
+			}
+			else if ((rx_msgs[n].xLength >= 2) && (p_rx_data[0] == BOOT_NET_BENCH_CMD_MODERATION))
+			{
+				// picked up by the next sample window of prvAdaptCoalescing()
+				ENET_CoalAdaptive = (p_rx_data[1] != 0);
+				net_bench_reply(sock, &rx_msgs[n].xAddress);
+			}
+			else if ((rx_msgs[n].xLength >= 2) && (p_rx_data[0] == BOOT_NET_BENCH_CMD_OFFLOAD))
+			{
+				ENET_ChecksumOffload = (p_rx_data[1] != 0);
+				net_bench_reply(sock, &rx_msgs[n].xAddress);
+			}
+			else if ((rx_msgs[n].xLength >= 2) && (p_rx_data[0] == BOOT_NET_BENCH_CMD_ECHO))
+			{
+				net_bench_echo = (p_rx_data[1] != 0);
+				net_bench_reply(sock, &rx_msgs[n].xAddress);
+			}
+#if (ipconfigUDP_FAST_PATH == 1)
+			else if ((rx_msgs[n].xLength >= 2) && (p_rx_data[0] == BOOT_NET_BENCH_CMD_FAST_PATH))
+			{
+				net_bench_fast_path = (p_rx_data[1] != 0) ? pdTRUE : pdFALSE;
+				FreeRTOS_setsockopt(sock, 0, FREERTOS_SO_UDP_FAST_PATH, &net_bench_fast_path, 0);
+				net_bench_reply(sock, &rx_msgs[n].xAddress);
+			}
+#endif
+			else
+			{
+				net_bench_sink_frames++;
+				if (net_bench_echo &&
+					(FreeRTOS_sendto(sock, rx_msgs[n].pvData, rx_msgs[n].xLength, FREERTOS_ZERO_COPY, &rx_msgs[n].xAddress, NULL, NULL) != 0))
+				{
+					// the buffer now belongs to the stack
+					net_bench_echo_frames++;
+					continue;
+				}
+			}
+			FreeRTOS_ReleaseUDPPayloadBuffer(rx_msgs[n].pvData);
+		}
+	}
+}
+
+void boot_net_bench_init(void)
+{
+	xTaskCreate(boot_net_bench_task, "net_bench", BOOT_NET_BENCH_STACK, NULL, BOOT_NET_BENCH_PRIO, NULL);
+}
+
+#else
+
+void boot_net_bench_init(void)
+{
+}
+
+#endif /* BOOT_NET_BENCH */
@@ -0,0 +1,55 @@
+/*
+ * boot_net_bench.h
+ *
+ *  CPU load of the network core against the received frame rate, built with
+ *  make NET_BENCH=1. The host tool (tool/vci8_load) offers small datagrams at
+ *  stepped rates to BOOT_NET_BENCH_PORT, a sink task on core 0 counts and
+ *  drops them, and a sample of the idle task time of core 0 and the ENET
+ *  counters is read before and after every step, with the adaptive interrupt
+ *  coalescing of NetworkInterface.c on or off. For the packet rate with and
+ *  without checksum offload the sink echoes the load back, and the checksums
+ *  are computed and checked by the driver in software when the offload is off.
+ *  The receive interrupt to sink latency (ipconfigMEASURE_RX_LATENCY) is read
+ *  with the sink socket on the fast path and through the IP-task.
+ */
+
+#ifndef BOOT_NET_BENCH_H_
+#define BOOT_NET_BENCH_H_
+#include <stdint.h>
+
+#define BOOT_NET_BENCH_PORT (14231)
+#define BOOT_NET_BENCH_STACK (512)
+#define BOOT_NET_BENCH_PRIO (3) // below boot_main_task, like an application task
+
+// Commands, first byte of a datagram from the host. Any other datagram is load.
+#define BOOT_NET_BENCH_CMD_LOAD (0)
+#define BOOT_NET_BENCH_CMD_SAMPLE (1)     // replies a boot_net_bench_sample_t
+#define BOOT_NET_BENCH_CMD_MODERATION (2) // second byte: 0 - interrupt per frame, 1 - adaptive; replies a sample
+#define BOOT_NET_BENCH_CMD_OFFLOAD (3)    // second byte: 0 - software checksums, 1 - MAC; replies a sample
+#define BOOT_NET_BENCH_CMD_ECHO (4)       // second byte: 1 - the load is sent back to its sender; replies a sample
+#define BOOT_NET_BENCH_CMD_FAST_PATH (5)  // second byte: 1 - FREERTOS_SO_UDP_FAST_PATH on the sink socket; replies a sample
+
+// Reply of a command, big endian, the counters are free running
+typedef struct
+{
+	uint32_t time_ticks; // run time counter (time stamp ticks, see tick_hz)
+	uint32_t idle_ticks; // run time of the idle task of core 0
+	uint32_t rx_frames;  // ENET_RxFrameCnt
+	uint32_t rx_irqs;    // ENET_RxIrqCnt
+	uint32_t sink_frames; // load datagrams which reached the sink task
+	uint32_t coal_level; // ENET_CoalLevel
+	uint32_t coal_adaptive; // ENET_CoalAdaptive
+	uint32_t tx_frames;  // ENET_TxFrameCnt
+	uint32_t echo_frames; // load datagrams sent back
+	uint32_t checksum_offload; // ENET_ChecksumOffload
+	uint32_t fast_path;  // the sink socket is on the fast path
+	uint32_t rx_latency_cnt[2]; // ENET_RxLatencyCnt, [0] - through the IP-task, [1] - fast path
+	uint32_t rx_latency_sum_us[2]; // ENET_RxLatencySumUs
+	uint32_t rx_latency_max_us[2]; // ENET_RxLatencyMaxUs since the previous sample
+	uint32_t tick_hz;
+} boot_net_bench_sample_t;
+
+// Creates the sink task, call after FreeRTOS_IPInit() on core 0.
+void boot_net_bench_init(void);
+
+#endif /* BOOT_NET_BENCH_H_ */
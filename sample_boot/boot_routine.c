@@ -0,0 +1,527 @@
+/*
+ * boot_routine.c
+ *
+ *  Routine jobs are queued by the service handler on core 0 and executed by
+ *  the workers on the cores selected in BOOT_ROUTINE_CORE_MASK. The queue and
+ *  the state objects live in the shared SRAM (no data cache in the boot), a
+ *  SEMA42 gate serializes the cores and a critical section the local tasks.
+ */
+#include <string.h>
+#include "drivers.h"
+#include "rtos.h"
+#include "boot_board.h"
+#include "boot_app.h"
+#include "boot_routine.h"
+#include "flash_drv.h"
+#include "crc32.h"
+#if defined(BOOT_CHANNEL_BENCH)
+#include "core_channel.h"
+#endif
+
+#if (BOOT_ROUTINE_CORE_MASK & 0x01)
+#error "Core 0 can not run a routine worker, it is reserved for the network."
+#endif
+#if ((BOOT_ROUTINE_CORE_MASK & (1U << 1)) && !defined(TURN_ON_CPU1)) || ((BOOT_ROUTINE_CORE_MASK & (1U << 2)) && !defined(TURN_ON_CPU2))
+#error "Routine worker core is not enabled, check TURN_ON_CPUx in the Makefile."
+#endif
+#if defined(BOOT_CHANNEL_BENCH) && (configUSE_CORE_CHANNELS != 1)
+#error "BOOT_CHANNEL_BENCH needs configUSE_CORE_CHANNELS."
+#endif
+
+typedef struct
+{
+	uint8_t routine;
+	uint32_t arg[3];
+} boot_routine_job_t;
+
+#if defined(TURN_ON_CPU1)
+extern void _startcore1(void);
+#endif
+#if defined(TURN_ON_CPU2)
+extern void _startcore2(void);
+#endif
+
+boot_routine_state_t boot_routine_state[BOOT_ROUTINE_NUM];
+
+static boot_routine_job_t routine_job_queue[BOOT_ROUTINE_QUEUE_LEN];
+static volatile uint32_t routine_job_head;
+static volatile uint32_t routine_job_tail;
+static volatile uint8_t routine_cores_ready; // bit n - worker of core n is running
+static uint8_t routine_copy_buf[BOOT_ROUTINE_CHUNK_SIZE]; // COPY runs on one core at a time
+
+#if defined(BOOT_CHANNEL_BENCH)
+typedef struct
+{
+	uint32_t seq;
+	uint32_t core; // core of the sender, the pong task answers to it
+} routine_bench_item_t;
+
+#define ROUTINE_BENCH_STORAGE_SIZE coreCHANNEL_STORAGE_SIZE(BOOT_ROUTINE_BENCH_LANE_LEN, sizeof(routine_bench_item_t), configSMP_CORE_NUMBER - 1)
+
+// Indexed by the consumer core: the pings are read by the pong task, the replies by the worker running the bench.
+SHARED_DATA_SECTION static CoreChannel_t routine_bench_ping_buf[configSMP_CORE_NUMBER];
+SHARED_DATA_SECTION static CoreChannel_t routine_bench_reply_buf[configSMP_CORE_NUMBER];
+SHARED_DATA_SECTION static uint8_t routine_bench_ping_storage[configSMP_CORE_NUMBER][ROUTINE_BENCH_STORAGE_SIZE];
+SHARED_DATA_SECTION static uint8_t routine_bench_reply_storage[configSMP_CORE_NUMBER][ROUTINE_BENCH_STORAGE_SIZE];
+static CoreChannelHandle_t routine_bench_ping[configSMP_CORE_NUMBER];
+static CoreChannelHandle_t routine_bench_reply[configSMP_CORE_NUMBER];
+static boot_routine_bench_t routine_bench; // written by the bench before it completes
+#endif
+
+static void routine_lock(void)
+{
+	taskENTER_CRITICAL();
+	while (STATUS_SUCCESS != SEMA42_DRV_LockGate(0U, BOARD_SEMA42_GATE_ROUTINE))
+	{
+	}
+}
+
+static void routine_unlock(void)
+{
+	(void)SEMA42_DRV_UnlockGate(0U, BOARD_SEMA42_GATE_ROUTINE);
+	taskEXIT_CRITICAL();
+}
+
+static int routine_job_pop(boot_routine_job_t *job)
+{
+	int ret = 0;
+	routine_lock();
+	if (routine_job_tail != routine_job_head)
+	{
+		*job = routine_job_queue[routine_job_tail % BOOT_ROUTINE_QUEUE_LEN];
+		++routine_job_tail;
+		boot_routine_state[job->routine].state = BOOT_ROUTINE_STATE_RUNNING;
+		ret = 1;
+	}
+	routine_unlock();
+	return ret;
+}
+
+// CRC32 of a memory range in chunks, 0 if stopped before the end.
+static int routine_crc(boot_routine_state_t *state, uint32_t addr, uint32_t size, uint32_t *crc)
+{
+	uint32_t len;
+	*crc = 0xFFFFFFFF;
+	while (state->progress < size)
+	{
+		if (state->stop_req)
+		{
+			return 0;
+		}
+		len = size - state->progress;
+		if (len > BOOT_ROUTINE_CHUNK_SIZE)
+		{
+			len = BOOT_ROUTINE_CHUNK_SIZE;
+		}
+		*crc = crc32(*crc, (const unsigned char *)(addr + state->progress), len);
+		state->progress += len;
+	}
+	return 1;
+}
+
+// Erases sector by sector, so a stop request is seen between two sectors.
+static int routine_erase(boot_routine_state_t *state, uint32_t addr, uint32_t size)
+{
+	uint32_t end;
+	while (state->progress < size)
+	{
+		if (state->stop_req)
+		{
+			return STATUS_ERROR;
+		}
+		end = flash_drv_sector_end(addr + state->progress) - addr;
+		if ((end <= state->progress) || (end > size))
+		{
+			// outside the sector table, the rest goes in one erase
+			end = size;
+		}
+		state->error_code = flash_erase(addr + state->progress, end - state->progress);
+		if (STATUS_SUCCESS != state->error_code)
+		{
+			return state->error_code;
+		}
+		state->progress = end;
+	}
+	return STATUS_SUCCESS;
+}
+
+static int routine_copy(boot_routine_state_t *state, uint32_t src, uint32_t dest, uint32_t size)
+{
+	uint32_t len;
+	while (state->progress < size)
+	{
+		if (state->stop_req)
+		{
+			return STATUS_ERROR;
+		}
+		len = size - state->progress;
+		if (len > BOOT_ROUTINE_CHUNK_SIZE)
+		{
+			len = BOOT_ROUTINE_CHUNK_SIZE;
+		}
+		// stage in RAM, the source may be in the partition being programmed
+		memcpy(routine_copy_buf, (const void *)(src + state->progress), len);
+		state->error_code = flash_write(dest + state->progress, routine_copy_buf, len);
+		if (STATUS_SUCCESS != state->error_code)
+		{
+			return state->error_code;
+		}
+		state->progress += len;
+	}
+	return STATUS_SUCCESS;
+}
+
+#if defined(BOOT_CHANNEL_BENCH)
+static uint32_t routine_bench_ns(uint64_t ticks)
+{
+	return (uint32_t)((ticks * 1000000000ULL) / configCPU_CLOCK_HZ);
+}
+
+static int routine_bench_send(uint8_t peer, uint8_t core, uint32_t seq)
+{
+	routine_bench_item_t item;
+	item.seq = seq;
+	item.core = core;
+	return (pdPASS == xCoreChannelSend(routine_bench_ping[peer], &item, pdMS_TO_TICKS(BOOT_ROUTINE_BENCH_TIMEOUT)));
+}
+
+static int routine_bench_reply_check(uint8_t core, uint32_t seq)
+{
+	routine_bench_item_t item;
+	if (pdPASS != xCoreChannelReceive(routine_bench_reply[core], &item, pdMS_TO_TICKS(BOOT_ROUTINE_BENCH_TIMEOUT)))
+	{
+		return 0;
+	}
+	return (item.seq == seq);
+}
+
+// Round trips through the pong task of another worker core: one item at a
+// time for the latency, then BOOT_ROUTINE_BENCH_LANE_LEN items in flight for
+// the throughput. Progress counts the round trips of both phases.
+static int routine_bench_run(boot_routine_state_t *state, uint32_t rounds)
+{
+	const uint8_t core = (uint8_t)ucPortGetCoreId();
+	routine_bench_item_t item;
+	uint8_t peer;
+	uint32_t sent, received, rtt;
+	uint64_t sum = 0, t0;
+
+	for (peer = 1; peer < configSMP_CORE_NUMBER; peer++)
+	{
+		if ((peer != core) && (routine_cores_ready & (1U << peer)))
+		{
+			break;
+		}
+	}
+	if ((peer >= configSMP_CORE_NUMBER) || (rounds == 0))
+	{
+		return STATUS_ERROR;
+	}
+	// replies left over by a stopped run
+	while (pdPASS == xCoreChannelReceive(routine_bench_reply[core], &item, BOOT_ROUTINE_POLL_TICKS))
+	{
+	}
+
+	routine_bench.rtt_min_ns = 0xFFFFFFFF;
+	routine_bench.rtt_max_ns = 0;
+	for (received = 0; received < rounds; received++)
+	{
+		if (state->stop_req)
+		{
+			return STATUS_ERROR;
+		}
+		t0 = ullPortGetTimeStampTicks();
+		if (!routine_bench_send(peer, core, received) || !routine_bench_reply_check(core, received))
+		{
+			return STATUS_ERROR;
+		}
+		rtt = routine_bench_ns(ullPortGetTimeStampTicks() - t0);
+		sum += rtt;
+		if (rtt < routine_bench.rtt_min_ns)
+		{
+			routine_bench.rtt_min_ns = rtt;
+		}
+		if (rtt > routine_bench.rtt_max_ns)
+		{
+			routine_bench.rtt_max_ns = rtt;
+		}
+		++state->progress;
+	}
+	routine_bench.rtt_avg_ns = (uint32_t)(sum / rounds);
+
+	sent = 0;
+	t0 = ullPortGetTimeStampTicks();
+	for (received = 0; received < rounds; received++)
+	{
+		if (state->stop_req)
+		{
+			return STATUS_ERROR;
+		}
+		for (; (sent < rounds) && (sent - received < BOOT_ROUTINE_BENCH_LANE_LEN); sent++)
+		{
+			if (!routine_bench_send(peer, core, sent))
+			{
+				return STATUS_ERROR;
+			}
+		}
+		if (!routine_bench_reply_check(core, received))
+		{
+			return STATUS_ERROR;
+		}
+		++state->progress;
+	}
+	t0 = ullPortGetTimeStampTicks() - t0;
+	routine_bench.items_per_s = (uint32_t)(((uint64_t)rounds * configCPU_CLOCK_HZ) / ((t0 != 0) ? t0 : 1));
+	return STATUS_SUCCESS;
+}
+
+// Sends the items of the ping channel of its core back to their sender.
+static void boot_routine_pong_task(void *param)
+{
+	const uint8_t core = (uint8_t)ucPortGetCoreId();
+	routine_bench_item_t item;
+	(void)param;
+	while (1)
+	{
+		if ((pdPASS == xCoreChannelReceive(routine_bench_ping[core], &item, portMAX_DELAY)) && (item.core < configSMP_CORE_NUMBER))
+		{
+			(void)xCoreChannelSend(routine_bench_reply[item.core], &item, portMAX_DELAY);
+		}
+	}
+}
+#endif
+
+static void routine_run(const boot_routine_job_t *job)
+{
+	boot_routine_state_t *state = &boot_routine_state[job->routine];
+	uint32_t tmp_u32[4];
+	uint32_t crc = 0;
+	uint8_t result = BOOT_ROUTINE_RESULT_FAIL;
+
+	if (!state->stop_req)
+	{
+		switch (job->routine)
+		{
+		case BOOT_ROUTINE_ERASE:
+			if (STATUS_SUCCESS == routine_erase(state, job->arg[0], job->arg[1]))
+			{
+				result = BOOT_ROUTINE_RESULT_OK;
+			}
+			break;
+		case BOOT_ROUTINE_CHECKSUM:
+			if (job->arg[0] == job->arg[1])
+			{
+				tmp_u32[0] = APP_VALID_PATTERN;
+				tmp_u32[1] = (~APP_VALID_PATTERN);
+				tmp_u32[2] = job->arg[2];
+				tmp_u32[3] = job->arg[1];
+				state->error_code = flash_write(APP_VALID_FLAG_ADDR, tmp_u32, 16);
+				if (STATUS_SUCCESS == state->error_code)
+				{
+					result = BOOT_ROUTINE_RESULT_OK;
+				}
+			}
+			break;
+		case BOOT_ROUTINE_CRC:
+			if (routine_crc(state, job->arg[0], job->arg[1], &crc))
+			{
+				result = BOOT_ROUTINE_RESULT_OK;
+			}
+			break;
+		case BOOT_ROUTINE_VERIFY:
+			if (routine_crc(state, job->arg[0], job->arg[1], &crc) && (crc == job->arg[2]))
+			{
+				result = BOOT_ROUTINE_RESULT_OK;
+			}
+			break;
+		case BOOT_ROUTINE_COPY:
+			if (STATUS_SUCCESS == routine_copy(state, job->arg[0], job->arg[1], job->arg[2]))
+			{
+				result = BOOT_ROUTINE_RESULT_OK;
+			}
+			break;
+#if defined(BOOT_CHANNEL_BENCH)
+		case BOOT_ROUTINE_BENCH:
+			if (STATUS_SUCCESS == routine_bench_run(state, job->arg[0]))
+			{
+				result = BOOT_ROUTINE_RESULT_OK;
+			}
+			break;
+#endif
+		default:
+			break;
+		}
+	}
+	routine_lock();
+	state->crc = crc;
+	state->result = result;
+	state->state = BOOT_ROUTINE_STATE_COMPLETE;
+	routine_unlock();
+}
+
+static void boot_routine_worker_task(void *param)
+{
+	boot_routine_job_t job;
+	(void)param;
+	routine_lock();
+	routine_cores_ready |= (uint8_t)(1U << ucPortGetCoreId());
+	routine_unlock();
+	while (1)
+	{
+		if (routine_job_pop(&job))
+		{
+			routine_run(&job);
+		}
+		else
+		{
+			vTaskDelay(BOOT_ROUTINE_POLL_TICKS);
+		}
+	}
+}
+
+static void routine_wait_core_ready(uint8_t core)
+{
+	TickType_t start = xTaskGetTickCount();
+	while (((routine_cores_ready & (1U << core)) == 0) &&
+		   ((xTaskGetTickCount() - start) < pdMS_TO_TICKS(BOOT_ROUTINE_START_TIMEOUT)))
+	{
+		vTaskDelay(1);
+	}
+}
+
+void boot_routine_init(void)
+{
+	unsigned int i;
+	routine_job_head = 0;
+	routine_job_tail = 0;
+	for (i = 0; i < BOOT_ROUTINE_NUM; i++)
+	{
+		boot_routine_state[i].state = BOOT_ROUTINE_STATE_IDLE;
+		boot_routine_state[i].result = BOOT_ROUTINE_RESULT_NONE;
+		boot_routine_state[i].stop_req = 0;
+		boot_routine_state[i].error_code = 0;
+		boot_routine_state[i].progress = 0;
+		boot_routine_state[i].crc = 0;
+	}
+#if defined(BOOT_CHANNEL_BENCH)
+	// created before the cores start, each worker core talks to the other ones
+	for (i = 1; i < configSMP_CORE_NUMBER; i++)
+	{
+		if (BOOT_ROUTINE_CORE_MASK & (1U << i))
+		{
+			routine_bench_ping[i] = xCoreChannelCreateStatic(&routine_bench_ping_buf[i], routine_bench_ping_storage[i], BOOT_ROUTINE_BENCH_LANE_LEN,
+															 sizeof(routine_bench_item_t), BOOT_ROUTINE_CORE_MASK & ~(1U << i), i);
+			routine_bench_reply[i] = xCoreChannelCreateStatic(&routine_bench_reply_buf[i], routine_bench_reply_storage[i], BOOT_ROUTINE_BENCH_LANE_LEN,
+															  sizeof(routine_bench_item_t), BOOT_ROUTINE_CORE_MASK & ~(1U << i), i);
+		}
+	}
+#endif
+}
+
+// Called from core 0 before the IP stack is started. The cores are released
+// one after the other and each one is waited for, so that routine_cores_ready
+// is final when the first job is queued. Each core allocates its tasks from
+// its own heap arena (heap_tlsf.c).
+void boot_routine_start_cores(void)
+{
+#if defined(TURN_ON_CPU1) && (BOOT_ROUTINE_CORE_MASK & (1U << 1))
+	board_start_core(1, _startcore1);
+	routine_wait_core_ready(1);
+#endif
+#if defined(TURN_ON_CPU2) && (BOOT_ROUTINE_CORE_MASK & (1U << 2))
+	board_start_core(2, _startcore2);
+	routine_wait_core_ready(2);
+#endif
+}
+
+// main() of the secondary cores.
+void boot_routine_core_main(void)
+{
+	xTaskCreate(boot_routine_worker_task, "routine", BOOT_ROUTINE_WORKER_STACK, NULL, BOOT_ROUTINE_WORKER_PRIO, NULL);
+#if defined(BOOT_CHANNEL_BENCH)
+	xTaskCreate(boot_routine_pong_task, "pong", BOOT_ROUTINE_BENCH_STACK, NULL, BOOT_ROUTINE_BENCH_PRIO, NULL);
+#endif
+	vTaskStartScheduler();
+}
+
+status_t boot_routine_start(uint8_t routine, const uint32_t *arg, uint8_t arg_num)
+{
+	status_t ret = STATUS_SUCCESS;
+	boot_routine_job_t *job;
+	uint8_t i;
+	if ((routine >= BOOT_ROUTINE_NUM) || (arg_num > 3))
+	{
+		return STATUS_ERROR;
+	}
+	routine_lock();
+	if (routine_cores_ready == 0)
+	{
+		// no worker came up
+		ret = STATUS_ERROR;
+	}
+	else if ((boot_routine_state[routine].state == BOOT_ROUTINE_STATE_PENDING) ||
+			 (boot_routine_state[routine].state == BOOT_ROUTINE_STATE_RUNNING) ||
+			 (routine_job_head - routine_job_tail >= BOOT_ROUTINE_QUEUE_LEN))
+	{
+		ret = STATUS_BUSY;
+	}
+	else
+	{
+		job = &routine_job_queue[routine_job_head % BOOT_ROUTINE_QUEUE_LEN];
+		job->routine = routine;
+		for (i = 0; i < arg_num; i++)
+		{
+			job->arg[i] = arg[i];
+		}
+		boot_routine_state[routine].state = BOOT_ROUTINE_STATE_PENDING;
+		boot_routine_state[routine].result = BOOT_ROUTINE_RESULT_NONE;
+		boot_routine_state[routine].stop_req = 0;
+		boot_routine_state[routine].error_code = 0;
+		boot_routine_state[routine].progress = 0;
+		++routine_job_head;
+	}
+	routine_unlock();
+	return ret;
+}
+
+void boot_routine_stop(uint8_t routine)
+{
+	if (routine < BOOT_ROUTINE_NUM)
+	{
+		boot_routine_state[routine].stop_req = 1;
+	}
+}
+
+// Returns the routine state. A completed routine reports its result once and goes back to idle.
+uint8_t boot_routine_get_result(uint8_t routine, uint8_t *result, uint32_t *crc)
+{
+	uint8_t ret;
+	if (routine >= BOOT_ROUTINE_NUM)
+	{
+		return BOOT_ROUTINE_STATE_IDLE;
+	}
+	routine_lock();
+	ret = boot_routine_state[routine].state;
+	if (BOOT_ROUTINE_STATE_COMPLETE == ret)
+	{
+		*result = boot_routine_state[routine].result;
+		*crc = boot_routine_state[routine].crc;
+		boot_routine_state[routine].state = BOOT_ROUTINE_STATE_IDLE;
+	}
+	else
+	{
+		*result = BOOT_ROUTINE_RESULT_NONE;
+		*crc = 0;
+	}
+	routine_unlock();
+	return ret;
+}
+
+#if defined(BOOT_CHANNEL_BENCH)
+void boot_routine_get_bench(boot_routine_bench_t *bench)
+{
+	routine_lock();
+	*bench = routine_bench;
+	routine_unlock();
+}
+#endif
@@ -0,0 +1,92 @@
+/*
+ * boot_routine.h
+ *
+ *  Asynchronous routine engine: a bounded job queue shared by the cores and
+ *  one worker task on each secondary core, so long flash operations never
+ *  run in boot_main_task on core 0.
+ */
+
+#ifndef BOOT_ROUTINE_H_
+#define BOOT_ROUTINE_H_
+#include <stdint.h>
+#include "status.h"
+
+// Cores running a routine worker (bit n - core n). Core 0 is reserved for the network.
+#define BOOT_ROUTINE_CORE_MASK ((1U << 1) | (1U << 2))
+#define BOOT_ROUTINE_QUEUE_LEN (8)
+#define BOOT_ROUTINE_CHUNK_SIZE (4096) // bytes processed between stop/progress checks
+#define BOOT_ROUTINE_POLL_TICKS (1)
+#define BOOT_ROUTINE_START_TIMEOUT (1000) // ms to wait for the secondary cores at startup
+#define BOOT_ROUTINE_WORKER_STACK (1024)
+#define BOOT_ROUTINE_WORKER_PRIO (3)
+
+// Build with -DBOOT_CHANNEL_BENCH to add the core channel ping-pong routine,
+// BOOT_ROUTINE_BENCH. It needs two worker cores: the worker running it sends
+// items to the pong task of the other worker core, which sends them back.
+#if defined(BOOT_CHANNEL_BENCH)
+#define BOOT_ROUTINE_BENCH_LANE_LEN (16) // items of a channel lane, also the throughput window
+#define BOOT_ROUTINE_BENCH_TIMEOUT (100) // ms to wait for the pong task
+#define BOOT_ROUTINE_BENCH_STACK (256)
+#define BOOT_ROUTINE_BENCH_PRIO (BOOT_ROUTINE_WORKER_PRIO + 1)
+#endif
+
+// Routine ID = ROUTINE_ID_BASE + index
+#define BOOT_ROUTINE_ID_BASE (0xFF00)
+
+typedef enum
+{
+	BOOT_ROUTINE_ERASE = 0,    // addr, size
+	BOOT_ROUTINE_CHECKSUM = 1, // expected crc, image crc, image size
+	BOOT_ROUTINE_CRC = 2,      // addr, size
+	BOOT_ROUTINE_VERIFY = 3,   // addr, size, expected crc
+	BOOT_ROUTINE_COPY = 4,     // src, dest, size
+#if defined(BOOT_CHANNEL_BENCH)
+	BOOT_ROUTINE_BENCH = 5,    // rounds
+#endif
+	BOOT_ROUTINE_NUM
+} boot_routine_index_t;
+
+typedef enum
+{
+	BOOT_ROUTINE_STATE_IDLE = 0,
+	BOOT_ROUTINE_STATE_PENDING = 1,
+	BOOT_ROUTINE_STATE_RUNNING = 2,
+	BOOT_ROUTINE_STATE_COMPLETE = 3,
+} boot_routine_state_id_t;
+
+#define BOOT_ROUTINE_RESULT_NONE (0)
+#define BOOT_ROUTINE_RESULT_OK (1)
+#define BOOT_ROUTINE_RESULT_FAIL (2)
+
+typedef struct
+{
+	volatile uint8_t state;    // boot_routine_state_id_t
+	volatile uint8_t result;   // BOOT_ROUTINE_RESULT_xxx
+	volatile uint8_t stop_req;
+	volatile int error_code;
+	volatile uint32_t progress; // bytes processed
+	volatile uint32_t crc;
+} boot_routine_state_t;
+
+#if defined(BOOT_CHANNEL_BENCH)
+// Result of the last BOOT_ROUTINE_BENCH
+typedef struct
+{
+	uint32_t rtt_min_ns; // round trip of one item
+	uint32_t rtt_avg_ns;
+	uint32_t rtt_max_ns;
+	uint32_t items_per_s; // round trips with BOOT_ROUTINE_BENCH_LANE_LEN items in flight
+} boot_routine_bench_t;
+#endif
+
+void boot_routine_init(void);
+void boot_routine_start_cores(void);
+void boot_routine_core_main(void);
+status_t boot_routine_start(uint8_t routine, const uint32_t *arg, uint8_t arg_num);
+void boot_routine_stop(uint8_t routine);
+uint8_t boot_routine_get_result(uint8_t routine, uint8_t *result, uint32_t *crc);
+#if defined(BOOT_CHANNEL_BENCH)
+void boot_routine_get_bench(boot_routine_bench_t *bench);
+#endif
+
+#endif /* BOOT_ROUTINE_H_ */
@@ -0,0 +1,320 @@
+/*
+ * boot_rtos_bench.c
+ *
+ *  Bench task of the kernel and port cycle counts. The commands of the host
+ *  run one after the other on core 0, next to the network, so the minimum is
+ *  the path itself and the maximum shows the interrupts that hit it.
+ */
+#include <string.h>
+#include "drivers.h"
+#include "rtos.h"
+#include "tcpip.h"
+#include "boot_rtos_bench.h"
+
+#if defined(BOOT_RTOS_BENCH)
+
+#define RTOS_BENCH_SPR_TBL (268)
+#define RTOS_BENCH_SPR_HID0 (1008)
+#define RTOS_BENCH_HID0_TBEN (0x00004000UL) // time base enabled, counting the core clock while SEL_TBCLK is 0
+
+// irq bench: channel 3 of STM_0, the counter the trace recorder runs too
+#define RTOS_BENCH_STM_CHANNEL (3u)
+#define RTOS_BENCH_STM_IRQn (STM0_Ch3_IRQn)
+#define RTOS_BENCH_STM_PERIOD (2000u) // counts to the next sample, plus a jitter of up to 255
+#define RTOS_BENCH_IRQ_PRIO_LOW (configMAX_API_CALL_INTERRUPT_PRIORITY)
+#define RTOS_BENCH_IRQ_PRIO_HIGH (11u) // above the ceiling and the PTP vectors (9, 10)
+
+typedef struct
+{
+	uint32_t cnt;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+} rtos_bench_stat_t;
+
+static TaskHandle_t rtos_bench_handle;
+static rtos_bench_stat_t rtos_bench_stat[BOOT_RTOS_BENCH_CASES];
+static uint32_t rtos_bench_rounds;
+static volatile uint64_t rtos_bench_sink; // keeps the results of the calls under test
+
+// switch bench, shared by the two tasks of a pair
+static volatile uint32_t rtos_switch_t0;
+static volatile uint32_t rtos_switch_running;
+static rtos_bench_stat_t *rtos_switch_stat;
+
+// irq bench, the handler counts the samples down
+static volatile uint32_t rtos_irq_remaining;
+static rtos_bench_stat_t *rtos_irq_stat;
+static volatile uint32_t rtos_load_running;
+
+static inline uint32_t rtos_bench_cycles(void)
+{
+	uint32_t tbl;
+	portGetSPR(tbl, RTOS_BENCH_SPR_TBL);
+	return tbl;
+}
+
+static void rtos_bench_stat_add(rtos_bench_stat_t *stat, uint32_t cycles)
+{
+	if ((stat->cnt == 0) || (cycles < stat->min))
+	{
+		stat->min = cycles;
+	}
+	if (cycles > stat->max)
+	{
+		stat->max = cycles;
+	}
+	stat->sum += cycles;
+	stat->cnt++;
+}
+
+// Yields to the other task of the pair rtos_bench_rounds times. Back from
+// taskYIELD(), the time since the other task yielded is one task switch.
+static void rtos_switch_task(void *param)
+{
+	uint32_t i;
+	uint32_t t1;
+	uint32_t running;
+	if (param != NULL)
+	{
+		portTASK_USES_FLOATING_POINT();
+	}
+	for (i = 0; i < rtos_bench_rounds; i++)
+	{
+		rtos_switch_t0 = rtos_bench_cycles();
+		taskYIELD();
+		t1 = rtos_bench_cycles();
+		// not a switch from the other task once it has left the loop
+		if (rtos_switch_running == 2)
+		{
+			rtos_bench_stat_add(rtos_switch_stat, t1 - rtos_switch_t0);
+		}
+	}
+	taskENTER_CRITICAL();
+	running = --rtos_switch_running;
+	taskEXIT_CRITICAL();
+	if (running == 0)
+	{
+		xTaskNotifyGive(rtos_bench_handle);
+	}
+	vTaskDelete(NULL);
+}
+
+// One pair of tasks above the bench task, integer only or floating point.
+static int rtos_bench_switch(rtos_bench_stat_t *stat, uint8_t fpu)
+{
+	void *param = fpu ? (void *)1 : NULL;
+	BaseType_t ok;
+	rtos_switch_stat = stat;
+	rtos_switch_running = 2;
+	(void)ulTaskNotifyTake(pdTRUE, 0);
+	// both tasks are ready before the first one runs
+	vTaskSuspendAll();
+	ok = (pdPASS == xTaskCreate(rtos_switch_task, "switch_a", 256, param, BOOT_RTOS_BENCH_PRIO + 1, NULL)) &&
+		 (pdPASS == xTaskCreate(rtos_switch_task, "switch_b", 256, param, BOOT_RTOS_BENCH_PRIO + 1, NULL));
+	(void)xTaskResumeAll();
+	// a task which could not be created is never waited for
+	return ok && (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BOOT_RTOS_BENCH_TIMEOUT)) != 0);
+}
+
+// Above configMAX_API_CALL_INTERRUPT_PRIORITY in the high case, no API call.
+static void rtos_irq_handler(void)
+{
+	uint32_t now = STM_0->CNT;
+	uint32_t cmp = STM_0->CHANNEL[RTOS_BENCH_STM_CHANNEL].CMP;
+	STM_0->CHANNEL[RTOS_BENCH_STM_CHANNEL].CIR = STM_CIR_CIF(1u);
+	rtos_bench_stat_add(rtos_irq_stat, now - cmp);
+	if (--rtos_irq_remaining != 0)
+	{
+		// the low bits of the count move the next sample across the load loop
+		STM_0->CHANNEL[RTOS_BENCH_STM_CHANNEL].CMP = now + RTOS_BENCH_STM_PERIOD + (now & 0xFFu);
+	}
+	else
+	{
+		STM_0->CHANNEL[RTOS_BENCH_STM_CHANNEL].CCR = 0;
+	}
+}
+
+// Kernel bookkeeping below the bench task: every queue call runs a critical
+// section, which masks the interrupts up to the ceiling.
+static void rtos_load_task(void *param)
+{
+	QueueHandle_t queue = (QueueHandle_t)param;
+	uint32_t item = 0;
+	while (rtos_load_running)
+	{
+		(void)xQueueSend(queue, &item, 0);
+		(void)xQueueReceive(queue, &item, 0);
+	}
+	xTaskNotifyGive(rtos_bench_handle);
+	vTaskDelete(NULL);
+}
+
+// rtos_bench_rounds samples of the STM_0 interrupt at the given priority, the
+// bench task sleeps meanwhile and the load task takes the core.
+static int rtos_bench_irq(rtos_bench_stat_t *stat, uint8_t prio)
+{
+	QueueHandle_t queue;
+	TickType_t start;
+	int ok;
+	queue = xQueueCreate(1, sizeof(uint32_t));
+	if (queue == NULL)
+	{
+		return 0;
+	}
+	rtos_irq_stat = stat;
+	rtos_irq_remaining = rtos_bench_rounds;
+	rtos_load_running = 1;
+	(void)ulTaskNotifyTake(pdTRUE, 0);
+	if (pdPASS != xTaskCreate(rtos_load_task, "irq_load", 256, queue, BOOT_RTOS_BENCH_PRIO - 1, NULL))
+	{
+		vQueueDelete(queue);
+		return 0;
+	}
+	INT_SYS_SetPriority(RTOS_BENCH_STM_IRQn, prio);
+	STM_0->CHANNEL[RTOS_BENCH_STM_CHANNEL].CIR = STM_CIR_CIF(1u);
+	STM_0->CHANNEL[RTOS_BENCH_STM_CHANNEL].CMP = STM_0->CNT + RTOS_BENCH_STM_PERIOD;
+	STM_0->CHANNEL[RTOS_BENCH_STM_CHANNEL].CCR = STM_CCR_CEN(1u);
+	start = xTaskGetTickCount();
+	while ((rtos_irq_remaining != 0) && ((xTaskGetTickCount() - start) < pdMS_TO_TICKS(BOOT_RTOS_BENCH_TIMEOUT)))
+	{
+		vTaskDelay(1);
+	}
+	STM_0->CHANNEL[RTOS_BENCH_STM_CHANNEL].CCR = 0;
+	ok = (rtos_irq_remaining == 0);
+	rtos_load_running = 0;
+	// the load task always leaves, the queue is free once it did
+	(void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	vQueueDelete(queue);
+	return ok;
+}
+
+// rtos_bench_rounds calls of each timestamp function, one time base read
+// before and after the call.
+static int rtos_bench_timestamp(void)
+{
+	uint64_t ticks = 0;
+	uint32_t t0;
+	uint32_t t1;
+	uint32_t i;
+	for (i = 0; i < rtos_bench_rounds; i++)
+	{
+		t0 = rtos_bench_cycles();
+		t1 = rtos_bench_cycles();
+		rtos_bench_stat_add(&rtos_bench_stat[0], t1 - t0);
+		t0 = rtos_bench_cycles();
+		ticks = ullPortGetTimeStampTicks();
+		t1 = rtos_bench_cycles();
+		rtos_bench_stat_add(&rtos_bench_stat[1], t1 - t0);
+		t0 = rtos_bench_cycles();
+		rtos_bench_sink += ullPortTimeStampTicksToNanoSec(ticks);
+		t1 = rtos_bench_cycles();
+		rtos_bench_stat_add(&rtos_bench_stat[2], t1 - t0);
+		t0 = rtos_bench_cycles();
+		rtos_bench_sink += ullPortTimeStampTicksToMicroSec(ticks);
+		t1 = rtos_bench_cycles();
+		rtos_bench_stat_add(&rtos_bench_stat[3], t1 - t0);
+	}
+	return 1;
+}
+
+// Runs a command, returns the number of cases measured.
+static uint32_t rtos_bench_run(uint8_t cmd)
+{
+	uint32_t cases = 0;
+	memset(rtos_bench_stat, 0, sizeof(rtos_bench_stat));
+	switch (cmd)
+	{
+	case BOOT_RTOS_BENCH_CMD_SWITCH:
+		if (rtos_bench_switch(&rtos_bench_stat[0], 0) && rtos_bench_switch(&rtos_bench_stat[1], 1))
+		{
+			cases = 2;
+		}
+		break;
+	case BOOT_RTOS_BENCH_CMD_IRQ:
+		if (rtos_bench_irq(&rtos_bench_stat[0], RTOS_BENCH_IRQ_PRIO_LOW) &&
+			rtos_bench_irq(&rtos_bench_stat[1], RTOS_BENCH_IRQ_PRIO_HIGH))
+		{
+			cases = 2;
+		}
+		break;
+	case BOOT_RTOS_BENCH_CMD_TIMESTAMP:
+		if (rtos_bench_timestamp())
+		{
+			cases = 4;
+		}
+		break;
+	default:
+		break;
+	}
+	return cases;
+}
+
+static void boot_rtos_bench_task(void *param)
+{
+	Socket_t sock;
+	struct freertos_sockaddr local_addr;
+	struct freertos_sockaddr host;
+	TickType_t rx_timeout = portMAX_DELAY;
+	boot_rtos_bench_result_t result;
+	uint8_t req[8];
+	int32_t len;
+	uint32_t hid0;
+	uint32_t i;
+	(void)param;
+
+	rtos_bench_handle = xTaskGetCurrentTaskHandle();
+	portGetSPR(hid0, RTOS_BENCH_SPR_HID0);
+	portSetSPR(RTOS_BENCH_SPR_HID0, hid0 | RTOS_BENCH_HID0_TBEN);
+	if ((STM_0->CR & STM_CR_TEN_MASK) == 0U)
+	{
+		STM_0->CR = STM_CR_TEN(1U);
+	}
+	STM_0->CHANNEL[RTOS_BENCH_STM_CHANNEL].CCR = 0;
+	INT_SYS_InstallHandler(RTOS_BENCH_STM_IRQn, rtos_irq_handler, NULL);
+	INT_SYS_EnableIRQ(RTOS_BENCH_STM_IRQn);
+
+	sock = FreeRTOS_socket(FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP);
+	FreeRTOS_setsockopt(sock, 0, FREERTOS_SO_RCVTIMEO, &rx_timeout, 0);
+	memset(&local_addr, 0, sizeof(local_addr));
+	local_addr.sin_port = FreeRTOS_htons(BOOT_RTOS_BENCH_PORT);
+	FreeRTOS_bind(sock, &local_addr, sizeof(local_addr));
+	while (1)
+	{
+		len = FreeRTOS_recvfrom(sock, req, sizeof(req), 0, &host, NULL, NULL);
+		if (len != (int32_t)sizeof(req))
+		{
+			continue;
+		}
+		memset(&result, 0, sizeof(result));
+		result.cmd = req[0];
+		result.rounds = ((uint32_t)req[4] << 24) | ((uint32_t)req[5] << 16) | ((uint32_t)req[6] << 8) | req[7];
+		if ((result.rounds != 0) && (result.rounds <= BOOT_RTOS_BENCH_ROUNDS_MAX))
+		{
+			rtos_bench_rounds = result.rounds;
+			result.cases = rtos_bench_run(req[0]);
+		}
+		for (i = 0; i < result.cases; i++)
+		{
+			result.cnt[i] = rtos_bench_stat[i].cnt;
+			result.min_cycles[i] = rtos_bench_stat[i].min;
+			result.avg_cycles[i] = (rtos_bench_stat[i].cnt != 0) ? (uint32_t)(rtos_bench_stat[i].sum / rtos_bench_stat[i].cnt) : 0;
+			result.max_cycles[i] = rtos_bench_stat[i].max;
+		}
+		// big endian target, the fields go out in network order
+		FreeRTOS_sendto(sock, &result, sizeof(result), 0, &host, NULL, NULL);
+	}
+}
+
+void boot_rtos_bench_init(void)
+{
+	xTaskCreate(boot_rtos_bench_task, "rtos_bench", BOOT_RTOS_BENCH_STACK, NULL, BOOT_RTOS_BENCH_PRIO, NULL);
+}
+
+#else
+
+void boot_rtos_bench_init(void)
+{
+}
+
+#endif /* BOOT_RTOS_BENCH */
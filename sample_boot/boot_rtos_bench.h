@@ -0,0 +1,50 @@
+/*
+ * boot_rtos_bench.h
+ *
+ *  Cycle counts of kernel and port paths on the target, built with make
+ *  RTOS_BENCH=1. The host tool (tool/vci8_rtos) sends a command to
+ *  BOOT_RTOS_BENCH_PORT, the bench task runs the measurement on core 0 and
+ *  replies a boot_rtos_bench_result_t. The cycles are read from the time base
+ *  of core 0, enabled by the bench, which counts the core clock.
+ */
+
+#ifndef BOOT_RTOS_BENCH_H_
+#define BOOT_RTOS_BENCH_H_
+#include <stdint.h>
+
+#define BOOT_RTOS_BENCH_PORT (14232)
+#define BOOT_RTOS_BENCH_STACK (512)
+#define BOOT_RTOS_BENCH_PRIO (3) // below boot_main_task, like an application task
+#define BOOT_RTOS_BENCH_TIMEOUT (2000) // ms for a case of a command
+#define BOOT_RTOS_BENCH_ROUNDS_MAX (100000)
+#define BOOT_RTOS_BENCH_CASES (4)
+
+// Request of the host, 8 bytes: the command, 3 bytes 0, the rounds (uint32_t,
+// big endian). Unknown commands and rounds out of range reply cases 0.
+#define BOOT_RTOS_BENCH_CMD_SWITCH (1) // taskYIELD() between two tasks: [0] integer tasks, [1] floating point tasks
+// STM_0 compare match to its handler, in STM_0 counts, while
+// a task below the bench task calls the queue API in a loop: [0] at
+// configMAX_API_CALL_INTERRUPT_PRIORITY, masked by the critical sections, [1]
+// above it. A sample every 2000 to 2255 counts, the rounds which do not fit
+// BOOT_RTOS_BENCH_TIMEOUT reply cases 0.
+#define BOOT_RTOS_BENCH_CMD_IRQ (2)
+// Timestamp of the port, in core cycles: [0] the empty measurement, to take off
+// the other cases, [1] ullPortGetTimeStampTicks(), [2] ticks to ns, [3] ticks to us
+#define BOOT_RTOS_BENCH_CMD_TIMESTAMP (3)
+
+// Reply of a command, big endian
+typedef struct
+{
+	uint32_t cmd;
+	uint32_t rounds;
+	uint32_t cases; // valid entries of the arrays
+	uint32_t cnt[BOOT_RTOS_BENCH_CASES]; // samples taken
+	uint32_t min_cycles[BOOT_RTOS_BENCH_CASES];
+	uint32_t avg_cycles[BOOT_RTOS_BENCH_CASES];
+	uint32_t max_cycles[BOOT_RTOS_BENCH_CASES];
+} boot_rtos_bench_result_t;
+
+// Creates the bench task, call after FreeRTOS_IPInit() on core 0.
+void boot_rtos_bench_init(void);
+
+#endif /* BOOT_RTOS_BENCH_H_ */
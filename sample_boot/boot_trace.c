@@ -0,0 +1,188 @@
+/*
+ * boot_trace.c
+ *
+ *  Stream task of the kernel trace. Every BOOT_TRACE_PERIOD_MS the rings of
+ *  the cores are copied into zero-copy UDP buffers, one datagram per core and
+ *  up to BOOT_TRACE_EVENTS_MAX events, until they are empty.
+ */
+#include <string.h>
+#include "drivers.h"
+#include "rtos.h"
+#include "tcpip.h"
+#include "boot_app.h"
+#include "boot_trace.h"
+
+#if (configUSE_TRACE_RECORDER == 1)
+
+// Events and names of one datagram, an Ethernet frame without fragmentation
+#define BOOT_TRACE_PAYLOAD_MAX (ipconfigNETWORK_MTU - ipSIZE_OF_IPv4_HEADER - ipSIZE_OF_UDP_HEADER)
+#define BOOT_TRACE_EVENTS_MAX ((BOOT_TRACE_PAYLOAD_MAX - sizeof(boot_trace_header_t)) / sizeof(TraceEvent_t))
+#define BOOT_TRACE_NAMES_MAX ((BOOT_TRACE_PAYLOAD_MAX - sizeof(boot_trace_header_t)) / sizeof(TraceName_t))
+
+static Socket_t trace_sock;
+static struct freertos_sockaddr trace_host;
+static uint32_t trace_sequence[configSMP_CORE_NUMBER][2];
+static uint32_t trace_names_sent[configSMP_CORE_NUMBER];
+
+static void trace_build_header(boot_trace_header_t *header, uint8_t kind, uint8_t core, uint8_t count, uint32_t dropped)
+{
+	uint64_t pit;
+	header->magic = BOOT_TRACE_MAGIC;
+	header->version = BOOT_TRACE_VERSION;
+	header->kind = kind;
+	header->core = core;
+	header->count = count;
+	header->sequence = trace_sequence[core][kind]++;
+	header->dropped = dropped;
+	taskENTER_CRITICAL();
+	header->sync_stm = ulTraceRecorderGetTimeStamp();
+	pit = ullPortGetTimeStampTicks();
+	taskEXIT_CRITICAL();
+	header->sync_pit_hi = (uint32_t)(pit >> 32);
+	header->sync_pit_lo = (uint32_t)pit;
+	header->pit_hz = configCPU_CLOCK_HZ;
+}
+
+// Sends the UDP buffer, which is released if the stack did not take it.
+static void trace_send(uint8_t *p_tx_data, uint32_t len)
+{
+	if (FreeRTOS_sendto(trace_sock, p_tx_data, len, FREERTOS_ZERO_COPY, &trace_host, NULL, NULL) == 0)
+	{
+		FreeRTOS_ReleaseUDPPayloadBuffer(p_tx_data);
+	}
+}
+
+// Sends one datagram of the ring of a core. Returns the number of events, BOOT_TRACE_EVENTS_MAX if more may be waiting.
+static uint32_t trace_send_events(uint8_t core)
+{
+	boot_trace_header_t header;
+	uint8_t *p_tx_data;
+	uint32_t count;
+	uint32_t dropped;
+	p_tx_data = FreeRTOS_GetUDPPayloadBuffer(BOOT_TRACE_PAYLOAD_MAX, 0);
+	if (p_tx_data == NULL)
+	{
+		// the events wait in the ring, which drops the new ones when it is full
+		return 0;
+	}
+	count = ulTraceRecorderRead(core, (TraceEvent_t *)(p_tx_data + sizeof(header)), BOOT_TRACE_EVENTS_MAX, &dropped);
+	if (count == 0)
+	{
+		FreeRTOS_ReleaseUDPPayloadBuffer(p_tx_data);
+		return 0;
+	}
+	trace_build_header(&header, BOOT_TRACE_KIND_EVENTS, core, (uint8_t)count, dropped);
+	memcpy(p_tx_data, &header, sizeof(header));
+	trace_send(p_tx_data, sizeof(header) + count * sizeof(TraceEvent_t));
+	return count;
+}
+
+// Sends the name table of a core when it grew or force is set.
+static void trace_send_names(uint8_t core, uint8_t force)
+{
+	boot_trace_header_t header;
+	const TraceName_t *names;
+	uint8_t *p_tx_data;
+	uint32_t count;
+	uint32_t first = 0;
+	uint32_t n;
+	names = pxTraceRecorderGetNames(core, &count);
+	if (!force)
+	{
+		first = trace_names_sent[core];
+	}
+	while (first < count)
+	{
+		n = count - first;
+		if (n > BOOT_TRACE_NAMES_MAX)
+		{
+			n = BOOT_TRACE_NAMES_MAX;
+		}
+		p_tx_data = FreeRTOS_GetUDPPayloadBuffer(sizeof(header) + n * sizeof(TraceName_t), 0);
+		if (p_tx_data == NULL)
+		{
+			return;
+		}
+		trace_build_header(&header, BOOT_TRACE_KIND_NAMES, core, (uint8_t)n, 0);
+		memcpy(p_tx_data, &header, sizeof(header));
+		memcpy(p_tx_data + sizeof(header), &names[first], n * sizeof(TraceName_t));
+		trace_send(p_tx_data, sizeof(header) + n * sizeof(TraceName_t));
+		first += n;
+	}
+	trace_names_sent[core] = count;
+}
+
+static void boot_trace_task(void *param)
+{
+	struct freertos_sockaddr local_addr;
+	struct freertos_sockaddr from;
+	TickType_t rx_timeout = pdMS_TO_TICKS(BOOT_TRACE_PERIOD_MS);
+	TickType_t names_time = 0;
+	uint32_t session_addr;
+	uint8_t streaming = 0;
+	uint8_t force_names;
+	uint8_t cmd;
+	uint8_t core;
+	(void)param;
+
+	// the network buffers of the stream are not traced
+	vTraceRecorderSetStreamTask(xTaskGetCurrentTaskHandle());
+	trace_sock = FreeRTOS_socket(FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP);
+	FreeRTOS_setsockopt(trace_sock, 0, FREERTOS_SO_RCVTIMEO, &rx_timeout, 0);
+	memset(&local_addr, 0, sizeof(local_addr));
+	local_addr.sin_port = FreeRTOS_htons(BOOT_TRACE_PORT);
+	FreeRTOS_bind(trace_sock, &local_addr, sizeof(local_addr));
+	while (1)
+	{
+		// also the period of the stream, the receive times out after BOOT_TRACE_PERIOD_MS
+		if (FreeRTOS_recvfrom(trace_sock, &cmd, sizeof(cmd), 0, &from, NULL, NULL) == sizeof(cmd))
+		{
+			// the stream is far bigger than a command, it only goes to the
+			// host of the unlocked bootloader session, not to any address a
+			// datagram claims to come from
+			if (cmd == BOOT_TRACE_CMD_START)
+			{
+				if (boot_app_session_host(&session_addr) && (session_addr == from.sin_addr))
+				{
+					trace_host = from;
+					streaming = 1;
+					names_time = xTaskGetTickCount() - pdMS_TO_TICKS(BOOT_TRACE_NAMES_PERIOD_MS);
+					vTraceRecorderStart();
+				}
+			}
+			else if (streaming && (from.sin_addr == trace_host.sin_addr))
+			{
+				vTraceRecorderStop();
+				streaming = 0;
+			}
+		}
+		if (streaming)
+		{
+			force_names = ((xTaskGetTickCount() - names_time) >= pdMS_TO_TICKS(BOOT_TRACE_NAMES_PERIOD_MS));
+			if (force_names)
+			{
+				names_time = xTaskGetTickCount();
+			}
+			for (core = 0; core < configSMP_CORE_NUMBER; core++)
+			{
+				trace_send_names(core, force_names);
+				while (trace_send_events(core) == BOOT_TRACE_EVENTS_MAX)
+				{
+				}
+			}
+		}
+	}
+}
+
+void boot_trace_init(void)
+{
+	xTaskCreate(boot_trace_task, "trace", BOOT_TRACE_STACK, NULL, BOOT_TRACE_PRIO, NULL);
+}
+
+#else
+
+void boot_trace_init(void)
+{
+}
+
+#endif /* configUSE_TRACE_RECORDER */
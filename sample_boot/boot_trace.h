@@ -0,0 +1,50 @@
+/*
+ * boot_trace.h
+ *
+ *  Streams the kernel trace rings (trace_recorder.h) of the three cores over
+ *  UDP. A datagram from the host decoder (tool/vci8_trace) starts or stops the
+ *  stream to its sender. Only the host that unlocked the bootloader session
+ *  (security access) can start it, and only the host streamed to can stop it.
+ */
+
+#ifndef BOOT_TRACE_H_
+#define BOOT_TRACE_H_
+#include <stdint.h>
+
+#define BOOT_TRACE_PORT (14230)
+#define BOOT_TRACE_PERIOD_MS (10) // rings drained every period
+#define BOOT_TRACE_NAMES_PERIOD_MS (1000) // name tables sent again, the datagrams can be lost
+#define BOOT_TRACE_STACK (512)
+#define BOOT_TRACE_PRIO (1) // just above idle, a busy system shows up as dropped events
+
+// Commands, first byte of a datagram from the host
+#define BOOT_TRACE_CMD_STOP (0)
+#define BOOT_TRACE_CMD_START (1)
+
+#define BOOT_TRACE_MAGIC (0x56545243) // "VTRC"
+#define BOOT_TRACE_VERSION (1)
+#define BOOT_TRACE_KIND_EVENTS (0) // TraceEvent_t follow the header
+#define BOOT_TRACE_KIND_NAMES (1)  // TraceName_t follow the header
+
+// Header of a datagram, all the fields big endian like the events behind it
+typedef struct
+{
+	uint32_t magic;
+	uint8_t version;
+	uint8_t kind;
+	uint8_t core;
+	uint8_t count;     // events or names behind the header
+	uint32_t sequence; // datagrams of this core and kind, a gap is a lost datagram
+	uint32_t dropped;  // events lost on the full ring of the core since the start
+	// STM_0 count and PIT lifetime ticks read together, they give the rate of
+	// the STM and extend its 32 bit count for the decoder
+	uint32_t sync_stm;
+	uint32_t sync_pit_hi;
+	uint32_t sync_pit_lo;
+	uint32_t pit_hz;
+} boot_trace_header_t;
+
+// Creates the stream task, call after FreeRTOS_IPInit().
+void boot_trace_init(void);
+
+#endif /* BOOT_TRACE_H_ */
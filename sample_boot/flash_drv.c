@@ -1,5 +1,9 @@
 #include "flash_c55_driver.h"
+#include "sema42_driver.h"
+#include "rtos.h"
+#include "boot_board.h"
 #include "flash_drv.h"
+#include "crc32.h"
 
 #define FLASH_FMC PFLASH_BASE
 
@@ -14,6 +18,9 @@ typedef struct
 #define FLASH_PFCR2 0x000000004U
 #define FLASH_FMC_BFEN_MASK 0x000000001U
 
+/* Bytes of the RAM buffer added to the CRC per program status poll */
+#define FLASH_CRC_SLICE 64U
+
 /* Lock State */
 #define UNLOCK_LOW_BLOCKS 0x00000000U
 #define UNLOCK_MID_BLOCKS 0x00000000U
@@ -89,6 +96,49 @@ static inline void RestoreFlashControllerCache(uint32_t flashConfigReg, uint32_t
     REG_WRITE32(FLASH_FMC + flashConfigReg, pflash_pfcr);
 }
 
+flash_drv_stats_t flash_drv_stats;
+
+/*****************************************************************
+*   Time stamp of the port (PIT ch0/1 lifetime timer), counts up *
+******************************************************************/
+uint32_t flash_drv_get_ticks(void)
+{
+    /* not through LTMR64H/L, their latch is shared by the cores */
+    return (uint32_t)ullPortGetTimeStampTicks();
+}
+
+/*****************************************************************
+*   Serialize program/erase between cores. The gate is owned per  *
+*   core, so the tasks of a core first take the mutex of the core.*
+*   A task holding a mutex is not moved to another core.         *
+******************************************************************/
+static SemaphoreHandle_t flash_mutex[configSMP_CORE_NUMBER];
+
+static void flash_lock(void)
+{
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())
+    {
+        configASSERT(flash_mutex[ucPortGetCoreId()] != NULL);
+        (void)xSemaphoreTake(flash_mutex[ucPortGetCoreId()], portMAX_DELAY);
+    }
+    while (STATUS_SUCCESS != SEMA42_DRV_LockGate(0U, BOARD_SEMA42_GATE_FLASH))
+    {
+        if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())
+        {
+            vTaskDelay(1);
+        }
+    }
+}
+
+static void flash_unlock(void)
+{
+    (void)SEMA42_DRV_UnlockGate(0U, BOARD_SEMA42_GATE_FLASH);
+    if (taskSCHEDULER_RUNNING == xTaskGetSchedulerState())
+    {
+        (void)xSemaphoreGive(flash_mutex[ucPortGetCoreId()]);
+    }
+}
+
 static void flash_get_block_select(flash_block_select_t *sel, uint32_t start_address, uint32_t size)
 {
     unsigned int i;
@@ -117,10 +167,37 @@ static void flash_get_block_select(flash_block_select_t *sel, uint32_t start_add
     }
 }
 
+/*****************************************************************
+*   First address after the sector holding address, 0 if it is   *
+*   not in the table.                                            *
+******************************************************************/
+uint32_t flash_drv_sector_end(uint32_t address)
+{
+    unsigned int i;
+    for (i = 0; i < sizeof(flash_sel_table) / sizeof(flash_sel_table[0]); i++)
+    {
+        if ((flash_sel_table[i].start_address <= address) && (flash_sel_table[i].end_address >= address))
+        {
+            return flash_sel_table[i].end_address + 1;
+        }
+    }
+    return 0;
+}
+
+/* Called on core 0 before the other cores are started */
 status_t flash_drv_init(void)
 {
     status_t ret;
     uint32_t blkLockState = 0; /* block lock status to be retrieved */
+    unsigned int i;
+    for (i = 0; i < configSMP_CORE_NUMBER; i++)
+    {
+        if (flash_mutex[i] == NULL)
+        {
+            flash_mutex[i] = xSemaphoreCreateMutex();
+            configASSERT(flash_mutex[i] != NULL);
+        }
+    }
     ret = FLASH_DRV_Init();
     if (ret == STATUS_SUCCESS)
     {
@@ -160,6 +237,7 @@ status_t flash_erase(uint32_t address, uint32_t size)
     flash_state_t opResult;           /* store the state of flash */
     uint32_t pflash_pfcr1, pflash_pfcr2;
     flash_get_block_select(&blockSelect, address, size);
+    flash_lock();
     /* Invalidate flash controller cache */
     DisableFlashControllerCache(FLASH_PFCR1, FLASH_FMC_BFEN_MASK, &pflash_pfcr1);
     DisableFlashControllerCache(FLASH_PFCR2, FLASH_FMC_BFEN_MASK, &pflash_pfcr2);
@@ -182,16 +260,27 @@ status_t flash_erase(uint32_t address, uint32_t size)
     }
     RestoreFlashControllerCache(FLASH_PFCR1, pflash_pfcr1);
     RestoreFlashControllerCache(FLASH_PFCR2, pflash_pfcr2);
+    flash_unlock();
     return ret;
 }
 
-status_t flash_write(uint32_t address, void *data, uint32_t size)
+/*****************************************************************
+*   Program and verify. If crc != NULL, the CRC32 of the RAM      *
+*   buffer is updated while the high voltage pulses run, so the   *
+*   written flash is only read once, by the verify.              *
+******************************************************************/
+status_t flash_write_crc(uint32_t address, void *data, uint32_t size, uint32_t *crc)
 {
     status_t ret;
     flash_context_data_t pCtxData;
     flash_state_t opResult; /* store the state of flash */
     uint32_t failedAddress; /* save the failed address in flash */
     uint32_t pflash_pfcr1, pflash_pfcr2;
+    uint32_t crc_len = (crc != NULL) ? size : 0U;
+    uint32_t crc_done = 0U;
+    uint32_t len;
+    uint32_t t0, t1;
+    flash_lock();
     /* Invalidate flash controller cache */
     DisableFlashControllerCache(FLASH_PFCR1, FLASH_FMC_BFEN_MASK, &pflash_pfcr1);
     DisableFlashControllerCache(FLASH_PFCR2, FLASH_FMC_BFEN_MASK, &pflash_pfcr2);
@@ -199,14 +288,33 @@ status_t flash_write(uint32_t address, void *data, uint32_t size)
     if ((size % 4) != 0)
         size += (4 - (size % 4));
 
+    t0 = flash_drv_get_ticks();
     ret = FLASH_DRV_BlankCheck(address, size, (size / C55_WORD_SIZE + 1), &failedAddress, NULL_CALLBACK);
     if (ret == STATUS_SUCCESS)
     {
-        ret = FLASH_DRV_Program(&pCtxData, address, size, data);
-        do
+        ret = FLASH_DRV_Program(&pCtxData, address, size, (uint32_t)data);
+        while (ret == STATUS_SUCCESS)
         {
+            if (crc_done < crc_len)
+            {
+                len = crc_len - crc_done;
+                if (len > FLASH_CRC_SLICE)
+                {
+                    len = FLASH_CRC_SLICE;
+                }
+                *crc = crc32(*crc, (const unsigned char *)data + crc_done, len);
+                crc_done += len;
+            }
             ret = FLASH_DRV_CheckProgramStatus(&pCtxData, &opResult);
-        } while (ret == STATUS_FLASH_INPROGRESS);
+            if (ret == STATUS_FLASH_INPROGRESS)
+            {
+                ret = STATUS_SUCCESS;
+            }
+            else
+            {
+                break;
+            }
+        }
         if (ret == STATUS_SUCCESS)
         {
             if (opResult != C55_OK)
@@ -214,14 +322,51 @@ status_t flash_write(uint32_t address, void *data, uint32_t size)
                 ret = (0x900 | opResult);
             }
         }
-        /*
+        t1 = flash_drv_get_ticks();
+        flash_drv_stats.prog_ticks += (t1 - t0);
+        if ((ret == STATUS_SUCCESS) && (crc_done < crc_len))
+        {
+            /* short writes finish before the CRC does */
+            *crc = crc32(*crc, (const unsigned char *)data + crc_done, crc_len - crc_done);
+            t0 = flash_drv_get_ticks();
+            flash_drv_stats.crc_ticks += (t0 - t1);
+            t1 = t0;
+        }
         if (ret == STATUS_SUCCESS)
         {
-            ret = FLASH_DRV_ProgramVerify(address, size, data, (size/C55_WORD_SIZE + 1), &failedAddress, NULL_CALLBACK);
+            ret = FLASH_DRV_ProgramVerify(address, size, (uint32_t)data, (size / C55_WORD_SIZE + 1), &failedAddress, NULL_CALLBACK);
+            flash_drv_stats.verify_ticks += (flash_drv_get_ticks() - t1);
+            flash_drv_stats.prog_bytes += size;
         }
-        */
     }
     RestoreFlashControllerCache(FLASH_PFCR1, pflash_pfcr1);
     RestoreFlashControllerCache(FLASH_PFCR2, pflash_pfcr2);
+    flash_unlock();
     return ret;
 }
+
+status_t flash_write(uint32_t address, void *data, uint32_t size)
+{
+    return flash_write_crc(address, data, size, NULL);
+}
+
+/*****************************************************************
+*   Flash access by other drivers (EEE): takes the gate and turns *
+*   the line buffers off until flash_drv_unlock(). The program/   *
+*   erase calls of the same task must not be nested in between.  *
+******************************************************************/
+static uint32_t ext_pflash_pfcr1, ext_pflash_pfcr2;
+
+void flash_drv_lock(void)
+{
+    flash_lock();
+    DisableFlashControllerCache(FLASH_PFCR1, FLASH_FMC_BFEN_MASK, &ext_pflash_pfcr1);
+    DisableFlashControllerCache(FLASH_PFCR2, FLASH_FMC_BFEN_MASK, &ext_pflash_pfcr2);
+}
+
+void flash_drv_unlock(void)
+{
+    RestoreFlashControllerCache(FLASH_PFCR1, ext_pflash_pfcr1);
+    RestoreFlashControllerCache(FLASH_PFCR2, ext_pflash_pfcr2);
+    flash_unlock();
+}
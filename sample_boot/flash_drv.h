@@ -5,9 +5,25 @@
 
 
 
+/* Program benchmark, lifetime timer ticks. ticks * 1024 / prog_bytes = ticks per KB */
+typedef struct
+{
+    uint32_t prog_bytes;
+    uint32_t prog_ticks;   /* blank check + program, CRC of the RAM buffer overlapped */
+    uint32_t crc_ticks;    /* CRC time not hidden behind the program pulses */
+    uint32_t verify_ticks; /* read back compare */
+} flash_drv_stats_t;
+
+extern flash_drv_stats_t flash_drv_stats;
+
 status_t flash_drv_init(void);
 status_t flash_erase(uint32_t address, uint32_t size);
 status_t flash_write(uint32_t address, void *data, uint32_t size);
+status_t flash_write_crc(uint32_t address, void *data, uint32_t size, uint32_t *crc);
+uint32_t flash_drv_get_ticks(void);
+uint32_t flash_drv_sector_end(uint32_t address);
+void flash_drv_lock(void);
+void flash_drv_unlock(void);
 
 //void DisableFlashControllerCache(uint32_t flashConfigReg, uint32_t disableVal, uint32_t *origin_pflash_pfcr);
 //void RestoreFlashControllerCache(uint32_t flashConfigReg, uint32_t pflash_pfcr);
@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include "boot_app.h"
+
+// Stand-in for the bootloader on the host, to run and time vci8_prog without
+// an ECU: session control, security access, reset and the upload services,
+// framed and answered as boot_app.c does. The memory read back is a pattern
+// of the address, see sim_mem(), so the file written by vci8_prog can be
+// checked with -c.
+//
+// -r limits the blocks to the wire rate of an Ethernet link of that many
+// Mbit/s (Ethernet, IP and UDP headers, FCS, preamble and gap counted) and -d
+// delays the first block of each window by that many us, the turnaround of
+// the bootloader. The rate printed by vci8_prog is then that of the protocol
+// on such a link.
+
+#define SIM_BOOT_PORT (8183)
+#define SIM_SVC_PORT (14229)
+#define SIM_MASK (0x55)
+#define SIM_UDP_HEADER (8)
+#define SIM_FRAG_PAYLOAD (1480) // IP payload of a fragment, 1500 bytes MTU
+#define SIM_WIRE_OVERHEAD (20 + 14 + 4 + 8 + 12) // IP, Ethernet, FCS, preamble, gap of each fragment
+#define LFSR_TAP_MASK (0x80000057U)
+
+typedef struct
+{
+	uint8_t unlocked;
+	uint32_t seed;
+	uint8_t upload_state;
+	uint8_t window_sn;
+	uint8_t window;
+	uint32_t req_addr;
+	uint32_t req_size;
+	uint32_t window_offset;
+} sim_state_t;
+
+static double sim_ns_per_byte; // 0 - no rate limit
+static uint64_t sim_turnaround_ns;
+static uint64_t sim_wire_free; // time the link is free for the next frame
+static uint64_t sim_blocks;
+
+static uint64_t sim_time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint8_t sim_mem(uint32_t addr)
+{
+	return (uint8_t)(addr ^ (addr >> 8) ^ (addr >> 16) ^ (addr >> 24));
+}
+
+static uint32_t LFSR32(uint32_t reg, uint32_t mask, uint16_t time)
+{
+	uint16_t tmp;
+	uint16_t i;
+	for (i = 0; i < time; i++)
+	{
+		tmp = ((uint16_t)(((uint32_t)(reg & mask)) >> 16)) ^ ((uint16_t)(reg & mask));
+		tmp = (tmp >> 8) ^ (tmp & 0xFF);
+		tmp = (tmp >> 4) ^ (tmp & 0xF);
+		tmp = (tmp >> 2) ^ (tmp & 0x3);
+		tmp = (tmp >> 1) ^ (tmp & 1);
+		reg = (reg << 1) | (uint32_t)tmp;
+	}
+	return reg;
+}
+
+// build_crypt_msg() of boot_app.c
+static uint32_t sim_frame(const uint8_t *src, uint32_t src_len, uint8_t *dest)
+{
+	uint32_t i;
+	uint8_t check = 0;
+
+	dest[0] = 0x7E;
+	dest[2] = (uint8_t)(src_len >> 8);
+	dest[3] = (uint8_t)(src_len);
+	for (i = 0; i < src_len; i++)
+	{
+		dest[(i == 0) ? 1 : (3 + i)] = (src[i] ^ SIM_MASK);
+		check += (src[i] ^ SIM_MASK);
+	}
+	dest[3 + src_len] = check;
+	dest[4 + src_len] = 0x7E;
+	return src_len + 5;
+}
+
+// decrypt_msg() of boot_app.c, with the length checked. Returns the request length, 0 if malformed.
+static uint32_t sim_unframe(const uint8_t *src, uint32_t src_len, uint8_t *dest)
+{
+	uint32_t i;
+	uint32_t len;
+
+	if ((src_len < 6) || (src[0] != 0x7E))
+	{
+		return 0;
+	}
+	len = ((uint32_t)src[2] << 8) | src[3];
+	if ((len == 0) || (len + 5 != src_len))
+	{
+		return 0;
+	}
+	dest[0] = src[1] ^ SIM_MASK;
+	for (i = 1; i < len; i++)
+	{
+		dest[i] = src[3 + i] ^ SIM_MASK;
+	}
+	return len;
+}
+
+static void sim_wait(uint64_t until)
+{
+	while (sim_time_ns() < until)
+	{
+	}
+}
+
+static void sim_send(int sock, const struct sockaddr_in *to, const uint8_t *msg, uint32_t len)
+{
+	uint8_t frame[BOOT_UPLOAD_BLOCK_SIZE + 16];
+	uint32_t frame_len = sim_frame(msg, len, frame);
+	uint32_t frags = (frame_len + SIM_UDP_HEADER + SIM_FRAG_PAYLOAD - 1) / SIM_FRAG_PAYLOAD;
+	uint64_t now;
+
+	if (sim_ns_per_byte > 0)
+	{
+		now = sim_time_ns();
+		if (sim_wire_free < now)
+		{
+			sim_wire_free = now;
+		}
+		sim_wait(sim_wire_free);
+		sim_wire_free += (uint64_t)((frame_len + SIM_UDP_HEADER + frags * SIM_WIRE_OVERHEAD) * sim_ns_per_byte);
+	}
+	sendto(sock, (const char *)frame, frame_len, 0, (const struct sockaddr *)to, sizeof(*to));
+}
+
+// upload_xfer_data() and upload_stream() of boot_app.c
+static uint8_t sim_upload(int sock, const struct sockaddr_in *to, sim_state_t *state, const uint8_t *req, uint32_t len)
+{
+	uint8_t msg[BOOT_UPLOAD_BLOCK_SIZE + 2];
+	uint8_t delta = (uint8_t)(req[1] - state->window_sn);
+	uint32_t offset, block_len, i;
+	uint8_t n, blocks;
+
+	sim_wait(sim_time_ns() + sim_turnaround_ns);
+	if (delta > state->window)
+	{
+		return 0x24;
+	}
+	offset = state->window_offset + (uint32_t)delta * BOOT_UPLOAD_BLOCK_SIZE;
+	if (offset >= state->req_size)
+	{
+		return 0x24;
+	}
+	state->window_sn = req[1];
+	state->window_offset = offset;
+	blocks = (len > 2) ? req[2] : 1;
+	if ((blocks == 0) || (blocks > BOOT_UPLOAD_MAX_WINDOW))
+	{
+		blocks = BOOT_UPLOAD_MAX_WINDOW;
+	}
+	for (n = 0; (n < blocks) && (offset < state->req_size); n++)
+	{
+		block_len = state->req_size - offset;
+		if (block_len > BOOT_UPLOAD_BLOCK_SIZE)
+		{
+			block_len = BOOT_UPLOAD_BLOCK_SIZE;
+		}
+		msg[0] = 0x76;
+		msg[1] = (uint8_t)(state->window_sn + n);
+		for (i = 0; i < block_len; i++)
+		{
+			msg[2 + i] = sim_mem(state->req_addr + offset + i);
+		}
+		sim_send(sock, to, msg, block_len + 2);
+		offset += block_len;
+		sim_blocks++;
+	}
+	state->window = n;
+	return 0;
+}
+
+// Answers one request in req, returns the response length (0 - none).
+static uint32_t sim_service(int sock, const struct sockaddr_in *from, sim_state_t *state, uint8_t *req, uint32_t len)
+{
+	uint32_t ret = 0;
+	uint32_t addr = 0, size = 0, key, i;
+	uint8_t nrc = 0;
+
+	switch (req[0])
+	{
+	case 0x10:
+	case 0x11:
+		memset(state, 0, sizeof(*state));
+		req[0] += 0x40;
+		ret = 2;
+		break;
+	case 0x27:
+		if ((req[1] == 0x01) && (len == 2))
+		{
+			state->seed = ((uint32_t)rand() << 16) ^ (uint32_t)rand() ^ 1;
+			req[0] += 0x40;
+			req[2] = (uint8_t)(state->seed >> 24);
+			req[3] = (uint8_t)(state->seed >> 16);
+			req[4] = (uint8_t)(state->seed >> 8);
+			req[5] = (uint8_t)(state->seed);
+			ret = 6;
+		}
+		else if ((req[1] == 0x02) && (len == 6) && (state->seed != 0))
+		{
+			key = ((uint32_t)req[2] << 24) | ((uint32_t)req[3] << 16) | ((uint32_t)req[4] << 8) | req[5];
+			// level 1 of the programming session, LFSR32() runs session * 8 times
+			state->unlocked = (key == LFSR32(state->seed ^ 0x20191028, LFSR_TAP_MASK, 16));
+			state->seed = 0;
+			if (state->unlocked)
+			{
+				req[0] += 0x40;
+				ret = 2;
+			}
+			else
+			{
+				nrc = 0x35;
+			}
+		}
+		else
+		{
+			nrc = 0x24;
+		}
+		break;
+	case 0x35:
+		if (!state->unlocked)
+		{
+			nrc = 0x33;
+		}
+		else if ((len != 10) || (req[1] != 0x44))
+		{
+			nrc = 0x13;
+		}
+		else
+		{
+			for (i = 0; i < 4; i++)
+			{
+				addr = (addr << 8) | req[2 + i];
+				size = (size << 8) | req[6 + i];
+			}
+			state->upload_state = 1;
+			state->window_sn = 1;
+			state->window = 0;
+			state->req_addr = addr;
+			state->req_size = size;
+			state->window_offset = 0;
+			req[0] += 0x40;
+			req[1] = 0x20;
+			req[2] = (uint8_t)((BOOT_UPLOAD_BLOCK_SIZE + 2) >> 8);
+			req[3] = (uint8_t)(BOOT_UPLOAD_BLOCK_SIZE + 2);
+			ret = 4;
+		}
+		break;
+	case 0x36:
+		nrc = (state->upload_state == 1) ? sim_upload(sock, from, state, req, len) : 0x24;
+		break;
+	case 0x37:
+		if (state->upload_state == 1)
+		{
+			req[0] += 0x40;
+			ret = 1;
+		}
+		else
+		{
+			nrc = 0x24;
+		}
+		state->upload_state = 0;
+		break;
+	default:
+		nrc = 0x11;
+		break;
+	}
+	if (nrc != 0)
+	{
+		req[1] = req[0];
+		req[0] = 0x7F;
+		req[2] = nrc;
+		ret = 3;
+	}
+	return ret;
+}
+
+static int sim_bind(uint16_t port)
+{
+	struct sockaddr_in addr;
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	if ((sock < 0) || (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0))
+	{
+		perror("bind");
+		exit(1);
+	}
+	return sock;
+}
+
+// Checks the file written by vci8_prog -u 127.0.0.1 addr size file.bin
+static int sim_check(const char *file_name, uint32_t addr)
+{
+	FILE *fs = fopen(file_name, "rb");
+	uint32_t n = 0;
+	int c;
+	if (fs == NULL)
+	{
+		perror(file_name);
+		return 1;
+	}
+	while ((c = fgetc(fs)) != EOF)
+	{
+		if ((uint8_t)c != sim_mem(addr + n))
+		{
+			printf("%s: 0x%08X differs\n", file_name, addr + n);
+			fclose(fs);
+			return 1;
+		}
+		n++;
+	}
+	fclose(fs);
+	printf("%s: %u bytes OK\n", file_name, n);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static uint8_t rx[65536];
+	static uint8_t req[65536];
+	sim_state_t state;
+	struct sockaddr_in from;
+	socklen_t from_len;
+	fd_set fds;
+	int boot_sock, svc_sock;
+	int rx_len;
+	int i;
+	uint32_t len;
+
+	if ((argc == 4) && (strcmp(argv[1], "-c") == 0))
+	{
+		return sim_check(argv[2], (uint32_t)strtoul(argv[3], NULL, 0));
+	}
+	for (i = 1; i < argc; i += 2)
+	{
+		if ((i + 1 < argc) && (strcmp(argv[i], "-r") == 0))
+		{
+			sim_ns_per_byte = 8000.0 / atof(argv[i + 1]);
+		}
+		else if ((i + 1 < argc) && (strcmp(argv[i], "-d") == 0))
+		{
+			sim_turnaround_ns = strtoull(argv[i + 1], NULL, 0) * 1000;
+		}
+		else
+		{
+			printf("USAGE: %s [-r link_mbit] [-d turnaround_us]   then: vci8_prog -u 127.0.0.1 address size file.bin\n", argv[0]);
+			printf("       %s -c file.bin address\n", argv[0]);
+			return 1;
+		}
+	}
+
+	boot_sock = sim_bind(SIM_BOOT_PORT);
+	svc_sock = sim_bind(SIM_SVC_PORT);
+	memset(&state, 0, sizeof(state));
+	while (1)
+	{
+		FD_ZERO(&fds);
+		FD_SET(boot_sock, &fds);
+		FD_SET(svc_sock, &fds);
+		if (select(((boot_sock > svc_sock) ? boot_sock : svc_sock) + 1, &fds, NULL, NULL, NULL) <= 0)
+		{
+			continue;
+		}
+		from_len = sizeof(from);
+		if (FD_ISSET(boot_sock, &fds))
+		{
+			// enter boot request, the ECU would reset into the bootloader
+			recvfrom(boot_sock, (char *)rx, sizeof(rx), 0, (struct sockaddr *)&from, &from_len);
+			memset(&state, 0, sizeof(state));
+			printf("enter boot, %llu blocks sent so far\n", (unsigned long long)sim_blocks);
+			continue;
+		}
+		rx_len = recvfrom(svc_sock, (char *)rx, sizeof(rx), 0, (struct sockaddr *)&from, &from_len);
+		len = (rx_len > 0) ? sim_unframe(rx, (uint32_t)rx_len, req) : 0;
+		if ((len > 0) && (len < sizeof(req) - 8))
+		{
+			len = sim_service(svc_sock, &from, &state, req, len);
+			if (len > 0)
+			{
+				sim_send(svc_sock, &from, req, len);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#ifndef WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+#include "FreeRTOS.h"
+#include "host_port.h"
+
+// Stress test and latency of the heap built in (HEAP in the Makefile, heap_tlsf
+// by default). The stress test runs one thread per core, the blocks are freed
+// by any core. The latency is the time of pvPortMalloc() and vPortFree() on
+// one core, with random sizes and with a heap cut into many free blocks.
+
+#define BENCH_SLOTS (512)
+#define BENCH_STRESS_OPS (300000)
+#define BENCH_LATENCY_OPS (200000)
+#define BENCH_LATENCY_SLOTS (128)
+#define BENCH_FRAGMENTS (300)
+#define BENCH_HIST_NS (10000) // latencies above go in the last bucket
+
+typedef struct
+{
+	uint32_t size;
+	uint32_t fill;
+} bench_block_t;
+
+typedef struct
+{
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint32_t hist[BENCH_HIST_NS + 1];
+} bench_stat_t;
+
+static bench_block_t *volatile bench_slots[BENCH_SLOTS];
+static uint64_t bench_overhead;
+
+static uint32_t bench_rand(uint32_t *seed)
+{
+	*seed = *seed * 1103515245U + 12345U;
+	return *seed >> 8;
+}
+
+static void bench_fail(const char *what)
+{
+	fprintf(stderr, "FAIL: %s\n", what);
+	exit(1);
+}
+
+// the first core to allocate sets up its arena
+static void bench_init_cores(void)
+{
+	UBaseType_t core;
+	for (core = 0; core < configSMP_CORE_NUMBER; core++)
+	{
+		uxHostCoreID = core;
+		vPortFree(pvPortMalloc(1));
+	}
+	uxHostCoreID = 0;
+}
+
+static bench_block_t *bench_alloc(uint32_t size, uint32_t fill)
+{
+	bench_block_t *block = pvPortMalloc(size);
+	if (block != NULL)
+	{
+		if ((size_t)block & portBYTE_ALIGNMENT_MASK)
+		{
+			bench_fail("alignment");
+		}
+		memset(block, (int)(fill & 0xFF), size);
+		block->size = size;
+		block->fill = fill;
+	}
+	return block;
+}
+
+static void bench_free(bench_block_t *block)
+{
+	uint8_t *data = (uint8_t *)block;
+	uint32_t i;
+	for (i = sizeof(bench_block_t); i < block->size; i++)
+	{
+		if (data[i] != (uint8_t)block->fill)
+		{
+			bench_fail("block overwritten");
+		}
+	}
+	vPortFree(block);
+}
+
+static void *bench_stress_thread(void *param)
+{
+	uint32_t seed = (uint32_t)(uintptr_t)param * 7919U + 1U;
+	uint32_t i, op, size;
+	bench_block_t *block;
+
+	uxHostCoreID = (UBaseType_t)(uintptr_t)param;
+	for (op = 0; op < BENCH_STRESS_OPS; op++)
+	{
+		i = bench_rand(&seed) % BENCH_SLOTS;
+		block = __atomic_exchange_n(&bench_slots[i], NULL, __ATOMIC_ACQ_REL);
+		if (block != NULL)
+		{
+			bench_free(block);
+		}
+		else
+		{
+			size = sizeof(bench_block_t) + bench_rand(&seed) % ((bench_rand(&seed) % 16 == 0) ? 2048 : 256);
+			block = bench_alloc(size, bench_rand(&seed));
+			if (block != NULL)
+			{
+				block = __atomic_exchange_n(&bench_slots[i], block, __ATOMIC_ACQ_REL);
+				if (block != NULL)
+				{
+					bench_free(block);
+				}
+			}
+		}
+	}
+	return NULL;
+}
+
+static void bench_stress(void)
+{
+	pthread_t threads[configSMP_CORE_NUMBER];
+	size_t free_start;
+	uintptr_t core;
+	uint32_t i;
+
+	bench_init_cores();
+	free_start = xPortGetFreeHeapSize();
+	for (core = 0; core < configSMP_CORE_NUMBER; core++)
+	{
+		if (pthread_create(&threads[core], NULL, bench_stress_thread, (void *)core) != 0)
+		{
+			bench_fail("thread");
+		}
+	}
+	for (core = 0; core < configSMP_CORE_NUMBER; core++)
+	{
+		pthread_join(threads[core], NULL);
+	}
+	for (i = 0; i < BENCH_SLOTS; i++)
+	{
+		uxHostCoreID = i % configSMP_CORE_NUMBER;
+		if (bench_slots[i] != NULL)
+		{
+			bench_free(bench_slots[i]);
+			bench_slots[i] = NULL;
+		}
+	}
+	// the owners take back the blocks freed by the other cores
+	bench_init_cores();
+	if (xPortGetFreeHeapSize() != free_start)
+	{
+		bench_fail("free size after the stress test");
+	}
+	printf("stress: %u threads x %u operations, free %u bytes, minimum ever %u bytes\n", configSMP_CORE_NUMBER, BENCH_STRESS_OPS,
+		(unsigned)xPortGetFreeHeapSize(), (unsigned)xPortGetMinimumEverFreeHeapSize());
+}
+
+static void bench_stat_add(bench_stat_t *stat, uint64_t ns)
+{
+	ns = (ns > bench_overhead) ? ns - bench_overhead : 0;
+	stat->count++;
+	stat->sum += ns;
+	if (ns > stat->max)
+	{
+		stat->max = ns;
+	}
+	stat->hist[(ns < BENCH_HIST_NS) ? ns : BENCH_HIST_NS]++;
+}
+
+static void bench_stat_print(const char *name, const bench_stat_t *stat)
+{
+	uint64_t n = 0;
+	uint32_t ns;
+	uint32_t p99 = BENCH_HIST_NS, p999 = BENCH_HIST_NS;
+	for (ns = 0; ns <= BENCH_HIST_NS; ns++)
+	{
+		n += stat->hist[ns];
+		if ((p99 == BENCH_HIST_NS) && (n * 100 >= stat->count * 99))
+		{
+			p99 = ns;
+		}
+		if (n * 1000 >= stat->count * 999)
+		{
+			p999 = ns;
+			break;
+		}
+	}
+	printf("%-18s %8.1f %8u %8u %8u\n", name, (double)stat->sum / stat->count, p99, p999, (unsigned)stat->max);
+}
+
+static void bench_latency(const char *name, uint32_t fragments)
+{
+	static bench_block_t *blocks[BENCH_LATENCY_SLOTS];
+	static bench_block_t *pieces[BENCH_FRAGMENTS * 2];
+	static bench_stat_t stat_malloc, stat_free;
+	uint32_t seed = 12345;
+	uint32_t i, op;
+	uint64_t t0;
+	char label[32];
+
+	memset(&stat_malloc, 0, sizeof(stat_malloc));
+	memset(&stat_free, 0, sizeof(stat_free));
+	uxHostCoreID = 0;
+	// every other small block is freed, they can not merge
+	for (i = 0; i < fragments * 2; i++)
+	{
+		pieces[i] = bench_alloc(sizeof(bench_block_t) + 16, i);
+		if (pieces[i] == NULL)
+		{
+			bench_fail("fragments");
+		}
+	}
+	for (i = 0; i < fragments * 2; i += 2)
+	{
+		bench_free(pieces[i]);
+	}
+	for (op = 0; op < BENCH_LATENCY_OPS; op++)
+	{
+		i = bench_rand(&seed) % BENCH_LATENCY_SLOTS;
+		if (blocks[i] != NULL)
+		{
+			t0 = host_time_ns();
+			vPortFree(blocks[i]);
+			bench_stat_add(&stat_free, host_time_ns() - t0);
+			blocks[i] = NULL;
+		}
+		else
+		{
+			t0 = host_time_ns();
+			blocks[i] = pvPortMalloc(sizeof(bench_block_t) + 64 + bench_rand(&seed) % 192);
+			bench_stat_add(&stat_malloc, host_time_ns() - t0);
+		}
+	}
+	for (i = 0; i < BENCH_LATENCY_SLOTS; i++)
+	{
+		vPortFree(blocks[i]);
+		blocks[i] = NULL;
+	}
+	for (i = 1; i < fragments * 2; i += 2)
+	{
+		bench_free(pieces[i]);
+	}
+	snprintf(label, sizeof(label), "%s malloc", name);
+	bench_stat_print(label, &stat_malloc);
+	snprintf(label, sizeof(label), "%s free", name);
+	bench_stat_print(label, &stat_free);
+}
+
+#ifndef WIN32
+// A block freed twice by another core than its owner must stop at the assert,
+// also when it is the only block of the deferred list.
+static void bench_double_free(void)
+{
+	int status;
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		void *p;
+		int fd = open("/dev/null", O_WRONLY);
+		dup2(fd, 2);
+		uxHostCoreID = 0;
+		p = pvPortMalloc(100);
+		uxHostCoreID = 1;
+		vPortFree(p);
+		vPortFree(p);
+		_exit(0);
+	}
+	waitpid(pid, &status, 0);
+	if (!WIFSIGNALED(status) || (WTERMSIG(status) != SIGABRT))
+	{
+		bench_fail("double free across cores not detected");
+	}
+	printf("double free across cores: detected\n");
+}
+#endif
+
+int main(void)
+{
+	uint32_t i;
+	uint64_t t0;
+
+	t0 = host_time_ns();
+	for (i = 0; i < 100000; i++)
+	{
+		(void)host_time_ns();
+	}
+	bench_overhead = (host_time_ns() - t0) / 100000;
+
+	printf("heap %s, %u bytes\n", BENCH_HEAP, (unsigned)configTOTAL_HEAP_SIZE);
+	bench_stress();
+	printf("latency in ns         avg      99%%    99.9%%      max\n");
+	bench_latency("random", 0);
+	bench_latency("fragmented", BENCH_FRAGMENTS);
+#ifndef WIN32
+	bench_double_free();
+#endif
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,82 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*
+ * Host build of the kernel and TCP sources for the tools of sample_boot/tool,
+ * see portmacro.h.  The settings that change the code under test are the ones
+ * of FreeRTOS/FreeRTOSConfig.h.
+ */
+
+#define configSMP_CORE_NUMBER (3)
+#define configUSE_CORE_AFFINITY 0
+#define configUSE_CORE_CHANNELS 0
+#define configHEAP_SEMA42_GATE (14U)
+#define configUSE_PREEMPTION 1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configCPU_CLOCK_HZ (40000000UL)
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define configMAX_PRIORITIES (8)
+#define configMINIMAL_STACK_SIZE ((unsigned short)512)
+#define configMAX_TASK_NAME_LEN (12)
+#define configUSE_16_BIT_TICKS 0
+#define configUSE_TASK_NOTIFICATIONS 1
+#define configUSE_MUTEXES 1
+#define configUSE_RECURSIVE_MUTEXES 1
+#define configUSE_COUNTING_SEMAPHORES 1
+#define configQUEUE_REGISTRY_SIZE 0
+#define configUSE_QUEUE_SETS 0
+#define configUSE_TIME_SLICING 1
+#define configUSE_NEWLIB_REENTRANT 0
+#define configENABLE_BACKWARD_COMPATIBILITY 1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 4
+#define configUSE_APPLICATION_TASK_TAG 1
+
+#define configSUPPORT_STATIC_ALLOCATION 0
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configTOTAL_HEAP_SIZE ((size_t)90112)
+#define configHEAP_ARENA_SIZES {65536U, 12288U, 12288U}
+#define configAPPLICATION_ALLOCATED_HEAP 0
+
+#define configUSE_IDLE_HOOK 0
+#define configUSE_TICK_HOOK 0
+#define configCHECK_FOR_STACK_OVERFLOW 0
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configUSE_DAEMON_TASK_STARTUP_HOOK 0
+
+#define configGENERATE_RUN_TIME_STATS 0
+#define configUSE_TRACE_FACILITY 0
+#define configUSE_STATS_FORMATTING_FUNCTIONS 0
+#define configUSE_TRACE_RECORDER 0
+
+#define configUSE_CO_ROUTINES 0
+#define configMAX_CO_ROUTINE_PRIORITIES (2)
+
+#define configUSE_TIMERS 1
+#define configTIMER_TASK_PRIORITY (3)
+#define configTIMER_QUEUE_LENGTH 10
+#define configTIMER_TASK_STACK_DEPTH 128
+/* A tool can build the sorted list of active timers to compare */
+#ifndef configUSE_TIMER_WHEEL
+#define configUSE_TIMER_WHEEL 1
+#endif
+
+#define INCLUDE_vTaskPrioritySet 1
+#define INCLUDE_uxTaskPriorityGet 1
+#define INCLUDE_vTaskDelete 1
+#define INCLUDE_vTaskSuspend 1
+#define INCLUDE_vTaskDelayUntil 1
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskGetSchedulerState 1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_xTimerPendFunctionCall 1
+
+/* A failed assert stops the tool with the place of the assert. */
+void vHostAssertFailed( const char *pcFile, unsigned long ulLine );
+#define configASSERT(x) if( ( x ) == 0 ) { vHostAssertFailed( __FILE__, __LINE__ ); }
+
+#define configMAX_API_CALL_INTERRUPT_PRIORITY (8)
+
+#define NOINIT_DATA_SECTION
+#define SHARED_DATA_SECTION
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sema42_driver.h"
+#include "host_port.h"
+
+// The kernel services used by the code under test. There is no scheduler:
+// the tick count is set by the tool and the scheduler lock of a core is the
+// critical section of the host port.
+
+__thread UBaseType_t uxHostCoreID;
+
+static volatile TickType_t host_tick_count;
+static pthread_mutex_t host_gate[16] = {
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+};
+static __thread UBaseType_t host_critical_nesting;
+
+void vHostAssertFailed(const char *pcFile, unsigned long ulLine)
+{
+	fprintf(stderr, "assert failed: %s:%lu\n", pcFile, ulLine);
+	abort();
+}
+
+void vPortEnterCritical(void)
+{
+	host_critical_nesting++;
+}
+
+void vPortExitCritical(void)
+{
+	configASSERT(host_critical_nesting > 0);
+	host_critical_nesting--;
+}
+
+status_t SEMA42_DRV_LockGate(uint32_t instance, uint8_t gate)
+{
+	(void)instance;
+	configASSERT(gate < 16);
+	return (pthread_mutex_trylock(&host_gate[gate]) == 0) ? STATUS_SUCCESS : STATUS_BUSY;
+}
+
+status_t SEMA42_DRV_UnlockGate(uint32_t instance, uint8_t gate)
+{
+	(void)instance;
+	configASSERT(gate < 16);
+	pthread_mutex_unlock(&host_gate[gate]);
+	return STATUS_SUCCESS;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+	return host_tick_count;
+}
+
+void host_set_tick_count(TickType_t ticks)
+{
+	host_tick_count = ticks;
+}
+
+void vTaskSuspendAll(void)
+{
+	vPortEnterCritical();
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+	vPortExitCritical();
+	return pdFALSE;
+}
+
+uint64_t host_time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,20 @@
+#ifndef HOST_PORT_H
+#define HOST_PORT_H
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// tick count returned by xTaskGetTickCount()
+void host_set_tick_count(TickType_t ticks);
+// monotonic time of the host, to time the code under test
+uint64_t host_time_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+/*
+ * Host port of the kernel sources, for the benchmarks and the stress tests of
+ * sample_boot/tool.  There is no scheduler: the code under test is called
+ * directly by the tool, a "core" is a thread of the tool and the SEMA42 gates
+ * are mutexes, see host_port.c.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Type definitions. */
+#define portCHAR			char
+#define portFLOAT			float
+#define portDOUBLE			double
+#define portLONG			long
+#define portSHORT			short
+#define portSTACK_TYPE		unsigned portLONG
+#define portBASE_TYPE		portLONG
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#if( configUSE_16_BIT_TICKS == 1 )
+	typedef uint16_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xFFFFU
+#else
+	typedef uint32_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xFFFFFFFFUL
+	#define portTICK_TYPE_IS_ATOMIC 1
+#endif
+
+/* Architecture specifics, the alignment is the one of the target. */
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT			32
+#define portNOP()
+
+#define portMEMORY_BARRIER()		__sync_synchronize()
+
+/* The core of the calling thread, set by the tool. */
+extern __thread UBaseType_t uxHostCoreID;
+
+#define ucPortGetCoreId()			( uxHostCoreID )
+
+/* Scheduler utilities, nothing is ever switched. */
+#define portYIELD()
+#define portYIELD_WITHIN_API()
+#define portYIELD_FROM_ISR( x )		( ( void ) ( x ) )
+#define portYIELD_CORE( xCoreID )	( ( void ) ( xCoreID ) )
+
+void vPortEnterCritical( void );
+void vPortExitCritical( void );
+
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL()					vPortEnterCritical()
+#define portEXIT_CRITICAL()						vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()		0
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	( ( void ) ( x ) )
+
+#define portGET_MIGRATION_LOCK()
+#define portRELEASE_MIGRATION_LOCK()
+
+#define portTASK_USES_FLOATING_POINT()
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters )       void vFunction( void *pvParameters )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
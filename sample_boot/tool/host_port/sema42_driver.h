@@ -0,0 +1,20 @@
+#ifndef SEMA42_DRIVER_H
+#define SEMA42_DRIVER_H
+
+/*
+ * Host stand-in of the SEMA42 driver for the host port, a gate is a mutex.
+ */
+
+#include <stdint.h>
+
+typedef enum
+{
+	STATUS_SUCCESS = 0x000U,
+	STATUS_ERROR = 0x001U,
+	STATUS_BUSY = 0x002U
+} status_t;
+
+status_t SEMA42_DRV_LockGate( uint32_t instance, uint8_t gate );
+status_t SEMA42_DRV_UnlockGate( uint32_t instance, uint8_t gate );
+
+#endif /* SEMA42_DRIVER_H */
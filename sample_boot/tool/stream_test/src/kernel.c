@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+// stream_buffer.c is built here so that the tool can place the head and the
+// tail of a buffer anywhere in its storage.
+#include "stream_buffer.c"
+#include "host_port.h"
+#include "kernel.h"
+
+// The kernel services used by stream_buffer.c. A task is a thread which runs
+// while it holds kernel_core, it gives the core up only while it waits for a
+// notification. The critical sections of the host port are then enough, as
+// on one core of the target.
+
+typedef struct
+{
+	pthread_t thread;
+	pthread_cond_t cond;
+	kernel_task_fn_t fn;
+	void *arg;
+	BaseType_t notified;
+	BaseType_t waiting;
+	uint32_t waits;
+} kernel_task_t;
+
+static pthread_mutex_t kernel_core = PTHREAD_MUTEX_INITIALIZER;
+static kernel_task_t kernel_tasks[KERNEL_TASKS_MAX];
+static UBaseType_t kernel_task_count;
+// the thread of main(), which never blocks
+static kernel_task_t kernel_main_task;
+static __thread kernel_task_t *kernel_current;
+
+void *pvPortMalloc(size_t xSize)
+{
+	return malloc(xSize);
+}
+
+void vPortFree(void *pv)
+{
+	free(pv);
+}
+
+static TickType_t kernel_ticks(void)
+{
+	return (TickType_t)(host_time_ns() / (1000000000ULL / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return (TaskHandle_t)((kernel_current != NULL) ? kernel_current : &kernel_main_task);
+}
+
+void vTaskSetTimeOutState(TimeOut_t *const pxTimeOut)
+{
+	pxTimeOut->xOverflowCount = 0;
+	pxTimeOut->xTimeOnEntering = kernel_ticks();
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *const pxTimeOut, TickType_t *const pxTicksToWait)
+{
+	TickType_t now = kernel_ticks();
+	TickType_t elapsed = now - pxTimeOut->xTimeOnEntering;
+
+	if (*pxTicksToWait == portMAX_DELAY)
+	{
+		return pdFALSE;
+	}
+	if (elapsed >= *pxTicksToWait)
+	{
+		*pxTicksToWait = 0;
+		return pdTRUE;
+	}
+	*pxTicksToWait -= elapsed;
+	pxTimeOut->xTimeOnEntering = now;
+	return pdFALSE;
+}
+
+BaseType_t xTaskNotifyStateClear(TaskHandle_t xTask)
+{
+	kernel_task_t *task = (kernel_task_t *)((xTask != NULL) ? xTask : xTaskGetCurrentTaskHandle());
+	BaseType_t ret = task->notified;
+
+	task->notified = pdFALSE;
+	return ret;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait)
+{
+	kernel_task_t *task = (kernel_task_t *)xTaskGetCurrentTaskHandle();
+	BaseType_t ret;
+	struct timespec until;
+	uint64_t ns;
+
+	(void)ulBitsToClearOnEntry;
+	(void)ulBitsToClearOnExit;
+	configASSERT(pulNotificationValue == NULL);
+	// the thread of main() has no core to give up
+	configASSERT(task != &kernel_main_task);
+	if ((task->notified == pdFALSE) && (xTicksToWait != 0))
+	{
+		task->waits++;
+		task->waiting = pdTRUE;
+		clock_gettime(CLOCK_REALTIME, &until);
+		ns = (uint64_t)until.tv_nsec + (uint64_t)xTicksToWait * (1000000000ULL / configTICK_RATE_HZ);
+		until.tv_sec += (time_t)(ns / 1000000000ULL);
+		until.tv_nsec = (long)(ns % 1000000000ULL);
+		while (task->notified == pdFALSE)
+		{
+			if (xTicksToWait == portMAX_DELAY)
+			{
+				pthread_cond_wait(&task->cond, &kernel_core);
+			}
+			else if (pthread_cond_timedwait(&task->cond, &kernel_core, &until) != 0)
+			{
+				break;
+			}
+		}
+		task->waiting = pdFALSE;
+	}
+	ret = task->notified;
+	task->notified = pdFALSE;
+	return ret;
+}
+
+static BaseType_t kernel_notify(TaskHandle_t xTaskToNotify)
+{
+	kernel_task_t *task = (kernel_task_t *)xTaskToNotify;
+	BaseType_t woken = ((task->waiting != pdFALSE) && (task->notified == pdFALSE)) ? pdTRUE : pdFALSE;
+
+	task->notified = pdTRUE;
+	pthread_cond_signal(&task->cond);
+	return woken;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue)
+{
+	(void)ulValue;
+	(void)pulPreviousNotificationValue;
+	configASSERT(eAction == eNoAction);
+	(void)kernel_notify(xTaskToNotify);
+	return pdPASS;
+}
+
+BaseType_t xTaskGenericNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue, BaseType_t *pxHigherPriorityTaskWoken)
+{
+	(void)ulValue;
+	(void)pulPreviousNotificationValue;
+	configASSERT(eAction == eNoAction);
+	// the tasks have the same priority, a woken task counts as one to switch to
+	if ((kernel_notify(xTaskToNotify) != pdFALSE) && (pxHigherPriorityTaskWoken != NULL))
+	{
+		*pxHigherPriorityTaskWoken = pdTRUE;
+	}
+	return pdPASS;
+}
+
+static void *kernel_thread(void *arg)
+{
+	kernel_task_t *task = (kernel_task_t *)arg;
+
+	pthread_mutex_lock(&kernel_core);
+	kernel_current = task;
+	task->fn(task->arg);
+	pthread_mutex_unlock(&kernel_core);
+	return NULL;
+}
+
+TaskHandle_t kernel_task_create(kernel_task_fn_t fn, void *arg)
+{
+	kernel_task_t *task;
+
+	configASSERT(kernel_task_count < KERNEL_TASKS_MAX);
+	task = &kernel_tasks[kernel_task_count++];
+	memset(task, 0, sizeof(*task));
+	pthread_cond_init(&task->cond, NULL);
+	task->fn = fn;
+	task->arg = arg;
+	return (TaskHandle_t)task;
+}
+
+void kernel_run(void)
+{
+	UBaseType_t i;
+
+	for (i = 0; i < kernel_task_count; i++)
+	{
+		pthread_create(&kernel_tasks[i].thread, NULL, kernel_thread, &kernel_tasks[i]);
+	}
+	for (i = 0; i < kernel_task_count; i++)
+	{
+		pthread_join(kernel_tasks[i].thread, NULL);
+		pthread_cond_destroy(&kernel_tasks[i].cond);
+	}
+	// the records stay readable until the next kernel_task_create()
+	kernel_task_count = 0;
+}
+
+BaseType_t kernel_task_blocked(TaskHandle_t task)
+{
+	return (((kernel_task_t *)task)->waiting != pdFALSE) && (((kernel_task_t *)task)->notified == pdFALSE);
+}
+
+uint32_t kernel_task_waits(TaskHandle_t task)
+{
+	return ((kernel_task_t *)task)->waits;
+}
+
+uint8_t *kernel_stream_storage(StreamBufferHandle_t stream, size_t *length)
+{
+	*length = stream->xLength;
+	return stream->pucBuffer;
+}
+
+void kernel_stream_seek(StreamBufferHandle_t stream, size_t index)
+{
+	BaseType_t reset = xStreamBufferReset(stream);
+
+	configASSERT(reset == pdPASS);
+	configASSERT(index < stream->xLength);
+	stream->xHead = index;
+	stream->xTail = index;
+}
@@ -0,0 +1,36 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stream_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KERNEL_TASKS_MAX (2)
+
+// Tasks of the tool on one core, without preemption: a task runs until it
+// blocks in the stream buffer or returns, then another one runs. Created by
+// kernel_task_create(), started together and waited for by kernel_run().
+typedef void (*kernel_task_fn_t)(void *arg);
+
+TaskHandle_t kernel_task_create(kernel_task_fn_t fn, void *arg);
+void kernel_run(void);
+// pdTRUE if the task waits in xTaskNotifyWait() and was not notified yet
+BaseType_t kernel_task_blocked(TaskHandle_t task);
+// times the task blocked, since its creation
+uint32_t kernel_task_waits(TaskHandle_t task);
+
+// The storage of the buffer, as indexed by the head and the tail, of
+// xBufferSizeBytes + 1 bytes.
+uint8_t *kernel_stream_storage(StreamBufferHandle_t stream, size_t *length);
+// Empties the buffer and moves its head and its tail to index.
+void kernel_stream_seek(StreamBufferHandle_t stream, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "stream_buffer.h"
+#include "message_buffer.h"
+#include "kernel.h"
+
+// Test of the zero copy functions of stream_buffer.c: reserve and commit,
+// peek and consume, on stream and message buffers.
+//
+// The wrap test starts an empty buffer at every index of its storage and
+// writes then reads every length, mixing the zero copy functions with send
+// and receive. The spans handed out are checked against the storage, the
+// length of a message wraps too. Run with the task and the FromISR functions.
+//
+// The block test runs a writer and a reader task on one core, see kernel.h,
+// through a small buffer: the blocking reserve and peek wait for the send and
+// receive of the other task and the other way round, the FromISR calls must
+// report the task they woke.
+
+#define TEST_WRAP_SIZE (24) // a message of up to 16 bytes with the length of the host
+#define TEST_LENGTH_BYTES (sizeof(configMESSAGE_BUFFER_LENGTH_TYPE))
+#define TEST_BLOCK_SIZE (64)
+#define TEST_BLOCK_MESSAGE_MAX (40)
+#define TEST_BLOCK_ITEMS (20000)
+#define TEST_WAIT_TICKS (1000) // a blocking call which times out fails the test
+#define TEST_FAILURES_SHOWN (10)
+
+#define TEST_CHECK(x) test_check((x) != 0, #x, __LINE__)
+
+enum
+{
+	TEST_WRITE_RESERVE,
+	TEST_WRITE_RESERVE_SHORT, // commits a byte less than reserved
+	TEST_WRITE_SEND,
+	TEST_WRITE_MODES
+};
+
+enum
+{
+	TEST_READ_PEEK,
+	TEST_READ_PEEK_SPLIT, // a stream is consumed in two parts
+	TEST_READ_RECEIVE,
+	TEST_READ_MODES
+};
+
+typedef struct
+{
+	StreamBufferHandle_t stream;
+	BaseType_t message;
+	TaskHandle_t writer;
+	TaskHandle_t reader;
+	uint32_t total; // bytes of a stream
+	uint32_t isr_wakes; // FromISR calls which woke the other task
+	BaseType_t timeout;
+} test_block_t;
+
+static uint32_t test_failures;
+
+static int test_check(int ok, const char *expr, int line)
+{
+	if (!ok)
+	{
+		if (test_failures < TEST_FAILURES_SHOWN)
+		{
+			printf("line %d: %s\n", line, expr);
+		}
+		test_failures++;
+	}
+	return ok;
+}
+
+static uint32_t test_hash(uint32_t k)
+{
+	k *= 0x9E3779B1u;
+	k ^= k >> 15;
+	k *= 0x85EBCA77u;
+	k ^= k >> 13;
+	return k;
+}
+
+// bytes from the position pos of a stream
+static void test_stream_bytes(uint32_t pos, size_t n, uint8_t *out)
+{
+	size_t i;
+	for (i = 0; i < n; i++)
+	{
+		out[i] = (uint8_t)(test_hash(pos + (uint32_t)i) >> 24);
+	}
+}
+
+// bytes of the message k
+static void test_message_bytes(uint32_t k, size_t n, uint8_t *out)
+{
+	size_t i;
+	for (i = 0; i < n; i++)
+	{
+		out[i] = (uint8_t)((test_hash(k) >> 24) + i);
+	}
+}
+
+static size_t test_spans_copy(const StreamBufferSpan_t spans[2], uint8_t *out)
+{
+	memcpy(out, spans[0].pucData, spans[0].xLength);
+	memcpy(&out[spans[0].xLength], spans[1].pucData, spans[1].xLength);
+	return spans[0].xLength + spans[1].xLength;
+}
+
+// The spans of count bytes from the index start of the storage.
+static int test_spans_at(const StreamBufferSpan_t spans[2], uint8_t *storage, size_t length, size_t start, size_t count)
+{
+	size_t first = ((length - start) < count) ? (length - start) : count;
+	return TEST_CHECK(spans[0].pucData == &storage[start]) && TEST_CHECK(spans[0].xLength == first) &&
+		   TEST_CHECK(spans[1].pucData == storage) && TEST_CHECK(spans[1].xLength == count - first);
+}
+
+// Writes len bytes to the empty buffer from the index of its storage and
+// reads them back.
+static void test_wrap_case(StreamBufferHandle_t stream, BaseType_t message, BaseType_t isr, size_t index, size_t len, int write, int read)
+{
+	StreamBufferSpan_t spans[2];
+	uint8_t data[TEST_WRAP_SIZE + 2];
+	uint8_t out[TEST_WRAP_SIZE + 2];
+	uint8_t *storage;
+	size_t length;
+	size_t prefix = message ? TEST_LENGTH_BYTES : 0;
+	size_t expected;
+	size_t committed;
+	size_t start;
+	size_t half;
+	size_t n;
+	size_t i;
+	BaseType_t woken = pdFALSE;
+
+	storage = kernel_stream_storage(stream, &length);
+	kernel_stream_seek(stream, index);
+	if (message)
+	{
+		expected = ((len + prefix) <= TEST_WRAP_SIZE) ? len : 0;
+	}
+	else
+	{
+		expected = (len <= TEST_WRAP_SIZE) ? len : TEST_WRAP_SIZE;
+	}
+	start = (index + prefix) % length;
+	for (i = 0; i < len; i++)
+	{
+		data[i] = (uint8_t)(index * 37 + len * 11 + i + 1);
+	}
+
+	if (write == TEST_WRITE_SEND)
+	{
+		n = isr ? xStreamBufferSendFromISR(stream, data, len, &woken) : xStreamBufferSend(stream, data, len, 0);
+		TEST_CHECK(n == expected);
+		committed = expected;
+	}
+	else
+	{
+		n = isr ? xStreamBufferReserveFromISR(stream, len, spans) : xStreamBufferReserve(stream, len, spans, 0);
+		// a reservation which fails hands out no bytes, from anywhere
+		if (!TEST_CHECK(n == expected) ||
+			((expected == 0) ? !TEST_CHECK((spans[0].xLength == 0) && (spans[1].xLength == 0)) : !test_spans_at(spans, storage, length, start, expected)))
+		{
+			return;
+		}
+		memcpy(spans[0].pucData, data, spans[0].xLength);
+		memcpy(spans[1].pucData, &data[spans[0].xLength], spans[1].xLength);
+		committed = ((write == TEST_WRITE_RESERVE_SHORT) && (expected > 1)) ? (expected - 1) : expected;
+		n = isr ? xStreamBufferCommitFromISR(stream, committed, &woken) : xStreamBufferCommit(stream, committed);
+		TEST_CHECK(n == committed);
+	}
+	// no task waits for the data
+	TEST_CHECK(woken == pdFALSE);
+	if (!TEST_CHECK(xStreamBufferBytesAvailable(stream) == committed + ((committed > 0) ? prefix : 0)))
+	{
+		return;
+	}
+
+	if (committed == 0)
+	{
+		n = isr ? xStreamBufferPeekContiguousFromISR(stream, spans) : xStreamBufferPeekContiguous(stream, spans, 0);
+		TEST_CHECK((n == 0) && (spans[0].xLength == 0) && (spans[1].xLength == 0));
+	}
+	else if (read == TEST_READ_RECEIVE)
+	{
+		n = isr ? xStreamBufferReceiveFromISR(stream, out, sizeof(out), &woken) : xStreamBufferReceive(stream, out, sizeof(out), 0);
+		TEST_CHECK((n == committed) && (memcmp(out, data, committed) == 0));
+	}
+	else
+	{
+		n = isr ? xStreamBufferPeekContiguousFromISR(stream, spans) : xStreamBufferPeekContiguous(stream, spans, 0);
+		if (!TEST_CHECK(n == committed) || !test_spans_at(spans, storage, length, start, committed))
+		{
+			return;
+		}
+		test_spans_copy(spans, out);
+		TEST_CHECK(memcmp(out, data, committed) == 0);
+		// a peek does not remove the data
+		n = isr ? xStreamBufferPeekContiguousFromISR(stream, spans) : xStreamBufferPeekContiguous(stream, spans, 0);
+		TEST_CHECK((n == committed) && (spans[0].pucData == &storage[start]));
+		half = 0;
+		if ((read == TEST_READ_PEEK_SPLIT) && !message && (committed > 1))
+		{
+			half = committed / 2;
+			n = isr ? xStreamBufferConsumeFromISR(stream, half, &woken) : xStreamBufferConsume(stream, half);
+			TEST_CHECK(n == half);
+			n = isr ? xStreamBufferPeekContiguousFromISR(stream, spans) : xStreamBufferPeekContiguous(stream, spans, 0);
+			if (!TEST_CHECK(n == committed - half) || !test_spans_at(spans, storage, length, (start + half) % length, n))
+			{
+				return;
+			}
+			test_spans_copy(spans, out);
+			TEST_CHECK(memcmp(out, &data[half], n) == 0);
+		}
+		n = isr ? xStreamBufferConsumeFromISR(stream, committed - half, &woken) : xStreamBufferConsume(stream, committed - half);
+		TEST_CHECK(n == committed - half);
+	}
+	// no task waits for the space
+	TEST_CHECK(woken == pdFALSE);
+	TEST_CHECK(xStreamBufferIsEmpty(stream) == pdTRUE);
+}
+
+static void test_wrap(BaseType_t message, BaseType_t isr)
+{
+	StreamBufferHandle_t stream;
+	size_t length;
+	size_t index;
+	size_t len;
+	uint32_t cases = 0;
+	uint32_t failures = test_failures;
+	int write;
+	int read;
+
+	stream = message ? xMessageBufferCreate(TEST_WRAP_SIZE) : xStreamBufferCreate(TEST_WRAP_SIZE, 1);
+	configASSERT(stream != NULL);
+	(void)kernel_stream_storage(stream, &length);
+	for (index = 0; index < length; index++)
+	{
+		// up to more than the buffer holds
+		for (len = 1; len <= TEST_WRAP_SIZE + 2; len++)
+		{
+			for (write = 0; write < TEST_WRITE_MODES; write++)
+			{
+				for (read = 0; read < TEST_READ_MODES; read++)
+				{
+					test_wrap_case(stream, message, isr, index, len, write, read);
+					cases++;
+				}
+			}
+		}
+	}
+	vStreamBufferDelete(stream);
+	printf("%-8s %-8s %-6s %8u cases %8u failures\n", "wrap", message ? "message" : "stream", isr ? "isr" : "task", cases, test_failures - failures);
+}
+
+static void test_block_writer(void *arg)
+{
+	test_block_t *test = (test_block_t *)arg;
+	StreamBufferSpan_t spans[2];
+	uint8_t data[TEST_BLOCK_SIZE];
+	size_t prefix = test->message ? TEST_LENGTH_BYTES : 0;
+	size_t len;
+	size_t n;
+	uint32_t pos = 0;
+	uint32_t k;
+	uint32_t h;
+	uint32_t mode;
+	BaseType_t woken;
+	BaseType_t blocked;
+
+	for (k = 0; (k < TEST_BLOCK_ITEMS) && !test->timeout; k++)
+	{
+		h = test_hash(k);
+		mode = (h >> 8) % 3;
+		if (test->message)
+		{
+			len = 1 + h % TEST_BLOCK_MESSAGE_MAX;
+			test_message_bytes(k, len, data);
+		}
+		else
+		{
+			len = 1 + h % TEST_BLOCK_SIZE;
+			test_stream_bytes(pos, len, data);
+		}
+		// the FromISR reserve does not wait, the space is waited for by a
+		// reservation which is dropped
+		if ((mode == 1) && (xStreamBufferSpacesAvailable(test->stream) < len + prefix))
+		{
+			(void)xStreamBufferReserve(test->stream, len, spans, TEST_WAIT_TICKS);
+		}
+		if (mode == 2)
+		{
+			n = xStreamBufferSend(test->stream, data, len, TEST_WAIT_TICKS);
+		}
+		else
+		{
+			n = (mode == 1) ? xStreamBufferReserveFromISR(test->stream, len, spans) : xStreamBufferReserve(test->stream, len, spans, TEST_WAIT_TICKS);
+			if (n == len)
+			{
+				memcpy(spans[0].pucData, data, spans[0].xLength);
+				memcpy(spans[1].pucData, &data[spans[0].xLength], spans[1].xLength);
+				if (mode == 1)
+				{
+					woken = pdFALSE;
+					blocked = kernel_task_blocked(test->reader);
+					n = xStreamBufferCommitFromISR(test->stream, len, &woken);
+					TEST_CHECK(woken == blocked);
+					test->isr_wakes += (woken != pdFALSE) ? 1 : 0;
+				}
+				else
+				{
+					n = xStreamBufferCommit(test->stream, len);
+				}
+			}
+		}
+		if (!TEST_CHECK(n == len))
+		{
+			test->timeout = pdTRUE;
+			break;
+		}
+		pos += (uint32_t)len;
+	}
+}
+
+static void test_block_reader(void *arg)
+{
+	test_block_t *test = (test_block_t *)arg;
+	StreamBufferSpan_t spans[2];
+	uint8_t data[TEST_BLOCK_SIZE];
+	uint8_t out[TEST_BLOCK_SIZE];
+	size_t prefix = test->message ? TEST_LENGTH_BYTES : 0;
+	size_t len = 0;
+	size_t n;
+	size_t c;
+	uint32_t pos = 0;
+	uint32_t k = 0;
+	uint32_t op;
+	uint32_t h;
+	uint32_t mode;
+	BaseType_t woken;
+	BaseType_t blocked;
+
+	for (op = 0; (test->message ? (k < TEST_BLOCK_ITEMS) : (pos < test->total)) && !test->timeout; op++)
+	{
+		h = test_hash(op + 0x80000000u);
+		mode = (h >> 8) % 3;
+		if (test->message)
+		{
+			len = 1 + test_hash(k) % TEST_BLOCK_MESSAGE_MAX;
+		}
+		// the FromISR peek does not wait, the data is waited for by a peek
+		if ((mode == 1) && (xStreamBufferBytesAvailable(test->stream) <= prefix))
+		{
+			(void)xStreamBufferPeekContiguous(test->stream, spans, TEST_WAIT_TICKS);
+		}
+		if (mode == 2)
+		{
+			n = xStreamBufferReceive(test->stream, out, test->message ? sizeof(out) : (1 + h % TEST_BLOCK_SIZE), TEST_WAIT_TICKS);
+			c = n;
+		}
+		else
+		{
+			n = (mode == 1) ? xStreamBufferPeekContiguousFromISR(test->stream, spans) : xStreamBufferPeekContiguous(test->stream, spans, TEST_WAIT_TICKS);
+			c = n;
+			if (n != 0)
+			{
+				TEST_CHECK(test_spans_copy(spans, out) == n);
+				// a stream is consumed in parts, a message whole
+				if (!test->message)
+				{
+					c = 1 + h % n;
+				}
+				if (mode == 1)
+				{
+					woken = pdFALSE;
+					blocked = kernel_task_blocked(test->writer);
+					TEST_CHECK(xStreamBufferConsumeFromISR(test->stream, c, &woken) == c);
+					TEST_CHECK(woken == blocked);
+					test->isr_wakes += (woken != pdFALSE) ? 1 : 0;
+				}
+				else
+				{
+					TEST_CHECK(xStreamBufferConsume(test->stream, c) == c);
+				}
+			}
+		}
+		if (!TEST_CHECK(n != 0))
+		{
+			test->timeout = pdTRUE;
+			break;
+		}
+		if (test->message)
+		{
+			test_message_bytes(k, len, data);
+			TEST_CHECK((n == len) && (memcmp(out, data, len) == 0));
+			k++;
+		}
+		else
+		{
+			test_stream_bytes(pos, c, data);
+			TEST_CHECK(memcmp(out, data, c) == 0);
+			pos += (uint32_t)c;
+		}
+	}
+}
+
+static void test_block(BaseType_t message)
+{
+	test_block_t test;
+	uint32_t failures = test_failures;
+	uint32_t k;
+
+	memset(&test, 0, sizeof(test));
+	test.message = message;
+	test.stream = message ? xMessageBufferCreate(TEST_BLOCK_SIZE) : xStreamBufferCreate(TEST_BLOCK_SIZE, 1);
+	configASSERT(test.stream != NULL);
+	for (k = 0; k < TEST_BLOCK_ITEMS; k++)
+	{
+		test.total += 1 + test_hash(k) % TEST_BLOCK_SIZE;
+	}
+	test.writer = kernel_task_create(test_block_writer, &test);
+	test.reader = kernel_task_create(test_block_reader, &test);
+	kernel_run();
+	// both sides must have waited for the other one
+	TEST_CHECK(kernel_task_waits(test.writer) != 0);
+	TEST_CHECK(kernel_task_waits(test.reader) != 0);
+	TEST_CHECK(test.isr_wakes != 0);
+	TEST_CHECK(xStreamBufferIsEmpty(test.stream) == pdTRUE);
+	vStreamBufferDelete(test.stream);
+	printf("%-8s %-8s %8u items, waits %u writer %u reader, %u isr wakes, %u failures\n", "block", message ? "message" : "stream", TEST_BLOCK_ITEMS,
+		   kernel_task_waits(test.writer), kernel_task_waits(test.reader), test.isr_wakes, test_failures - failures);
+}
+
+int main(int argc, char *argv[])
+{
+	(void)argc;
+	(void)argv;
+
+	test_wrap(pdFALSE, pdFALSE);
+	test_wrap(pdFALSE, pdTRUE);
+	test_wrap(pdTRUE, pdFALSE);
+	test_wrap(pdTRUE, pdTRUE);
+	test_block(pdFALSE);
+	test_block(pdTRUE);
+	printf("%u failures\n", test_failures);
+	return (test_failures == 0) ? 0 : -1;
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "list.h"
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_TCP_WIN.h"
+#include "host_port.h"
+
+// Time taken by FreeRTOS_TCP_WIN.c to process an ACK, a SACK and a retransmitted
+// out-of-order segment, against the number of segments outstanding in the window.
+// The segments are found with a binary search in the sorted rings of the window,
+// so apart from the SACK in the middle, which counts a duplicate ACK for each of
+// the count / 2 segments below it, the times should not grow with the window.
+// Windows above ipconfigTCP_WIN_RING_LENGTH segments are skipped, build with
+// DEFS=-DipconfigTCP_WIN_RING_LENGTH=256 for all of them.
+
+#define BENCH_MSS (1460)
+#define BENCH_SEQ (0xFFFF0000UL) // wraps inside the window
+#define BENCH_ACK (0x10000000UL)
+#define BENCH_ROUNDS (2000)
+
+static const uint32_t bench_counts[] = {1, 8, 16, 32, 64, 128, 200};
+static TCPWindow_t window;
+
+void *pvPortMalloc(size_t xSize)
+{
+	return malloc(xSize);
+}
+
+void vPortFree(void *pv)
+{
+	free(pv);
+}
+
+// count segments sent and waiting for their ACK
+static void bench_tx_fill(uint32_t count)
+{
+	int32_t position;
+	uint32_t length = count * BENCH_MSS;
+
+	memset(&window, 0, sizeof(window));
+	vTCPWindowCreate(&window, length, length, BENCH_ACK, BENCH_SEQ, BENCH_MSS);
+	if (lTCPWindowTxAdd(&window, length, 0, (int32_t)(length + BENCH_MSS)) != (int32_t)length)
+	{
+		fprintf(stderr, "can not queue %u segments\n", count);
+		exit(1);
+	}
+	while (ulTCPWindowTxGet(&window, length, &position) != 0)
+	{
+	}
+	if (listCURRENT_LIST_LENGTH(&window.xWaitQueue) != count)
+	{
+		fprintf(stderr, "%u segments outstanding instead of %u\n", (unsigned)listCURRENT_LIST_LENGTH(&window.xWaitQueue), count);
+		exit(1);
+	}
+}
+
+// count out-of-order segments stored, with a gap before each of them
+static void bench_rx_fill(uint32_t count)
+{
+	uint32_t i;
+	uint32_t space = (2 * count + 2) * BENCH_MSS;
+
+	memset(&window, 0, sizeof(window));
+	vTCPWindowCreate(&window, space, space, BENCH_ACK, BENCH_SEQ, BENCH_MSS);
+	for (i = 0; i < count; i++)
+	{
+		if (lTCPWindowRxCheck(&window, BENCH_ACK + (2 * i + 1) * BENCH_MSS, BENCH_MSS, space) <= 0)
+		{
+			fprintf(stderr, "can not store rx segment %u\n", i);
+			exit(1);
+		}
+	}
+}
+
+static void bench_check(uint32_t value, uint32_t expected, const char *what)
+{
+	if (value != expected)
+	{
+		fprintf(stderr, "%s: %u instead of %u\n", what, value, expected);
+		exit(1);
+	}
+}
+
+int main(void)
+{
+	uint32_t i, round, count, ret;
+	uint64_t t0, overhead, ack_ns, sack_ns, sack_mid_ns, ack_all_ns, rx_ns;
+
+	t0 = host_time_ns();
+	for (round = 0; round < BENCH_ROUNDS; round++)
+	{
+		(void)host_time_ns();
+	}
+	overhead = (host_time_ns() - t0) / BENCH_ROUNDS;
+
+	printf("ring length %d, mss %d, %d rounds, times in ns\n", ipconfigTCP_WIN_RING_LENGTH, BENCH_MSS, BENCH_ROUNDS);
+	printf("segments      ack     sack sack mid  ack all/seg  rx retrans\n");
+	for (i = 0; i < sizeof(bench_counts) / sizeof(bench_counts[0]); i++)
+	{
+		count = bench_counts[i];
+		if (count > ipconfigTCP_WIN_RING_LENGTH)
+		{
+			break;
+		}
+		ack_ns = sack_ns = sack_mid_ns = ack_all_ns = rx_ns = 0;
+		for (round = 0; round < BENCH_ROUNDS; round++)
+		{
+			host_set_tick_count(round);
+
+			// ACK of the oldest segment
+			bench_tx_fill(count);
+			t0 = host_time_ns();
+			ret = ulTCPWindowTxAck(&window, BENCH_SEQ + BENCH_MSS);
+			ack_ns += host_time_ns() - t0;
+			bench_check(ret, BENCH_MSS, "ack");
+			vTCPWindowDestroy(&window);
+
+			// SACK of the second segment, the first one was lost
+			bench_tx_fill(count);
+			t0 = host_time_ns();
+			ret = ulTCPWindowTxSack(&window, BENCH_SEQ + BENCH_MSS, BENCH_SEQ + 2 * BENCH_MSS);
+			sack_ns += host_time_ns() - t0;
+			bench_check(ret, 0, "sack");
+			vTCPWindowDestroy(&window);
+
+			// SACK of the segment in the middle of the window
+			bench_tx_fill(count);
+			t0 = host_time_ns();
+			ret = ulTCPWindowTxSack(&window, BENCH_SEQ + (count / 2) * BENCH_MSS, BENCH_SEQ + (count / 2 + 1) * BENCH_MSS);
+			sack_mid_ns += host_time_ns() - t0;
+			bench_check(ret, (count == 1) ? BENCH_MSS : 0, "sack mid");
+			vTCPWindowDestroy(&window);
+
+			// ACK of the whole window
+			bench_tx_fill(count);
+			t0 = host_time_ns();
+			ret = ulTCPWindowTxAck(&window, BENCH_SEQ + count * BENCH_MSS);
+			ack_all_ns += host_time_ns() - t0;
+			bench_check(ret, count * BENCH_MSS, "ack all");
+			vTCPWindowDestroy(&window);
+
+			// second reception of the out-of-order segment in the middle
+			bench_rx_fill(count);
+			t0 = host_time_ns();
+			ret = (uint32_t)lTCPWindowRxCheck(&window, BENCH_ACK + (2 * (count / 2) + 1) * BENCH_MSS, BENCH_MSS, (2 * count + 2) * BENCH_MSS);
+			rx_ns += host_time_ns() - t0;
+			bench_check(ret, (uint32_t)-1, "rx retrans");
+			vTCPWindowDestroy(&window);
+		}
+		printf("%8u %8.0f %8.0f %8.0f %12.1f %11.0f\n", count,
+			(double)(ack_ns - overhead * BENCH_ROUNDS) / BENCH_ROUNDS,
+			(double)(sack_ns - overhead * BENCH_ROUNDS) / BENCH_ROUNDS,
+			(double)(sack_mid_ns - overhead * BENCH_ROUNDS) / BENCH_ROUNDS,
+			(double)(ack_all_ns - overhead * BENCH_ROUNDS) / BENCH_ROUNDS / count,
+			(double)(rx_ns - overhead * BENCH_ROUNDS) / BENCH_ROUNDS);
+	}
+	vTCPSegmentCleanup();
+	return 0;
+}
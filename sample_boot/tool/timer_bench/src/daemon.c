@@ -0,0 +1,164 @@
+#include <stdlib.h>
+#include <string.h>
+
+// timers.c is built here so that the tool can run the loop of the timer
+// service task one pass at a time, the task itself is never started.
+#include "timers.c"
+#include "daemon.h"
+
+// The kernel services used by timers.c. The queue is a ring buffer, a wait
+// for a message only records the tick the daemon would wake at.
+
+typedef struct
+{
+	UBaseType_t length;
+	UBaseType_t item_size;
+	UBaseType_t head;
+	UBaseType_t count;
+	uint8_t items[];
+} host_queue_t;
+
+#if (configUSE_TIMER_WHEEL == 1)
+const char *const daemon_kind = "timer wheel";
+#else
+const char *const daemon_kind = "sorted lists";
+#endif
+
+static BaseType_t daemon_block;
+static BaseType_t daemon_forever;
+static TickType_t daemon_wake;
+
+void *pvPortMalloc(size_t xSize)
+{
+	return malloc(xSize);
+}
+
+void vPortFree(void *pv)
+{
+	free(pv);
+}
+
+QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType)
+{
+	host_queue_t *queue = calloc(1, sizeof(host_queue_t) + uxQueueLength * uxItemSize);
+
+	(void)ucQueueType;
+	configASSERT(queue != NULL);
+	queue->length = uxQueueLength;
+	queue->item_size = uxItemSize;
+	return (QueueHandle_t)queue;
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void *const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition)
+{
+	host_queue_t *queue = (host_queue_t *)xQueue;
+	UBaseType_t index;
+
+	(void)xTicksToWait;
+	if (queue->count == queue->length)
+	{
+		return errQUEUE_FULL;
+	}
+	if (xCopyPosition == queueSEND_TO_FRONT)
+	{
+		queue->head = (queue->head + queue->length - 1) % queue->length;
+		index = queue->head;
+	}
+	else
+	{
+		index = (queue->head + queue->count) % queue->length;
+	}
+	memcpy(&queue->items[index * queue->item_size], pvItemToQueue, queue->item_size);
+	queue->count++;
+	return pdPASS;
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t xQueue, const void *const pvItemToQueue, BaseType_t *const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition)
+{
+	if (pxHigherPriorityTaskWoken != NULL)
+	{
+		*pxHigherPriorityTaskWoken = pdFALSE;
+	}
+	return xQueueGenericSend(xQueue, pvItemToQueue, 0, xCopyPosition);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *const pvBuffer, TickType_t xTicksToWait)
+{
+	host_queue_t *queue = (host_queue_t *)xQueue;
+
+	(void)xTicksToWait;
+	if (queue->count == 0)
+	{
+		return pdFAIL;
+	}
+	memcpy(pvBuffer, &queue->items[queue->head * queue->item_size], queue->item_size);
+	queue->head = (queue->head + 1) % queue->length;
+	queue->count--;
+	return pdPASS;
+}
+
+void vQueueWaitForMessageRestricted(QueueHandle_t xQueue, TickType_t xTicksToWait, const BaseType_t xWaitIndefinitely)
+{
+	// as the kernel, the daemon does not block if a command is queued
+	if (((host_queue_t *)xQueue)->count == 0)
+	{
+		daemon_block = pdTRUE;
+		daemon_forever = xWaitIndefinitely;
+		daemon_wake = xTaskGetTickCount() + xTicksToWait;
+	}
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *const pcName, const configSTACK_DEPTH_TYPE usStackDepth, void *const pvParameters, UBaseType_t uxPriority, TaskHandle_t *const pxCreatedTask)
+{
+	(void)pxTaskCode;
+	(void)pcName;
+	(void)usStackDepth;
+	(void)pvParameters;
+	(void)uxPriority;
+	if (pxCreatedTask != NULL)
+	{
+		*pxCreatedTask = NULL;
+	}
+	return pdPASS;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+	return taskSCHEDULER_RUNNING;
+}
+
+// the body of the loop of prvTimerTask()
+void daemon_pass(void)
+{
+	daemon_block = pdFALSE;
+
+#if (configUSE_TIMER_WHEEL == 1)
+	prvProcessTimerWheelOrBlockTask();
+#else
+	{
+		TickType_t xNextExpireTime;
+		BaseType_t xListWasEmpty;
+
+		xNextExpireTime = prvGetNextExpireTime(&xListWasEmpty);
+		prvProcessTimerOrBlockTask(xNextExpireTime, xListWasEmpty);
+	}
+#endif
+
+	prvProcessReceivedCommands();
+}
+
+BaseType_t daemon_blocked(TickType_t *wake, BaseType_t *forever)
+{
+	*wake = daemon_wake;
+	*forever = daemon_forever;
+	return daemon_block;
+}
+
+UBaseType_t daemon_active_timers(void)
+{
+#if (configUSE_TIMER_WHEEL == 1)
+	return uxTimersInWheel;
+#else
+	return listCURRENT_LIST_LENGTH(pxCurrentTimerList) + listCURRENT_LIST_LENGTH(pxOverflowTimerList);
+#endif
+}
@@ -0,0 +1,25 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// timers.c as built in daemon.c: "timer wheel" or "sorted lists"
+extern const char *const daemon_kind;
+
+// one pass of the loop of the timer service task
+void daemon_pass(void);
+// pdTRUE if the last pass blocked the daemon, until the tick *wake or until
+// a command is received, or only until a command if *forever is pdTRUE
+BaseType_t daemon_blocked(TickType_t *wake, BaseType_t *forever);
+// timers in the wheel or in the lists of active timers
+UBaseType_t daemon_active_timers(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,387 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "timers.h"
+#include "host_port.h"
+#include "daemon.h"
+
+// Randomised test and daemon load of the active timers of timers.c, the timer
+// wheel by default, the sorted lists with DEFS=-DconfigUSE_TIMER_WHEEL=0.
+// The test starts, resets, stops and changes the period of BENCH_TIMERS timers
+// at random ticks and checks that every timer expires at the tick of a reference
+// model, across a tick count overflow. The load is the time the daemon takes
+// with many auto reload timers, reset all the time as the TCP timers are.
+
+#define BENCH_TIMERS (1000)
+#define BENCH_SEEDS (4)
+#define BENCH_TICK0 (0xFFF00000ULL) // the tick count wraps early in a run
+#define BENCH_TEST_TICKS (2500000ULL)
+#define BENCH_MIN_RELOAD (64) // shortest auto reload period of the test
+#define BENCH_MAX_PASSES (100000)
+#define BENCH_LOAD_TICKS (200000ULL)
+#define BENCH_LOAD_PERIOD (5000)
+#define BENCH_LOAD_GAP (4) // ticks between two resets of the load
+
+typedef struct
+{
+	UBaseType_t timers;
+	uint32_t period_bits; // periods up to 2^period_bits ticks
+	uint32_t max_gap; // ticks between two commands
+} bench_test_t;
+
+typedef struct
+{
+	TimerHandle_t handle;
+	uint64_t expiry;
+	TickType_t period;
+	BaseType_t autoreload;
+	BaseType_t active;
+} bench_timer_t;
+
+// up to twice the range of the wheel, then few timers that expire often and
+// cascade into an empty wheel
+static const bench_test_t bench_tests[] = {
+	{BENCH_TIMERS, 21, 16},
+	{16, 12, 64},
+	{2, 8, 256},
+};
+static const UBaseType_t bench_loads[] = {10, 100, 1000};
+
+static const bench_test_t *bench_run;
+static bench_timer_t bench_timers[BENCH_TIMERS];
+static UBaseType_t bench_count;
+static UBaseType_t bench_active;
+static BaseType_t bench_check;
+static uint64_t bench_now; // the tick count is the low 32 bits
+static uint64_t bench_wake; // tick the daemon waits for
+static uint64_t bench_expired;
+static uint64_t bench_passes;
+static uint64_t bench_daemon_ns;
+static uint64_t bench_daemon_max;
+static uint64_t bench_overhead;
+
+static uint32_t bench_rand(uint32_t *seed)
+{
+	*seed = *seed * 1103515245U + 12345U;
+	return *seed >> 8;
+}
+
+static void bench_fail(const char *what, const bench_timer_t *ref)
+{
+	fprintf(stderr, "FAIL: %s, %s, tick %llu", what, daemon_kind, (unsigned long long)bench_now);
+	if (ref != NULL)
+	{
+		fprintf(stderr, ", timer %u period %u %s, %s expiry %llu", (unsigned)(ref - bench_timers), (unsigned)ref->period,
+			ref->autoreload ? "auto reload" : "one shot", ref->active ? "active" : "stopped", (unsigned long long)ref->expiry);
+	}
+	fprintf(stderr, "\n");
+	exit(1);
+}
+
+// log-uniform, from 1 tick to 2^period_bits ticks of the run
+static TickType_t bench_period(uint32_t *seed, TickType_t min)
+{
+	TickType_t period = (TickType_t)1 << (bench_rand(seed) % bench_run->period_bits);
+
+	period += bench_rand(seed) & (period - 1);
+	return (period < min) ? min + period : period;
+}
+
+// the expiry must be the one of the reference, at the tick of the reference
+static void bench_callback(TimerHandle_t timer)
+{
+	bench_timer_t *ref = &bench_timers[(uintptr_t)pvTimerGetTimerID(timer)];
+
+	bench_expired++;
+	if (bench_check)
+	{
+		if (!ref->active)
+		{
+			bench_fail("stopped timer expired", ref);
+		}
+		if (ref->expiry != bench_now)
+		{
+			bench_fail("expired at the wrong tick", ref);
+		}
+		if (ref->autoreload)
+		{
+			ref->expiry += ref->period;
+		}
+		else
+		{
+			ref->active = pdFALSE;
+			bench_active--;
+		}
+	}
+}
+
+static void bench_set_now(uint64_t now)
+{
+	bench_now = now;
+	host_set_tick_count((TickType_t)now);
+}
+
+// runs the daemon until it blocks, as it does when woken at this tick
+static void bench_run_daemon(void)
+{
+	TickType_t wake;
+	BaseType_t forever;
+	uint64_t t0, ns;
+	uint32_t passes = 0;
+
+	t0 = host_time_ns();
+	do
+	{
+		if (++passes > BENCH_MAX_PASSES)
+		{
+			bench_fail("the daemon does not block", NULL);
+		}
+		daemon_pass();
+	} while (daemon_blocked(&wake, &forever) == pdFALSE);
+	ns = host_time_ns() - t0;
+	ns = (ns > bench_overhead) ? ns - bench_overhead : 0;
+	bench_daemon_ns += ns;
+	bench_daemon_max = (ns > bench_daemon_max) ? ns : bench_daemon_max;
+	bench_passes += passes;
+
+	if (forever)
+	{
+		bench_wake = UINT64_MAX;
+	}
+	else if ((TickType_t)(wake - (TickType_t)bench_now) == 0)
+	{
+		bench_fail("the daemon blocks for no tick", NULL);
+	}
+	else
+	{
+		bench_wake = bench_now + (TickType_t)(wake - (TickType_t)bench_now);
+	}
+}
+
+static void bench_create(UBaseType_t count, uint32_t seed)
+{
+	UBaseType_t i;
+	bench_timer_t *ref;
+
+	for (i = 0; i < count; i++)
+	{
+		ref = &bench_timers[i];
+		ref->autoreload = (bench_rand(&seed) & 1) ? pdTRUE : pdFALSE;
+		ref->period = bench_period(&seed, ref->autoreload ? BENCH_MIN_RELOAD : 1);
+		ref->active = pdFALSE;
+		ref->handle = xTimerCreate("bench", ref->period, (UBaseType_t)ref->autoreload, (void *)(uintptr_t)i, bench_callback);
+		if (ref->handle == NULL)
+		{
+			bench_fail("xTimerCreate", ref);
+		}
+	}
+	bench_count = count;
+	bench_active = 0;
+}
+
+static void bench_delete(void)
+{
+	UBaseType_t i;
+
+	bench_check = pdFALSE;
+	for (i = 0; i < bench_count; i++)
+	{
+		if (xTimerDelete(bench_timers[i].handle, 0) != pdPASS)
+		{
+			bench_fail("xTimerDelete", &bench_timers[i]);
+		}
+		bench_run_daemon();
+	}
+	if (daemon_active_timers() != 0)
+	{
+		bench_fail("timers left active", NULL);
+	}
+	bench_count = 0;
+}
+
+static void bench_command(uint32_t *seed)
+{
+	bench_timer_t *ref = &bench_timers[bench_rand(seed) % bench_count];
+	BaseType_t result;
+	uint32_t op;
+
+	// the daemon has processed the ticks up to this one
+	if (ref->active && (ref->expiry <= bench_now))
+	{
+		bench_fail("expiry missed", ref);
+	}
+	if ((xTimerIsTimerActive(ref->handle) != pdFALSE) != (ref->active != pdFALSE))
+	{
+		bench_fail("active state", ref);
+	}
+	if (daemon_active_timers() != bench_active)
+	{
+		bench_fail("count of active timers", NULL);
+	}
+
+	// processed by the daemon at this tick: a stop leaves the timer stopped,
+	// the other commands start it for a period from now
+	op = bench_rand(seed) % 8;
+	switch (op)
+	{
+	case 0:
+	case 1:
+		result = xTimerStart(ref->handle, 0);
+		break;
+	case 2:
+	case 3:
+		result = xTimerReset(ref->handle, 0);
+		break;
+	case 4:
+	case 5:
+		result = xTimerStop(ref->handle, 0);
+		break;
+	default:
+		ref->period = bench_period(seed, ref->autoreload ? BENCH_MIN_RELOAD : 1);
+		result = xTimerChangePeriod(ref->handle, ref->period, 0);
+		break;
+	}
+	if (result != pdPASS)
+	{
+		bench_fail("command not queued", ref);
+	}
+
+	bench_active -= ref->active ? 1 : 0;
+	ref->active = (op == 4 || op == 5) ? pdFALSE : pdTRUE;
+	bench_active += ref->active ? 1 : 0;
+	ref->expiry = bench_now + ref->period;
+}
+
+static void bench_test(const bench_test_t *run, const uint32_t first)
+{
+	uint32_t seed = first;
+	uint64_t end = BENCH_TICK0 + BENCH_TEST_TICKS;
+	uint64_t next, next_now;
+	uint32_t commands = 0;
+	UBaseType_t i;
+
+	bench_run = run;
+	bench_check = pdTRUE;
+	bench_expired = 0;
+	bench_set_now(BENCH_TICK0);
+	bench_create(run->timers, seed);
+	bench_run_daemon();
+
+	next = bench_now;
+	while (bench_now < end)
+	{
+		// the daemon has the higher priority, it runs first at a tick
+		if (bench_wake <= bench_now)
+		{
+			bench_run_daemon();
+		}
+		if (next == bench_now)
+		{
+			bench_command(&seed);
+			bench_run_daemon();
+			commands++;
+			next += 1 + bench_rand(&seed) % run->max_gap;
+		}
+		next_now = (bench_wake < next) ? bench_wake : next;
+		bench_set_now((next_now < end) ? next_now : end);
+	}
+	for (i = 0; i < bench_count; i++)
+	{
+		if (bench_timers[i].active && (bench_timers[i].expiry < end))
+		{
+			bench_fail("expiry missed", &bench_timers[i]);
+		}
+	}
+	if (daemon_active_timers() != bench_active)
+	{
+		bench_fail("count of active timers", NULL);
+	}
+	printf("seed %08x: %u timers, %u commands, %llu expiries OK\n", (unsigned)first, (unsigned)bench_count, (unsigned)commands,
+		(unsigned long long)bench_expired);
+	bench_delete();
+}
+
+// count auto reload timers, one of them reset every BENCH_LOAD_GAP ticks
+static void bench_load(UBaseType_t count)
+{
+	uint32_t seed = 0x5EED;
+	uint64_t end, next;
+	UBaseType_t i;
+
+	bench_check = pdFALSE;
+	bench_set_now(BENCH_TICK0);
+	bench_wake = UINT64_MAX;
+	for (i = 0; i < count; i++)
+	{
+		bench_timers[i].period = 10 + bench_rand(&seed) % BENCH_LOAD_PERIOD;
+		bench_timers[i].handle = xTimerCreate("load", bench_timers[i].period, pdTRUE, (void *)(uintptr_t)i, bench_callback);
+		if ((bench_timers[i].handle == NULL) || (xTimerStart(bench_timers[i].handle, 0) != pdPASS))
+		{
+			bench_fail("xTimerStart", &bench_timers[i]);
+		}
+		bench_run_daemon();
+	}
+	bench_count = count;
+
+	bench_expired = 0;
+	bench_passes = 0;
+	bench_daemon_ns = 0;
+	bench_daemon_max = 0;
+	end = bench_now + BENCH_LOAD_TICKS;
+	next = bench_now;
+	while (bench_now < end)
+	{
+		if (bench_wake <= bench_now)
+		{
+			bench_run_daemon();
+		}
+		if (next == bench_now)
+		{
+			if (xTimerReset(bench_timers[bench_rand(&seed) % count].handle, 0) != pdPASS)
+			{
+				bench_fail("xTimerReset", NULL);
+			}
+			bench_run_daemon();
+			next += BENCH_LOAD_GAP;
+		}
+		bench_set_now((bench_wake < next) ? bench_wake : next);
+	}
+	printf("%8u %10.1f %10.1f %10.1f %10u\n", (unsigned)count, (double)bench_daemon_ns / BENCH_LOAD_TICKS,
+		(double)bench_daemon_ns / (bench_expired + BENCH_LOAD_TICKS / BENCH_LOAD_GAP), (double)bench_passes / BENCH_LOAD_TICKS,
+		(unsigned)bench_daemon_max);
+	bench_delete();
+}
+
+int main(void)
+{
+	uint32_t i;
+	uint64_t t0;
+
+	t0 = host_time_ns();
+	for (i = 0; i < 100000; i++)
+	{
+		(void)host_time_ns();
+	}
+	bench_overhead = (host_time_ns() - t0) / 100000;
+
+	uxHostCoreID = 0;
+	bench_set_now(BENCH_TICK0);
+	if (xTimerCreateTimerTask() != pdPASS)
+	{
+		bench_fail("xTimerCreateTimerTask", NULL);
+	}
+
+	printf("active timers in %s\n", daemon_kind);
+	for (i = 0; i < BENCH_SEEDS * sizeof(bench_tests) / sizeof(bench_tests[0]); i++)
+	{
+		bench_test(&bench_tests[i / BENCH_SEEDS], 0x1234567U + i * 0x9E3779B9U);
+	}
+	printf("daemon load   ns/tick   ns/event  passes/tick   max ns\n");
+	for (i = 0; i < sizeof(bench_loads) / sizeof(bench_loads[0]); i++)
+	{
+		bench_load(bench_loads[i]);
+	}
+	printf("OK\n");
+	return 0;
+}
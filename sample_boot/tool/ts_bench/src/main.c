@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "porttimestamp.h"
+
+// Host bench of the timestamp conversions of the PowerPC port, porttimestamp.h,
+// against the 64-bit divisions they replaced: ticks / (configCPU_CLOCK_HZ / N).
+// The target has no 64 by 32 bit divide, the compiler calls __udivdi3 of
+// libgcc, which soft_udivdi3() follows with 32-bit divisions only. The native
+// column is the divide instruction of the host, a lower bound.
+//
+// Every conversion is first checked against the exact 128-bit quotient.
+
+#define BENCH_SAMPLES (4096)
+#define BENCH_PASSES (2000)
+#define BENCH_CHECKS (10000000)
+
+typedef struct
+{
+	const char *name;
+	uint64_t n; // units per second
+} bench_unit_t;
+
+static const bench_unit_t bench_units[] = {
+	{"s", 1u},
+	{"ms", 1000u},
+	{"us", 1000000u},
+	{"ns", 1000000000u},
+};
+
+static uint64_t bench_ticks[BENCH_SAMPLES];
+static volatile uint64_t bench_sink;
+
+static uint64_t bench_time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench_rand64(void)
+{
+	return ((uint64_t)(rand() & 0xFFFF) << 48) | ((uint64_t)(rand() & 0xFFFF) << 32) |
+		   ((uint64_t)(rand() & 0xFFFF) << 16) | (uint64_t)(rand() & 0xFFFF);
+}
+
+// __udiv_qrnnd_c of longlong.h: (n1:n0) / d for n1 < d and d normalised, from
+// 32 by 16 bit steps, r the remainder
+static uint32_t udiv_qrnnd(uint32_t *r, uint32_t n1, uint32_t n0, uint32_t d)
+{
+	uint32_t d1 = d >> 16;
+	uint32_t d0 = d & 0xFFFFu;
+	uint32_t q1;
+	uint32_t q0;
+	uint32_t r1;
+	uint32_t r0;
+	uint32_t m;
+	q1 = n1 / d1;
+	r1 = n1 - q1 * d1;
+	m = q1 * d0;
+	r1 = (r1 << 16) | (n0 >> 16);
+	if (r1 < m)
+	{
+		q1--;
+		r1 += d;
+		// no carry out of r1
+		if ((r1 >= d) && (r1 < m))
+		{
+			q1--;
+			r1 += d;
+		}
+	}
+	r1 -= m;
+	q0 = r1 / d1;
+	r0 = r1 - q0 * d1;
+	m = q0 * d0;
+	r0 = (r0 << 16) | (n0 & 0xFFFFu);
+	if (r0 < m)
+	{
+		q0--;
+		r0 += d;
+		if ((r0 >= d) && (r0 < m))
+		{
+			q0--;
+			r0 += d;
+		}
+	}
+	*r = r0 - m;
+	return (q1 << 16) | q0;
+}
+
+// __udivmoddi4 of libgcc for a divisor below 2^32, a call like on the target
+static __attribute__((noinline)) uint64_t soft_udivdi3(uint64_t n, uint32_t d)
+{
+	uint32_t n1 = (uint32_t)(n >> 32);
+	uint32_t n0 = (uint32_t)n;
+	uint32_t n2;
+	uint32_t q1 = 0;
+	uint32_t q0;
+	uint32_t r;
+	uint32_t bm = (uint32_t)__builtin_clz(d);
+	if (n1 < d)
+	{
+		if (bm != 0)
+		{
+			d <<= bm;
+			n1 = (n1 << bm) | (n0 >> (32 - bm));
+			n0 <<= bm;
+		}
+	}
+	else if (bm == 0)
+	{
+		// the divisor has its top bit set, the high quotient is 1
+		n1 -= d;
+		q1 = 1;
+	}
+	else
+	{
+		d <<= bm;
+		n2 = n1 >> (32 - bm);
+		n1 = (n1 << bm) | (n0 >> (32 - bm));
+		n0 <<= bm;
+		q1 = udiv_qrnnd(&r, n2, n1, d);
+		n1 = r;
+	}
+	q0 = udiv_qrnnd(&r, n1, n0, d);
+	return ((uint64_t)q1 << 32) | q0;
+}
+
+static __attribute__((noinline)) uint64_t native_udivdi3(uint64_t n, uint32_t d)
+{
+	return n / d;
+}
+
+// the conversion of the port for the unit, a call like on the target
+static __attribute__((noinline)) uint64_t bench_convert(uint64_t ticks, uint32_t unit)
+{
+	switch (unit)
+	{
+	case 0:
+		return portTS_CONVERT(ticks, 1u);
+	case 1:
+		return portTS_CONVERT(ticks, 1000u);
+	case 2:
+		return portTS_CONVERT(ticks, 1000000u);
+	default:
+		return portTS_CONVERT(ticks, 1000000000u);
+	}
+}
+
+// Returns the conversions which differ from the exact quotient.
+static uint64_t bench_check(uint32_t unit)
+{
+	uint64_t n = bench_units[unit].n;
+	uint64_t fails = 0;
+	uint64_t ticks;
+	unsigned __int128 exact;
+	uint32_t i;
+	for (i = 0; i < BENCH_CHECKS; i++)
+	{
+		// the full range, then the first hours of counting, then around the powers of two
+		if (i % 3 == 0)
+		{
+			ticks = bench_rand64();
+		}
+		else if (i % 3 == 1)
+		{
+			ticks = bench_rand64() >> 24;
+		}
+		else
+		{
+			ticks = (1ULL << (i % 64)) + (uint64_t)(rand() % 5) - 2u;
+		}
+		exact = ((unsigned __int128)ticks * n) / configCPU_CLOCK_HZ;
+		// a quotient above 64 bits wraps on both sides
+		if (bench_convert(ticks, unit) != (uint64_t)exact)
+		{
+			fails++;
+		}
+	}
+	return fails;
+}
+
+// ns per call of the conversion, the soft and the native division
+static void bench_run(uint32_t unit, double *convert, double *soft, double *native)
+{
+	uint32_t div = (uint32_t)(configCPU_CLOCK_HZ / bench_units[unit].n);
+	uint64_t sum = 0;
+	uint64_t t0;
+	uint32_t p;
+	uint32_t i;
+	double calls = (double)BENCH_SAMPLES * BENCH_PASSES;
+	t0 = bench_time_ns();
+	for (p = 0; p < BENCH_PASSES; p++)
+	{
+		for (i = 0; i < BENCH_SAMPLES; i++)
+		{
+			sum += bench_convert(bench_ticks[i], unit);
+		}
+	}
+	*convert = (double)(bench_time_ns() - t0) / calls;
+	if (div == 0)
+	{
+		// above the timer rate the old code multiplied, there is no division
+		*soft = 0.0;
+		*native = 0.0;
+		bench_sink = sum;
+		return;
+	}
+	t0 = bench_time_ns();
+	for (p = 0; p < BENCH_PASSES; p++)
+	{
+		for (i = 0; i < BENCH_SAMPLES; i++)
+		{
+			sum += soft_udivdi3(bench_ticks[i], div);
+		}
+	}
+	*soft = (double)(bench_time_ns() - t0) / calls;
+	t0 = bench_time_ns();
+	for (p = 0; p < BENCH_PASSES; p++)
+	{
+		for (i = 0; i < BENCH_SAMPLES; i++)
+		{
+			sum += native_udivdi3(bench_ticks[i], div);
+		}
+	}
+	*native = (double)(bench_time_ns() - t0) / calls;
+	bench_sink = sum;
+}
+
+int main(int argc, char *argv[])
+{
+	double convert;
+	double soft;
+	double native;
+	uint64_t fails;
+	uint32_t unit;
+	uint32_t i;
+	int ret = 0;
+	(void)argc;
+	(void)argv;
+
+	srand(1);
+	// timestamps of up to a day of counting
+	for (i = 0; i < BENCH_SAMPLES; i++)
+	{
+		bench_ticks[i] = bench_rand64() % (86400ULL * configCPU_CLOCK_HZ);
+	}
+	// the soft division itself against the host
+	for (i = 0; i < BENCH_CHECKS; i++)
+	{
+		uint64_t n = bench_rand64() >> (i % 64);
+		uint32_t d = (uint32_t)bench_rand64() >> (i % 32);
+		if ((d != 0) && (soft_udivdi3(n, d) != n / d))
+		{
+			printf("soft_udivdi3 wrong for %llu / %u\n", (unsigned long long)n, d);
+			return -1;
+		}
+	}
+
+	printf("timer %lu Hz, ns per call, %u samples x %u passes\n", (unsigned long)configCPU_CLOCK_HZ, BENCH_SAMPLES, BENCH_PASSES);
+	printf("%-4s %10s %10s %10s %8s\n", "unit", "convert", "__udivdi3", "native", "wrong");
+	for (unit = 0; unit < sizeof(bench_units) / sizeof(bench_units[0]); unit++)
+	{
+		fails = bench_check(unit);
+		bench_run(unit, &convert, &soft, &native);
+		if (soft == 0.0)
+		{
+			printf("%-4s %10.2f %10s %10s %8llu\n", bench_units[unit].name, convert, "-", "-", (unsigned long long)fails);
+		}
+		else
+		{
+			printf("%-4s %10.2f %10.2f %10.2f %8llu\n", bench_units[unit].name, convert, soft, native, (unsigned long long)fails);
+		}
+		if (fails != 0)
+		{
+			ret = -1;
+		}
+	}
+	return ret;
+}
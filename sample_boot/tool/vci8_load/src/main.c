@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include "boot_net_bench.h"
+#include "boot_trace.h"
+
+// CPU load of the network core of a bootloader built with make NET_BENCH=1
+// against the received frame rate. For the interrupt per frame and then the
+// adaptive coalescing, small datagrams are offered at each rate of
+// load_rates[] and the idle time of core 0 is read before and after the step,
+// see boot_net_bench.h.
+//
+// With -c the device echoes the load back and the steps run with the
+// checksums inserted and checked by the MAC and then computed in software by
+// the driver, the echo column is the packet rate through both directions.
+//
+// With -l the steps run with an interrupt per frame and the sink socket
+// through the IP-task and then on the UDP fast path, the latency columns are
+// the receive interrupt to sink time per path (ipconfigMEASURE_RX_LATENCY).
+//
+// With -t the steps run without and then with the kernel trace streamed to this
+// host, on a bootloader built with NET_BENCH=1 TRACE=1 and its session
+// unlocked from this host. The cpu% difference at a rate is the cost of the
+// trace hooks and of the stream task, the trace column the stream datagrams
+// received per second.
+//
+// The rate is paced by the host, check the offered column against the rx
+// column: a host which can not keep up shows a lower rx rate, a device which
+// can not keep up shows sink frames below the rx frames.
+
+#define LOAD_RX_TIMEOUT_MS (200)
+#define LOAD_RETRY (5)
+#define LOAD_SETTLE_MS (300) // load before a step, for the adaptive level to follow
+#define LOAD_PAYLOAD_DEFAULT (18) // minimum Ethernet frame
+#define LOAD_TRACE_WAIT_MS (1000) // for the first datagram of the trace stream
+
+static const uint32_t load_rates[] = {0, 1000, 2000, 5000, 10000, 20000, 40000, 60000, 80000};
+
+static uint64_t load_time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Sends a command and waits for the sample of the device. Returns 0 on success.
+static int load_cmd(int sock, const struct sockaddr_in *remote_addr, uint8_t cmd, uint8_t arg, boot_net_bench_sample_t *sample)
+{
+	uint8_t req[2] = {cmd, arg};
+	uint8_t buf[128];
+	uint32_t *field;
+	int len;
+	int retry;
+	uint32_t i;
+	for (retry = 0; retry < LOAD_RETRY; retry++)
+	{
+		sendto(sock, req, sizeof(req), 0, (const struct sockaddr *)remote_addr, sizeof(*remote_addr));
+		len = recv(sock, buf, sizeof(buf), 0);
+		if (len == (int)sizeof(*sample))
+		{
+			memcpy(sample, buf, sizeof(*sample));
+			// big endian on the wire, all the fields are uint32_t
+			field = (uint32_t *)sample;
+			for (i = 0; i < sizeof(*sample) / sizeof(uint32_t); i++)
+			{
+				field[i] = ntohl(field[i]);
+			}
+			return 0;
+		}
+	}
+	return -1;
+}
+
+// Takes the echoed datagrams waiting on the load socket.
+static uint64_t load_drain(int load_sock)
+{
+	uint8_t buf[1472];
+	uint64_t cnt = 0;
+	while (recv(load_sock, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+	{
+		cnt++;
+	}
+	return cnt;
+}
+
+// Offers rate datagrams per second for duration_ns, paced against the clock.
+// Returns the datagrams sent, *echoed counts those which came back and
+// *traced the trace datagrams taken from trace_sock, -1 without the stream.
+static uint64_t load_offer(int load_sock, int trace_sock, const struct sockaddr_in *remote_addr, uint32_t rate, uint64_t duration_ns, uint32_t payload, uint64_t *echoed, uint64_t *traced)
+{
+	uint8_t buf[1472];
+	uint64_t start = load_time_ns();
+	uint64_t now = start;
+	uint64_t sent = 0;
+	memset(buf, BOOT_NET_BENCH_CMD_LOAD, sizeof(buf));
+	while (now - start < duration_ns)
+	{
+		// catch up after a late wake, the device sees the average rate
+		while ((rate != 0) && ((sent * 1000000000ULL) / rate <= (now - start)))
+		{
+			sendto(load_sock, buf, payload, 0, (const struct sockaddr *)remote_addr, sizeof(*remote_addr));
+			sent++;
+		}
+		*echoed += load_drain(load_sock);
+		if (trace_sock >= 0)
+		{
+			*traced += load_drain(trace_sock);
+		}
+		if (rate == 0)
+		{
+			usleep(1000);
+		}
+		now = load_time_ns();
+	}
+	return sent;
+}
+
+static void load_print_latency(const boot_net_bench_sample_t *a, const boot_net_bench_sample_t *b, uint32_t path)
+{
+	uint32_t cnt = b->rx_latency_cnt[path] - a->rx_latency_cnt[path];
+	if (cnt == 0)
+	{
+		printf(" %8s %8s", "-", "-");
+		return;
+	}
+	printf(" %8.1f %8u", (double)(uint32_t)(b->rx_latency_sum_us[path] - a->rx_latency_sum_us[path]) / cnt,
+		   b->rx_latency_max_us[path]);
+}
+
+static int load_step(int sock, int load_sock, int trace_sock, const struct sockaddr_in *cmd_addr, uint32_t rate, uint32_t seconds, uint32_t payload, uint8_t latency, uint8_t trace)
+{
+	boot_net_bench_sample_t a;
+	boot_net_bench_sample_t b;
+	uint64_t offered;
+	uint64_t echoed = 0;
+	uint64_t traced = 0;
+	double dt;
+	double idle;
+	uint32_t irqs;
+	load_offer(load_sock, trace_sock, cmd_addr, rate, LOAD_SETTLE_MS * 1000000ULL, payload, &echoed, &traced);
+	if (load_cmd(sock, cmd_addr, BOOT_NET_BENCH_CMD_SAMPLE, 0, &a) != 0)
+	{
+		return -1;
+	}
+	echoed = 0;
+	traced = 0;
+	offered = load_offer(load_sock, trace_sock, cmd_addr, rate, (uint64_t)seconds * 1000000000ULL, payload, &echoed, &traced);
+	if (load_cmd(sock, cmd_addr, BOOT_NET_BENCH_CMD_SAMPLE, 0, &b) != 0)
+	{
+		return -1;
+	}
+	// the counters are free running, the differences survive a wrap
+	dt = (double)(uint32_t)(b.time_ticks - a.time_ticks) / (double)b.tick_hz;
+	idle = (double)(uint32_t)(b.idle_ticks - a.idle_ticks) / (double)(uint32_t)(b.time_ticks - a.time_ticks);
+	irqs = b.rx_irqs - a.rx_irqs;
+	if (trace)
+	{
+		printf("%-8s %9.0f %9.0f %9.0f %5.1f %9.0f\n", (trace_sock >= 0) ? "on" : "off", (double)offered / seconds,
+			   (b.rx_frames - a.rx_frames) / dt, (b.sink_frames - a.sink_frames) / dt, (1.0 - idle) * 100.0,
+			   (double)traced / seconds);
+		return 0;
+	}
+	if (latency)
+	{
+		// the max is reset by every sample, b holds the max of this step
+		printf("%-8s %9.0f %9.0f %9.0f %5.1f", b.fast_path ? "fast" : "ip-task", (double)offered / seconds,
+			   (b.rx_frames - a.rx_frames) / dt, (b.sink_frames - a.sink_frames) / dt, (1.0 - idle) * 100.0);
+		load_print_latency(&a, &b, 0);
+		load_print_latency(&a, &b, 1);
+		printf("\n");
+		return 0;
+	}
+	printf("%-8s %-8s %9.0f %9.0f %9.0f %9.0f %9.0f %7.2f %6.1f %5.1f %5u\n", b.coal_adaptive ? "adaptive" : "off",
+		   b.checksum_offload ? "mac" : "software", (double)offered / seconds, (b.rx_frames - a.rx_frames) / dt,
+		   (b.sink_frames - a.sink_frames) / dt, (double)echoed / seconds, irqs / dt,
+		   (irqs != 0) ? (double)(b.rx_frames - a.rx_frames) / irqs : 0.0, idle * 100.0, (1.0 - idle) * 100.0, b.coal_level);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int sock;
+	int load_sock;
+	int trace_sock;
+	struct sockaddr_in remote_addr;
+	struct sockaddr_in trace_addr;
+	struct timeval timeout;
+	boot_net_bench_sample_t sample;
+	uint32_t seconds = 2;
+	uint32_t payload = LOAD_PAYLOAD_DEFAULT;
+	uint8_t checksum = 0;
+	uint8_t latency = 0;
+	uint8_t trace = 0;
+	uint8_t cmd;
+	uint8_t buf[16];
+	uint8_t mode;
+	uint8_t ok = 1;
+	uint8_t no_stream = 0;
+	int arg = 1;
+	uint32_t i;
+
+	if ((argc > 1) && (strcmp(argv[1], "-c") == 0))
+	{
+		checksum = 1;
+		arg++;
+	}
+	else if ((argc > 1) && (strcmp(argv[1], "-l") == 0))
+	{
+		latency = 1;
+		arg++;
+	}
+	else if ((argc > 1) && (strcmp(argv[1], "-t") == 0))
+	{
+		trace = 1;
+		arg++;
+	}
+	if ((argc - arg < 1) || (argc - arg > 3))
+	{
+		printf("USAGE: %s [-c|-l|-t] ip_address [seconds_per_step] [payload_bytes]\n", argv[0]);
+		printf("       -c checksum offload on and off, the load is echoed\n");
+		printf("       -l receive latency through the IP-task and the fast path\n");
+		printf("       -t kernel trace stream off and on, the session of this host unlocked\n");
+		printf("       interrupt coalescing off and adaptive otherwise\n");
+		return -1;
+	}
+	if (argc - arg > 1)
+	{
+		seconds = (uint32_t)strtoul(argv[arg + 1], NULL, 0);
+	}
+	if (argc - arg > 2)
+	{
+		payload = (uint32_t)strtoul(argv[arg + 2], NULL, 0);
+	}
+	if ((seconds == 0) || (payload == 0) || (payload > 1472))
+	{
+		printf("seconds_per_step > 0, 0 < payload_bytes <= 1472\n");
+		return -1;
+	}
+	memset(&remote_addr, 0, sizeof(remote_addr));
+	remote_addr.sin_family = AF_INET;
+	remote_addr.sin_port = htons(BOOT_NET_BENCH_PORT);
+	remote_addr.sin_addr.s_addr = inet_addr(argv[arg]);
+	trace_addr = remote_addr;
+	trace_addr.sin_port = htons(BOOT_TRACE_PORT);
+	// the echoed load and the trace come back to their own sockets, not to the commands
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+	load_sock = socket(AF_INET, SOCK_DGRAM, 0);
+	trace_sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if ((sock < 0) || (load_sock < 0) || (trace_sock < 0))
+	{
+		printf("socket error\n");
+		return -1;
+	}
+	timeout.tv_sec = 0;
+	timeout.tv_usec = LOAD_RX_TIMEOUT_MS * 1000;
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	timeout.tv_sec = LOAD_TRACE_WAIT_MS / 1000;
+	timeout.tv_usec = (LOAD_TRACE_WAIT_MS % 1000) * 1000;
+	setsockopt(trace_sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	if (trace)
+	{
+		printf("%-8s %9s %9s %9s %5s %9s\n", "trace", "offered/s", "rx/s", "sink/s", "cpu%", "trace/s");
+	}
+	else if (latency)
+	{
+		printf("%-8s %9s %9s %9s %5s %8s %8s %8s %8s\n", "path", "offered/s", "rx/s", "sink/s", "cpu%", "ip_avg", "ip_max",
+			   "fast_avg", "fast_max");
+	}
+	else
+	{
+		printf("%-8s %-8s %9s %9s %9s %9s %9s %7s %6s %5s %5s\n", "coalesce", "checksum", "offered/s", "rx/s", "sink/s",
+			   "echo/s", "irq/s", "fr/irq", "idle%", "cpu%", "level");
+	}
+	for (mode = 0; ok && (mode < 2); mode++)
+	{
+		// coalescing: off then adaptive, the checksums by the MAC
+		// -c: checksums by the MAC then in software, adaptive coalescing
+		// -l: through the IP-task then the fast path, interrupt per frame
+		// -t: without then with the trace stream, adaptive coalescing
+		ok = (load_cmd(sock, &remote_addr, BOOT_NET_BENCH_CMD_ECHO, checksum, &sample) == 0) &&
+			 (load_cmd(sock, &remote_addr, BOOT_NET_BENCH_CMD_MODERATION, (checksum || trace) ? 1 : (latency ? 0 : mode), &sample) == 0) &&
+			 (load_cmd(sock, &remote_addr, BOOT_NET_BENCH_CMD_OFFLOAD, checksum ? !mode : 1, &sample) == 0) &&
+			 (load_cmd(sock, &remote_addr, BOOT_NET_BENCH_CMD_FAST_PATH, latency ? mode : 1, &sample) == 0);
+		if (ok && trace && mode)
+		{
+			cmd = BOOT_TRACE_CMD_START;
+			sendto(trace_sock, &cmd, sizeof(cmd), 0, (const struct sockaddr *)&trace_addr, sizeof(trace_addr));
+			if (recv(trace_sock, buf, sizeof(buf), 0) < 0)
+			{
+				printf("no trace stream from %s:%u, is the bootloader built with TRACE=1 and the session of this host unlocked?\n",
+					   argv[arg], BOOT_TRACE_PORT);
+				no_stream = 1;
+				break;
+			}
+		}
+		for (i = 0; ok && (i < sizeof(load_rates) / sizeof(load_rates[0])); i++)
+		{
+			if (load_step(sock, load_sock, (trace && mode) ? trace_sock : -1, &remote_addr, load_rates[i], seconds, payload,
+						  latency, trace) != 0)
+			{
+				printf("sample lost at %u frames/s\n", load_rates[i]);
+			}
+		}
+	}
+	if (trace)
+	{
+		cmd = BOOT_TRACE_CMD_STOP;
+		sendto(trace_sock, &cmd, sizeof(cmd), 0, (const struct sockaddr *)&trace_addr, sizeof(trace_addr));
+	}
+	if (!ok)
+	{
+		printf("no reply from %s:%u, is the bootloader built with NET_BENCH=1?\n", argv[arg], BOOT_NET_BENCH_PORT);
+	}
+	else
+	{
+		// leave the defaults behind
+		load_cmd(sock, &remote_addr, BOOT_NET_BENCH_CMD_ECHO, 0, &sample);
+		load_cmd(sock, &remote_addr, BOOT_NET_BENCH_CMD_MODERATION, 1, &sample);
+		load_cmd(sock, &remote_addr, BOOT_NET_BENCH_CMD_OFFLOAD, 1, &sample);
+		load_cmd(sock, &remote_addr, BOOT_NET_BENCH_CMD_FAST_PATH, 1, &sample);
+	}
+	if (no_stream)
+	{
+		ok = 0;
+	}
+	close(sock);
+	close(load_sock);
+	close(trace_sock);
+	return ok ? 0 : -1;
+}
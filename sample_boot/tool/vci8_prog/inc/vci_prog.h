@@ -19,10 +19,14 @@ extern "C" {
 #define VCI_PROG_ERR_EXIT_DOWNLOAD_FAIL         (-11)
 #define VCI_PROG_ERR_CHECKSUM_VALIDATE_FAIL     (-12)
 #define VCI_PROG_ERR_RESET_DEVICE_FAIL          (-13)
+#define VCI_PROG_ERR_UPLOAD_DATA_FAIL           (-14)
+#define VCI_PROG_ERR_WRITE_FILE_FAIL            (-15)
 
 typedef void *vci_prog_callback_t(int total, int prog);
 
 int vci_prog(char *ip_addr, char *file_name, vci_prog_callback_t callback);
+/* Read back [addr, addr + size) to file_name, raw binary for *.bin, S-record otherwise. */
+int vci_upload(char *ip_addr, char *file_name, unsigned int addr, unsigned int size, vci_prog_callback_t callback);
 
 #ifdef __cplusplus
 }
@@ -97,6 +97,17 @@ void boot_sock_deinit(SOCKET sock)
 }
 
 
+uint32_t boot_time_ms(void)
+{
+#ifdef WIN32
+	return (uint32_t)GetTickCount();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+#endif
+}
+
 void print_hex(uint8_t *data, int len)
 {
 	int i;
@@ -389,11 +400,11 @@ int write_data_by_id(SOCKET sock, struct sockaddr_in *remote_addr, uint16_t id,
 int download_data(SOCKET sock, struct sockaddr_in *remote_addr, uint32_t addr, uint32_t size, uint8_t *data, uint32_t *crc, uint8_t enc_enable)
 {
 	int ret;
-	uint8_t buf[1026];
-	uint8_t buf_crypt[1031];
+	static uint8_t buf[BOOT_MAX_MSG_LEN];
+	static uint8_t buf_crypt[BOOT_MAX_MSG_LEN + 5];
 	uint32_t cryptLen = 0;
 	uint8_t sn, enc_flag;
-	uint32_t i, tx_len;
+	uint32_t i, tx_len, block_len;
 	remote_addr->sin_family = AF_INET;
 	remote_addr->sin_port = htons(14229);
 	if (enc_enable)
@@ -420,15 +431,25 @@ int download_data(SOCKET sock, struct sockaddr_in *remote_addr, uint32_t addr, u
 	decrypt_msg(buf_crypt, ret, buf, &ret, CPYPT_MASK);
 	if ((ret >= 1) && (buf[0] == 0x74))
 	{
+		// maxNumberOfBlockLength (SID + SN + data)
+		block_len = DOWNLOAD_LEGACY_BLOCK;
+		if ((ret == 4) && (buf[1] == 0x20))
+		{
+			block_len = (((uint32_t)buf[2] << 8) | buf[3]) - 2;
+			if ((block_len == 0) || (block_len > sizeof(buf) - 2))
+			{
+				return -3;
+			}
+		}
 		sn = 1;
 		i = 0;
 		ret = 0;
 		while (i < size)
 		{
 			tx_len = size - i;
-			if (tx_len > sizeof(buf) - 2)
+			if (tx_len > block_len)
 			{
-				tx_len = sizeof(buf) - 2;
+				tx_len = block_len;
 			}
 			buf[0] = 0x36;
 			buf[1] = sn;
@@ -601,4 +622,144 @@ int reset_device(SOCKET sock, struct sockaddr_in *remote_addr, uint8_t mode)
 		ret = -1;
 	}
 	return ret;
-}
\ No newline at end of file
+}
+static void set_sock_rx_timeout(SOCKET sock, int ms)
+{
+#ifdef WIN32
+	DWORD timeout = ms;
+#else
+	struct timeval timeout;
+	timeout.tv_sec = ms / 1000;
+	timeout.tv_usec = (ms % 1000) * 1000;
+#endif
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+}
+
+/* RequestUpload + windowed TransferData: every 0x36 asks for up to UPLOAD_WINDOW blocks
+ * starting at sn, a lost or late block is requested again from its sn. */
+int upload_data(SOCKET sock, struct sockaddr_in *remote_addr, uint32_t addr, uint32_t size, uint8_t *data)
+{
+	int ret;
+	static uint8_t buf[BOOT_MAX_MSG_LEN];
+	static uint8_t buf_crypt[BOOT_MAX_MSG_LEN + 5];
+	uint32_t cryptLen = 0;
+	uint32_t i, block_len, rx_len, start;
+	int rcv_buf;
+	uint8_t sn, n;
+	int retry;
+#ifdef WIN32
+	int addr_len;
+#else
+	socklen_t addr_len;
+#endif
+	struct sockaddr_in my_addr;
+	remote_addr->sin_family = AF_INET;
+	remote_addr->sin_port = htons(14229);
+	buf[0] = 0x35;
+	buf[1] = 0x44;
+	buf[2] = (uint8_t)(addr >> 24);
+	buf[3] = (uint8_t)(addr >> 16);
+	buf[4] = (uint8_t)(addr >> 8);
+	buf[5] = (uint8_t)(addr);
+	buf[6] = (uint8_t)(size >> 24);
+	buf[7] = (uint8_t)(size >> 16);
+	buf[8] = (uint8_t)(size >> 8);
+	buf[9] = (uint8_t)(size);
+
+	build_crypt_msg(buf, 10, buf_crypt, &cryptLen, CPYPT_MASK);
+	ret = boot_req(sock, remote_addr, buf_crypt, cryptLen, buf_crypt, sizeof(buf_crypt));
+	decrypt_msg(buf_crypt, ret, buf, &ret, CPYPT_MASK);
+	if ((ret == 4) && (buf[0] == 0x75) && (buf[1] == 0x20))
+	{
+		block_len = (((uint32_t)buf[2] << 8) | buf[3]) - 2;
+		if ((block_len == 0) || (block_len > sizeof(buf) - 2))
+		{
+			return -3;
+		}
+		set_sock_rx_timeout(sock, UPLOAD_RX_TIMEOUT_MS);
+		// room for a whole window, the blocks of the bootloader fill a datagram each
+		rcv_buf = UPLOAD_WINDOW * (int)(block_len + 64);
+		setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char *)&rcv_buf, sizeof(rcv_buf));
+		sn = 1;
+		i = 0;
+		retry = 0;
+		ret = 0;
+		while (i < size)
+		{
+			buf[0] = 0x36;
+			buf[1] = sn;
+			buf[2] = UPLOAD_WINDOW;
+			build_crypt_msg(buf, 3, buf_crypt, &cryptLen, CPYPT_MASK);
+			ret = boot_req(sock, remote_addr, buf_crypt, cryptLen, NULL, 0);
+			if (ret != (int)cryptLen)
+			{
+				ret = -2;
+				break;
+			}
+			ret = 0;
+			start = i;
+			for (n = 0; (n < UPLOAD_WINDOW) && (i < size); )
+			{
+				addr_len = sizeof(my_addr);
+				ret = recvfrom(sock, (char *)buf_crypt, sizeof(buf_crypt), 0, (struct sockaddr *)&my_addr, &addr_len);
+				if (ret <= 0)
+				{
+					// timeout, ask again from the first missing block
+					ret = 0;
+					break;
+				}
+				if ((ret < 7) || ((((int)buf_crypt[2] << 8) | buf_crypt[3]) + 5 != ret))
+				{
+					ret = 0;
+					continue;
+				}
+				decrypt_msg(buf_crypt, ret, buf, &ret, CPYPT_MASK);
+				if ((ret >= 3) && (buf[0] == 0x76) && (buf[1] == sn))
+				{
+					rx_len = ret - 2;
+					if (rx_len > size - i)
+					{
+						rx_len = size - i;
+					}
+					memcpy(&data[i], &buf[2], rx_len);
+					i += rx_len;
+					++sn;
+					++n;
+				}
+				else if ((ret == 3) && (buf[0] == 0x7F) && (buf[1] == 0x36))
+				{
+					ret = buf[2];
+					break;
+				}
+				// else: block of an earlier window, drop it
+				ret = 0;
+			}
+			if (ret != 0)
+			{
+				break;
+			}
+			if (i == start)
+			{
+				if (++retry > UPLOAD_RETRY)
+				{
+					ret = -2;
+					break;
+				}
+			}
+			else
+			{
+				retry = 0;
+			}
+		}
+		set_sock_rx_timeout(sock, 0);
+	}
+	else if ((ret == 3) && (buf[0] == 0x7F) && (buf[1] == 0x35))
+	{
+		ret = buf[2];
+	}
+	else
+	{
+		ret = -1;
+	}
+	return ret;
+}
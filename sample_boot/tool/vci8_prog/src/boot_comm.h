@@ -7,6 +7,8 @@
 #define DelayMs(ms) Sleep(ms)
 #else
 #include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -14,9 +16,18 @@
 typedef int SOCKET;
 #define DelayMs(ms) usleep((ms)*1000)
 #endif
+
+// Longest message (SID + parameters) the bootloader takes in one UDP datagram, see BOOT_MAX_MSG_LEN in boot_app.h.
+// The block length used is the one advertised by 0x34/0x35, an older bootloader without it takes DOWNLOAD_LEGACY_BLOCK.
+#define BOOT_MAX_MSG_LEN (16384 - 20 - 8 - 5)
+#define DOWNLOAD_LEGACY_BLOCK (1024)
+#define UPLOAD_WINDOW (16) // blocks requested per TransferData
+#define UPLOAD_RX_TIMEOUT_MS (200)
+#define UPLOAD_RETRY (10)
 int boot_req(SOCKET sock, struct sockaddr_in *remote_addr, uint8_t *req, int req_len, uint8_t *resp_buf, int resp_buf_size);
 
 SOCKET boot_sock_init(void);
+uint32_t boot_time_ms(void); // monotonic, to time the transfers
 void boot_sock_deinit(SOCKET sock);
 
 int enter_boot_req(SOCKET sock, struct sockaddr_in *remote_addr);
@@ -25,6 +36,7 @@ int security_access(SOCKET sock, struct sockaddr_in *remote_addr, uint8_t level)
 int erase_flash_memory(SOCKET sock, struct sockaddr_in *remote_addr, uint32_t addr, uint32_t size);
 int download_data(SOCKET sock, struct sockaddr_in *remote_addr, uint32_t addr, uint32_t size, uint8_t *data, uint32_t *crc, uint8_t enc_enable);
 int exit_download_data(SOCKET sock, struct sockaddr_in *remote_addr);
+int upload_data(SOCKET sock, struct sockaddr_in *remote_addr, uint32_t addr, uint32_t size, uint8_t *data);
 int data_checksum_validate(SOCKET sock, struct sockaddr_in *remote_addr, uint32_t chksum);
 int reset_device(SOCKET sock, struct sockaddr_in *remote_addr, uint8_t mode);
 int write_data_by_id(SOCKET sock, struct sockaddr_in *remote_addr, uint16_t id, uint8_t *data, uint8_t data_len);
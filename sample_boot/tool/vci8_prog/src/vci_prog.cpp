@@ -1,3 +1,6 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "vci_prog.h"
 #include "boot_comm.h"
 #include "SRecMem.h"
@@ -211,4 +214,129 @@ int vci_prog(char *ip_addr, char *file_name, vci_prog_callback_t callback)
 		ret = VCI_PROG_ERR_INVALID_ARG;
 	}
 	return ret;
-}
\ No newline at end of file
+}
+#define UPLOAD_CHUNK_SIZE (64 * 1024)
+
+static bool write_upload_file(char *file_name, uint32_t addr, uint8_t *data, uint32_t size)
+{
+	bool ret = false;
+	FILE *fs;
+	SRecordMem srec;
+	const char *ext = strrchr(file_name, '.');
+	if ((ext != NULL) && ((0 == strcmp(ext, ".bin")) || (0 == strcmp(ext, ".BIN"))))
+	{
+		fs = fopen(file_name, "wb");
+		if (fs != NULL)
+		{
+			ret = (size == fwrite(data, 1, size, fs));
+			fclose(fs);
+		}
+	}
+	else
+	{
+		srec.AddSegment(addr, data, size);
+		ret = srec.WriteFile(file_name);
+	}
+	return ret;
+}
+
+int vci_upload(char *ip_addr, char *file_name, unsigned int addr, unsigned int size, vci_prog_callback_t callback)
+{
+	int ret;
+	SOCKET sock;
+	uint8_t *data;
+	uint32_t offset, len, t0;
+	struct sockaddr_in vci_addr;
+	if ((ip_addr == NULL) || (file_name == NULL) || (size == 0))
+	{
+		return VCI_PROG_ERR_INVALID_ARG;
+	}
+	data = (uint8_t *)malloc(size);
+	if (data == NULL)
+	{
+		return VCI_PROG_ERR_INVALID_ARG;
+	}
+	sock = boot_sock_init();
+	if (sock != INVALID_SOCKET)
+	{
+#ifdef WIN32
+		vci_addr.sin_addr.S_un.S_addr = inet_addr(ip_addr);
+#else
+		vci_addr.sin_addr.s_addr = inet_addr(ip_addr);
+#endif
+		if (5 == enter_boot_req(sock, &vci_addr))
+		{
+			printf("Enter boot request OK.\n");
+			DelayMs(1000); // delay for waiting MCU reset
+			ret = enter_session(sock, &vci_addr, 0x02);
+			if (0 == ret)
+			{
+				ret = security_access(sock, &vci_addr, 0x01);
+				if (0 == ret)
+				{
+					t0 = boot_time_ms();
+					for (offset = 0; offset < size; offset += len)
+					{
+						len = size - offset;
+						if (len > UPLOAD_CHUNK_SIZE)
+						{
+							len = UPLOAD_CHUNK_SIZE;
+						}
+						ret = upload_data(sock, &vci_addr, addr + offset, len, &data[offset]);
+						if (0 == ret)
+						{
+							ret = exit_download_data(sock, &vci_addr);
+						}
+						if (0 != ret)
+						{
+							printf("Upload data fail. 0x%X\n", ret);
+							ret = VCI_PROG_ERR_UPLOAD_DATA_FAIL;
+							break;
+						}
+						if (callback != NULL)
+						{
+							callback(size, offset + len);
+						}
+					}
+					if (0 == ret)
+					{
+						// the line rate goal is about 10 MB/s on 100 Mbit
+						t0 = boot_time_ms() - t0;
+						printf("Upload %u bytes in %u ms, %u kB/s.\n", size, t0, (t0 != 0) ? (size / t0) : 0);
+						if (write_upload_file(file_name, addr, data, size))
+						{
+							printf("VCI8 Upload Complete Successfully.\n");
+						}
+						else
+						{
+							ret = VCI_PROG_ERR_WRITE_FILE_FAIL;
+						}
+					}
+					reset_device(sock, &vci_addr, 0x01);
+				}
+				else
+				{
+					printf("Security Access fail. 0x%X\n", ret);
+					ret = VCI_PROG_ERR_SEC_ACCESS_FAIL;
+				}
+			}
+			else
+			{
+				printf("Enter prog session fail. 0x%X\n", ret);
+				ret = VCI_PROG_ERR_ENTER_PROG_SESSION_FAIL;
+			}
+		}
+		else
+		{
+			ret = VCI_PROG_ERR_ENTER_BOOT_FAIL;
+			printf("Enter boot fail.\n");
+		}
+		boot_sock_deinit(sock);
+	}
+	else
+	{
+		ret = VCI_PROG_ERR_OPEN_SOCKET_FAIL;
+	}
+	free(data);
+	return ret;
+}
@@ -1,19 +1,26 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "vci_prog.h"
 
 int main(int argc, char *argv[])
 {
 	int ret;
 
-	if (argc != 3)
+	if ((argc == 6) && (strcmp(argv[1], "-u") == 0))
 	{
-		printf("USAGE: %s ip_address hex_file_name\n", argv[0]);
-		ret = -1;
+		// read back, the address and the size take a 0x prefix
+		ret = vci_upload(argv[2], argv[5], (unsigned int)strtoul(argv[3], NULL, 0), (unsigned int)strtoul(argv[4], NULL, 0), NULL);
 	}
-	else
+	else if (argc == 3)
 	{
 		ret = vci_prog(argv[1], argv[2], NULL);
 	}
+	else
+	{
+		printf("USAGE: %s ip_address hex_file_name\n", argv[0]);
+		printf("       %s -u ip_address address size out_file (*.bin raw, S-record otherwise)\n", argv[0]);
+		ret = -1;
+	}
 	return ret;
 }
-
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include "boot_rtos_bench.h"
+
+// Cycle counts of kernel and port paths of a bootloader built with make
+// RTOS_BENCH=1, see boot_rtos_bench.h. Every command of rtos_cmds[] is run
+// with the given rounds and printed as one line per case, in the unit of the
+// command: core cycles or STM_0 counts.
+
+#define RTOS_RX_TIMEOUT_MS (5000) // above BOOT_RTOS_BENCH_TIMEOUT of every case of a command
+#define RTOS_ROUNDS_DEFAULT (10000)
+
+typedef struct
+{
+	uint8_t cmd;
+	const char *name;
+	const char *unit;
+	const char *cases[BOOT_RTOS_BENCH_CASES];
+} rtos_cmd_t;
+
+static const rtos_cmd_t rtos_cmds[] = {
+	{BOOT_RTOS_BENCH_CMD_SWITCH, "task switch", "cycles", {"integer tasks", "fpu tasks"}},
+	{BOOT_RTOS_BENCH_CMD_IRQ, "irq latency", "stm", {"api ceiling", "above ceiling"}},
+	{BOOT_RTOS_BENCH_CMD_TIMESTAMP, "timestamp", "cycles", {"empty", "read ticks", "ticks to ns", "ticks to us"}},
+};
+
+// Sends a command and waits for the result. Returns 0 on success.
+static int rtos_cmd(int sock, const struct sockaddr_in *remote_addr, uint8_t cmd, uint32_t rounds, boot_rtos_bench_result_t *result)
+{
+	uint8_t req[8] = {cmd, 0, 0, 0, (uint8_t)(rounds >> 24), (uint8_t)(rounds >> 16), (uint8_t)(rounds >> 8), (uint8_t)rounds};
+	uint8_t buf[256];
+	uint32_t *field;
+	uint32_t i;
+	int len;
+	sendto(sock, req, sizeof(req), 0, (const struct sockaddr *)remote_addr, sizeof(*remote_addr));
+	len = recv(sock, buf, sizeof(buf), 0);
+	if (len != (int)sizeof(*result))
+	{
+		return -1;
+	}
+	memcpy(result, buf, sizeof(*result));
+	// big endian on the wire, all the fields are uint32_t
+	field = (uint32_t *)result;
+	for (i = 0; i < sizeof(*result) / sizeof(uint32_t); i++)
+	{
+		field[i] = ntohl(field[i]);
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int sock;
+	struct sockaddr_in remote_addr;
+	struct timeval timeout;
+	boot_rtos_bench_result_t result;
+	uint32_t rounds = RTOS_ROUNDS_DEFAULT;
+	uint32_t i;
+	uint32_t n;
+	int ret = 0;
+
+	if ((argc < 2) || (argc > 3))
+	{
+		printf("USAGE: %s ip_address [rounds]\n", argv[0]);
+		return -1;
+	}
+	if (argc > 2)
+	{
+		rounds = (uint32_t)strtoul(argv[2], NULL, 0);
+	}
+	if ((rounds == 0) || (rounds > BOOT_RTOS_BENCH_ROUNDS_MAX))
+	{
+		printf("0 < rounds <= %u\n", BOOT_RTOS_BENCH_ROUNDS_MAX);
+		return -1;
+	}
+	memset(&remote_addr, 0, sizeof(remote_addr));
+	remote_addr.sin_family = AF_INET;
+	remote_addr.sin_port = htons(BOOT_RTOS_BENCH_PORT);
+	remote_addr.sin_addr.s_addr = inet_addr(argv[1]);
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0)
+	{
+		printf("socket error\n");
+		return -1;
+	}
+	timeout.tv_sec = RTOS_RX_TIMEOUT_MS / 1000;
+	timeout.tv_usec = (RTOS_RX_TIMEOUT_MS % 1000) * 1000;
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	printf("%-16s %-16s %8s %8s %8s %8s %-6s\n", "bench", "case", "samples", "min", "avg", "max", "unit");
+	for (i = 0; i < sizeof(rtos_cmds) / sizeof(rtos_cmds[0]); i++)
+	{
+		if (rtos_cmd(sock, &remote_addr, rtos_cmds[i].cmd, rounds, &result) != 0)
+		{
+			printf("no reply from %s:%u, is the bootloader built with RTOS_BENCH=1?\n", argv[1], BOOT_RTOS_BENCH_PORT);
+			ret = -1;
+			break;
+		}
+		if (result.cases == 0)
+		{
+			printf("%-16s failed on the device\n", rtos_cmds[i].name);
+			ret = -1;
+			continue;
+		}
+		for (n = 0; (n < result.cases) && (n < BOOT_RTOS_BENCH_CASES); n++)
+		{
+			printf("%-16s %-16s %8u %8u %8u %8u %-6s\n", rtos_cmds[i].name, rtos_cmds[i].cases[n] ? rtos_cmds[i].cases[n] : "-",
+				   result.cnt[n], result.min_cycles[n], result.avg_cycles[n], result.max_cycles[n], rtos_cmds[i].unit);
+		}
+	}
+	close(sock);
+	return ret;
+}
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef WIN32
+#include <winsock2.h>
+#else
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#define INVALID_SOCKET (-1)
+typedef int SOCKET;
+#endif
+#include "trace_decode.h"
+
+#define TRACE_PORT (14230) // BOOT_TRACE_PORT
+#define TRACE_CMD_STOP (0)
+#define TRACE_CMD_START (1)
+#define TRACE_RX_TIMEOUT_MS (200)
+#define TRACE_START_PERIOD_S (1) // the start command is repeated, it can be lost
+
+static SOCKET trace_sock_init(void)
+{
+#ifdef WIN32
+	WSADATA ws_data;
+	DWORD timeout = TRACE_RX_TIMEOUT_MS;
+#else
+	struct timeval timeout;
+#endif
+	SOCKET ret = INVALID_SOCKET;
+#ifdef WIN32
+	if (WSAStartup(MAKEWORD(2,2), &ws_data) == 0)
+#endif
+	{
+		ret = socket(AF_INET, SOCK_DGRAM, 0);
+		if (ret != INVALID_SOCKET)
+		{
+#ifndef WIN32
+			timeout.tv_sec = 0;
+			timeout.tv_usec = TRACE_RX_TIMEOUT_MS * 1000;
+#endif
+			setsockopt(ret, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+		}
+	}
+	return ret;
+}
+
+static void trace_sock_deinit(SOCKET sock)
+{
+#ifdef WIN32
+	closesocket(sock);
+	WSACleanup();
+#else
+	close(sock);
+#endif
+}
+
+static void trace_cmd(SOCKET sock, struct sockaddr_in *remote_addr, uint8_t cmd)
+{
+	sendto(sock, (const char *)&cmd, 1, 0, (struct sockaddr *)remote_addr, sizeof(*remote_addr));
+}
+
+int main(int argc, char *argv[])
+{
+	SOCKET sock;
+	struct sockaddr_in remote_addr;
+	std::vector<trace_datagram_t> datagrams;
+	uint8_t buf[2048];
+	time_t start;
+	time_t last_cmd;
+	int seconds;
+	int len;
+	int ret = -1;
+	FILE *out;
+
+	if (argc != 4)
+	{
+		printf("USAGE: %s ip_address seconds json_file\n", argv[0]);
+		return -1;
+	}
+	seconds = atoi(argv[2]);
+	memset(&remote_addr, 0, sizeof(remote_addr));
+	remote_addr.sin_family = AF_INET;
+	remote_addr.sin_port = htons(TRACE_PORT);
+	remote_addr.sin_addr.s_addr = inet_addr(argv[1]);
+	sock = trace_sock_init();
+	if (sock == INVALID_SOCKET)
+	{
+		printf("socket error\n");
+		return -1;
+	}
+
+	start = time(NULL);
+	last_cmd = 0;
+	while (time(NULL) - start < seconds)
+	{
+		if (time(NULL) - last_cmd >= TRACE_START_PERIOD_S)
+		{
+			trace_cmd(sock, &remote_addr, TRACE_CMD_START);
+			last_cmd = time(NULL);
+		}
+		len = recv(sock, (char *)buf, sizeof(buf), 0);
+		if ((len > 0) && trace_datagram_valid(buf, len))
+		{
+			datagrams.push_back(trace_datagram_t(buf, buf + len));
+		}
+	}
+	trace_cmd(sock, &remote_addr, TRACE_CMD_STOP);
+	trace_sock_deinit(sock);
+	printf("%u datagrams received\n", (unsigned int)datagrams.size());
+
+	out = fopen(argv[3], "w");
+	if (out == NULL)
+	{
+		printf("can not open %s\n", argv[3]);
+		return -1;
+	}
+	ret = trace_write_chrome_json(datagrams, out);
+	fclose(out);
+	if (ret < 0)
+	{
+		// the device streams only to the host of its unlocked bootloader session
+		printf("no trace decoded, is the bootloader session of this host unlocked?\n");
+	}
+	else
+	{
+		printf("%d events written to %s\n", ret, argv[3]);
+		ret = 0;
+	}
+	return ret;
+}
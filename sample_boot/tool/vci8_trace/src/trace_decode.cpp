@@ -0,0 +1,311 @@
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include "trace_decode.h"
+
+typedef struct
+{
+	uint8_t kind;
+	uint8_t core;
+	uint8_t count;
+	uint32_t sequence;
+	uint32_t dropped;
+	uint32_t sync_stm;
+	uint64_t sync_pit;
+	uint32_t pit_hz;
+	const uint8_t *body;
+} trace_header_t;
+
+typedef struct
+{
+	double ts; // us from the first event
+	uint8_t core;
+	uint8_t type;
+	uint8_t arg8;
+	uint16_t arg16;
+	uint32_t object;
+	uint32_t data;
+} trace_event_t;
+
+static uint32_t get_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint16_t get_be16(const uint8_t *p)
+{
+	return (uint16_t)(((uint16_t)p[0] << 8) | (uint16_t)p[1]);
+}
+
+bool trace_datagram_valid(const uint8_t *data, int len)
+{
+	int item_size;
+	if ((len < TRACE_HEADER_SIZE) || (get_be32(data) != TRACE_MAGIC) || (data[4] != TRACE_VERSION) || (data[6] >= TRACE_CORE_NUM))
+	{
+		return false;
+	}
+	item_size = (data[5] == TRACE_KIND_EVENTS) ? TRACE_EVENT_SIZE : TRACE_NAME_SIZE;
+	return (data[5] <= TRACE_KIND_NAMES) && (len >= TRACE_HEADER_SIZE + data[7] * item_size);
+}
+
+static void parse_header(const trace_datagram_t &d, trace_header_t *h)
+{
+	const uint8_t *p = &d[0];
+	h->kind = p[5];
+	h->core = p[6];
+	h->count = p[7];
+	h->sequence = get_be32(p + 8);
+	h->dropped = get_be32(p + 12);
+	h->sync_stm = get_be32(p + 16);
+	h->sync_pit = ((uint64_t)get_be32(p + 20) << 32) | get_be32(p + 24);
+	h->pit_hz = get_be32(p + 28);
+	h->body = p + TRACE_HEADER_SIZE;
+}
+
+static bool sync_less(const trace_header_t &a, const trace_header_t &b)
+{
+	return a.sync_pit < b.sync_pit;
+}
+
+static bool event_less(const trace_event_t &a, const trace_event_t &b)
+{
+	return a.ts < b.ts;
+}
+
+// STM ticks per second from the sync pairs, the STM count is extended over its wraps
+// assuming less than one wrap (53 s at 80 MHz) between two datagrams.
+static double estimate_stm_hz(std::vector<trace_header_t> &headers)
+{
+	uint64_t stm_span = 0;
+	double pit_span;
+	size_t i;
+	std::sort(headers.begin(), headers.end(), sync_less);
+	for (i = 1; i < headers.size(); i++)
+	{
+		stm_span += (uint32_t)(headers[i].sync_stm - headers[i - 1].sync_stm);
+	}
+	pit_span = (double)(headers.back().sync_pit - headers.front().sync_pit) / headers.front().pit_hz;
+	if (pit_span < 0.1)
+	{
+		return 0.0;
+	}
+	return (double)stm_span / pit_span;
+}
+
+static const char *event_name(uint8_t type)
+{
+	switch (type)
+	{
+	case TRACE_TASK_READY: return "ready";
+	case TRACE_TASK_CREATE: return "create";
+	case TRACE_TASK_DELETE: return "delete";
+	case TRACE_TASK_DELAY: return "delay";
+	case TRACE_TASK_NOTIFY: return "notify";
+	case TRACE_TASK_NOTIFY_WAIT: return "notify wait";
+	case TRACE_QUEUE_SEND: return "queue send";
+	case TRACE_QUEUE_SEND_FAILED: return "queue send failed";
+	case TRACE_QUEUE_SEND_BLOCK: return "queue send block";
+	case TRACE_QUEUE_RECEIVE: return "queue receive";
+	case TRACE_QUEUE_RECEIVE_FAILED: return "queue receive failed";
+	case TRACE_QUEUE_RECEIVE_BLOCK: return "queue receive block";
+	case TRACE_STREAM_SEND: return "stream send";
+	case TRACE_STREAM_RECEIVE: return "stream receive";
+	case TRACE_STREAM_SEND_BLOCK: return "stream send block";
+	case TRACE_STREAM_RECEIVE_BLOCK: return "stream receive block";
+	case TRACE_NET_BUFFER_GET: return "net buffer get";
+	case TRACE_NET_BUFFER_RELEASE: return "net buffer release";
+	default: return NULL;
+	}
+}
+
+static std::string object_name(const std::map<uint32_t, std::string> &names, uint32_t object)
+{
+	char buf[16];
+	std::map<uint32_t, std::string>::const_iterator it = names.find(object);
+	if (it != names.end())
+	{
+		return it->second;
+	}
+	snprintf(buf, sizeof(buf), "0x%08X", object);
+	return std::string(buf);
+}
+
+int trace_write_chrome_json(const std::vector<trace_datagram_t> &datagrams, FILE *out)
+{
+	std::vector<trace_header_t> headers;
+	std::vector<trace_event_t> events;
+	std::map<uint32_t, std::string> names;
+	std::map<uint64_t, bool> threads; // core << 32 | task with a thread_name
+	trace_header_t h;
+	trace_event_t e;
+	double stm_hz;
+	double origin;
+	uint32_t last_sequence[TRACE_CORE_NUM][2];
+	uint32_t last_dropped[TRACE_CORE_NUM];
+	bool sequence_valid[TRACE_CORE_NUM][2];
+	uint32_t running[TRACE_CORE_NUM];
+	double running_since[TRACE_CORE_NUM];
+	const char *name;
+	const char *sep = "";
+	char task_name[TRACE_NAME_LENGTH + 1];
+	int written = 0;
+	unsigned int lost = 0;
+	size_t i;
+	int n;
+	int j;
+	const uint8_t *p;
+
+	memset(sequence_valid, 0, sizeof(sequence_valid));
+	memset(last_dropped, 0, sizeof(last_dropped));
+	memset(running, 0, sizeof(running));
+	memset(running_since, 0, sizeof(running_since));
+	for (i = 0; i < datagrams.size(); i++)
+	{
+		parse_header(datagrams[i], &h);
+		if (sequence_valid[h.core][h.kind] && (h.sequence != last_sequence[h.core][h.kind] + 1))
+		{
+			lost += h.sequence - last_sequence[h.core][h.kind] - 1;
+		}
+		sequence_valid[h.core][h.kind] = true;
+		last_sequence[h.core][h.kind] = h.sequence;
+		if (h.kind == TRACE_KIND_NAMES)
+		{
+			for (n = 0; n < h.count; n++)
+			{
+				p = h.body + n * TRACE_NAME_SIZE;
+				memcpy(task_name, p + 4, TRACE_NAME_LENGTH);
+				task_name[TRACE_NAME_LENGTH] = '\0';
+				for (j = 0; task_name[j] != '\0'; j++)
+				{
+					// the names go into JSON strings as they are
+					if ((task_name[j] == '"') || (task_name[j] == '\\') || ((uint8_t)task_name[j] < 0x20))
+					{
+						task_name[j] = '_';
+					}
+				}
+				names[get_be32(p)] = task_name;
+			}
+		}
+		headers.push_back(h);
+	}
+	if (headers.empty())
+	{
+		return -1;
+	}
+	stm_hz = estimate_stm_hz(headers);
+	if (stm_hz == 0.0)
+	{
+		fprintf(stderr, "capture too short to measure the STM clock\n");
+		return -1;
+	}
+
+	// the events of a datagram were recorded before its sync pair
+	for (i = 0; i < headers.size(); i++)
+	{
+		if (headers[i].kind != TRACE_KIND_EVENTS)
+		{
+			continue;
+		}
+		for (n = 0; n < headers[i].count; n++)
+		{
+			p = headers[i].body + n * TRACE_EVENT_SIZE;
+			e.ts = (double)headers[i].sync_pit * 1e6 / headers[i].pit_hz -
+				   (double)(uint32_t)(headers[i].sync_stm - get_be32(p)) * 1e6 / stm_hz;
+			e.core = headers[i].core;
+			e.type = p[4];
+			e.arg8 = p[5];
+			e.arg16 = get_be16(p + 6);
+			e.object = get_be32(p + 8);
+			e.data = get_be32(p + 12);
+			events.push_back(e);
+		}
+		if (headers[i].dropped != last_dropped[headers[i].core])
+		{
+			fprintf(stderr, "core %u: %u events dropped\n", headers[i].core, headers[i].dropped - last_dropped[headers[i].core]);
+			last_dropped[headers[i].core] = headers[i].dropped;
+		}
+	}
+	if (lost != 0)
+	{
+		fprintf(stderr, "%u datagrams lost\n", lost);
+	}
+	if (events.empty())
+	{
+		return -1;
+	}
+	std::stable_sort(events.begin(), events.end(), event_less);
+	origin = events[0].ts;
+
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for (n = 0; n < TRACE_CORE_NUM; n++)
+	{
+		fprintf(out, "%s{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"core %d\"}}", sep, n, n);
+		sep = ",\n";
+		fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"interrupts\"}}", sep, n);
+	}
+	for (i = 0; i < events.size(); i++)
+	{
+		e = events[i];
+		e.ts -= origin;
+		switch (e.type)
+		{
+		case TRACE_TASK_SWITCHED_IN:
+			if (running[e.core] != e.object)
+			{
+				if (running[e.core] != 0)
+				{
+					fprintf(out, "%s{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", sep,
+							object_name(names, running[e.core]).c_str(), e.core, running[e.core], running_since[e.core], e.ts - running_since[e.core]);
+					written++;
+				}
+				if (threads.find(((uint64_t)e.core << 32) | e.object) == threads.end())
+				{
+					threads[((uint64_t)e.core << 32) | e.object] = true;
+					fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", sep,
+							e.core, e.object, object_name(names, e.object).c_str());
+				}
+				running[e.core] = e.object;
+				running_since[e.core] = e.ts;
+			}
+			break;
+		case TRACE_ISR_ENTER:
+		case TRACE_ISR_EXIT:
+			fprintf(out, "%s{\"ph\":\"%s\",\"name\":\"irq %u\",\"pid\":%u,\"tid\":0,\"ts\":%.3f}", sep,
+					(e.type == TRACE_ISR_ENTER) ? "B" : "E", e.arg16, e.core, e.ts);
+			written++;
+			break;
+		case TRACE_TICK:
+			break;
+		default:
+			name = event_name(e.type);
+			if (name == NULL)
+			{
+				if (e.type < TRACE_USER)
+				{
+					break;
+				}
+				name = "user";
+			}
+			// events from an interrupt go to the interrupt thread, the others to the running task
+			fprintf(out, "%s{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,"
+					"\"args\":{\"object\":\"%s\",\"type\":%u,\"arg\":%u,\"data\":%u}}", sep,
+					name, e.core, (e.arg8 != 0) ? 0 : running[e.core], e.ts,
+					object_name(names, e.object).c_str(), e.type, e.arg16, e.data);
+			written++;
+			break;
+		}
+	}
+	// the tasks still running at the end of the capture
+	for (n = 0; n < TRACE_CORE_NUM; n++)
+	{
+		if (running[n] != 0)
+		{
+			fprintf(out, "%s{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", sep,
+					object_name(names, running[n]).c_str(), n, running[n], running_since[n], e.ts - running_since[n]);
+			written++;
+		}
+	}
+	fprintf(out, "\n]}\n");
+	return written;
+}
@@ -0,0 +1,54 @@
+#ifndef TRACE_DECODE_H
+#define TRACE_DECODE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// Wire format of sample_boot/boot_trace.h and FreeRTOS/Source/include/trace_recorder.h,
+// all the fields are big endian.
+#define TRACE_MAGIC (0x56545243) // "VTRC"
+#define TRACE_VERSION (1)
+#define TRACE_KIND_EVENTS (0)
+#define TRACE_KIND_NAMES (1)
+#define TRACE_HEADER_SIZE (32)
+#define TRACE_EVENT_SIZE (16)
+#define TRACE_NAME_SIZE (16)
+#define TRACE_NAME_LENGTH (12)
+#define TRACE_CORE_NUM (3)
+
+#define TRACE_TASK_SWITCHED_IN (1)
+#define TRACE_TASK_READY (2)
+#define TRACE_TASK_CREATE (3)
+#define TRACE_TASK_DELETE (4)
+#define TRACE_TASK_DELAY (5)
+#define TRACE_TASK_NOTIFY (6)
+#define TRACE_TASK_NOTIFY_WAIT (7)
+#define TRACE_TICK (8)
+#define TRACE_ISR_ENTER (9)
+#define TRACE_ISR_EXIT (10)
+#define TRACE_QUEUE_SEND (11)
+#define TRACE_QUEUE_SEND_FAILED (12)
+#define TRACE_QUEUE_SEND_BLOCK (13)
+#define TRACE_QUEUE_RECEIVE (14)
+#define TRACE_QUEUE_RECEIVE_FAILED (15)
+#define TRACE_QUEUE_RECEIVE_BLOCK (16)
+#define TRACE_STREAM_SEND (17)
+#define TRACE_STREAM_RECEIVE (18)
+#define TRACE_STREAM_SEND_BLOCK (19)
+#define TRACE_STREAM_RECEIVE_BLOCK (20)
+#define TRACE_NET_BUFFER_GET (21)
+#define TRACE_NET_BUFFER_RELEASE (22)
+#define TRACE_USER (64)
+
+typedef std::vector<uint8_t> trace_datagram_t;
+
+// Checks the header of a received datagram, returns false if it is not a trace datagram.
+bool trace_datagram_valid(const uint8_t *data, int len);
+
+// Writes the datagrams as Chrome trace JSON (chrome://tracing, Perfetto): one process per core,
+// one thread per task with its running time, the interrupts on thread 0 and the kernel events as
+// instant events. Returns the number of events written, -1 on error.
+int trace_write_chrome_json(const std::vector<trace_datagram_t> &datagrams, FILE *out);
+
+#endif
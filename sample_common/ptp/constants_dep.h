@@ -65,6 +65,7 @@
 
 #define PTP_RX_TASK_STACK_SIZE (1024U)
 #define PTP_RX_TASK_PRIO (4U)
+#define PTP_RX_BATCH (4) /* datagrams taken per FreeRTOS_recvmmsg() */
 
 #endif /*CONSTANTS_DEP_H_*/
 
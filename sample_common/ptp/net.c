@@ -30,68 +30,51 @@ static Boolean netQCheck(rb_t *prb)
     }
 }
 
-static void event_ptp_rx_task(void *param)
+/**
+ * @brief  Receive loop of the PTP sockets, queues the messages with their time
+ * @param  sock socket to read
+ * @param  prb queue of the received messages
+ * @retval None
+ */
+static void ptp_rx_loop(Socket_t sock, rb_t *prb)
 {
-    NetPath *netPath = (NetPath *)param;
-    int32_t rx_size = 0;
-    uint8_t *p_rx_data;
+    struct freertos_mmsghdr msgs[PTP_RX_BATCH];
+    int32_t rx_cnt;
+    int32_t i;
     pbuf_t *q = NULL;
     int32_t time_s;
     int32_t time_ns;
-    UInteger16 data_len;
     for (;;)
     {
-        rx_size = FreeRTOS_recvfrom(netPath->event_ptp_sock, (void *)&p_rx_data, PACKET_SIZE, FREERTOS_ZERO_COPY, NULL, &time_s, &time_ns);
-        if (rx_size > 0)
+        /* Messages that arrived together share the receive time. */
+        rx_cnt = FreeRTOS_recvmmsg(sock, msgs, PTP_RX_BATCH, 0, &time_s, &time_ns);
+        for (i = 0; i < rx_cnt; i++)
         {
-            if (!rb_is_full(&netPath->event_rb))
+            if ((msgs[i].xLength > 0) && (msgs[i].xLength <= PACKET_SIZE) && !rb_is_full(prb))
             {
-                q = (pbuf_t *)rb_peek_w_buff(&netPath->event_rb);
-                data_len = (UInteger16)rx_size;
-                memcpy(q->payload, p_rx_data, data_len);
-                q->tot_len = data_len;
+                q = (pbuf_t *)rb_peek_w_buff(prb);
+                memcpy(q->payload, msgs[i].pvData, msgs[i].xLength);
+                q->tot_len = (UInteger16)msgs[i].xLength;
                 q->time_sec = time_s;
                 q->time_nsec = time_ns;
-                rb_w_idx_inc(&netPath->event_rb);
+                rb_w_idx_inc(prb);
             }
-        }
-        if (rx_size >= 0) /* The buffer *must* be freed once it is no longer needed. */
-        {
-            FreeRTOS_ReleaseUDPPayloadBuffer(p_rx_data);
+            /* The buffer *must* be freed once it is no longer needed. */
+            FreeRTOS_ReleaseUDPPayloadBuffer(msgs[i].pvData);
         }
     }
 }
 
+static void event_ptp_rx_task(void *param)
+{
+    NetPath *netPath = (NetPath *)param;
+    ptp_rx_loop(netPath->event_ptp_sock, &netPath->event_rb);
+}
+
 static void general_ptp_rx_task(void *param)
 {
     NetPath *netPath = (NetPath *)param;
-    int32_t rx_size = 0;
-    uint8_t *p_rx_data;
-    pbuf_t *q = NULL;
-    int32_t time_s;
-    int32_t time_ns;
-    UInteger16 data_len;
-    for (;;)
-    {
-        rx_size = FreeRTOS_recvfrom(netPath->general_ptp_sock, (void *)&p_rx_data, PACKET_SIZE, FREERTOS_ZERO_COPY, NULL, &time_s, &time_ns);
-        if (rx_size > 0)
-        {
-            if (!rb_is_full(&netPath->general_rb))
-            {
-                q = (pbuf_t *)rb_peek_w_buff(&netPath->general_rb);
-                data_len = (UInteger16)rx_size;
-                memcpy(q->payload, p_rx_data, data_len);
-                q->tot_len = data_len;
-                q->time_sec = time_s;
-                q->time_nsec = time_ns;
-                rb_w_idx_inc(&netPath->general_rb);
-            }
-        }
-        if (rx_size >= 0) /* The buffer *must* be freed once it is no longer needed. */
-        {
-            FreeRTOS_ReleaseUDPPayloadBuffer(p_rx_data);
-        }
-    }
+    ptp_rx_loop(netPath->general_ptp_sock, &netPath->general_rb);
 }
 
 /**
@@ -103,6 +86,10 @@ static void general_ptp_rx_task(void *param)
 Boolean netInit(NetPath *netPath)
 {
     struct freertos_sockaddr local_addr;
+#if (ipconfigUDP_FAST_PATH == 1)
+    /* The PTP messages skip the IP-task queue. */
+    BaseType_t fast_path = pdTRUE;
+#endif
 
     if (0 == netPath->init_flag)
     {
@@ -116,6 +103,9 @@ Boolean netInit(NetPath *netPath)
             FreeRTOS_GetAddressConfiguration(&local_addr.sin_addr, NULL, NULL, NULL);
             local_addr.sin_port = FreeRTOS_htons(PTP_EVENT_PORT);
             FreeRTOS_bind(netPath->event_ptp_sock, &local_addr, sizeof(local_addr));
+#if (ipconfigUDP_FAST_PATH == 1)
+            FreeRTOS_setsockopt(netPath->event_ptp_sock, 0, FREERTOS_SO_UDP_FAST_PATH, &fast_path, 0);
+#endif
             /* Initialize the buffer queues. */
             rb_init(&netPath->event_rb, pbuf_t, netPath->event_buf, PBUF_QUEUE_SIZE);
             xTaskCreate(event_ptp_rx_task, "default_ptp", PTP_RX_TASK_STACK_SIZE, (void *)netPath, PTP_RX_TASK_PRIO, NULL);
@@ -135,6 +125,9 @@ Boolean netInit(NetPath *netPath)
             FreeRTOS_GetAddressConfiguration(&local_addr.sin_addr, NULL, NULL, NULL);
             local_addr.sin_port = FreeRTOS_htons(PTP_GENERAL_PORT);
             FreeRTOS_bind(netPath->general_ptp_sock, &local_addr, sizeof(local_addr));
+#if (ipconfigUDP_FAST_PATH == 1)
+            FreeRTOS_setsockopt(netPath->general_ptp_sock, 0, FREERTOS_SO_UDP_FAST_PATH, &fast_path, 0);
+#endif
             /* Initialize the buffer queues. */
             rb_init(&netPath->general_rb, pbuf_t, netPath->general_buf, PBUF_QUEUE_SIZE);
             xTaskCreate(general_ptp_rx_task, "peer_ptp", PTP_RX_TASK_STACK_SIZE, (void *)netPath, PTP_RX_TASK_PRIO, NULL);
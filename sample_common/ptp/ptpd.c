@@ -18,6 +18,8 @@ void ptp_run_control_task(void *param)
 {
 	(void)(param);
 	TickType_t xLastWakeTime;
+	/* the servo computes the frequency adjustment in floating point */
+	portTASK_USES_FLOATING_POINT();
 	PTPTimerInit();
 	xLastWakeTime = xTaskGetTickCount();
 	while (1)
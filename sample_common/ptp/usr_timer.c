@@ -14,45 +14,39 @@
 
 #define PTP_USE_PIT_CHANNEL_IRQn (PIT_Ch5_IRQn)
 #define PTP_USE_PIT_CHANNEL (5u)
+/* Above configMAX_API_CALL_INTERRUPT_PRIORITY, the seconds of the timestamps
+ * never wait for a critical section. Neither handler calls the API. */
+#define PTP_ENET_TIMER_IRQ_PRIORITY (10u)
+#define PTP_PIT_IRQ_PRIORITY (9u)
 
 static volatile uint32_t s_correctionInc = 0;
+static const IRQn_Type s_ptpTimerIrqId[] = FEATURE_ENET_TIMER_IRQS;
 
 enet_timer_config_t ptp_timer_config_struct;
 static volatile uint32_t time_s = 0;
-static volatile uint32_t last_visit_time_ns = 0;
-static volatile uint32_t last_visit_time_s = 0;
 
+/* Lock free, the interrupt of the timer period may preempt the read on this
+ * core or run on another one. The seconds are read around the nanoseconds and
+ * the read is retried when the period interrupt ran in between. A period that
+ * elapsed with its interrupt still pending is taken from the event flag, the
+ * nanoseconds then exceed S_TO_NS_COUNT and the caller carries them. */
 void get_current_time(uint32_t *s, uint32_t *ns, uint8_t irq_flag)
 {
     uint32_t temp_ns = 0;
     uint32_t temp_s = 0;
-    if (USE_OUT_IRQ_FLAG == irq_flag)
+    uint32_t pending;
+    (void)(irq_flag);
+    do
     {
-        taskENTER_CRITICAL();
-    }
-    temp_s = time_s;
-    ENET_DRV_TimerGet(PTP_ENET_INSTANCE, &temp_ns);
-
-    if (temp_s == last_visit_time_s)
-    {
-        if ((last_visit_time_ns > 990000000) && (temp_ns < 1000000))
-        {
-            temp_ns += (uint32_t)S_TO_NS_COUNT;
-        }
-        else
-        {
-            last_visit_time_ns = temp_ns;
-        }
-    }
-    else
-    {
-        last_visit_time_s = temp_s;
-        last_visit_time_ns = temp_ns;
-    }
+        temp_s = time_s;
+        ENET_DRV_TimerGet(PTP_ENET_INSTANCE, &temp_ns);
+        pending = ENET_DRV_GetInterruptFlags(PTP_ENET_INSTANCE) & (uint32_t)ENET_TS_TIMER_INTERRUPT;
+    } while (temp_s != time_s);
 
-    if (USE_OUT_IRQ_FLAG == irq_flag)
+    /* a count in the first half of the period was captured after the wrap */
+    if ((pending != 0u) && (temp_ns < (S_TO_NS_COUNT / 2u)))
     {
-        taskEXIT_CRITICAL();
+        temp_ns += (uint32_t)S_TO_NS_COUNT;
     }
     *s = temp_s;
     *ns = temp_ns;
@@ -83,9 +77,10 @@ void PTPTimerInit(void)
     s_correctionInc = NS_INC_IN_TICK;
     ENET_DRV_TimerInit(PTP_ENET_INSTANCE, &ptp_timer_config_struct);
     ENET_DRV_TimerStart(PTP_ENET_INSTANCE);
+    INT_SYS_SetPriority(s_ptpTimerIrqId[PTP_ENET_INSTANCE], PTP_ENET_TIMER_IRQ_PRIORITY);
     INT_SYS_InstallHandler(PTP_USE_PIT_CHANNEL_IRQn, ptp_timer_close_irqhandler, NULL);
     INT_SYS_EnableIRQ(PTP_USE_PIT_CHANNEL_IRQn);
-    INT_SYS_SetPriority(PTP_USE_PIT_CHANNEL_IRQn, 9);
+    INT_SYS_SetPriority(PTP_USE_PIT_CHANNEL_IRQn, PTP_PIT_IRQ_PRIORITY);
 }
 
 void setPTPUsrTime(const int32_t second, const int32_t nanoSecond)